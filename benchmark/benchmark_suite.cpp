@@ -7,13 +7,17 @@
 #include "../src/data/DataStorage.h"
 #include "../src/exchange/BinanceAPI.h"
 #include "../src/exchange/BinanceWebSocket.h"
+#include "../src/exchange/BinanceRestDecoder.h"
+#include "../src/utils/JsonParser.h"
 #include "../src/utils/Logger.h"
+#include "../src/strategy/RecipeLoader.h"
 
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 #include <vector>
 #include <cmath>
+#include <cstdio>
 
 using namespace Emiglio;
 using namespace std::chrono;
@@ -122,8 +126,8 @@ void benchmarkIndicators() {
 
 	// Benchmark Stochastic
 	{
-		BenchmarkTimer timer("Stochastic(14,3,3) - 10k candles");
-		auto result = Indicators::stochastic(candles, 14, 3, 3);
+		BenchmarkTimer timer("Stochastic(14,3) - 10k candles");
+		auto result = Indicators::stochastic(candles, 14, 3);
 	}
 }
 
@@ -158,6 +162,7 @@ void benchmarkDatabase() {
 	{
 		BenchmarkTimer timer("Count candles");
 		int count = storage.getCandleCount("binance", "BTCUSDT", "1h");
+		(void)count;
 	}
 
 	// Cleanup
@@ -171,35 +176,49 @@ void benchmarkPortfolio() {
 	          << std::setw(15) << std::right << "Time" << std::endl;
 	std::cout << std::string(55, '-') << std::endl;
 
-	Portfolio portfolio(10000.0); // $10k initial
+	Backtest::Portfolio portfolio(10000.0); // $10k initial
+
+	Backtest::Trade trade;
+	trade.symbol = "BTCUSDT";
+	trade.type = Backtest::TradeType::LONG;
+	trade.entryPrice = 50000.0;
+	trade.quantity = 0.1;
+	trade.entryTime = std::time(nullptr);
 
 	// Benchmark: Buy order
 	{
 		BenchmarkTimer timer("Execute buy order");
-		portfolio.buy("BTCUSDT", 0.1, 50000.0, std::time(nullptr));
+		portfolio.openPosition(trade, 5.0, 2.5);
 	}
 
 	// Benchmark: Sell order
 	{
 		BenchmarkTimer timer("Execute sell order");
-		portfolio.sell("BTCUSDT", 0.1, 51000.0, std::time(nullptr));
+		portfolio.closePosition(trade.id, 51000.0, "Signal", 5.1, 2.55);
 	}
 
 	// Benchmark: Get position
 	{
 		BenchmarkTimer timer("Get position");
-		auto pos = portfolio.getPosition("BTCUSDT");
+		int index = portfolio.getOpenTradeIndex(trade.id);
+		(void)index;
 	}
 
 	// Benchmark: Calculate total value (100 positions)
-	Portfolio bigPortfolio(100000.0);
+	Backtest::Portfolio bigPortfolio(100000.0);
 	for (int i = 0; i < 100; i++) {
-		bigPortfolio.buy("SYM" + std::to_string(i), 1.0, 100.0, std::time(nullptr));
+		Backtest::Trade position = trade;
+		position.id.clear();
+		position.symbol = "SYM" + std::to_string(i);
+		position.entryPrice = 100.0;
+		position.quantity = 1.0;
+		bigPortfolio.openPosition(position, 0.0, 0.0);
 	}
 
 	{
 		BenchmarkTimer timer("Calculate value (100 positions)");
-		double value = bigPortfolio.getTotalValue();
+		double value = bigPortfolio.getEquity(101.0);
+		(void)value;
 	}
 }
 
@@ -211,36 +230,90 @@ void benchmarkBacktest() {
 	std::cout << std::string(55, '-') << std::endl;
 
 	// Generate test data
-	std::vector<Candle> candles = generateTestCandles(1000);
+	std::vector<Candle> candles = generateTestCandles(10000);
+
+	// Simple RSI strategy
+	Recipe recipe;
+	recipe.name = "Benchmark RSI";
+	recipe.market = { "binance", "BTCUSDT", "1h" };
+	recipe.capital = { 10000.0, 50.0 };
+	recipe.risk = { 2.0, 5.0, 0.0, 1 };
+	IndicatorConfig rsi;
+	rsi.name = "rsi";
+	rsi.period = 14;
+	recipe.indicators.push_back(rsi);
+	recipe.entryConditions.logic = "AND";
+	recipe.entryConditions.rules.push_back({ "rsi", "<", 30.0, "" });
+	recipe.exitConditions.logic = "OR";
+	recipe.exitConditions.rules.push_back({ "rsi", ">", 70.0, "" });
 
 	Backtest::BacktestConfig config;
 	config.initialCapital = 10000.0;
-	config.symbol = "BTCUSDT";
-	config.timeframe = "1h";
-	config.startTime = candles.front().timestamp;
-	config.endTime = candles.back().timestamp;
-	config.stopLoss = 0.02;
-	config.takeProfit = 0.05;
 
-	Backtest::BacktestSimulator simulator;
+	// Benchmark: Simple RSI strategy (10000 candles)
+	{
+		BenchmarkTimer timer("Backtest RSI (10k candles)");
+		Backtest::BacktestSimulator simulator(recipe, config);
+		Backtest::BacktestResult result = simulator.run(candles);
+		(void)result;
+	}
+}
+
+// Benchmark: REST response decoding (1000-kline /api/v3/klines response)
+void benchmarkJsonDecoding() {
+	std::cout << "\n=== JSON Decoding Benchmarks ===" << std::endl;
+	std::cout << std::setw(40) << std::left << "Operation"
+	          << std::setw(15) << std::right << "Time" << std::endl;
+	std::cout << std::string(55, '-') << std::endl;
+
+	std::vector<Candle> source = generateTestCandles(1000);
+	std::string response = "[";
+	char row[512];
+	for (size_t i = 0; i < source.size(); i++) {
+		const Candle& c = source[i];
+		long long openTime = static_cast<long long>(c.timestamp) * 1000;
+		snprintf(row, sizeof(row),
+		         "%s[%lld,\"%.8f\",\"%.8f\",\"%.8f\",\"%.8f\",\"%.8f\",%lld,\"%.8f\",%d,\"%.8f\",\"%.8f\",\"0\"]",
+		         i == 0 ? "" : ",", openTime, c.open, c.high, c.low, c.close, c.volume,
+		         openTime + 3599999, c.volume * c.close, 1000, c.volume / 2, c.volume * c.close / 2);
+		response += row;
+	}
+	response += "]";
+
+	const int iterations = 100;
 
-	// Benchmark: Simple RSI strategy (1000 candles)
+	// DOM + key path lookups (previous BinanceAPI::getCandles)
 	{
-		BenchmarkTimer timer("Backtest RSI (1000 candles)");
-
-		// Simple RSI strategy
-		for (size_t i = 20; i < candles.size(); i++) {
-			std::vector<Candle> window(candles.begin(), candles.begin() + i);
-			std::vector<double> closes = Indicators::getClosePrices(window);
-			std::vector<double> rsi = Indicators::rsi(closes, 14);
-
-			if (!rsi.empty() && rsi.back() < 30) {
-				// Buy signal
-			} else if (!rsi.empty() && rsi.back() > 70) {
-				// Sell signal
+		BenchmarkTimer timer("JsonParser klines x100");
+		for (int n = 0; n < iterations; n++) {
+			JsonParser parser;
+			parser.parse(response);
+			std::vector<Candle> candles;
+			size_t count = parser.getArraySize("");
+			for (size_t i = 0; i < count; i++) {
+				Candle candle;
+				candle.timestamp = parser.getNestedArrayInt64("", i, 0, 0) / 1000;
+				candle.open = parser.getNestedArrayDouble("", i, 1, 0.0);
+				candle.high = parser.getNestedArrayDouble("", i, 2, 0.0);
+				candle.low = parser.getNestedArrayDouble("", i, 3, 0.0);
+				candle.close = parser.getNestedArrayDouble("", i, 4, 0.0);
+				candle.volume = parser.getNestedArrayDouble("", i, 5, 0.0);
+				candles.push_back(candle);
 			}
 		}
 	}
+
+	// One-pass decoder (input is consumed, so each run gets a copy)
+	{
+		BenchmarkTimer timer("BinanceRestDecoder klines x100");
+		BinanceRestDecoder decoder;
+		std::vector<Candle> candles;
+		for (int n = 0; n < iterations; n++) {
+			std::string buffer = response;
+			candles.clear();
+			decoder.decodeKlines(buffer, candles, "BTCUSDT", "1h");
+		}
+	}
 }
 
 // Benchmark: WebSocket message processing
@@ -261,7 +334,7 @@ void benchmarkWebSocket() {
 	// Benchmark: Subscribe to ticker
 	{
 		BenchmarkTimer timer("Subscribe to ticker");
-		ws.subscribeTicker("BTCUSDT", [](const TickerUpdate& update) {
+		ws.subscribeTicker("BTCUSDT", [](const TickerUpdate&) {
 			// Callback
 		});
 	}
@@ -269,7 +342,7 @@ void benchmarkWebSocket() {
 	// Benchmark: Subscribe to trades
 	{
 		BenchmarkTimer timer("Subscribe to trades");
-		ws.subscribeTrades("BTCUSDT", [](const TradeUpdate& update) {
+		ws.subscribeTrades("BTCUSDT", [](const TradeUpdate&) {
 			// Callback
 		});
 	}
@@ -279,18 +352,19 @@ void benchmarkWebSocket() {
 	int tickerCount = 0;
 	int tradeCount = 0;
 
-	ws.subscribeTicker("ETHUSDT", [&tickerCount](const TickerUpdate& update) {
+	ws.subscribeTicker("ETHUSDT", [&tickerCount](const TickerUpdate&) {
 		tickerCount++;
 	});
 
-	ws.subscribeTrades("ETHUSDT", [&tradeCount](const TradeUpdate& update) {
+	ws.subscribeTrades("ETHUSDT", [&tradeCount](const TradeUpdate&) {
 		tradeCount++;
 	});
 
 	auto start = high_resolution_clock::now();
 	while (duration_cast<seconds>(high_resolution_clock::now() - start).count() < 3) {
-		// Let it run
-		std::this_thread::sleep_for(milliseconds(100));
+		// Callbacks run from processMessages()
+		ws.waitForMessages(100);
+		ws.processMessages();
 	}
 
 	std::cout << "Received " << tickerCount << " ticker updates in 3s ("
@@ -302,7 +376,7 @@ void benchmarkWebSocket() {
 }
 
 // Main benchmark runner
-int main(int argc, char* argv[]) {
+int main() {
 	std::cout << "\n";
 	std::cout << "╔════════════════════════════════════════════════════════╗" << std::endl;
 	std::cout << "║         EMIGLIO TRADING BOT - BENCHMARK SUITE          ║" << std::endl;
@@ -316,6 +390,7 @@ int main(int argc, char* argv[]) {
 	benchmarkDatabase();
 	benchmarkPortfolio();
 	benchmarkBacktest();
+	benchmarkJsonDecoding();
 	benchmarkWebSocket();
 
 	std::cout << "\n";
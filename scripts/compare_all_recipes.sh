@@ -147,6 +147,60 @@ MATRIX_FILE="$OUTPUT_DIR/comparison_matrix.csv"
 echo "✓ Comparison matrix template created: $MATRIX_FILE"
 echo ""
 
+# Run the backtests with the headless runner when it has been built
+# (cd ../src/cli && make)
+BACKTEST_BIN="../src/cli/emiglio_backtest"
+DB_PATH="${EMIGLIO_DB:-/boot/home/Emiglio/data/emilio.db}"
+
+if [ -x "$BACKTEST_BIN" ]; then
+    echo "Running backtests with $BACKTEST_BIN (database: $DB_PATH)"
+    for config_key in "${!TEST_CONFIGS[@]}"; do
+        IFS='|' read -r symbol timeframe label <<< "${TEST_CONFIGS[$config_key]}"
+        echo "  - $label"
+        "$BACKTEST_BIN" --db "$DB_PATH" --symbol "$symbol" --timeframe "$timeframe" \
+            --quiet -o "$OUTPUT_DIR/results_${config_key}.json" "$RECIPES_DIR" || true
+    done
+
+    # Fill the matrix with total returns
+    python3 - "$OUTPUT_DIR" "$MATRIX_FILE" <<'PYTHON_END'
+import csv, json, os, sys
+
+output_dir, matrix_file = sys.argv[1], sys.argv[2]
+with open(matrix_file) as f:
+    rows = list(csv.reader(f))
+
+header = rows[0]
+configs = header[1:-2]
+returns = {}
+for config in configs:
+    path = os.path.join(output_dir, f"results_{config}.json")
+    if not os.path.exists(path):
+        continue
+    with open(path) as f:
+        for result in json.load(f).get("results", []):
+            recipe = os.path.splitext(os.path.basename(result["recipeFile"]))[0]
+            value = result["report"].get("returns", {}).get("totalReturn")
+            if value is not None:
+                returns[(recipe, config)] = value
+
+for row in rows[1:]:
+    values = []
+    for i, config in enumerate(configs):
+        value = returns.get((row[0], config))
+        row[i + 1] = f"{value:.2f}" if value is not None else "N/A"
+        if value is not None:
+            values.append((value, config))
+    if values:
+        row[-2] = f"{sum(v for v, _ in values) / len(values):.2f}"
+        row[-1] = max(values)[1]
+
+with open(matrix_file, "w", newline="") as f:
+    csv.writer(f).writerows(rows)
+PYTHON_END
+    echo "✓ Backtest results written to $OUTPUT_DIR/results_*.json"
+    echo ""
+fi
+
 # Create detailed test plan
 PLAN_FILE="$OUTPUT_DIR/test_plan.md"
 
@@ -247,9 +301,9 @@ echo ""
 echo "1. Review the recipe analysis: $ANALYSIS_FILE"
 echo "2. Check the test plan: $PLAN_FILE"
 echo "3. To run actual backtests, you need:"
-echo "   - EmilioUI application with backtest functionality"
-echo "   - OR a dedicated backtest engine"
+echo "   - The headless runner: cd ../src/cli && make (then rerun this script)"
 echo "   - Historical data for all symbols (ETHUSDT, EURUSDT, ETHEUR)"
+echo "     in \$EMIGLIO_DB (default /boot/home/Emiglio/data/emilio.db)"
 echo ""
 echo "4. The comparison matrix is ready at: $MATRIX_FILE"
 echo "   Once backtests complete, populate this file with results"
@@ -130,9 +130,9 @@ int main(int argc, char* argv[]) {
 		return 1;
 	}
 
-	// Clear existing data
-	LOG_INFO("Clearing existing data for " + symbol);
-	storage.clearCandles("binance", symbol, interval);
+	// Existing candles are kept: inserts update candles already stored.
+	// For years of history, import the data.binance.vision dumps with
+	// emiglio_import (src/cli) instead.
 
 	// Download data
 	if (!DownloadData(api, storage, symbol, interval, startTime, endTime)) {
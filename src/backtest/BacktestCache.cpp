@@ -0,0 +1,461 @@
+#include "BacktestCache.h"
+#include "../utils/Logger.h"
+
+#include <cstring>
+#include <cstdio>
+
+namespace Emiglio {
+namespace Backtest {
+
+namespace {
+
+// Bump when the simulator or the serialized layout changes so stale
+// entries are never returned
+const uint32_t kCacheVersion = 1;
+
+// FNV-1a 64-bit over a canonical byte stream
+class Hasher {
+public:
+	Hasher() : hash(0xcbf29ce484222325ULL) {}
+
+	void bytes(const void* data, size_t size) {
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) {
+			hash ^= p[i];
+			hash *= 0x100000001b3ULL;
+		}
+	}
+
+	void u64(uint64_t value) { bytes(&value, sizeof(value)); }
+	void i64(int64_t value) { bytes(&value, sizeof(value)); }
+
+	void dbl(double value) {
+		if (value == 0.0) value = 0.0;  // Fold -0.0 into 0.0
+		uint64_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		u64(bits);
+	}
+
+	// Length-prefixed so "ab"+"c" and "a"+"bc" differ
+	void str(const std::string& value) {
+		u64(value.size());
+		bytes(value.data(), value.size());
+	}
+
+	uint64_t value() const { return hash; }
+
+private:
+	uint64_t hash;
+};
+
+void hashRule(Hasher& h, const TradingRule& rule) {
+	h.str(rule.indicator);
+	h.str(rule.operatorStr);
+	h.dbl(rule.value);
+	h.str(rule.compareWith);
+}
+
+void hashConditions(Hasher& h, const TradingConditions& conditions) {
+	h.str(conditions.logic);
+	h.u64(conditions.rules.size());
+	for (const auto& rule : conditions.rules) {
+		hashRule(h, rule);
+	}
+}
+
+// Append-only binary writer for serialize()
+class Writer {
+public:
+	explicit Writer(std::string& out) : out(out) {}
+
+	void raw(const void* data, size_t size) { out.append(static_cast<const char*>(data), size); }
+	void u32(uint32_t value) { raw(&value, sizeof(value)); }
+	void i64(int64_t value) { raw(&value, sizeof(value)); }
+	void dbl(double value) { raw(&value, sizeof(value)); }
+
+	void str(const std::string& value) {
+		u32(static_cast<uint32_t>(value.size()));
+		raw(value.data(), value.size());
+	}
+
+private:
+	std::string& out;
+};
+
+// Bounds-checked reader for deserialize(); ok() turns false on truncation
+class Reader {
+public:
+	explicit Reader(const std::string& in) : in(in), pos(0), valid(true) {}
+
+	bool raw(void* data, size_t size) {
+		if (!valid || in.size() - pos < size) {
+			valid = false;
+			return false;
+		}
+		std::memcpy(data, in.data() + pos, size);
+		pos += size;
+		return true;
+	}
+
+	uint32_t u32() { uint32_t v = 0; raw(&v, sizeof(v)); return v; }
+	int64_t i64() { int64_t v = 0; raw(&v, sizeof(v)); return v; }
+	double dbl() { double v = 0.0; raw(&v, sizeof(v)); return v; }
+
+	std::string str() {
+		uint32_t size = u32();
+		if (!valid || in.size() - pos < size) {
+			valid = false;
+			return "";
+		}
+		std::string value = in.substr(pos, size);
+		pos += size;
+		return value;
+	}
+
+	bool ok() const { return valid; }
+	bool atEnd() const { return pos == in.size(); }
+
+private:
+	const std::string& in;
+	size_t pos;
+	bool valid;
+};
+
+} // namespace
+
+BacktestCache& BacktestCache::getInstance() {
+	static BacktestCache instance;
+	return instance;
+}
+
+BacktestCache::BacktestCache()
+	: hits(0)
+	, misses(0)
+{
+}
+
+BacktestCache::~BacktestCache() {
+}
+
+bool BacktestCache::init(const std::string& dbPath) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (storage) {
+		return true;
+	}
+
+	std::unique_ptr<DataStorage> db = std::make_unique<DataStorage>();
+	if (!db->init(dbPath)) {
+		LOG_WARNING("Backtest cache running in memory only: cannot open " + dbPath);
+		return false;
+	}
+
+	storage = std::move(db);
+	return true;
+}
+
+uint64_t BacktestCache::hashRecipe(const Recipe& recipe) {
+	Hasher h;
+	h.str(recipe.name);
+
+	h.str(recipe.market.exchange);
+	h.str(recipe.market.symbol);
+	h.str(recipe.market.timeframe);
+
+	h.dbl(recipe.capital.initial);
+	h.dbl(recipe.capital.positionSizePercent);
+
+	h.dbl(recipe.risk.stopLossPercent);
+	h.dbl(recipe.risk.takeProfitPercent);
+	h.dbl(recipe.risk.maxDailyLossPercent);
+	h.i64(recipe.risk.maxOpenPositions);
+
+	h.u64(recipe.indicators.size());
+	for (const auto& indicator : recipe.indicators) {
+		h.str(indicator.name);
+		h.i64(indicator.period);
+		h.str(indicator.timeframe);
+		// std::map iterates in key order, so params are already canonical
+		h.u64(indicator.params.size());
+		for (const auto& [key, value] : indicator.params) {
+			h.str(key);
+			h.dbl(value);
+		}
+	}
+
+	hashConditions(h, recipe.entryConditions);
+	hashConditions(h, recipe.exitConditions);
+
+	return h.value();
+}
+
+uint64_t BacktestCache::hashConfig(const BacktestConfig& config) {
+	Hasher h;
+	h.u64(kCacheVersion);
+	h.dbl(config.initialCapital);
+	h.dbl(config.commissionPercent);
+	h.dbl(config.slippagePercent);
+	h.u64(config.useStopLoss ? 1 : 0);
+	h.u64(config.useTakeProfit ? 1 : 0);
+	h.i64(config.maxOpenPositions);
+	return h.value();
+}
+
+uint64_t BacktestCache::fingerprintCandles(const std::vector<Candle>& candles) {
+	Hasher h;
+	h.u64(candles.size());
+
+	if (!candles.empty()) {
+		h.str(candles.front().exchange);
+		h.str(candles.front().symbol);
+		h.str(candles.front().timeframe);
+	}
+
+	for (const auto& candle : candles) {
+		h.i64(candle.timestamp);
+		h.dbl(candle.open);
+		h.dbl(candle.high);
+		h.dbl(candle.low);
+		h.dbl(candle.close);
+		h.dbl(candle.volume);
+	}
+
+	return h.value();
+}
+
+std::string BacktestCache::computeKey(const Recipe& recipe,
+                                      const BacktestConfig& config,
+                                      const std::vector<Candle>& candles,
+                                      const std::map<std::string, std::vector<Candle>>& timeframeCandles) {
+	uint64_t candlesHash = fingerprintCandles(candles);
+	for (const auto& [timeframe, series] : timeframeCandles) {
+		Hasher h;
+		h.u64(candlesHash);
+		h.str(timeframe);
+		h.u64(fingerprintCandles(series));
+		candlesHash = h.value();
+	}
+
+	char key[3 * 16 + 1];
+	std::snprintf(key, sizeof(key), "%016llx%016llx%016llx",
+	              static_cast<unsigned long long>(hashRecipe(recipe)),
+	              static_cast<unsigned long long>(hashConfig(config)),
+	              static_cast<unsigned long long>(candlesHash));
+	return key;
+}
+
+std::string BacktestCache::serialize(const BacktestResult& result) {
+	std::string data;
+	data.reserve(256 + result.trades.size() * 160 + result.equityCurve.size() * 32);
+	Writer w(data);
+
+	w.u32(kCacheVersion);
+
+	w.str(result.recipeName);
+	w.str(result.symbol);
+	w.i64(result.startTime);
+	w.i64(result.endTime);
+	w.i64(result.totalCandles);
+
+	w.dbl(result.initialCapital);
+	w.dbl(result.finalEquity);
+	w.dbl(result.peakEquity);
+
+	w.u32(static_cast<uint32_t>(result.trades.size()));
+	for (const auto& trade : result.trades) {
+		w.str(trade.id);
+		w.str(trade.symbol);
+		w.u32(static_cast<uint32_t>(trade.type));
+		w.u32(static_cast<uint32_t>(trade.status));
+		w.dbl(trade.entryPrice);
+		w.dbl(trade.exitPrice);
+		w.dbl(trade.quantity);
+		w.i64(trade.entryTime);
+		w.i64(trade.exitTime);
+		w.dbl(trade.commission);
+		w.dbl(trade.slippage);
+		w.dbl(trade.pnl);
+		w.dbl(trade.pnlPercent);
+		w.str(trade.entryReason);
+		w.str(trade.exitReason);
+		w.dbl(trade.stopLossPrice);
+		w.dbl(trade.takeProfitPrice);
+	}
+	w.i64(result.totalTrades);
+	w.i64(result.winningTrades);
+	w.i64(result.losingTrades);
+
+	w.u32(static_cast<uint32_t>(result.equityCurve.size()));
+	for (const auto& point : result.equityCurve) {
+		w.i64(point.timestamp);
+		w.dbl(point.equity);
+		w.dbl(point.cash);
+		w.dbl(point.positionValue);
+	}
+
+	w.dbl(result.totalCommission);
+	w.dbl(result.totalSlippage);
+
+	w.dbl(result.totalReturn);
+	w.dbl(result.totalReturnPercent);
+	w.dbl(result.annualizedReturn);
+	w.dbl(result.sharpeRatio);
+	w.dbl(result.sortinoRatio);
+	w.dbl(result.maxDrawdown);
+	w.dbl(result.maxDrawdownPercent);
+	w.dbl(result.winRate);
+	w.dbl(result.profitFactor);
+	w.dbl(result.expectancy);
+	w.dbl(result.averageWin);
+	w.dbl(result.averageLoss);
+
+	return data;
+}
+
+bool BacktestCache::deserialize(const std::string& data, BacktestResult& result) {
+	Reader r(data);
+
+	if (r.u32() != kCacheVersion) {
+		return false;
+	}
+
+	BacktestResult out;
+	out.recipeName = r.str();
+	out.symbol = r.str();
+	out.startTime = static_cast<time_t>(r.i64());
+	out.endTime = static_cast<time_t>(r.i64());
+	out.totalCandles = static_cast<int>(r.i64());
+
+	out.initialCapital = r.dbl();
+	out.finalEquity = r.dbl();
+	out.peakEquity = r.dbl();
+
+	uint32_t tradeCount = r.u32();
+	for (uint32_t i = 0; i < tradeCount && r.ok(); i++) {
+		Trade trade;
+		trade.id = r.str();
+		trade.symbol = r.str();
+		trade.type = static_cast<TradeType>(r.u32());
+		trade.status = static_cast<TradeStatus>(r.u32());
+		trade.entryPrice = r.dbl();
+		trade.exitPrice = r.dbl();
+		trade.quantity = r.dbl();
+		trade.entryTime = static_cast<time_t>(r.i64());
+		trade.exitTime = static_cast<time_t>(r.i64());
+		trade.commission = r.dbl();
+		trade.slippage = r.dbl();
+		trade.pnl = r.dbl();
+		trade.pnlPercent = r.dbl();
+		trade.entryReason = r.str();
+		trade.exitReason = r.str();
+		trade.stopLossPrice = r.dbl();
+		trade.takeProfitPrice = r.dbl();
+		out.trades.push_back(trade);
+	}
+	out.totalTrades = static_cast<int>(r.i64());
+	out.winningTrades = static_cast<int>(r.i64());
+	out.losingTrades = static_cast<int>(r.i64());
+
+	uint32_t pointCount = r.u32();
+	if (r.ok()) {
+		out.equityCurve.reserve(pointCount);
+	}
+	for (uint32_t i = 0; i < pointCount && r.ok(); i++) {
+		EquityPoint point;
+		point.timestamp = static_cast<time_t>(r.i64());
+		point.equity = r.dbl();
+		point.cash = r.dbl();
+		point.positionValue = r.dbl();
+		out.equityCurve.push_back(point);
+	}
+
+	out.totalCommission = r.dbl();
+	out.totalSlippage = r.dbl();
+
+	out.totalReturn = r.dbl();
+	out.totalReturnPercent = r.dbl();
+	out.annualizedReturn = r.dbl();
+	out.sharpeRatio = r.dbl();
+	out.sortinoRatio = r.dbl();
+	out.maxDrawdown = r.dbl();
+	out.maxDrawdownPercent = r.dbl();
+	out.winRate = r.dbl();
+	out.profitFactor = r.dbl();
+	out.expectancy = r.dbl();
+	out.averageWin = r.dbl();
+	out.averageLoss = r.dbl();
+
+	if (!r.ok() || !r.atEnd()) {
+		return false;
+	}
+
+	result = std::move(out);
+	return true;
+}
+
+void BacktestCache::storeInMemory(const std::string& key, const BacktestResult& result) {
+	auto it = memory.find(key);
+	if (it != memory.end()) {
+		lruOrder.erase(it->second.second);
+		memory.erase(it);
+	}
+
+	lruOrder.push_front(key);
+	memory.emplace(key, std::make_pair(result, lruOrder.begin()));
+
+	while (memory.size() > kMaxMemoryEntries) {
+		memory.erase(lruOrder.back());
+		lruOrder.pop_back();
+	}
+}
+
+bool BacktestCache::get(const std::string& key, BacktestResult& result) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = memory.find(key);
+	if (it != memory.end()) {
+		lruOrder.splice(lruOrder.begin(), lruOrder, it->second.second);
+		result = it->second.first;
+		hits++;
+		return true;
+	}
+
+	if (storage) {
+		std::string data;
+		if (storage->getBacktestCache(key, data)) {
+			if (deserialize(data, result)) {
+				storeInMemory(key, result);
+				hits++;
+				return true;
+			}
+			LOG_WARNING("Discarding unreadable backtest cache entry " + key);
+		}
+	}
+
+	misses++;
+	return false;
+}
+
+void BacktestCache::put(const std::string& key, const BacktestResult& result) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	storeInMemory(key, result);
+
+	if (storage && !storage->insertBacktestCache(key, result.recipeName, serialize(result))) {
+		LOG_WARNING("Failed to persist backtest cache entry " + key);
+	}
+}
+
+void BacktestCache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	memory.clear();
+	lruOrder.clear();
+
+	if (storage) {
+		storage->clearBacktestCache();
+	}
+}
+
+} // namespace Backtest
+} // namespace Emiglio
@@ -0,0 +1,90 @@
+#ifndef EMIGLIO_BACKTEST_CACHE_H
+#define EMIGLIO_BACKTEST_CACHE_H
+
+#include "BacktestResult.h"
+#include "BacktestSimulator.h"
+#include "../strategy/RecipeLoader.h"
+#include "../data/DataStorage.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace Emiglio {
+namespace Backtest {
+
+// Content-addressed cache of analyzed backtest results.
+//
+// The key is built from hashes of the canonicalized recipe, the backtest
+// configuration and a fingerprint of the candle series, so an unchanged run
+// returns the stored result (trades and equity curve included) without
+// simulating again. Results are kept in memory (LRU) and, once init() has
+// been called, persisted in the backtest_cache table of the database.
+class BacktestCache {
+public:
+	static BacktestCache& getInstance();
+
+	// Enable persistent storage in the given database
+	bool init(const std::string& dbPath);
+
+	// Cache key for a run ("<recipe hash><config hash><candles hash>").
+	// Higher timeframe series given to the simulator are part of the
+	// candles hash.
+	static std::string computeKey(const Recipe& recipe,
+	                              const BacktestConfig& config,
+	                              const std::vector<Candle>& candles,
+	                              const std::map<std::string, std::vector<Candle>>& timeframeCandles = {});
+
+	// Hashes of the individual parts of the key
+	static uint64_t hashRecipe(const Recipe& recipe);
+	static uint64_t hashConfig(const BacktestConfig& config);
+	static uint64_t fingerprintCandles(const std::vector<Candle>& candles);
+
+	// Look up a result; returns false on miss
+	bool get(const std::string& key, BacktestResult& result);
+
+	// Store an analyzed result
+	void put(const std::string& key, const BacktestResult& result);
+
+	// Drop all cached results (memory and database)
+	void clear();
+
+	// Binary (de)serialization of a complete result
+	static std::string serialize(const BacktestResult& result);
+	static bool deserialize(const std::string& data, BacktestResult& result);
+
+	// Statistics
+	size_t getHits() const { return hits; }
+	size_t getMisses() const { return misses; }
+
+	BacktestCache(const BacktestCache&) = delete;
+	BacktestCache& operator=(const BacktestCache&) = delete;
+
+private:
+	BacktestCache();
+	~BacktestCache();
+
+	// Max results kept in memory (each holds a full equity curve)
+	static const size_t kMaxMemoryEntries = 64;
+
+	mutable std::mutex mutex;
+	std::unique_ptr<DataStorage> storage;
+
+	// LRU: most recently used key at the front
+	std::list<std::string> lruOrder;
+	std::map<std::string, std::pair<BacktestResult, std::list<std::string>::iterator>> memory;
+
+	size_t hits;
+	size_t misses;
+
+	void storeInMemory(const std::string& key, const BacktestResult& result);
+};
+
+} // namespace Backtest
+} // namespace Emiglio
+
+#endif // EMIGLIO_BACKTEST_CACHE_H
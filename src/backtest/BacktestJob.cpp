@@ -0,0 +1,194 @@
+#include "BacktestJob.h"
+#include "BacktestCache.h"
+#include "PerformanceAnalyzer.h"
+#include "../utils/Logger.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace Emiglio {
+namespace Backtest {
+
+namespace {
+
+// Share of the progress bar used by each phase
+const double kLoadEnd = 30.0;
+const double kSimulateEnd = 90.0;
+
+} // namespace
+
+BacktestJob::BacktestJob(const Recipe& recipe, const BacktestConfig& config)
+	: recipe(recipe)
+	, config(config)
+	, candleLoader(nullptr)
+	, progressCallback(nullptr)
+	, finishedCallback(nullptr)
+	, useCache(true)
+	, cancelRequested(false)
+	, state(State::IDLE)
+	, cached(false)
+{
+}
+
+BacktestJob::~BacktestJob() {
+	cancel();
+	wait();
+}
+
+void BacktestJob::setCandleLoader(CandleLoader loader) {
+	candleLoader = loader;
+}
+
+void BacktestJob::setCandles(const std::vector<Candle>& candles) {
+	this->candles = candles;
+}
+
+void BacktestJob::setTimeframeCandles(const std::string& timeframe, const std::vector<Candle>& candles) {
+	timeframeCandles[timeframe] = candles;
+}
+
+void BacktestJob::setProgressCallback(ProgressCallback callback) {
+	progressCallback = callback;
+}
+
+void BacktestJob::setFinishedCallback(FinishedCallback callback) {
+	finishedCallback = callback;
+}
+
+void BacktestJob::setUseCache(bool useCache) {
+	this->useCache = useCache;
+}
+
+bool BacktestJob::start() {
+	State expected = State::IDLE;
+	if (!state.compare_exchange_strong(expected, State::RUNNING)) {
+		LOG_WARNING("Backtest job already started");
+		return false;
+	}
+
+	worker = std::thread(&BacktestJob::run, this);
+	return true;
+}
+
+void BacktestJob::cancel() {
+	cancelRequested = true;
+}
+
+void BacktestJob::wait() {
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+std::string BacktestJob::getLastError() const {
+	std::lock_guard<std::mutex> lock(errorMutex);
+	return lastError;
+}
+
+void BacktestJob::setError(const std::string& error) {
+	std::lock_guard<std::mutex> lock(errorMutex);
+	lastError = error;
+}
+
+void BacktestJob::reportProgress(double percent, const std::string& status) {
+	if (progressCallback) {
+		progressCallback(percent, status);
+	}
+}
+
+void BacktestJob::run() {
+	State finalState;
+	try {
+		finalState = execute();
+	} catch (const std::exception& e) {
+		setError(e.what());
+		finalState = State::FAILED;
+	}
+
+	if (finalState == State::FAILED) {
+		LOG_ERROR("Backtest failed: " + getLastError());
+	}
+
+	state = finalState;
+	if (finishedCallback) {
+		finishedCallback(finalState);
+	}
+}
+
+BacktestJob::State BacktestJob::execute() {
+	// Load candles
+	if (candleLoader) {
+		reportProgress(0.0, "Loading candles...");
+		if (!candleLoader(*this, candles)) {
+			if (cancelRequested) {
+				return State::CANCELLED;
+			}
+			if (getLastError().empty()) {
+				setError("Failed to load candles");
+			}
+			return State::FAILED;
+		}
+	}
+
+	if (cancelRequested) {
+		return State::CANCELLED;
+	}
+
+	if (candles.empty()) {
+		setError("No candles available for " + recipe.market.symbol);
+		return State::FAILED;
+	}
+
+	// Cached result?
+	BacktestCache& cache = BacktestCache::getInstance();
+	if (useCache) {
+		cacheKey = BacktestCache::computeKey(recipe, config, candles, timeframeCandles);
+		if (cache.get(cacheKey, result)) {
+			cached = true;
+			reportProgress(100.0, "Complete (cached)");
+			return State::COMPLETED;
+		}
+	}
+
+	// Simulate
+	reportProgress(kLoadEnd, "Running backtest simulation...");
+
+	BacktestSimulator simulator(recipe, config);
+	for (const auto& [timeframe, series] : timeframeCandles) {
+		simulator.setTimeframeCandles(timeframe, series);
+	}
+
+	// About 200 progress updates per run, never fewer than 1000 candles apart
+	size_t interval = std::max<size_t>(1000, candles.size() / 200);
+	simulator.setProgressCallback([this](size_t processed, size_t total) {
+		double percent = kLoadEnd + (kSimulateEnd - kLoadEnd) * processed / total;
+		reportProgress(percent, "Simulating " + std::to_string(processed) + " / " +
+		               std::to_string(total) + " candles...");
+		return !cancelRequested.load();
+	}, interval);
+
+	result = simulator.run(candles);
+	if (result.cancelled) {
+		return State::CANCELLED;
+	}
+	if (!simulator.getLastError().empty()) {
+		// An empty result; neither analyzed nor cached
+		setError(simulator.getLastError());
+		return State::FAILED;
+	}
+
+	// Analyze
+	reportProgress(kSimulateEnd, "Analyzing performance...");
+	PerformanceAnalyzer analyzer;
+	analyzer.analyze(result);
+
+	if (useCache) {
+		cache.put(cacheKey, result);
+	}
+
+	reportProgress(100.0, "Complete!");
+	return State::COMPLETED;
+}
+
+} // namespace Backtest
+} // namespace Emiglio
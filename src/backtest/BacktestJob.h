@@ -0,0 +1,118 @@
+#ifndef EMIGLIO_BACKTEST_JOB_H
+#define EMIGLIO_BACKTEST_JOB_H
+
+#include "BacktestSimulator.h"
+#include "BacktestResult.h"
+#include "../strategy/RecipeLoader.h"
+#include "../data/DataStorage.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Emiglio {
+namespace Backtest {
+
+// Runs the load -> simulate -> analyze pipeline of one backtest on a
+// background thread. Callbacks are invoked from that thread; UI code should
+// forward them as messages without blocking (the owner may be waiting for
+// the job with its window locked) and read the outcome with getResult()
+// once the finished callback has fired.
+class BacktestJob {
+public:
+	enum class State {
+		IDLE,
+		RUNNING,
+		COMPLETED,
+		CANCELLED,
+		FAILED
+	};
+
+	// Fills 'candles' (e.g. from the database or a download). May call
+	// reportProgress() and should return early when isCancelled() is true.
+	// Return false (or throw) with setError() on failure.
+	using CandleLoader = std::function<bool(BacktestJob& job, std::vector<Candle>& candles)>;
+
+	// (percent 0-100, status text)
+	using ProgressCallback = std::function<void(double, const std::string&)>;
+	using FinishedCallback = std::function<void(State)>;
+
+	BacktestJob(const Recipe& recipe, const BacktestConfig& config);
+	~BacktestJob();  // Cancels and joins a running job
+
+	void setCandleLoader(CandleLoader loader);
+	void setCandles(const std::vector<Candle>& candles);
+
+	// Series for indicators declared on 'timeframe', with history before
+	// the first candle; without one the base candles are resampled. Call
+	// before start() or from the candle loader.
+	void setTimeframeCandles(const std::string& timeframe, const std::vector<Candle>& candles);
+	void setProgressCallback(ProgressCallback callback);
+	void setFinishedCallback(FinishedCallback callback);
+
+	// Look up / store results in BacktestCache (default on)
+	void setUseCache(bool useCache);
+
+	// Start the background thread; false if already started
+	bool start();
+
+	// Request cancellation; the job stops at the next check: after loading,
+	// after indicator pre-calculation, or between blocks of candles
+	void cancel();
+	bool isCancelled() const { return cancelRequested.load(); }
+
+	// Block until the background thread has exited
+	void wait();
+
+	State getState() const { return state.load(); }
+
+	const Recipe& getRecipe() const { return recipe; }
+
+	// Valid once the job has finished
+	const BacktestResult& getResult() const { return result; }
+	const std::vector<Candle>& getCandles() const { return candles; }
+	const std::string& getCacheKey() const { return cacheKey; }
+	bool isCached() const { return cached; }
+	std::string getLastError() const;
+
+	// For candle loaders
+	void reportProgress(double percent, const std::string& status);
+	void setError(const std::string& error);
+
+	BacktestJob(const BacktestJob&) = delete;
+	BacktestJob& operator=(const BacktestJob&) = delete;
+
+private:
+	Recipe recipe;
+	BacktestConfig config;
+
+	CandleLoader candleLoader;
+	ProgressCallback progressCallback;
+	FinishedCallback finishedCallback;
+	bool useCache;
+
+	std::thread worker;
+	std::atomic<bool> cancelRequested;
+	std::atomic<State> state;
+
+	std::vector<Candle> candles;
+	std::map<std::string, std::vector<Candle>> timeframeCandles;
+	BacktestResult result;
+	std::string cacheKey;
+	bool cached;
+
+	mutable std::mutex errorMutex;
+	std::string lastError;
+
+	void run();
+	State execute();
+};
+
+} // namespace Backtest
+} // namespace Emiglio
+
+#endif // EMIGLIO_BACKTEST_JOB_H
@@ -39,6 +39,7 @@ struct BacktestResult {
 	time_t startTime;            // Backtest start
 	time_t endTime;              // Backtest end
 	int totalCandles;            // Number of candles processed
+	bool cancelled;              // Run was aborted; the result is partial
 
 	// Initial state
 	double initialCapital;       // Starting capital
@@ -77,6 +78,7 @@ struct BacktestResult {
 		: startTime(0)
 		, endTime(0)
 		, totalCandles(0)
+		, cancelled(false)
 		, initialCapital(0.0)
 		, finalEquity(0.0)
 		, peakEquity(0.0)
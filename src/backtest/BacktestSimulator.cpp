@@ -11,6 +11,8 @@ BacktestSimulator::BacktestSimulator(const Recipe& recipe, const BacktestConfig&
 	, config(config)
 	, signalGen()
 	, portfolio(config.initialCapital)
+	, progressCallback(nullptr)
+	, progressInterval(1000)
 {
 	signalGen.loadRecipe(recipe);
 	LOG_INFO("BacktestSimulator initialized for strategy: " + recipe.name);
@@ -19,6 +21,15 @@ BacktestSimulator::BacktestSimulator(const Recipe& recipe, const BacktestConfig&
 BacktestSimulator::~BacktestSimulator() {
 }
 
+void BacktestSimulator::setProgressCallback(ProgressCallback callback, size_t interval) {
+	progressCallback = callback;
+	progressInterval = interval > 0 ? interval : 1;
+}
+
+void BacktestSimulator::setTimeframeCandles(const std::string& timeframe, const std::vector<Candle>& candles) {
+	signalGen.setTimeframeCandles(timeframe, candles);
+}
+
 void BacktestSimulator::setCommission(double percent) {
 	config.commissionPercent = percent;
 }
@@ -237,9 +248,22 @@ void BacktestSimulator::processCandle(const Candle& candle, size_t index,
 	updateEquityCurve(candle);
 }
 
+bool BacktestSimulator::reportProgress(size_t processed, size_t total) {
+	if (!progressCallback || progressCallback(processed, total)) {
+		return true;
+	}
+
+	result.cancelled = true;
+	lastError = "Backtest cancelled";
+	LOG_INFO("Backtest cancelled after " + std::to_string(processed) + " of " +
+	         std::to_string(total) + " candles");
+	return false;
+}
+
 BacktestResult BacktestSimulator::run(const std::vector<Candle>& candles) {
 	// Reset result
 	result = BacktestResult();
+	lastError.clear();
 	result.recipeName = recipe.name;
 	result.initialCapital = config.initialCapital;
 
@@ -266,15 +290,29 @@ BacktestResult BacktestSimulator::run(const std::vector<Candle>& candles) {
 	// OPTIMIZATION: Pre-calculate all indicators once (instead of recalculating for each candle)
 	LOG_INFO("Pre-calculating indicators...");
 	if (!signalGen.precalculateIndicators(candles)) {
-		lastError = "Failed to pre-calculate indicators";
+		lastError = "Failed to pre-calculate indicators: " + signalGen.getLastError();
 		LOG_ERROR(lastError);
 		return result;
 	}
 	LOG_INFO("Indicators pre-calculated successfully");
 
-	// Process each candle
-	for (size_t i = 0; i < candles.size(); i++) {
-		processCandle(candles[i], i, candles);
+	// A cancel requested during pre-calculation is seen here
+	const size_t total = candles.size();
+	if (!reportProgress(0, total)) {
+		return result;
+	}
+
+	// Process candles in blocks so the progress hook stays out of the inner loop
+	const size_t blockSize = progressCallback ? progressInterval : total;
+	for (size_t blockStart = 0; blockStart < total; blockStart += blockSize) {
+		size_t blockEnd = std::min(total, blockStart + blockSize);
+		for (size_t i = blockStart; i < blockEnd; i++) {
+			processCandle(candles[i], i, candles);
+		}
+
+		if (!reportProgress(blockEnd, total)) {
+			return result;
+		}
 	}
 
 	// Close any remaining open positions at final price
@@ -7,6 +7,8 @@
 #include "../strategy/RecipeLoader.h"
 #include "../data/DataStorage.h"
 
+#include <functional>
+
 namespace Emiglio {
 namespace Backtest {
 
@@ -32,12 +34,23 @@ struct BacktestConfig {
 // Main backtest simulator
 class BacktestSimulator {
 public:
+	// Called every N candles with (processed, total); return false to cancel
+	using ProgressCallback = std::function<bool(size_t, size_t)>;
+
 	BacktestSimulator(const Recipe& recipe, const BacktestConfig& config);
 	~BacktestSimulator();
 
 	// Run backtest on historical data
 	BacktestResult run(const std::vector<Candle>& candles);
 
+	// Progress/cancellation hook, called with (0, total) once indicators are
+	// pre-calculated and then after every block of 'interval' candles.
+	// Pre-calculation itself can't be interrupted.
+	void setProgressCallback(ProgressCallback callback, size_t interval = 1000);
+
+	// Series for indicators declared on 'timeframe' (see SignalGenerator)
+	void setTimeframeCandles(const std::string& timeframe, const std::vector<Candle>& candles);
+
 	// Configuration setters
 	void setCommission(double percent);
 	void setSlippage(double percent);
@@ -55,6 +68,12 @@ private:
 	BacktestResult result;
 	std::string lastError;
 
+	ProgressCallback progressCallback;
+	size_t progressInterval;
+
+	// Call the progress hook; false (and a cancelled result) if it asks to stop
+	bool reportProgress(size_t processed, size_t total);
+
 	// Processing
 	void processCandle(const Candle& candle, size_t index, const std::vector<Candle>& allCandles);
 	void checkStopLoss(const Candle& candle);
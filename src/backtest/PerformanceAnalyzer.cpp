@@ -8,6 +8,23 @@
 namespace Emiglio {
 namespace Backtest {
 
+namespace {
+
+// A report number; JSON has no NaN or infinity (e.g. the annualized return
+// of a loss over 100%, or the profit factor without losing trades)
+struct JsonNumber {
+	double value;
+};
+
+std::ostream& operator<<(std::ostream& out, JsonNumber number) {
+	if (!std::isfinite(number.value)) {
+		return out << "null";
+	}
+	return out << number.value;
+}
+
+} // namespace
+
 PerformanceAnalyzer::PerformanceAnalyzer() {
 }
 
@@ -367,44 +384,44 @@ std::string PerformanceAnalyzer::generateJSONReport(const BacktestResult& result
 	json << "  \"period\": {\n";
 	json << "    \"startTime\": " << result.startTime << ",\n";
 	json << "    \"endTime\": " << result.endTime << ",\n";
-	json << "    \"durationDays\": " << ((result.endTime - result.startTime) / 86400.0) << ",\n";
+	json << "    \"durationDays\": " << JsonNumber{((result.endTime - result.startTime) / 86400.0)} << ",\n";
 	json << "    \"totalCandles\": " << result.totalCandles << "\n";
 	json << "  },\n";
 
 	json << "  \"capital\": {\n";
-	json << "    \"initial\": " << result.initialCapital << ",\n";
-	json << "    \"final\": " << result.finalEquity << ",\n";
-	json << "    \"peak\": " << result.peakEquity << ",\n";
-	json << "    \"netProfit\": " << (result.finalEquity - result.initialCapital) << "\n";
+	json << "    \"initial\": " << JsonNumber{result.initialCapital} << ",\n";
+	json << "    \"final\": " << JsonNumber{result.finalEquity} << ",\n";
+	json << "    \"peak\": " << JsonNumber{result.peakEquity} << ",\n";
+	json << "    \"netProfit\": " << JsonNumber{(result.finalEquity - result.initialCapital)} << "\n";
 	json << "  },\n";
 
 	json << "  \"returns\": {\n";
-	json << "    \"totalReturn\": " << result.totalReturnPercent << ",\n";
-	json << "    \"annualizedReturn\": " << result.annualizedReturn << "\n";
+	json << "    \"totalReturn\": " << JsonNumber{result.totalReturnPercent} << ",\n";
+	json << "    \"annualizedReturn\": " << JsonNumber{result.annualizedReturn} << "\n";
 	json << "  },\n";
 
 	json << "  \"risk\": {\n";
-	json << "    \"maxDrawdown\": " << result.maxDrawdownPercent << ",\n";
-	json << "    \"maxDrawdownAmount\": " << (result.peakEquity - (result.peakEquity * (1.0 - result.maxDrawdownPercent / 100.0))) << ",\n";
-	json << "    \"sharpeRatio\": " << std::setprecision(3) << result.sharpeRatio << ",\n";
-	json << "    \"sortinoRatio\": " << result.sortinoRatio << "\n";
+	json << "    \"maxDrawdown\": " << JsonNumber{result.maxDrawdownPercent} << ",\n";
+	json << "    \"maxDrawdownAmount\": " << JsonNumber{(result.peakEquity - (result.peakEquity * (1.0 - result.maxDrawdownPercent / 100.0)))} << ",\n";
+	json << "    \"sharpeRatio\": " << std::setprecision(3) << JsonNumber{result.sharpeRatio} << ",\n";
+	json << "    \"sortinoRatio\": " << JsonNumber{result.sortinoRatio} << "\n";
 	json << "  },\n";
 
 	json << "  \"trading\": {\n";
 	json << "    \"totalTrades\": " << result.totalTrades << ",\n";
 	json << "    \"winningTrades\": " << result.winningTrades << ",\n";
 	json << "    \"losingTrades\": " << result.losingTrades << ",\n";
-	json << "    \"winRate\": " << std::setprecision(2) << result.winRate << ",\n";
-	json << "    \"profitFactor\": " << std::setprecision(3) << result.profitFactor << ",\n";
-	json << "    \"expectancy\": " << std::setprecision(2) << result.expectancy << ",\n";
-	json << "    \"averageWin\": " << result.averageWin << ",\n";
-	json << "    \"averageLoss\": " << result.averageLoss << "\n";
+	json << "    \"winRate\": " << std::setprecision(2) << JsonNumber{result.winRate} << ",\n";
+	json << "    \"profitFactor\": " << std::setprecision(3) << JsonNumber{result.profitFactor} << ",\n";
+	json << "    \"expectancy\": " << std::setprecision(2) << JsonNumber{result.expectancy} << ",\n";
+	json << "    \"averageWin\": " << JsonNumber{result.averageWin} << ",\n";
+	json << "    \"averageLoss\": " << JsonNumber{result.averageLoss} << "\n";
 	json << "  },\n";
 
 	json << "  \"costs\": {\n";
-	json << "    \"totalCommission\": " << result.totalCommission << ",\n";
-	json << "    \"totalSlippage\": " << result.totalSlippage << ",\n";
-	json << "    \"totalCosts\": " << (result.totalCommission + result.totalSlippage) << "\n";
+	json << "    \"totalCommission\": " << JsonNumber{result.totalCommission} << ",\n";
+	json << "    \"totalSlippage\": " << JsonNumber{result.totalSlippage} << ",\n";
+	json << "    \"totalCosts\": " << JsonNumber{(result.totalCommission + result.totalSlippage)} << "\n";
 	json << "  },\n";
 
 	// Calculate best/worst trade and streaks
@@ -443,10 +460,10 @@ std::string PerformanceAnalyzer::generateJSONReport(const BacktestResult& result
 	}
 
 	json << "  \"performance\": {\n";
-	json << "    \"bestTrade\": " << bestTrade << ",\n";
-	json << "    \"worstTrade\": " << worstTrade << ",\n";
-	json << "    \"totalWinAmount\": " << totalWinAmount << ",\n";
-	json << "    \"totalLossAmount\": " << totalLossAmount << ",\n";
+	json << "    \"bestTrade\": " << JsonNumber{bestTrade} << ",\n";
+	json << "    \"worstTrade\": " << JsonNumber{worstTrade} << ",\n";
+	json << "    \"totalWinAmount\": " << JsonNumber{totalWinAmount} << ",\n";
+	json << "    \"totalLossAmount\": " << JsonNumber{totalLossAmount} << ",\n";
 	json << "    \"longestWinStreak\": " << longestWinStreak << ",\n";
 	json << "    \"longestLossStreak\": " << longestLossStreak << "\n";
 	json << "  },\n";
@@ -463,11 +480,11 @@ std::string PerformanceAnalyzer::generateJSONReport(const BacktestResult& result
 			json << "      \"id\": \"" << trade.id << "\",\n";
 			json << "      \"entryTime\": " << trade.entryTime << ",\n";
 			json << "      \"exitTime\": " << trade.exitTime << ",\n";
-			json << "      \"entryPrice\": " << trade.entryPrice << ",\n";
-			json << "      \"exitPrice\": " << trade.exitPrice << ",\n";
-			json << "      \"quantity\": " << std::setprecision(6) << trade.quantity << ",\n";
-			json << "      \"pnl\": " << std::setprecision(2) << trade.pnl << ",\n";
-			json << "      \"pnlPercent\": " << (trade.pnl / (trade.entryPrice * trade.quantity) * 100.0) << ",\n";
+			json << "      \"entryPrice\": " << JsonNumber{trade.entryPrice} << ",\n";
+			json << "      \"exitPrice\": " << JsonNumber{trade.exitPrice} << ",\n";
+			json << "      \"quantity\": " << std::setprecision(6) << JsonNumber{trade.quantity} << ",\n";
+			json << "      \"pnl\": " << std::setprecision(2) << JsonNumber{trade.pnl} << ",\n";
+			json << "      \"pnlPercent\": " << JsonNumber{(trade.pnl / (trade.entryPrice * trade.quantity) * 100.0)} << ",\n";
 			json << "      \"exitReason\": \"" << trade.exitReason << "\"\n";
 			json << "    }";
 		}
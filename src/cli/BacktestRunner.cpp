@@ -0,0 +1,499 @@
+// Headless backtest runner
+//
+// Runs one or more recipes against candles from the database or from a
+// CSV/binary candle file and prints the PerformanceAnalyzer JSON reports.
+// Recipes are spread over a pool of worker threads.
+
+#include "../strategy/RecipeLoader.h"
+#include "../strategy/SignalGenerator.h"
+#include "../backtest/BacktestSimulator.h"
+#include "../backtest/PerformanceAnalyzer.h"
+#include "../backtest/BacktestCache.h"
+#include "../data/DataStorage.h"
+#include "../data/CandleFile.h"
+#include "../data/CandleResampler.h"
+#include "../utils/Logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+using namespace Emiglio;
+
+namespace {
+
+struct Options {
+	std::vector<std::string> recipes;
+	std::string dbPath = "/boot/home/Emiglio/data/emilio.db";
+	std::string candlesFile;
+	std::string symbol;
+	std::string timeframe;
+	std::string startDate;
+	std::string endDate;
+	std::string outputFile;
+	std::string logFile;
+	double capital = 0.0;               // 0 = use recipe capital
+	double commissionPercent = 0.1;
+	double slippagePercent = 0.05;
+	unsigned int jobs = 0;              // 0 = hardware concurrency
+	bool useCache = true;
+	bool quiet = false;
+};
+
+// One recipe to run, with its outcome
+struct Job {
+	std::string recipeFile;
+	Recipe recipe;
+	std::string seriesKey;              // Key into the loaded candle series
+	std::map<std::string, std::string> timeframeKeys;  // Higher timeframe -> series key
+	bool ok = false;
+	bool cached = false;
+	double elapsedMs = 0.0;
+	std::string report;
+	std::string error;
+};
+
+void printUsage(const char* program) {
+	std::cerr <<
+		"Usage: " << program << " [options] <recipe.json|directory>...\n"
+		"\n"
+		"Candle source:\n"
+		"  --db PATH            SQLite database (default /boot/home/Emiglio/data/emilio.db)\n"
+		"  --candles FILE       CSV or .bin candle file instead of the database\n"
+		"  --symbol SYMBOL      Override recipe symbol (e.g. BTCUSDT)\n"
+		"  --timeframe TF       Override recipe timeframe / timeframe of --candles\n"
+		"  --start YYYY-MM-DD   Start date (default: 365 days before --end)\n"
+		"  --end YYYY-MM-DD     End date (default: now)\n"
+		"\n"
+		"Simulation:\n"
+		"  --capital N          Initial capital (default: recipe capital)\n"
+		"  --commission PCT     Commission percent per trade (default 0.1)\n"
+		"  --slippage PCT       Slippage percent per trade (default 0.05)\n"
+		"  --no-cache           Always simulate, ignore the backtest cache\n"
+		"\n"
+		"Execution:\n"
+		"  -j, --jobs N         Worker threads (default: number of cores)\n"
+		"  -o, --output FILE    Write JSON to FILE instead of stdout\n"
+		"  --log FILE           Write the engine log to FILE\n"
+		"  -q, --quiet          No progress on stderr\n";
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto next = [&](std::string& out) {
+			if (i + 1 >= argc) {
+				std::cerr << "Missing value for " << arg << std::endl;
+				return false;
+			}
+			out = argv[++i];
+			return true;
+		};
+		std::string value;
+
+		if (arg == "-h" || arg == "--help") {
+			return false;
+		} else if (arg == "--db") {
+			if (!next(options.dbPath)) return false;
+		} else if (arg == "--candles") {
+			if (!next(options.candlesFile)) return false;
+		} else if (arg == "--symbol") {
+			if (!next(options.symbol)) return false;
+		} else if (arg == "--timeframe") {
+			if (!next(options.timeframe)) return false;
+		} else if (arg == "--start") {
+			if (!next(options.startDate)) return false;
+		} else if (arg == "--end") {
+			if (!next(options.endDate)) return false;
+		} else if (arg == "-o" || arg == "--output") {
+			if (!next(options.outputFile)) return false;
+		} else if (arg == "--log") {
+			if (!next(options.logFile)) return false;
+		} else if (arg == "--capital") {
+			if (!next(value)) return false;
+			options.capital = std::atof(value.c_str());
+		} else if (arg == "--commission") {
+			if (!next(value)) return false;
+			options.commissionPercent = std::atof(value.c_str());
+		} else if (arg == "--slippage") {
+			if (!next(value)) return false;
+			options.slippagePercent = std::atof(value.c_str());
+		} else if (arg == "-j" || arg == "--jobs") {
+			if (!next(value)) return false;
+			options.jobs = static_cast<unsigned int>(std::atoi(value.c_str()));
+		} else if (arg == "--no-cache") {
+			options.useCache = false;
+		} else if (arg == "-q" || arg == "--quiet") {
+			options.quiet = true;
+		} else if (!arg.empty() && arg[0] == '-') {
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return false;
+		} else {
+			options.recipes.push_back(arg);
+		}
+	}
+
+	if (options.recipes.empty()) {
+		std::cerr << "No recipes given" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// Local midnight of a YYYY-MM-DD date, as in BacktestView
+bool parseDate(const std::string& text, bool endOfDay, time_t& out) {
+	struct tm tm = {};
+	if (sscanf(text.c_str(), "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday) != 3) {
+		return false;
+	}
+	tm.tm_year -= 1900;
+	tm.tm_mon -= 1;
+	tm.tm_hour = endOfDay ? 23 : 0;
+	tm.tm_min = endOfDay ? 59 : 0;
+	tm.tm_sec = endOfDay ? 59 : 0;
+	tm.tm_isdst = -1;
+	out = std::mktime(&tm);
+	return out != static_cast<time_t>(-1);
+}
+
+// Expand directories to the *.json recipes they contain
+std::vector<std::string> expandRecipePaths(const std::vector<std::string>& paths) {
+	namespace fs = std::filesystem;
+	std::vector<std::string> files;
+
+	for (const auto& path : paths) {
+		std::error_code ec;
+		if (fs::is_directory(path, ec)) {
+			std::vector<std::string> found;
+			for (const auto& entry : fs::directory_iterator(path, ec)) {
+				if (entry.is_regular_file() && entry.path().extension() == ".json") {
+					found.push_back(entry.path().string());
+				}
+			}
+			std::sort(found.begin(), found.end());
+			files.insert(files.end(), found.begin(), found.end());
+		} else {
+			files.push_back(path);
+		}
+	}
+
+	return files;
+}
+
+// "BTC/USDT" -> "BTCUSDT", the form candles are stored under
+std::string normalizeSymbol(std::string symbol) {
+	symbol.erase(std::remove(symbol.begin(), symbol.end(), '/'), symbol.end());
+	return symbol;
+}
+
+// JSON string escaping for file names and error messages
+std::string jsonEscape(const std::string& value) {
+	std::string out;
+	out.reserve(value.size() + 2);
+	for (char c : value) {
+		switch (c) {
+			case '"':  out += "\\\""; break;
+			case '\\': out += "\\\\"; break;
+			case '\n': out += "\\n"; break;
+			case '\t': out += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char buffer[8];
+					snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+					out += buffer;
+				} else {
+					out += c;
+				}
+		}
+	}
+	return out;
+}
+
+// Load a series from the database, falling back to resampled 1m candles
+std::vector<Candle> loadFromDatabase(DataStorage& storage, const Recipe& recipe, const std::string& timeframe,
+                                     time_t startTime, time_t endTime) {
+	std::vector<Candle> candles = storage.getCandles(recipe.market.exchange, recipe.market.symbol,
+	                                                 timeframe, startTime, endTime);
+
+	if (candles.empty() && timeframe != "1m" && CandleResampler::canResample("1m", timeframe)) {
+		candles = CandleResampler::loadResampled(storage, recipe.market.exchange, recipe.market.symbol,
+		                                         timeframe, startTime, endTime);
+	}
+
+	return candles;
+}
+
+void runJob(Job& job, const std::map<std::string, std::vector<Candle>>& series, const Options& options) {
+	auto started = std::chrono::steady_clock::now();
+	const std::vector<Candle>& candles = series.at(job.seriesKey);
+
+	// Higher timeframe series with their warm-up history; indicators on
+	// timeframes without one use the base candles resampled
+	std::map<std::string, std::vector<Candle>> timeframeCandles;
+	for (const auto& [timeframe, key] : job.timeframeKeys) {
+		const std::vector<Candle>& higher = series.at(key);
+		if (!higher.empty()) {
+			timeframeCandles[timeframe] = higher;
+		}
+	}
+
+	if (candles.size() < 50) {
+		job.error = "Not enough candles (" + std::to_string(candles.size()) + ") for " +
+		            job.recipe.market.symbol + " " + job.recipe.market.timeframe;
+		return;
+	}
+
+	Backtest::BacktestConfig config;
+	config.initialCapital = options.capital > 0 ? options.capital :
+	                        (job.recipe.capital.initial > 0 ? job.recipe.capital.initial : config.initialCapital);
+	config.commissionPercent = options.commissionPercent / 100.0;
+	config.slippagePercent = options.slippagePercent / 100.0;
+	config.useStopLoss = true;
+	config.useTakeProfit = true;
+	config.maxOpenPositions = job.recipe.risk.maxOpenPositions;
+
+	Backtest::BacktestCache& cache = Backtest::BacktestCache::getInstance();
+	std::string cacheKey;
+	Backtest::BacktestResult result;
+
+	if (options.useCache) {
+		cacheKey = Backtest::BacktestCache::computeKey(job.recipe, config, candles, timeframeCandles);
+		job.cached = cache.get(cacheKey, result);
+	}
+
+	Backtest::PerformanceAnalyzer analyzer;
+	if (!job.cached) {
+		Backtest::BacktestSimulator simulator(job.recipe, config);
+		for (const auto& [timeframe, higher] : timeframeCandles) {
+			simulator.setTimeframeCandles(timeframe, higher);
+		}
+		result = simulator.run(candles);
+		if (!simulator.getLastError().empty()) {
+			job.error = simulator.getLastError();
+			return;
+		}
+		analyzer.analyze(result);
+
+		if (options.useCache) {
+			cache.put(cacheKey, result);
+		}
+	}
+
+	job.report = analyzer.generateJSONReport(result);
+	job.ok = true;
+	job.elapsedMs = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - started).count();
+}
+
+void writeOutput(std::ostream& out, const std::vector<Job>& jobs) {
+	out << "{\n  \"results\": [";
+	bool first = true;
+	for (const auto& job : jobs) {
+		if (!job.ok) continue;
+		out << (first ? "\n" : ",\n");
+		first = false;
+		out << "    {\n";
+		out << "      \"recipeFile\": \"" << jsonEscape(job.recipeFile) << "\",\n";
+		out << "      \"cached\": " << (job.cached ? "true" : "false") << ",\n";
+		out << "      \"elapsedMs\": " << job.elapsedMs << ",\n";
+		out << "      \"report\": " << job.report << "\n";
+		out << "    }";
+	}
+	out << "\n  ],\n  \"errors\": [";
+	first = true;
+	for (const auto& job : jobs) {
+		if (job.ok) continue;
+		out << (first ? "\n" : ",\n");
+		first = false;
+		out << "    {\"recipeFile\": \"" << jsonEscape(job.recipeFile) << "\", "
+		    << "\"error\": \"" << jsonEscape(job.error) << "\"}";
+	}
+	out << "\n  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseArgs(argc, argv, options)) {
+		printUsage(argv[0]);
+		return 2;
+	}
+
+	// Keep stdout clean for the JSON output; without --log only errors
+	// reach stderr
+	if (options.logFile.empty()) {
+		Logger::getInstance().init("/dev/null", LogLevel::ERROR);
+	} else {
+		Logger::getInstance().init(options.logFile);
+	}
+
+	// Date range
+	time_t endTime = std::time(nullptr);
+	if (!options.endDate.empty() && !parseDate(options.endDate, true, endTime)) {
+		std::cerr << "Invalid end date: " << options.endDate << std::endl;
+		return 2;
+	}
+	time_t startTime = endTime - 365 * 24 * 3600;
+	if (!options.startDate.empty() && !parseDate(options.startDate, false, startTime)) {
+		std::cerr << "Invalid start date: " << options.startDate << std::endl;
+		return 2;
+	}
+	if (startTime >= endTime) {
+		std::cerr << "Start date must be before end date" << std::endl;
+		return 2;
+	}
+
+	// Load recipes
+	std::vector<Job> jobs;
+	for (const auto& file : expandRecipePaths(options.recipes)) {
+		Job job;
+		job.recipeFile = file;
+
+		RecipeLoader loader;
+		if (!loader.loadFromFile(file, job.recipe)) {
+			job.error = loader.getLastError();
+		} else {
+			if (!options.symbol.empty()) job.recipe.market.symbol = options.symbol;
+			if (!options.timeframe.empty()) job.recipe.market.timeframe = options.timeframe;
+			job.recipe.market.symbol = normalizeSymbol(job.recipe.market.symbol);
+			job.seriesKey = options.candlesFile.empty() ?
+				job.recipe.market.exchange + "|" + job.recipe.market.symbol + "|" + job.recipe.market.timeframe :
+				options.candlesFile;
+		}
+		jobs.push_back(std::move(job));
+	}
+
+	// Load each distinct candle series once; workers share them read-only
+	std::map<std::string, std::vector<Candle>> series;
+	if (!options.candlesFile.empty()) {
+		CandleFile file;
+		std::vector<Candle> candles;
+		std::string symbol = normalizeSymbol(options.symbol);
+		if (!file.load(options.candlesFile, candles, "binance", symbol, options.timeframe)) {
+			std::cerr << file.getLastError() << std::endl;
+			return 1;
+		}
+
+		// Honour the date range only when it was given explicitly
+		if (!options.startDate.empty() || !options.endDate.empty()) {
+			candles.erase(std::remove_if(candles.begin(), candles.end(), [&](const Candle& c) {
+				return c.timestamp < startTime || c.timestamp > endTime;
+			}), candles.end());
+		}
+		series[options.candlesFile] = std::move(candles);
+	} else {
+		DataStorage storage;
+		if (!storage.init(options.dbPath)) {
+			std::cerr << "Failed to open database: " << options.dbPath << std::endl;
+			return 1;
+		}
+
+		for (auto& job : jobs) {
+			if (job.seriesKey.empty()) continue;
+			if (!series.count(job.seriesKey)) {
+				series[job.seriesKey] = loadFromDatabase(storage, job.recipe, job.recipe.market.timeframe,
+				                                         startTime, endTime);
+				if (!options.quiet) {
+					std::cerr << "Loaded " << series[job.seriesKey].size() << " candles for "
+					          << job.recipe.market.symbol << " " << job.recipe.market.timeframe << std::endl;
+				}
+			}
+
+			// Higher timeframe indicators start with enough history to be
+			// warmed up at the first base candle
+			for (const auto& [timeframe, warmup] : SignalGenerator::getTimeframeWarmup(job.recipe)) {
+				time_t from = startTime - static_cast<time_t>(warmup) * CandleResampler::timeframeToSeconds(timeframe);
+				std::string key = job.seriesKey + "|" + timeframe + "|" + std::to_string(from);
+				job.timeframeKeys[timeframe] = key;
+				if (!series.count(key)) {
+					series[key] = loadFromDatabase(storage, job.recipe, timeframe, from, endTime);
+					if (!options.quiet) {
+						std::cerr << "Loaded " << series[key].size() << " candles for "
+						          << job.recipe.market.symbol << " " << timeframe << std::endl;
+					}
+				}
+			}
+		}
+
+		if (options.useCache) {
+			Backtest::BacktestCache::getInstance().init(options.dbPath);
+		}
+	}
+
+	// Run recipes on a worker pool
+	unsigned int workers = options.jobs > 0 ? options.jobs : std::thread::hardware_concurrency();
+	if (workers == 0) workers = 1;
+	workers = std::min<unsigned int>(workers, static_cast<unsigned int>(std::max<size_t>(jobs.size(), 1)));
+
+	std::atomic<size_t> nextJob(0);
+	std::atomic<size_t> finished(0);
+	std::mutex progressMutex;
+	auto started = std::chrono::steady_clock::now();
+
+	auto worker = [&]() {
+		size_t index;
+		while ((index = nextJob.fetch_add(1)) < jobs.size()) {
+			Job& job = jobs[index];
+			if (job.error.empty()) {
+				runJob(job, series, options);
+			}
+
+			size_t done = ++finished;
+			if (!options.quiet) {
+				std::lock_guard<std::mutex> lock(progressMutex);
+				std::cerr << "[" << done << "/" << jobs.size() << "] "
+				          << (job.ok ? (job.cached ? "cached " : "done   ") : "failed ")
+				          << job.recipeFile;
+				if (!job.ok) std::cerr << ": " << job.error;
+				std::cerr << std::endl;
+			}
+		}
+	};
+
+	// The series map is only read from here on
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < workers; i++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	double totalMs = std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now() - started).count();
+
+	if (options.outputFile.empty()) {
+		writeOutput(std::cout, jobs);
+	} else {
+		std::ofstream out(options.outputFile);
+		if (!out.is_open()) {
+			std::cerr << "Failed to open output file: " << options.outputFile << std::endl;
+			return 1;
+		}
+		writeOutput(out, jobs);
+	}
+
+	size_t failed = std::count_if(jobs.begin(), jobs.end(), [](const Job& job) { return !job.ok; });
+	if (!options.quiet) {
+		std::cerr << jobs.size() - failed << " of " << jobs.size() << " recipes completed in "
+		          << static_cast<long>(totalMs) << " ms using " << workers << " threads" << std::endl;
+	}
+
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+// Bulk candle importer
+//
+// Loads Binance public kline dumps (data.binance.vision .zip files, or the
+// CSV files inside them) into the database, adding only candles the series
+// doesn't have yet. Symbol and timeframe are read from the file names.
+
+#include "../data/DataStorage.h"
+#include "../data/CandleImporter.h"
+#include "../utils/Logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace Emiglio;
+
+namespace {
+
+struct Options {
+	std::vector<std::string> inputs;
+	std::string dbPath = "/boot/home/Emiglio/data/emilio.db";
+	std::string exchange = "binance";
+	std::string symbol;
+	std::string timeframe;
+	std::string logFile;
+	unsigned int threads = 0;           // 0 = hardware concurrency
+	bool quiet = false;
+};
+
+void printUsage(const char* program) {
+	std::cerr <<
+		"Usage: " << program << " [options] <file.zip|file.csv|directory>...\n"
+		"\n"
+		"Imports kline dumps such as BTCUSDT-1m-2024-01.zip from data.binance.vision.\n"
+		"Directories are searched for .zip and .csv files, imported in name order.\n"
+		"\n"
+		"Options:\n"
+		"  --db PATH            SQLite database (default /boot/home/Emiglio/data/emilio.db)\n"
+		"  --exchange NAME      Exchange to store the candles under (default binance)\n"
+		"  --symbol SYMBOL      Symbol of all files, instead of their names\n"
+		"  --timeframe TF       Timeframe of all files, instead of their names\n"
+		"  -j, --threads N      Parsing threads (default: number of cores)\n"
+		"  --log FILE           Write the engine log to FILE\n"
+		"  -q, --quiet          No progress on stderr\n";
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto next = [&](std::string& out) {
+			if (i + 1 >= argc) {
+				std::cerr << "Missing value for " << arg << std::endl;
+				return false;
+			}
+			out = argv[++i];
+			return true;
+		};
+		std::string value;
+
+		if (arg == "-h" || arg == "--help") {
+			return false;
+		} else if (arg == "--db") {
+			if (!next(options.dbPath)) return false;
+		} else if (arg == "--exchange") {
+			if (!next(options.exchange)) return false;
+		} else if (arg == "--symbol") {
+			if (!next(options.symbol)) return false;
+		} else if (arg == "--timeframe") {
+			if (!next(options.timeframe)) return false;
+		} else if (arg == "--log") {
+			if (!next(options.logFile)) return false;
+		} else if (arg == "-j" || arg == "--threads") {
+			if (!next(value)) return false;
+			options.threads = static_cast<unsigned int>(std::atoi(value.c_str()));
+		} else if (arg == "-q" || arg == "--quiet") {
+			options.quiet = true;
+		} else if (!arg.empty() && arg[0] == '-') {
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return false;
+		} else {
+			options.inputs.push_back(arg);
+		}
+	}
+
+	if (options.inputs.empty()) {
+		std::cerr << "No files given" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// Expand directories to the dumps they contain; names sort by date
+std::vector<std::string> expandInputs(const std::vector<std::string>& inputs) {
+	namespace fs = std::filesystem;
+	std::vector<std::string> files;
+
+	for (const auto& input : inputs) {
+		std::error_code ec;
+		if (fs::is_directory(input, ec)) {
+			std::vector<std::string> found;
+			for (const auto& entry : fs::recursive_directory_iterator(input, ec)) {
+				std::string extension = entry.path().extension().string();
+				if (entry.is_regular_file() && (extension == ".zip" || extension == ".csv")) {
+					found.push_back(entry.path().string());
+				}
+			}
+			std::sort(found.begin(), found.end());
+			files.insert(files.end(), found.begin(), found.end());
+		} else {
+			files.push_back(input);
+		}
+	}
+
+	return files;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseArgs(argc, argv, options)) {
+		printUsage(argv[0]);
+		return 2;
+	}
+
+	if (options.logFile.empty()) {
+		Logger::getInstance().init("/dev/null", LogLevel::ERROR);
+	} else {
+		Logger::getInstance().init(options.logFile);
+	}
+
+	std::vector<std::string> files = expandInputs(options.inputs);
+	if (files.empty()) {
+		std::cerr << "No .zip or .csv files found" << std::endl;
+		return 1;
+	}
+
+	DataStorage storage;
+	if (!storage.init(options.dbPath)) {
+		std::cerr << "Failed to open database: " << options.dbPath << std::endl;
+		return 1;
+	}
+
+	CandleImporter importer(storage);
+	importer.setExchange(options.exchange);
+	importer.setParseThreads(options.threads);
+
+	size_t done = 0;
+	size_t failed = 0;
+	importer.setProgressCallback([&](const std::string& path, const CandleImporter::Stats& stats) {
+		done++;
+		if (stats.failedFiles > failed) {
+			failed = stats.failedFiles;
+			std::cerr << "[" << done << "/" << files.size() << "] " << path << ": "
+			          << importer.getLastError() << std::endl;
+		} else if (!options.quiet) {
+			std::cerr << "[" << done << "/" << files.size() << "] " << path << std::endl;
+		}
+	});
+
+	bool ok = importer.importFiles(files, options.symbol, options.timeframe);
+
+	const CandleImporter::Stats& stats = importer.getStats();
+	if (!options.quiet) {
+		double rate = stats.seconds > 0 ? stats.parsed / stats.seconds : 0.0;
+		fprintf(stderr, "Imported %llu candles (%llu already stored) from %zu files in %.1fs, %.0f candles/s\n",
+		        static_cast<unsigned long long>(stats.inserted),
+		        static_cast<unsigned long long>(stats.skipped),
+		        stats.files, stats.seconds, rate);
+		if (stats.malformedLines > 0) {
+			fprintf(stderr, "Skipped %llu malformed lines\n",
+			        static_cast<unsigned long long>(stats.malformedLines));
+		}
+	}
+
+	storage.close();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,1328 @@
+#include "MockBinanceServer.h"
+#include "../data/CandleResampler.h"
+#include "../utils/JsonParser.h"
+#include "../utils/Logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace Emiglio {
+
+namespace {
+
+const char* kWebSocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC11B85";
+const double kTickSize = 0.01;
+const int kDefaultKlineLimit = 500;
+const int kMaxKlineLimit = 1000;
+const int kMaxRequestSize = 64 * 1024;
+const int64_t kDayMs = 24LL * 3600 * 1000;
+const int kSlowDepthIntervalMs = 1000;   // Plain <symbol>@depth
+const size_t kMaxControlMessagesPerSecond = 5;
+const size_t kMaxTradesPerStep = 100000;
+
+int64_t nowMs() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+uint64_t mix(uint64_t z) {
+	z += 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1), a pure function of 'hash'
+double unit(uint64_t hash) {
+	return (mix(hash) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+uint64_t hashString(const std::string& text) {
+	uint64_t hash = 1469598103934665603ULL;
+	for (unsigned char c : text) {
+		hash = (hash ^ c) * 1099511628211ULL;
+	}
+	return hash;
+}
+
+std::string toLower(std::string text) {
+	std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+	return text;
+}
+
+std::string toUpper(std::string text) {
+	std::transform(text.begin(), text.end(), text.begin(), ::toupper);
+	return text;
+}
+
+std::string number(double value, int decimals) {
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+	return buffer;
+}
+
+std::string quoted(double value, int decimals) {
+	return "\"" + number(value, decimals) + "\"";
+}
+
+double roundToTick(double price) {
+	return std::round(price / kTickSize) * kTickSize;
+}
+
+bool sendAll(int fd, const char* data, size_t length) {
+	while (length > 0) {
+		ssize_t sent = ::send(fd, data, length, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR) {
+			continue;
+		}
+		if (sent <= 0) {
+			return false;
+		}
+		data += sent;
+		length -= sent;
+	}
+	return true;
+}
+
+bool recvAll(int fd, void* buffer, size_t length) {
+	char* out = static_cast<char*>(buffer);
+	while (length > 0) {
+		ssize_t received = ::recv(fd, out, length, 0);
+		if (received < 0 && errno == EINTR) {
+			continue;
+		}
+		if (received <= 0) {
+			return false;
+		}
+		out += received;
+		length -= received;
+	}
+	return true;
+}
+
+// Unmasked server frame
+void appendFrame(std::string& out, uint8_t opcode, const std::string& payload) {
+	out += static_cast<char>(0x80 | opcode);
+	if (payload.size() < 126) {
+		out += static_cast<char>(payload.size());
+	} else if (payload.size() < 65536) {
+		out += static_cast<char>(126);
+		out += static_cast<char>((payload.size() >> 8) & 0xFF);
+		out += static_cast<char>(payload.size() & 0xFF);
+	} else {
+		out += static_cast<char>(127);
+		for (int i = 7; i >= 0; i--) {
+			out += static_cast<char>((static_cast<uint64_t>(payload.size()) >> (i * 8)) & 0xFF);
+		}
+	}
+	out += payload;
+}
+
+std::string acceptKey(const std::string& key) {
+	std::string input = key + kWebSocketGuid;
+	unsigned char digest[SHA_DIGEST_LENGTH];
+	SHA1(reinterpret_cast<const unsigned char*>(input.data()), input.size(), digest);
+	unsigned char encoded[64];
+	int length = EVP_EncodeBlock(encoded, digest, SHA_DIGEST_LENGTH);
+	return std::string(reinterpret_cast<char*>(encoded), length);
+}
+
+std::map<std::string, std::string> parseQuery(const std::string& query) {
+	std::map<std::string, std::string> params;
+	size_t pos = 0;
+	while (pos < query.size()) {
+		size_t end = query.find('&', pos);
+		if (end == std::string::npos) {
+			end = query.size();
+		}
+		std::string pair = query.substr(pos, end - pos);
+		size_t equals = pair.find('=');
+		if (equals != std::string::npos) {
+			params[pair.substr(0, equals)] = pair.substr(equals + 1);
+		}
+		pos = end + 1;
+	}
+	return params;
+}
+
+const char* statusText(int status) {
+	switch (status) {
+		case 101: return "Switching Protocols";
+		case 200: return "OK";
+		case 400: return "Bad Request";
+		case 404: return "Not Found";
+		case 429: return "Too Many Requests";
+		default: return "Error";
+	}
+}
+
+std::string errorBody(int code, const std::string& message) {
+	return "{\"code\":" + std::to_string(code) + ",\"msg\":\"" + message + "\"}";
+}
+
+} // namespace
+
+class MockBinanceServer::Impl {
+public:
+	typedef std::map<int64_t, double, std::greater<int64_t>> BidLevels;  // Price ticks, best first
+	typedef std::map<int64_t, double> AskLevels;
+
+	// Changes of one depth stream since its last message
+	struct DepthFeed {
+		int64_t firstUpdateId = 0;
+		int64_t nextDue = 0;
+		std::map<int64_t, double> bids;
+		std::map<int64_t, double> asks;
+	};
+
+	// Open kline of one subscribed interval
+	struct KlineState {
+		int64_t lengthMs = 0;
+		int64_t openTime = 0;
+		double open = 0, high = 0, low = 0, close = 0;
+		double volume = 0, quoteVolume = 0;
+		int64_t trades = 0;
+		int64_t firstTradeId = -1, lastTradeId = -1;
+		int64_t nextPush = 0;
+	};
+
+	struct Market {
+		std::string symbol;
+		std::string stream;  // Lowercase stream prefix
+		uint64_t hash = 0;
+		double basePrice = 0;
+
+		double lastPrice = 0;
+		double tradeBudget = 0;
+		int64_t nextTradeId = 1;
+		double volume = 0, quoteVolume = 0;  // Since start, for the ticker
+
+		int64_t updateId = 1000;
+		BidLevels bids;
+		AskLevels asks;
+		int64_t nextBookChange = 0;
+		DepthFeed fastDepth;
+		DepthFeed slowDepth;
+
+		std::map<std::string, KlineState> klines;  // By interval
+		int64_t nextTicker = 0;
+	};
+
+	struct StreamConnection {
+		int fd = -1;
+		bool combined = true;               // /stream wraps data, /ws doesn't
+		std::set<std::string> streams;      // Guarded by mutex
+		std::string outbox;                 // Guarded by mutex
+		std::vector<int64_t> controlTimes;  // Reader thread only
+		std::mutex writeMutex;
+		bool open = true;                   // Guarded by writeMutex
+	};
+
+	MockServerConfig config;
+	int listenFd;
+	int port;
+	std::atomic<bool> running;
+	std::thread acceptThread;
+	std::thread marketThread;
+	std::string lastError;
+
+	// Markets, subscriptions and outboxes
+	std::mutex mutex;
+	std::vector<Market> markets;
+	std::vector<std::shared_ptr<StreamConnection>> connections;
+	std::map<std::string, int> subscribers;  // Stream -> connection count
+	std::map<std::string, std::vector<Candle>> datasets;  // "SYMBOL|interval"
+
+	// Connection workers run detached; stop() waits for them
+	std::mutex workerMutex;
+	std::condition_variable workersDone;
+	std::set<int> activeFds;
+	int workers;
+
+	std::mutex weightMutex;
+	int64_t weightMinute;
+	int usedWeight;
+
+	std::atomic<uint64_t> requestCount;
+	std::atomic<uint64_t> rateLimitedCount;
+	std::atomic<uint64_t> messagesSent;
+
+	explicit Impl(const MockServerConfig& serverConfig)
+		: config(serverConfig)
+		, listenFd(-1)
+		, port(0)
+		, running(false)
+		, workers(0)
+		, weightMinute(0)
+		, usedWeight(0)
+		, requestCount(0)
+		, rateLimitedCount(0)
+		, messagesSent(0) {
+		double price = config.basePrice;
+		for (const auto& symbol : config.symbols) {
+			Market market;
+			market.symbol = toUpper(symbol);
+			market.stream = toLower(symbol);
+			market.hash = hashString(market.symbol) ^ mix(config.seed);
+			market.basePrice = price;
+			price = std::max(0.1, price / 2.0);
+			markets.push_back(market);
+		}
+	}
+
+	// Deterministic price path: slow weekly and hourly swings plus a small
+	// per-minute wiggle, phase-shifted per symbol
+	double priceAt(const Market& market, int64_t ms) const {
+		const double kTwoPi = 6.283185307179586;
+		double t = ms / 1000.0;
+		double phase = unit(market.hash) * kTwoPi;
+		double factor = 1.0 +
+			0.05 * std::sin(kTwoPi * t / (7 * 86400.0) + phase) +
+			0.01 * std::sin(kTwoPi * t / 3600.0 + 2 * phase) +
+			0.002 * std::sin(kTwoPi * t / 60.0 + 3 * phase);
+		return roundToTick(market.basePrice * factor);
+	}
+
+	Candle generateCandle(const Market& market, const std::string& interval, int64_t openMs, int64_t lengthMs) const {
+		uint64_t hash = market.hash ^ mix(static_cast<uint64_t>(openMs) * 31 + lengthMs);
+		Candle candle;
+		candle.exchange = "binance";
+		candle.symbol = market.symbol;
+		candle.timeframe = interval;
+		candle.timestamp = static_cast<time_t>(openMs / 1000);
+		candle.open = priceAt(market, openMs);
+		candle.close = priceAt(market, openMs + lengthMs);
+		candle.high = roundToTick(std::max(candle.open, candle.close) * (1.0 + 0.002 * unit(hash + 1)));
+		candle.low = roundToTick(std::min(candle.open, candle.close) * (1.0 - 0.002 * unit(hash + 2)));
+		candle.volume = lengthMs / 60000.0 * (5.0 + 20.0 * unit(hash + 3));
+		return candle;
+	}
+
+	Market* findMarket(const std::string& symbol) {
+		std::string upper = toUpper(symbol);
+		for (auto& market : markets) {
+			if (market.symbol == upper) {
+				return &market;
+			}
+		}
+		return nullptr;
+	}
+
+	// Market whose streams 'stream' belongs to, nullptr if none
+	Market* marketOfStream(const std::string& stream) {
+		size_t at = stream.find('@');
+		return at == std::string::npos ? nullptr : findMarket(stream.substr(0, at));
+	}
+
+	// --- Lifecycle ---
+
+	bool start() {
+		if (running) {
+			return true;
+		}
+		signal(SIGPIPE, SIG_IGN);
+
+		listenFd = socket(AF_INET, SOCK_STREAM, 0);
+		if (listenFd < 0) {
+			lastError = "Failed to create socket: " + std::string(strerror(errno));
+			return false;
+		}
+		int yes = 1;
+		setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(static_cast<uint16_t>(config.port));
+		if (inet_pton(AF_INET, config.bindAddress.c_str(), &addr.sin_addr) != 1) {
+			lastError = "Invalid bind address: " + config.bindAddress;
+			close(listenFd);
+			listenFd = -1;
+			return false;
+		}
+		if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+		    listen(listenFd, 128) != 0) {
+			lastError = "Failed to listen on " + config.bindAddress + ":" +
+			            std::to_string(config.port) + ": " + strerror(errno);
+			close(listenFd);
+			listenFd = -1;
+			return false;
+		}
+		socklen_t length = sizeof(addr);
+		getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &length);
+		port = ntohs(addr.sin_port);
+
+		running = true;
+		acceptThread = std::thread(&Impl::acceptLoop, this);
+		marketThread = std::thread(&Impl::marketLoop, this);
+		LOG_INFO("Mock Binance server listening on " + config.bindAddress + ":" + std::to_string(port));
+		return true;
+	}
+
+	void stop() {
+		if (!running) {
+			return;
+		}
+		running = false;
+		::shutdown(listenFd, SHUT_RDWR);
+		if (acceptThread.joinable()) {
+			acceptThread.join();
+		}
+		if (marketThread.joinable()) {
+			marketThread.join();
+		}
+
+		// Unblock the connection workers and wait for them
+		std::unique_lock<std::mutex> lock(workerMutex);
+		for (int fd : activeFds) {
+			::shutdown(fd, SHUT_RDWR);
+		}
+		workersDone.wait(lock, [this]() { return workers == 0; });
+		lock.unlock();
+
+		close(listenFd);
+		listenFd = -1;
+		LOG_INFO("Mock Binance server stopped");
+	}
+
+	void acceptLoop() {
+		while (running) {
+			int fd = accept(listenFd, nullptr, nullptr);
+			if (fd < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return;
+			}
+			if (!running) {
+				close(fd);
+				return;
+			}
+
+			int yes = 1;
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+			{
+				std::lock_guard<std::mutex> lock(workerMutex);
+				activeFds.insert(fd);
+				workers++;
+			}
+			std::thread(&Impl::serveConnection, this, fd).detach();
+		}
+	}
+
+	void serveConnection(int fd) {
+		std::string request;
+		if (readRequest(fd, request)) {
+			requestCount++;
+			handleRequest(fd, request);
+		}
+
+		std::lock_guard<std::mutex> lock(workerMutex);
+		activeFds.erase(fd);
+		close(fd);
+		workers--;
+		workersDone.notify_all();
+	}
+
+	// Request line and headers
+	bool readRequest(int fd, std::string& request) {
+		char buffer[4096];
+		while (request.find("\r\n\r\n") == std::string::npos) {
+			if (request.size() > static_cast<size_t>(kMaxRequestSize)) {
+				return false;
+			}
+			ssize_t received = ::recv(fd, buffer, sizeof(buffer), 0);
+			if (received <= 0) {
+				return false;
+			}
+			request.append(buffer, received);
+		}
+		return true;
+	}
+
+	void handleRequest(int fd, const std::string& request) {
+		size_t lineEnd = request.find("\r\n");
+		std::string line = request.substr(0, lineEnd);
+		size_t firstSpace = line.find(' ');
+		size_t secondSpace = line.find(' ', firstSpace + 1);
+		if (firstSpace == std::string::npos || secondSpace == std::string::npos) {
+			respond(fd, 400, errorBody(-1100, "Malformed request."), "");
+			return;
+		}
+		std::string target = line.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+		std::string path = target.substr(0, target.find('?'));
+		std::string query = target.size() > path.size() ? target.substr(path.size() + 1) : "";
+
+		// Header names are case-insensitive
+		std::string lowered = toLower(request);
+		size_t upgrade = lowered.find("\r\nupgrade:");
+		bool websocket = upgrade != std::string::npos &&
+		                 lowered.find("websocket", upgrade) < lowered.find("\r\n", upgrade + 2);
+		if (websocket) {
+			size_t keyAt = lowered.find("\r\nsec-websocket-key:");
+			if (keyAt == std::string::npos) {
+				respond(fd, 400, errorBody(-1100, "Missing Sec-WebSocket-Key."), "");
+				return;
+			}
+			size_t valueStart = request.find_first_not_of(" \t", keyAt + 20);
+			std::string key = request.substr(valueStart, request.find("\r\n", valueStart) - valueStart);
+			serveStreams(fd, path, query, key);
+			return;
+		}
+
+		serveRest(fd, path, parseQuery(query));
+	}
+
+	void respond(int fd, int status, const std::string& body, const std::string& headers) {
+		if (config.responseDelayMs > 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(config.responseDelayMs));
+		}
+		std::string response = "HTTP/1.1 " + std::to_string(status) + " " + statusText(status) + "\r\n"
+			"Content-Type: application/json;charset=UTF-8\r\n"
+			"Content-Length: " + std::to_string(body.size()) + "\r\n"
+			"Connection: close\r\n" + headers + "\r\n" + body;
+		sendAll(fd, response.data(), response.size());
+	}
+
+	// --- REST ---
+
+	// Charge 'weight' to the current minute. False when over the limit.
+	bool chargeWeight(int weight, int& used, int& retryAfter) {
+		std::lock_guard<std::mutex> lock(weightMutex);
+		int64_t now = nowMs();
+		if (now / 60000 != weightMinute) {
+			weightMinute = now / 60000;
+			usedWeight = 0;
+		}
+		if (usedWeight + weight > config.weightLimit) {
+			used = usedWeight;
+			retryAfter = static_cast<int>(60 - (now / 1000) % 60);
+			return false;
+		}
+		usedWeight += weight;
+		used = usedWeight;
+		return true;
+	}
+
+	void serveRest(int fd, const std::string& path, const std::map<std::string, std::string>& params) {
+		auto param = [&params](const std::string& name) {
+			auto it = params.find(name);
+			return it == params.end() ? std::string() : it->second;
+		};
+
+		// Request weights as documented by Binance
+		int weight;
+		if (path == "/api/v3/ping" || path == "/api/v3/time") {
+			weight = 1;
+		} else if (path == "/api/v3/exchangeInfo") {
+			weight = 20;
+		} else if (path == "/api/v3/klines") {
+			weight = 2;
+		} else if (path == "/api/v3/depth") {
+			int limit = param("limit").empty() ? 100 : std::atoi(param("limit").c_str());
+			weight = limit <= 100 ? 5 : limit <= 500 ? 25 : limit <= 1000 ? 50 : 250;
+		} else if (path == "/api/v3/ticker/24hr") {
+			weight = param("symbol").empty() ? 80 : 2;
+		} else if (path == "/api/v3/trades") {
+			weight = 25;
+		} else {
+			respond(fd, 404, errorBody(-1000, "Unknown endpoint."), "");
+			return;
+		}
+
+		int used = 0;
+		int retryAfter = 0;
+		if (!chargeWeight(weight, used, retryAfter)) {
+			rateLimitedCount++;
+			respond(fd, 429, errorBody(-1003, "Too much request weight used; current limit is " +
+			                                  std::to_string(config.weightLimit) +
+			                                  " request weight per 1 MINUTE."),
+			        "X-MBX-USED-WEIGHT-1M: " + std::to_string(used) + "\r\n"
+			        "Retry-After: " + std::to_string(retryAfter) + "\r\n");
+			return;
+		}
+		std::string headers = "X-MBX-USED-WEIGHT-1M: " + std::to_string(used) + "\r\n";
+
+		if (path == "/api/v3/ping") {
+			respond(fd, 200, "{}", headers);
+		} else if (path == "/api/v3/time") {
+			respond(fd, 200, "{\"serverTime\":" + std::to_string(nowMs()) + "}", headers);
+		} else if (path == "/api/v3/exchangeInfo") {
+			respond(fd, 200, exchangeInfo(), headers);
+		} else {
+			std::string body;
+			std::lock_guard<std::mutex> lock(mutex);
+			Market* market = findMarket(param("symbol"));
+			if (!market && !(path == "/api/v3/ticker/24hr" && param("symbol").empty())) {
+				body = errorBody(-1121, "Invalid symbol.");
+			} else if (path == "/api/v3/klines") {
+				if (!klines(*market, param("interval"), param("startTime"), param("endTime"), param("limit"), body)) {
+					body = errorBody(-1120, "Invalid interval.");
+				}
+			} else if (path == "/api/v3/depth") {
+				body = depthSnapshot(*market, param("limit").empty() ? 100 : std::atoi(param("limit").c_str()));
+			} else if (path == "/api/v3/ticker/24hr") {
+				if (market) {
+					body = tickerJson(*market, nowMs(), false);
+				} else {
+					body = "[";
+					for (size_t i = 0; i < markets.size(); i++) {
+						body += (i ? "," : "") + tickerJson(markets[i], nowMs(), false);
+					}
+					body += "]";
+				}
+			} else {
+				body = recentTrades(*market, param("limit").empty() ? 500 : std::atoi(param("limit").c_str()));
+			}
+			bool failed = body.compare(0, 8, "{\"code\":") == 0;
+			respond(fd, failed ? 400 : 200, body, headers);
+		}
+	}
+
+	std::string exchangeInfo() {
+		static const char* kQuotes[] = { "USDT", "USDC", "BUSD", "BTC", "ETH", "BNB", "EUR" };
+		std::string body = "{\"timezone\":\"UTC\",\"serverTime\":" + std::to_string(nowMs()) +
+			",\"rateLimits\":[{\"rateLimitType\":\"REQUEST_WEIGHT\",\"interval\":\"MINUTE\","
+			"\"intervalNum\":1,\"limit\":" + std::to_string(config.weightLimit) + "}],\"symbols\":[";
+		for (size_t i = 0; i < markets.size(); i++) {
+			const std::string& symbol = markets[i].symbol;
+			std::string base = symbol;
+			std::string quote;
+			for (const char* candidate : kQuotes) {
+				size_t length = strlen(candidate);
+				if (symbol.size() > length && symbol.compare(symbol.size() - length, length, candidate) == 0) {
+					base = symbol.substr(0, symbol.size() - length);
+					quote = candidate;
+					break;
+				}
+			}
+			body += (i ? "," : "") + std::string("{\"symbol\":\"") + symbol + "\",\"status\":\"TRADING\","
+				"\"baseAsset\":\"" + base + "\",\"quoteAsset\":\"" + quote + "\",\"filters\":["
+				"{\"filterType\":\"PRICE_FILTER\",\"tickSize\":\"0.01000000\"},"
+				"{\"filterType\":\"LOT_SIZE\",\"stepSize\":\"0.00001000\"}]}";
+		}
+		return body + "]}";
+	}
+
+	// Klines of a stored dataset when there is one, else generated
+	bool klines(const Market& market, const std::string& interval, const std::string& startParam,
+	            const std::string& endParam, const std::string& limitParam, std::string& body) {
+		int64_t lengthMs = CandleResampler::timeframeToSeconds(interval) * 1000;
+		if (lengthMs <= 0) {
+			return false;
+		}
+		int limit = limitParam.empty() ? kDefaultKlineLimit :
+		            std::max(1, std::min(kMaxKlineLimit, std::atoi(limitParam.c_str())));
+		int64_t now = nowMs();
+		int64_t endTime = endParam.empty() ? now : std::atoll(endParam.c_str());
+
+		std::vector<Candle> candles;
+		auto dataset = datasets.find(market.symbol + "|" + interval);
+		if (dataset != datasets.end()) {
+			const std::vector<Candle>& all = dataset->second;
+			auto first = all.begin();
+			if (!startParam.empty()) {
+				int64_t startTime = std::atoll(startParam.c_str());
+				first = std::lower_bound(all.begin(), all.end(), startTime, [](const Candle& candle, int64_t ms) {
+					return static_cast<int64_t>(candle.timestamp) * 1000 < ms;
+				});
+			} else {
+				auto last = std::upper_bound(all.begin(), all.end(), endTime, [](int64_t ms, const Candle& candle) {
+					return ms < static_cast<int64_t>(candle.timestamp) * 1000;
+				});
+				first = last - std::min<ptrdiff_t>(limit, last - all.begin());
+			}
+			for (auto it = first; it != all.end() && static_cast<int>(candles.size()) < limit &&
+			                      static_cast<int64_t>(it->timestamp) * 1000 <= endTime; ++it) {
+				candles.push_back(*it);
+			}
+		} else {
+			endTime = std::min(endTime, now);
+			int64_t open;
+			if (!startParam.empty()) {
+				int64_t startTime = std::atoll(startParam.c_str());
+				open = (startTime + lengthMs - 1) / lengthMs * lengthMs;
+			} else {
+				open = endTime / lengthMs * lengthMs - static_cast<int64_t>(limit - 1) * lengthMs;
+			}
+			for (; open <= endTime && static_cast<int>(candles.size()) < limit; open += lengthMs) {
+				candles.push_back(generateCandle(market, interval, open, lengthMs));
+			}
+		}
+
+		body = "[";
+		for (size_t i = 0; i < candles.size(); i++) {
+			const Candle& candle = candles[i];
+			int64_t open = static_cast<int64_t>(candle.timestamp) * 1000;
+			double quoteVolume = candle.volume * (candle.open + candle.close) / 2.0;
+			body += (i ? ",[" : "[") + std::to_string(open) + "," + quoted(candle.open, 8) + "," +
+				quoted(candle.high, 8) + "," + quoted(candle.low, 8) + "," + quoted(candle.close, 8) + "," +
+				quoted(candle.volume, 8) + "," + std::to_string(open + lengthMs - 1) + "," +
+				quoted(quoteVolume, 8) + ",100," + quoted(candle.volume / 2, 8) + "," +
+				quoted(quoteVolume / 2, 8) + ",\"0\"]";
+		}
+		body += "]";
+		return true;
+	}
+
+	std::string depthSnapshot(Market& market, int limit) {
+		limit = std::max(1, std::min(limit, 5000));
+		if (market.bids.empty()) {
+			changeBook(market, nowMs());
+		}
+		std::string body = "{\"lastUpdateId\":" + std::to_string(market.updateId) + ",\"bids\":[";
+		int count = 0;
+		for (auto it = market.bids.begin(); it != market.bids.end() && count < limit; ++it, ++count) {
+			body += (count ? ",[" : "[") + quoted(it->first * kTickSize, 8) + "," + quoted(it->second, 8) + "]";
+		}
+		body += "],\"asks\":[";
+		count = 0;
+		for (auto it = market.asks.begin(); it != market.asks.end() && count < limit; ++it, ++count) {
+			body += (count ? ",[" : "[") + quoted(it->first * kTickSize, 8) + "," + quoted(it->second, 8) + "]";
+		}
+		return body + "]}";
+	}
+
+	std::string recentTrades(const Market& market, int limit) {
+		limit = std::max(1, std::min(limit, kMaxKlineLimit));
+		int64_t now = nowMs();
+		std::string body = "[";
+		for (int i = limit - 1; i >= 0; i--) {
+			int64_t id = market.nextTradeId - 1 - i;
+			int64_t time = now - static_cast<int64_t>(i) * 100;
+			double price = tradePrice(market, time, id);
+			double quantity = tradeQuantity(market, id);
+			body += (i == limit - 1 ? "{" : ",{") + std::string("\"id\":") + std::to_string(id) +
+				",\"price\":" + quoted(price, 8) + ",\"qty\":" + quoted(quantity, 8) +
+				",\"quoteQty\":" + quoted(price * quantity, 8) + ",\"time\":" + std::to_string(time) +
+				",\"isBuyerMaker\":" + (unit(market.hash ^ id) < 0.5 ? "true" : "false") +
+				",\"isBestMatch\":true}";
+		}
+		return body + "]";
+	}
+
+	// REST (full names) or stream (one-letter) 24h ticker
+	std::string tickerJson(const Market& market, int64_t now, bool stream) {
+		double last = market.lastPrice > 0 ? market.lastPrice : priceAt(market, now);
+		double open = priceAt(market, now - kDayMs);
+		double high = std::max(open, last) * 1.01;
+		double low = std::min(open, last) * 0.99;
+		double bid = market.bids.empty() ? last - kTickSize : market.bids.begin()->first * kTickSize;
+		double ask = market.asks.empty() ? last + kTickSize : market.asks.begin()->first * kTickSize;
+		double volume = 1000.0 + market.volume;
+		double quoteVolume = volume * (open + last) / 2.0;
+		std::string change = quoted(last - open, 8);
+		std::string percent = quoted((last - open) / open * 100.0, 3);
+
+		if (stream) {
+			return "{\"e\":\"24hrTicker\",\"E\":" + std::to_string(now) + ",\"s\":\"" + market.symbol +
+				"\",\"p\":" + change + ",\"P\":" + percent + ",\"w\":" + quoted((open + last) / 2, 8) +
+				",\"x\":" + quoted(open, 8) + ",\"c\":" + quoted(last, 8) + ",\"Q\":\"0.01000000\"" +
+				",\"b\":" + quoted(bid, 8) + ",\"B\":\"1.00000000\",\"a\":" + quoted(ask, 8) +
+				",\"A\":\"1.00000000\",\"o\":" + quoted(open, 8) + ",\"h\":" + quoted(high, 8) +
+				",\"l\":" + quoted(low, 8) + ",\"v\":" + quoted(volume, 8) + ",\"q\":" + quoted(quoteVolume, 8) +
+				",\"O\":" + std::to_string(now - kDayMs) + ",\"C\":" + std::to_string(now) +
+				",\"F\":0,\"L\":" + std::to_string(market.nextTradeId - 1) +
+				",\"n\":" + std::to_string(market.nextTradeId - 1) + "}";
+		}
+		return "{\"symbol\":\"" + market.symbol + "\",\"priceChange\":" + change +
+			",\"priceChangePercent\":" + percent + ",\"weightedAvgPrice\":" + quoted((open + last) / 2, 8) +
+			",\"prevClosePrice\":" + quoted(open, 8) + ",\"lastPrice\":" + quoted(last, 8) +
+			",\"lastQty\":\"0.01000000\",\"bidPrice\":" + quoted(bid, 8) + ",\"bidQty\":\"1.00000000\"" +
+			",\"askPrice\":" + quoted(ask, 8) + ",\"askQty\":\"1.00000000\",\"openPrice\":" + quoted(open, 8) +
+			",\"highPrice\":" + quoted(high, 8) + ",\"lowPrice\":" + quoted(low, 8) +
+			",\"volume\":" + quoted(volume, 8) + ",\"quoteVolume\":" + quoted(quoteVolume, 8) +
+			",\"openTime\":" + std::to_string(now - kDayMs) + ",\"closeTime\":" + std::to_string(now) +
+			",\"firstId\":0,\"lastId\":" + std::to_string(market.nextTradeId - 1) +
+			",\"count\":" + std::to_string(market.nextTradeId - 1) + "}";
+	}
+
+	double tradePrice(const Market& market, int64_t time, int64_t id) const {
+		return roundToTick(priceAt(market, time) * (1.0 + 0.0003 * (unit(market.hash + id) - 0.5)));
+	}
+
+	double tradeQuantity(const Market& market, int64_t id) const {
+		return std::round((0.001 + 0.5 * unit(market.hash ^ (id * 7919))) * 100000.0) / 100000.0;
+	}
+
+	// --- Streams ---
+
+	void serveStreams(int fd, const std::string& path, const std::string& query, const std::string& key) {
+		std::shared_ptr<StreamConnection> connection(new StreamConnection());
+		connection->fd = fd;
+
+		// /stream?streams=a/b (combined) or /ws/a/b (raw)
+		std::string list;
+		if (path == "/stream") {
+			list = parseQuery(query)["streams"];
+		} else if (path.compare(0, 3, "/ws") == 0) {
+			connection->combined = false;
+			list = path.size() > 4 ? path.substr(4) : "";
+		} else {
+			respond(fd, 404, errorBody(-1000, "Unknown endpoint."), "");
+			return;
+		}
+
+		// Take a connection slot before answering, so a client opening the
+		// next connection right after the upgrade sees it counted
+		bool refused;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			refused = config.maxStreamConnections > 0 && connections.size() >= config.maxStreamConnections;
+			if (!refused) {
+				connections.push_back(connection);
+			}
+		}
+		if (refused) {
+			respond(fd, 429, errorBody(-1003, "Too many stream connections."), "");
+			return;
+		}
+
+		std::string response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+			"Connection: Upgrade\r\nSec-WebSocket-Accept: " + acceptKey(key) + "\r\n\r\n";
+		if (!sendAll(fd, response.data(), response.size())) {
+			std::lock_guard<std::mutex> lock(mutex);
+			connections.erase(std::remove(connections.begin(), connections.end(), connection), connections.end());
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			size_t pos = 0;
+			while (pos < list.size()) {
+				size_t end = list.find('/', pos);
+				if (end == std::string::npos) {
+					end = list.size();
+				}
+				subscribe(*connection, list.substr(pos, end - pos));
+				pos = end + 1;
+			}
+		}
+
+		readControlMessages(*connection);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const auto& stream : connection->streams) {
+				subscribers[stream]--;
+			}
+			connections.erase(std::remove(connections.begin(), connections.end(), connection), connections.end());
+		}
+		std::lock_guard<std::mutex> lock(connection->writeMutex);
+		connection->open = false;
+	}
+
+	// With mutex held
+	void subscribe(StreamConnection& connection, const std::string& name) {
+		std::string stream = toLower(name);
+		if (stream.empty() || !connection.streams.insert(stream).second) {
+			return;
+		}
+		subscribers[stream]++;
+
+		size_t kline = stream.find("@kline_");
+		Market* market = marketOfStream(stream);
+		if (market && kline != std::string::npos) {
+			std::string interval = name.substr(kline + 7);  // Case matters: 1m vs 1M
+			int64_t lengthMs = CandleResampler::timeframeToSeconds(interval) * 1000;
+			if (lengthMs > 0 && market->klines.find(interval) == market->klines.end()) {
+				KlineState state;
+				state.lengthMs = lengthMs;
+				startKline(*market, state, nowMs());
+				market->klines[interval] = state;
+			}
+		}
+	}
+
+	// With mutex held
+	void unsubscribe(StreamConnection& connection, const std::string& name) {
+		if (connection.streams.erase(toLower(name)) > 0) {
+			subscribers[toLower(name)]--;
+		}
+	}
+
+	bool sendFrame(StreamConnection& connection, uint8_t opcode, const std::string& payload) {
+		std::string frame;
+		appendFrame(frame, opcode, payload);
+		std::lock_guard<std::mutex> lock(connection.writeMutex);
+		return connection.open && sendAll(connection.fd, frame.data(), frame.size());
+	}
+
+	// Reader: client frames until close
+	void readControlMessages(StreamConnection& connection) {
+		int fd = connection.fd;
+		while (running) {
+			uint8_t header[2];
+			if (!recvAll(fd, header, 2)) {
+				return;
+			}
+			uint8_t opcode = header[0] & 0x0F;
+			uint64_t length = header[1] & 0x7F;
+			if (length == 126) {
+				uint8_t extended[2];
+				if (!recvAll(fd, extended, 2)) return;
+				length = (extended[0] << 8) | extended[1];
+			} else if (length == 127) {
+				uint8_t extended[8];
+				if (!recvAll(fd, extended, 8)) return;
+				length = 0;
+				for (int i = 0; i < 8; i++) {
+					length = (length << 8) | extended[i];
+				}
+			}
+			if (length > static_cast<uint64_t>(kMaxRequestSize)) {
+				return;
+			}
+			uint8_t mask[4] = { 0, 0, 0, 0 };
+			if ((header[1] & 0x80) && !recvAll(fd, mask, 4)) {
+				return;
+			}
+			std::string payload(length, '\0');
+			if (length > 0 && !recvAll(fd, &payload[0], length)) {
+				return;
+			}
+			for (size_t i = 0; i < payload.size(); i++) {
+				payload[i] ^= mask[i & 3];
+			}
+
+			if (opcode == 0x8) {
+				sendFrame(connection, 0x8, payload.substr(0, 2));
+				return;
+			} else if (opcode == 0x9) {
+				sendFrame(connection, 0xA, payload);
+			} else if (opcode == 0x1 && !handleControl(connection, payload)) {
+				return;
+			}
+		}
+	}
+
+	// SUBSCRIBE/UNSUBSCRIBE/LIST_SUBSCRIPTIONS. False drops the connection,
+	// as Binance does past 5 messages per second.
+	bool handleControl(StreamConnection& connection, const std::string& message) {
+		int64_t now = nowMs();
+		auto& times = connection.controlTimes;
+		times.erase(std::remove_if(times.begin(), times.end(),
+			[now](int64_t time) { return now - time >= 1000; }), times.end());
+		times.push_back(now);
+		if (times.size() > kMaxControlMessagesPerSecond) {
+			LOG_WARNING("Mock server: control message rate exceeded, closing connection");
+			return false;
+		}
+
+		JsonParser parser;
+		if (!parser.parse(message)) {
+			return sendFrame(connection, 0x1, "{\"error\":{\"code\":3,\"msg\":\"Invalid JSON\"}}");
+		}
+		std::string method = parser.getString("method");
+		std::string id = std::to_string(parser.getInt64("id"));
+		std::string reply;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			size_t count = parser.getArraySize("params");
+			if (method == "SUBSCRIBE" || method == "UNSUBSCRIBE") {
+				for (size_t i = 0; i < count; i++) {
+					std::string stream = parser.getArrayString("params", i);
+					if (method == "SUBSCRIBE") {
+						subscribe(connection, stream);
+					} else {
+						unsubscribe(connection, stream);
+					}
+				}
+				reply = "{\"result\":null,\"id\":" + id + "}";
+			} else if (method == "LIST_SUBSCRIPTIONS") {
+				reply = "{\"result\":[";
+				bool first = true;
+				for (const auto& stream : connection.streams) {
+					reply += (first ? "\"" : ",\"") + stream + "\"";
+					first = false;
+				}
+				reply += "],\"id\":" + id + "}";
+			} else {
+				reply = "{\"error\":{\"code\":2,\"msg\":\"Invalid request: unknown method\"},\"id\":" + id + "}";
+			}
+		}
+		return sendFrame(connection, 0x1, reply);
+	}
+
+	// --- Market simulation ---
+
+	void marketLoop() {
+		int64_t last = nowMs();
+		std::vector<std::pair<std::shared_ptr<StreamConnection>, std::string>> pending;
+
+		while (running) {
+			int64_t now = nowMs();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for (auto& market : markets) {
+					step(market, now, now - last);
+				}
+				for (auto& connection : connections) {
+					if (!connection->outbox.empty()) {
+						pending.emplace_back(connection, std::string());
+						pending.back().second.swap(connection->outbox);
+					}
+				}
+			}
+			last = now;
+
+			// One write per connection per step, like a busy exchange feed
+			for (auto& entry : pending) {
+				StreamConnection& connection = *entry.first;
+				std::lock_guard<std::mutex> lock(connection.writeMutex);
+				if (connection.open && !sendAll(connection.fd, entry.second.data(), entry.second.size())) {
+					connection.open = false;
+					::shutdown(connection.fd, SHUT_RDWR);
+				}
+			}
+			pending.clear();
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	bool hasSubscribers(const std::string& stream) const {
+		auto it = subscribers.find(stream);
+		return it != subscribers.end() && it->second > 0;
+	}
+
+	// With mutex held: queue 'data' for every subscriber of 'stream'
+	void broadcast(const std::string& stream, const std::string& data) {
+		std::string wrapped;
+		for (auto& connection : connections) {
+			if (connection->streams.count(stream) == 0) {
+				continue;
+			}
+			if (connection->combined) {
+				if (wrapped.empty()) {
+					wrapped = "{\"stream\":\"" + stream + "\",\"data\":" + data + "}";
+				}
+				appendFrame(connection->outbox, 0x1, wrapped);
+			} else {
+				appendFrame(connection->outbox, 0x1, data);
+			}
+			messagesSent++;
+		}
+	}
+
+	void startKline(const Market& market, KlineState& state, int64_t now) {
+		state.openTime = now / state.lengthMs * state.lengthMs;
+		double price = market.lastPrice > 0 ? market.lastPrice : priceAt(market, now);
+		state.open = state.high = state.low = state.close = price;
+		state.volume = state.quoteVolume = 0;
+		state.trades = 0;
+		state.firstTradeId = state.lastTradeId = -1;
+		state.nextPush = now;
+	}
+
+	std::string klineJson(const Market& market, const std::string& interval, const KlineState& state,
+	                      bool closed, int64_t now) {
+		return "{\"e\":\"kline\",\"E\":" + std::to_string(now) + ",\"s\":\"" + market.symbol +
+			"\",\"k\":{\"t\":" + std::to_string(state.openTime) +
+			",\"T\":" + std::to_string(state.openTime + state.lengthMs - 1) +
+			",\"s\":\"" + market.symbol + "\",\"i\":\"" + interval + "\"" +
+			",\"f\":" + std::to_string(state.firstTradeId) + ",\"L\":" + std::to_string(state.lastTradeId) +
+			",\"o\":" + quoted(state.open, 8) + ",\"c\":" + quoted(state.close, 8) +
+			",\"h\":" + quoted(state.high, 8) + ",\"l\":" + quoted(state.low, 8) +
+			",\"v\":" + quoted(state.volume, 8) + ",\"n\":" + std::to_string(state.trades) +
+			",\"x\":" + (closed ? "true" : "false") + ",\"q\":" + quoted(state.quoteVolume, 8) +
+			",\"V\":" + quoted(state.volume / 2, 8) + ",\"Q\":" + quoted(state.quoteVolume / 2, 8) +
+			",\"B\":\"0\"}}";
+	}
+
+	// Advance one symbol by 'elapsedMs' (mutex held)
+	void step(Market& market, int64_t now, int64_t elapsedMs) {
+		std::string tradeStream = market.stream + "@trade";
+		std::string aggTradeStream = market.stream + "@aggTrade";
+		std::string aggTradeKey = toLower(aggTradeStream);
+
+		// Trades
+		market.tradeBudget += config.tradesPerSecond * elapsedMs / 1000.0;
+		size_t trades = static_cast<size_t>(market.tradeBudget);
+		market.tradeBudget -= trades;
+		trades = std::min(trades, kMaxTradesPerStep);
+		bool tradeSubscribers = hasSubscribers(tradeStream);
+		bool aggTradeSubscribers = hasSubscribers(aggTradeKey);
+		for (size_t i = 0; i < trades; i++) {
+			int64_t id = market.nextTradeId++;
+			double price = tradePrice(market, now, id);
+			double quantity = tradeQuantity(market, id);
+			bool buyerMaker = unit(market.hash ^ id) < 0.5;
+			market.lastPrice = price;
+			market.volume += quantity;
+			market.quoteVolume += price * quantity;
+
+			for (auto& entry : market.klines) {
+				KlineState& state = entry.second;
+				if (state.firstTradeId < 0) {
+					state.firstTradeId = id;
+				}
+				state.lastTradeId = id;
+				state.high = std::max(state.high, price);
+				state.low = std::min(state.low, price);
+				state.close = price;
+				state.volume += quantity;
+				state.quoteVolume += price * quantity;
+				state.trades++;
+			}
+
+			if (tradeSubscribers) {
+				broadcast(tradeStream, "{\"e\":\"trade\",\"E\":" + std::to_string(now) + ",\"s\":\"" +
+					market.symbol + "\",\"t\":" + std::to_string(id) + ",\"p\":" + quoted(price, 8) +
+					",\"q\":" + quoted(quantity, 8) + ",\"T\":" + std::to_string(now) +
+					",\"m\":" + (buyerMaker ? "true" : "false") + ",\"M\":true}");
+			}
+			if (aggTradeSubscribers) {
+				broadcast(aggTradeKey, "{\"e\":\"aggTrade\",\"E\":" + std::to_string(now) + ",\"s\":\"" +
+					market.symbol + "\",\"a\":" + std::to_string(id) + ",\"p\":" + quoted(price, 8) +
+					",\"q\":" + quoted(quantity, 8) + ",\"f\":" + std::to_string(id) +
+					",\"l\":" + std::to_string(id) + ",\"T\":" + std::to_string(now) +
+					",\"m\":" + (buyerMaker ? "true" : "false") + ",\"M\":true}");
+			}
+		}
+
+		// Klines: pushes of the open kline, then the closed one at the boundary
+		for (auto& entry : market.klines) {
+			const std::string& interval = entry.first;
+			KlineState& state = entry.second;
+			std::string stream = market.stream + "@kline_" + interval;
+			bool subscribed = hasSubscribers(stream);
+			if (now >= state.openTime + state.lengthMs) {
+				if (subscribed) {
+					broadcast(stream, klineJson(market, interval, state, true, now));
+				}
+				startKline(market, state, now);
+			} else if (now >= state.nextPush) {
+				if (subscribed) {
+					broadcast(stream, klineJson(market, interval, state, false, now));
+				}
+				state.nextPush = now + config.klineUpdateMs;
+			}
+		}
+
+		// Order book
+		if (now >= market.nextBookChange) {
+			changeBook(market, now);
+			market.nextBookChange = now + std::max(1, config.depthIntervalMs);
+			emitDepth(market, market.fastDepth, market.stream + "@depth@100ms", now);
+		}
+		if (now >= market.slowDepth.nextDue) {
+			emitDepth(market, market.slowDepth, market.stream + "@depth", now);
+			market.slowDepth.nextDue = now + kSlowDepthIntervalMs;
+		}
+
+		// Ticker
+		if (now >= market.nextTicker) {
+			market.nextTicker = now + std::max(1, config.tickerIntervalMs);
+			std::string stream = market.stream + "@ticker";
+			if (hasSubscribers(stream)) {
+				broadcast(stream, tickerJson(market, now, true));
+			}
+		}
+	}
+
+	// Re-center the book on the current price and vary a few quantities.
+	// Every change gets an update ID and goes to both depth feeds.
+	void changeBook(Market& market, int64_t now) {
+		int64_t mid = static_cast<int64_t>(std::llround(priceAt(market, now) / kTickSize));
+		int levels = std::max(1, config.depthLevels);
+		std::map<int64_t, double> bidChanges;
+		std::map<int64_t, double> askChanges;
+		uint64_t hash = market.hash ^ mix(static_cast<uint64_t>(now));
+
+		// Crossed and far-away levels go, missing ones near the mid come
+		for (auto it = market.bids.begin(); it != market.bids.end();) {
+			if (it->first >= mid || it->first < mid - 2 * levels) {
+				bidChanges[it->first] = 0;
+				it = market.bids.erase(it);
+			} else {
+				++it;
+			}
+		}
+		for (auto it = market.asks.begin(); it != market.asks.end();) {
+			if (it->first <= mid || it->first > mid + 2 * levels) {
+				askChanges[it->first] = 0;
+				it = market.asks.erase(it);
+			} else {
+				++it;
+			}
+		}
+		for (int k = 1; k <= levels; k++) {
+			if (market.bids.find(mid - k) == market.bids.end()) {
+				double quantity = std::round((0.1 + 5.0 * unit(hash + k)) * 100000.0) / 100000.0;
+				market.bids[mid - k] = quantity;
+				bidChanges[mid - k] = quantity;
+			}
+			if (market.asks.find(mid + k) == market.asks.end()) {
+				double quantity = std::round((0.1 + 5.0 * unit(hash + 1000 + k)) * 100000.0) / 100000.0;
+				market.asks[mid + k] = quantity;
+				askChanges[mid + k] = quantity;
+			}
+		}
+
+		// Some activity even when the price holds still
+		for (int i = 0; i < 3; i++) {
+			int k = 1 + static_cast<int>(unit(hash + 2000 + i) * levels);
+			double quantity = std::round((0.1 + 5.0 * unit(hash + 3000 + i)) * 100000.0) / 100000.0;
+			if (i % 2 == 0) {
+				market.bids[mid - k] = quantity;
+				bidChanges[mid - k] = quantity;
+			} else {
+				market.asks[mid + k] = quantity;
+				askChanges[mid + k] = quantity;
+			}
+		}
+
+		int64_t firstUpdateId = market.updateId + 1;
+		market.updateId += static_cast<int64_t>(bidChanges.size() + askChanges.size());
+		for (DepthFeed* feed : { &market.fastDepth, &market.slowDepth }) {
+			if (feed->bids.empty() && feed->asks.empty()) {
+				feed->firstUpdateId = firstUpdateId;
+			}
+			for (const auto& change : bidChanges) {
+				feed->bids[change.first] = change.second;
+			}
+			for (const auto& change : askChanges) {
+				feed->asks[change.first] = change.second;
+			}
+		}
+	}
+
+	void emitDepth(const Market& market, DepthFeed& feed, const std::string& stream, int64_t now) {
+		if (feed.bids.empty() && feed.asks.empty()) {
+			return;
+		}
+		if (hasSubscribers(stream)) {
+			std::string data = "{\"e\":\"depthUpdate\",\"E\":" + std::to_string(now) + ",\"s\":\"" +
+				market.symbol + "\",\"U\":" + std::to_string(feed.firstUpdateId) +
+				",\"u\":" + std::to_string(market.updateId) + ",\"b\":[";
+			bool first = true;
+			for (auto it = feed.bids.rbegin(); it != feed.bids.rend(); ++it) {
+				data += (first ? "[" : ",[") + quoted(it->first * kTickSize, 8) + "," + quoted(it->second, 8) + "]";
+				first = false;
+			}
+			data += "],\"a\":[";
+			first = true;
+			for (const auto& level : feed.asks) {
+				data += (first ? "[" : ",[") + quoted(level.first * kTickSize, 8) + "," + quoted(level.second, 8) + "]";
+				first = false;
+			}
+			broadcast(stream, data + "]}");
+		}
+		feed.bids.clear();
+		feed.asks.clear();
+	}
+};
+
+MockBinanceServer::MockBinanceServer(const MockServerConfig& config)
+	: pImpl(new Impl(config)) {
+}
+
+MockBinanceServer::~MockBinanceServer() {
+	stop();
+}
+
+bool MockBinanceServer::start() {
+	return pImpl->start();
+}
+
+void MockBinanceServer::stop() {
+	pImpl->stop();
+}
+
+bool MockBinanceServer::isRunning() const {
+	return pImpl->running;
+}
+
+int MockBinanceServer::getPort() const {
+	return pImpl->port;
+}
+
+std::string MockBinanceServer::getRestUrl() const {
+	return "http://" + pImpl->config.bindAddress + ":" + std::to_string(pImpl->port);
+}
+
+std::string MockBinanceServer::getStreamUrl() const {
+	return "ws://" + pImpl->config.bindAddress + ":" + std::to_string(pImpl->port);
+}
+
+void MockBinanceServer::addCandles(const std::vector<Candle>& candles) {
+	if (candles.empty()) {
+		return;
+	}
+	std::vector<Candle> sorted = candles;
+	std::sort(sorted.begin(), sorted.end(),
+	          [](const Candle& a, const Candle& b) { return a.timestamp < b.timestamp; });
+
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	std::string symbol = toUpper(sorted.front().symbol);
+	if (!pImpl->findMarket(symbol)) {
+		Impl::Market market;
+		market.symbol = symbol;
+		market.stream = toLower(symbol);
+		market.hash = hashString(symbol) ^ mix(pImpl->config.seed);
+		market.basePrice = sorted.back().close;
+		pImpl->markets.push_back(market);
+	}
+	pImpl->datasets[symbol + "|" + sorted.front().timeframe] = std::move(sorted);
+}
+
+void MockBinanceServer::resetWeight() {
+	std::lock_guard<std::mutex> lock(pImpl->weightMutex);
+	pImpl->usedWeight = 0;
+}
+
+void MockBinanceServer::dropStreamConnections() {
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	for (auto& connection : pImpl->connections) {
+		::shutdown(connection->fd, SHUT_RDWR);
+	}
+}
+
+uint64_t MockBinanceServer::getRequestCount() const {
+	return pImpl->requestCount;
+}
+
+uint64_t MockBinanceServer::getRateLimitedCount() const {
+	return pImpl->rateLimitedCount;
+}
+
+uint64_t MockBinanceServer::getMessagesSent() const {
+	return pImpl->messagesSent;
+}
+
+size_t MockBinanceServer::getStreamConnectionCount() const {
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	return pImpl->connections.size();
+}
+
+std::string MockBinanceServer::getLastError() const {
+	return pImpl->lastError;
+}
+
+} // namespace Emiglio
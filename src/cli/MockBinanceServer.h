@@ -0,0 +1,87 @@
+#ifndef EMIGLIO_MOCKBINANCESERVER_H
+#define EMIGLIO_MOCKBINANCESERVER_H
+
+#include "../data/DataStorage.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Emiglio {
+
+struct MockServerConfig {
+	std::string bindAddress = "127.0.0.1";
+	int port = 0;                                   // 0 picks a free port
+	std::vector<std::string> symbols = { "BTCUSDT" };
+	double basePrice = 50000.0;                     // First symbol; each next one halves
+	uint64_t seed = 1;
+
+	// Streams
+	double tradesPerSecond = 10.0;                  // Per symbol
+	int depthIntervalMs = 100;                      // Book changes; @depth sends every 1000ms
+	int depthLevels = 20;                           // Per side
+	int klineUpdateMs = 1000;                       // Open kline pushes
+	int tickerIntervalMs = 1000;
+	size_t maxStreamConnections = 0;                // 0 = unlimited, then upgrades get 429
+
+	// REST
+	int weightLimit = 6000;                         // Request weight per minute, then 429
+	int responseDelayMs = 0;                        // Added to every response
+};
+
+// Stand-in for Binance's REST and stream endpoints, for offline tests and
+// benchmarks of the exchange layer.
+//
+// REST (http://host:port): ping, time, exchangeInfo, klines, depth,
+// ticker/24hr and trades, with Binance's request weights. Used weight is
+// reported in X-MBX-USED-WEIGHT-1M; past the limit requests get 429 with
+// Retry-After until the minute ends. Klines come from loaded candles or
+// are generated from a deterministic price path.
+//
+// Streams (ws://host:port/stream?streams=...): trade, aggTrade, kline_<i>,
+// depth, depth@100ms and ticker per symbol, at the configured rates, plus
+// SUBSCRIBE/UNSUBSCRIBE/LIST_SUBSCRIPTIONS. Depth diffs continue the REST
+// snapshot's lastUpdateId, so LocalOrderBook syncs against it.
+class MockBinanceServer {
+public:
+	explicit MockBinanceServer(const MockServerConfig& config = MockServerConfig());
+	~MockBinanceServer();
+
+	bool start();
+	void stop();
+	bool isRunning() const;
+
+	int getPort() const;
+	std::string getRestUrl() const;    // For BinanceAPI::setBaseUrl()
+	std::string getStreamUrl() const;  // For BinanceWebSocket::setStreamUrl()
+
+	// Serve these klines (one symbol and timeframe, e.g. from CandleFile)
+	// instead of generated ones
+	void addCandles(const std::vector<Candle>& candles);
+
+	// Start a fresh weight window
+	void resetWeight();
+
+	// Cut every stream connection without a close frame, as a network
+	// failure would
+	void dropStreamConnections();
+
+	uint64_t getRequestCount() const;
+	uint64_t getRateLimitedCount() const;
+	uint64_t getMessagesSent() const;
+	size_t getStreamConnectionCount() const;
+
+	std::string getLastError() const;
+
+	MockBinanceServer(const MockBinanceServer&) = delete;
+	MockBinanceServer& operator=(const MockBinanceServer&) = delete;
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_MOCKBINANCESERVER_H
@@ -0,0 +1,210 @@
+// Local Binance stand-in
+//
+// Serves klines, depth, tickers and trades over REST and synthetic
+// trade/kline/depth/ticker streams over WebSocket, with Binance's request
+// weights and 429 responses. Point the app at it with
+//   EMIGLIO_BINANCE_API_URL=http://127.0.0.1:PORT
+//   EMIGLIO_BINANCE_STREAM_URL=ws://127.0.0.1:PORT
+
+#include "MockBinanceServer.h"
+#include "../data/CandleFile.h"
+#include "../utils/Logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Emiglio;
+
+namespace {
+
+struct Options {
+	MockServerConfig config;
+	std::string candlesFile;
+	std::string symbol = "BTCUSDT";
+	std::string timeframe = "1h";
+	int durationSeconds = 0;            // 0 = until interrupted
+	std::string logFile;
+};
+
+std::atomic<bool> interrupted(false);
+
+void onSignal(int) {
+	interrupted = true;
+}
+
+void printUsage(const char* program) {
+	std::cerr <<
+		"Usage: " << program << " [options]\n"
+		"\n"
+		"Server:\n"
+		"  --port N             Port to listen on (default: a free one)\n"
+		"  --bind ADDRESS       Address to bind (default 127.0.0.1)\n"
+		"  --symbols A,B,...    Symbols to simulate (default BTCUSDT)\n"
+		"  --seed N             Seed of the generated price path (default 1)\n"
+		"  --duration SECONDS   Stop after this long (default: until Ctrl-C)\n"
+		"  --log FILE           Write the log to FILE\n"
+		"\n"
+		"Klines:\n"
+		"  --candles FILE       Serve the candles of a CSV or .bin file\n"
+		"  --symbol SYMBOL      Symbol of --candles (default BTCUSDT)\n"
+		"  --timeframe TF       Timeframe of --candles (default 1h)\n"
+		"\n"
+		"Streams:\n"
+		"  --trades-per-sec N   Trades per symbol per second (default 10)\n"
+		"  --depth-ms N         Order book change interval (default 100)\n"
+		"  --depth-levels N     Book levels per side (default 20)\n"
+		"  --kline-ms N         Open kline push interval (default 1000)\n"
+		"\n"
+		"Rate limits:\n"
+		"  --weight-limit N     Request weight per minute before 429 (default 6000)\n"
+		"  --latency-ms N       Delay added to every REST response (default 0)\n";
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+	std::vector<std::string> items;
+	size_t pos = 0;
+	while (pos <= text.size()) {
+		size_t end = text.find(',', pos);
+		if (end == std::string::npos) {
+			end = text.size();
+		}
+		if (end > pos) {
+			items.push_back(text.substr(pos, end - pos));
+		}
+		pos = end + 1;
+	}
+	return items;
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+	MockServerConfig& config = options.config;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		auto next = [&](std::string& out) {
+			if (i + 1 >= argc) {
+				std::cerr << "Missing value for " << arg << std::endl;
+				return false;
+			}
+			out = argv[++i];
+			return true;
+		};
+		std::string value;
+
+		if (arg == "-h" || arg == "--help") {
+			return false;
+		} else if (arg == "--port") {
+			if (!next(value)) return false;
+			config.port = std::atoi(value.c_str());
+		} else if (arg == "--bind") {
+			if (!next(config.bindAddress)) return false;
+		} else if (arg == "--symbols") {
+			if (!next(value)) return false;
+			config.symbols = splitList(value);
+		} else if (arg == "--seed") {
+			if (!next(value)) return false;
+			config.seed = std::strtoull(value.c_str(), nullptr, 10);
+		} else if (arg == "--duration") {
+			if (!next(value)) return false;
+			options.durationSeconds = std::atoi(value.c_str());
+		} else if (arg == "--log") {
+			if (!next(options.logFile)) return false;
+		} else if (arg == "--candles") {
+			if (!next(options.candlesFile)) return false;
+		} else if (arg == "--symbol") {
+			if (!next(options.symbol)) return false;
+		} else if (arg == "--timeframe") {
+			if (!next(options.timeframe)) return false;
+		} else if (arg == "--trades-per-sec") {
+			if (!next(value)) return false;
+			config.tradesPerSecond = std::atof(value.c_str());
+		} else if (arg == "--depth-ms") {
+			if (!next(value)) return false;
+			config.depthIntervalMs = std::atoi(value.c_str());
+		} else if (arg == "--depth-levels") {
+			if (!next(value)) return false;
+			config.depthLevels = std::atoi(value.c_str());
+		} else if (arg == "--kline-ms") {
+			if (!next(value)) return false;
+			config.klineUpdateMs = std::atoi(value.c_str());
+		} else if (arg == "--weight-limit") {
+			if (!next(value)) return false;
+			config.weightLimit = std::atoi(value.c_str());
+		} else if (arg == "--latency-ms") {
+			if (!next(value)) return false;
+			config.responseDelayMs = std::atoi(value.c_str());
+		} else {
+			std::cerr << "Unknown option: " << arg << std::endl;
+			return false;
+		}
+	}
+
+	if (config.symbols.empty()) {
+		std::cerr << "No symbols given" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	Options options;
+	if (!parseArgs(argc, argv, options)) {
+		printUsage(argv[0]);
+		return 2;
+	}
+
+	if (options.logFile.empty()) {
+		Logger::getInstance().init("/dev/null", LogLevel::ERROR);
+	} else {
+		Logger::getInstance().init(options.logFile);
+	}
+
+	MockBinanceServer server(options.config);
+	if (!options.candlesFile.empty()) {
+		CandleFile file;
+		std::vector<Candle> candles;
+		if (!file.load(options.candlesFile, candles, "binance", options.symbol, options.timeframe)) {
+			std::cerr << file.getLastError() << std::endl;
+			return 1;
+		}
+		server.addCandles(candles);
+		std::cerr << "Serving " << candles.size() << " " << options.symbol << " "
+		          << options.timeframe << " candles from " << options.candlesFile << std::endl;
+	}
+
+	if (!server.start()) {
+		std::cerr << server.getLastError() << std::endl;
+		return 1;
+	}
+
+	std::signal(SIGINT, onSignal);
+	std::signal(SIGTERM, onSignal);
+
+	std::cout << "REST:    " << server.getRestUrl() << "\n"
+	          << "Streams: " << server.getStreamUrl() << "\n"
+	          << "export EMIGLIO_BINANCE_API_URL=" << server.getRestUrl() << "\n"
+	          << "export EMIGLIO_BINANCE_STREAM_URL=" << server.getStreamUrl() << std::endl;
+
+	auto started = std::chrono::steady_clock::now();
+	while (!interrupted) {
+		if (options.durationSeconds > 0 &&
+		    std::chrono::steady_clock::now() - started >= std::chrono::seconds(options.durationSeconds)) {
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+
+	server.stop();
+	std::cerr << "Requests: " << server.getRequestCount()
+	          << ", rate limited: " << server.getRateLimitedCount()
+	          << ", stream messages: " << server.getMessagesSent() << std::endl;
+	return 0;
+}
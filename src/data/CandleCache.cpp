@@ -0,0 +1,254 @@
+#include "CandleCache.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+
+namespace Emiglio {
+
+namespace {
+
+const size_t kDefaultMaxBytes = 128 * 1024 * 1024;
+
+// End of a segment that reached the present when it was loaded
+const time_t kOpenEnd = std::numeric_limits<time_t>::max();
+
+std::string seriesKey(const std::string& path, const std::string& exchange,
+                      const std::string& symbol, const std::string& timeframe) {
+	return path + '\n' + exchange + '\n' + symbol + '\n' + timeframe;
+}
+
+size_t bytesOf(const std::vector<Candle>& candles) {
+	return sizeof(candles) + candles.capacity() * sizeof(Candle);
+}
+
+// The candles of 'data' (sorted) with open times in [startTime, endTime]
+CandleSeries slice(const std::shared_ptr<const std::vector<Candle>>& data, time_t startTime, time_t endTime) {
+	auto first = std::lower_bound(data->begin(), data->end(), startTime,
+		[](const Candle& candle, time_t time) { return candle.timestamp < time; });
+	auto last = std::upper_bound(first, data->end(), endTime,
+		[](time_t time, const Candle& candle) { return time < candle.timestamp; });
+	return CandleSeries(data, first - data->begin(), last - first);
+}
+
+} // namespace
+
+class CandleCache::Impl {
+public:
+	typedef std::list<std::pair<std::string, time_t>> LruList;
+
+	// The complete answer for open times [start, end]
+	struct Segment {
+		time_t start;
+		time_t end;
+		std::shared_ptr<const std::vector<Candle>> candles;
+		size_t bytes;
+		LruList::iterator lru;
+	};
+
+	struct Series {
+		std::map<time_t, Segment> segments;  // Disjoint, by start
+		uint64_t generation = 0;             // Bumped by every invalidation
+	};
+
+	mutable std::mutex mutex;
+	std::map<std::string, Series> series;
+	LruList lru;  // Most recently used first
+	size_t maxBytes = kDefaultMaxBytes;
+	Stats stats;
+
+	// Segments of 's' overlapping [start, end]
+	std::vector<std::map<time_t, Segment>::iterator> overlapping(Series& s, time_t start, time_t end) {
+		std::vector<std::map<time_t, Segment>::iterator> result;
+		auto it = s.segments.upper_bound(start);
+		if (it != s.segments.begin() && std::prev(it)->second.end >= start) {
+			--it;
+		}
+		for (; it != s.segments.end() && it->second.start <= end; ++it) {
+			result.push_back(it);
+		}
+		return result;
+	}
+
+	void touch(Segment& segment) {
+		lru.splice(lru.begin(), lru, segment.lru);
+	}
+
+	void add(const std::string& key, Series& s, Segment segment) {
+		lru.emplace_front(key, segment.start);
+		segment.lru = lru.begin();
+		stats.bytes += segment.bytes;
+		stats.segments++;
+		s.segments.emplace(segment.start, std::move(segment));
+	}
+
+	void remove(Series& s, std::map<time_t, Segment>::iterator it) {
+		stats.bytes -= it->second.bytes;
+		stats.segments--;
+		lru.erase(it->second.lru);
+		s.segments.erase(it);
+	}
+
+	void evict() {
+		while (stats.bytes > maxBytes && !lru.empty()) {
+			Series& s = series[lru.back().first];
+			remove(s, s.segments.find(lru.back().second));
+			stats.evictions++;
+		}
+	}
+};
+
+CandleCache& CandleCache::getInstance() {
+	static CandleCache instance;
+	return instance;
+}
+
+CandleCache::CandleCache()
+	: pImpl(std::make_unique<Impl>()) {
+	DataStorage::setCandleWriteListener([this](const std::string& path, const std::string& exchange,
+	                                           const std::string& symbol, const std::string& timeframe,
+	                                           time_t first, time_t last) {
+		invalidate(path, exchange, symbol, timeframe, first, last);
+	});
+}
+
+CandleCache::~CandleCache() {
+	DataStorage::setCandleWriteListener(nullptr);
+}
+
+CandleSeries CandleCache::getCandles(DataStorage& storage,
+                                     const std::string& exchange,
+                                     const std::string& symbol,
+                                     const std::string& timeframe,
+                                     time_t startTime,
+                                     time_t endTime) {
+	if (endTime < startTime) {
+		return CandleSeries();
+	}
+
+	// Nothing newer than now is stored until a write, which invalidates
+	time_t wantedEnd = endTime >= std::time(nullptr) ? kOpenEnd : endTime;
+	std::string key = seriesKey(storage.getPath(), exchange, symbol, timeframe);
+
+	// Segments to reuse, and the generation they belong to
+	std::vector<Impl::Segment> reused;
+	uint64_t generation;
+	{
+		std::lock_guard<std::mutex> lock(pImpl->mutex);
+		Impl::Series& s = pImpl->series[key];
+		auto found = pImpl->overlapping(s, startTime, wantedEnd);
+		if (found.size() == 1 && found[0]->second.start <= startTime && found[0]->second.end >= wantedEnd) {
+			pImpl->touch(found[0]->second);
+			pImpl->stats.hits++;
+			return slice(found[0]->second.candles, startTime, endTime);
+		}
+		pImpl->stats.misses++;
+		generation = s.generation;
+		for (auto it : found) {
+			reused.push_back(it->second);
+		}
+	}
+
+	// Read only what the reused segments leave uncovered, outside the lock
+	time_t mergedStart = reused.empty() ? startTime : std::min(startTime, reused.front().start);
+	time_t mergedEnd = reused.empty() ? wantedEnd : std::max(wantedEnd, reused.back().end);
+	auto merged = std::make_shared<std::vector<Candle>>();
+	uint64_t reads = 0;
+	time_t cursor = mergedStart;
+	bool done = false;
+	for (const auto& segment : reused) {
+		if (segment.start > cursor) {
+			std::vector<Candle> part = storage.getCandles(exchange, symbol, timeframe, cursor, segment.start - 1);
+			merged->insert(merged->end(), part.begin(), part.end());
+			reads++;
+		}
+		merged->insert(merged->end(), segment.candles->begin(), segment.candles->end());
+		if (segment.end == kOpenEnd) {
+			done = true;
+			break;
+		}
+		cursor = segment.end + 1;
+	}
+	if (!done && cursor <= mergedEnd) {
+		std::vector<Candle> part = storage.getCandles(exchange, symbol, timeframe, cursor, mergedEnd);
+		merged->insert(merged->end(), part.begin(), part.end());
+		reads++;
+	}
+	merged->shrink_to_fit();
+	std::shared_ptr<const std::vector<Candle>> candles = merged;
+
+	{
+		std::lock_guard<std::mutex> lock(pImpl->mutex);
+		pImpl->stats.storageReads += reads;
+
+		// A write since the snapshot may have changed what was read; the
+		// reader still gets it, the cache doesn't keep it
+		Impl::Series& s = pImpl->series[key];
+		if (s.generation == generation) {
+			for (auto it : pImpl->overlapping(s, mergedStart, mergedEnd)) {
+				pImpl->remove(s, it);
+			}
+			Impl::Segment segment;
+			segment.start = mergedStart;
+			segment.end = mergedEnd;
+			segment.candles = candles;
+			segment.bytes = bytesOf(*candles);
+			pImpl->add(key, s, segment);
+			pImpl->evict();
+		}
+	}
+
+	return slice(candles, startTime, endTime);
+}
+
+void CandleCache::invalidate(const std::string& path,
+                             const std::string& exchange,
+                             const std::string& symbol,
+                             const std::string& timeframe,
+                             time_t first,
+                             time_t last) {
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	auto found = pImpl->series.find(seriesKey(path, exchange, symbol, timeframe));
+	if (found == pImpl->series.end()) {
+		return;
+	}
+
+	Impl::Series& s = found->second;
+	s.generation++;
+	for (auto it : pImpl->overlapping(s, first, last)) {
+		pImpl->remove(s, it);
+		pImpl->stats.invalidations++;
+	}
+}
+
+void CandleCache::clear() {
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	for (auto& entry : pImpl->series) {
+		Impl::Series& s = entry.second;
+		s.generation++;
+		while (!s.segments.empty()) {
+			pImpl->remove(s, s.segments.begin());
+		}
+	}
+}
+
+void CandleCache::setMaxBytes(size_t bytes) {
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	pImpl->maxBytes = bytes;
+	pImpl->evict();
+}
+
+size_t CandleCache::getMaxBytes() const {
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	return pImpl->maxBytes;
+}
+
+CandleCache::Stats CandleCache::getStats() const {
+	std::lock_guard<std::mutex> lock(pImpl->mutex);
+	return pImpl->stats;
+}
+
+} // namespace Emiglio
@@ -0,0 +1,103 @@
+#ifndef EMIGLIO_CANDLECACHE_H
+#define EMIGLIO_CANDLECACHE_H
+
+#include "DataStorage.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Emiglio {
+
+// Read-only window into a cached candle series. Holds the candles alive,
+// so it stays valid after the cache evicted or invalidated them.
+class CandleSeries {
+public:
+	CandleSeries() : first(0), count(0) {}
+	CandleSeries(std::shared_ptr<const std::vector<Candle>> data, size_t first, size_t count)
+		: data(std::move(data)), first(first), count(count) {}
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	const Candle* begin() const { return data ? data->data() + first : nullptr; }
+	const Candle* end() const { return begin() + count; }
+	const Candle& operator[](size_t index) const { return (*data)[first + index]; }
+	const Candle& front() const { return (*data)[first]; }
+	const Candle& back() const { return (*data)[first + count - 1]; }
+
+	// Copies every candle in the window, for APIs that take a vector (the
+	// backtest pipeline). Prefer reading the series in place.
+	std::vector<Candle> toVector() const { return std::vector<Candle>(begin(), end()); }
+
+private:
+	std::shared_ptr<const std::vector<Candle>> data;
+	size_t first;
+	size_t count;
+};
+
+// Process-wide cache of stored candle series, in front of
+// DataStorage::getCandles() for charts and backtests.
+//
+// Per database and series it keeps disjoint segments, each the complete
+// answer for a range of open times. A request inside a segment is served
+// from memory; otherwise only the parts no segment covers are read from
+// storage, and the result replaces the segments it overlaps. Segments are
+// immutable and shared with readers. Writes through any DataStorage drop
+// the segments they touch. Least recently used segments are evicted past
+// the memory budget.
+class CandleCache {
+public:
+	struct Stats {
+		uint64_t hits = 0;          // Served without touching storage
+		uint64_t misses = 0;
+		uint64_t storageReads = 0;  // getCandles() calls made for misses
+		uint64_t invalidations = 0;
+		uint64_t evictions = 0;
+		size_t segments = 0;
+		size_t bytes = 0;
+	};
+
+	static CandleCache& getInstance();
+
+	// Candles of [startTime, endTime] from 'storage'. A range reaching the
+	// present also covers candles stored later, until a write invalidates it.
+	CandleSeries getCandles(DataStorage& storage,
+	                        const std::string& exchange,
+	                        const std::string& symbol,
+	                        const std::string& timeframe,
+	                        time_t startTime,
+	                        time_t endTime);
+
+	// Drop cached candles of a series overlapping [first, last]
+	void invalidate(const std::string& path,
+	                const std::string& exchange,
+	                const std::string& symbol,
+	                const std::string& timeframe,
+	                time_t first,
+	                time_t last);
+	void clear();
+
+	// Memory budget in bytes (default 128 MB)
+	void setMaxBytes(size_t bytes);
+	size_t getMaxBytes() const;
+
+	Stats getStats() const;
+
+	CandleCache(const CandleCache&) = delete;
+	CandleCache& operator=(const CandleCache&) = delete;
+
+private:
+	CandleCache();
+	~CandleCache();
+
+	class Impl;
+	std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_CANDLECACHE_H
@@ -0,0 +1,647 @@
+#include "CandleFile.h"
+#include "../utils/Logger.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace Emiglio {
+
+namespace {
+
+const char kBinaryMagic[4] = {'E', 'M', 'G', 'C'};
+const uint32_t kBinaryVersion = 1;
+
+// Timestamps above this are milliseconds (year 5138 in seconds), above the
+// second one microseconds (Binance spot dumps since 2025)
+const int64_t kMillisecondThreshold = 100000000000LL;
+const int64_t kMicrosecondThreshold = 100000000000000LL;
+
+// Smaller CSV texts are not worth another parsing thread
+const size_t kMinChunkBytes = 1024 * 1024;
+
+// Powers of ten that are exact doubles
+const double kPowersOfTen[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int kMaxExactPower = 22;
+
+// Integers up to 2^53 are exact doubles
+const uint64_t kMaxExactMantissa = 1ULL << 53;
+
+// Zip records (APPNOTE.TXT 4.3)
+const uint32_t kZipLocalSignature = 0x04034b50;
+const uint32_t kZipCentralSignature = 0x02014b50;
+const uint32_t kZipEndSignature = 0x06054b50;
+const size_t kZipLocalSize = 30;
+const size_t kZipCentralSize = 46;
+const size_t kZipEndSize = 22;
+const uint16_t kZipStored = 0;
+const uint16_t kZipDeflated = 8;
+
+// On-disk record of the binary format
+struct BinaryCandle {
+	int64_t timestamp;
+	double open;
+	double high;
+	double low;
+	double close;
+	double volume;
+};
+
+bool endsWith(const std::string& value, const std::string& suffix) {
+	return value.size() >= suffix.size() &&
+	       value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool writeString(FILE* file, const std::string& value) {
+	uint32_t size = static_cast<uint32_t>(value.size());
+	return fwrite(&size, sizeof(size), 1, file) == 1 &&
+	       (size == 0 || fwrite(value.data(), 1, size, file) == size);
+}
+
+bool readString(FILE* file, std::string& value) {
+	uint32_t size = 0;
+	if (fread(&size, sizeof(size), 1, file) != 1 || size > 4096) {
+		return false;
+	}
+	value.resize(size);
+	return size == 0 || fread(&value[0], 1, size, file) == size;
+}
+
+uint16_t readLE16(const unsigned char* p) {
+	return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readLE32(const unsigned char* p) {
+	return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+	       (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// Read-only memory map of a whole file
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& path) : fd(-1), data(nullptr), size(0) {
+		fd = open(path.c_str(), O_RDONLY);
+		struct stat info;
+		if (fd < 0 || fstat(fd, &info) != 0) {
+			return;
+		}
+		size = static_cast<size_t>(info.st_size);
+		if (size > 0) {
+			void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			data = mapped == MAP_FAILED ? nullptr : static_cast<const char*>(mapped);
+		}
+	}
+
+	~MappedFile() {
+		if (data) {
+			munmap(const_cast<char*>(data), size);
+		}
+		if (fd >= 0) {
+			::close(fd);
+		}
+	}
+
+	bool isOpen() const { return fd >= 0 && (size == 0 || data); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	int fd;
+	const char* data;
+	size_t size;
+};
+
+// Unsigned integer at 'p'; returns the end of its digits, or nullptr
+const char* parseInteger(const char* p, const char* end, int64_t& value) {
+	const char* start = p;
+	uint64_t result = 0;
+	for (; p < end && *p >= '0' && *p <= '9' && p - start < 18; p++) {
+		result = result * 10 + static_cast<uint64_t>(*p - '0');
+	}
+	if (p == start || (p < end && *p >= '0' && *p <= '9')) {
+		return nullptr;
+	}
+	value = static_cast<int64_t>(result);
+	return p;
+}
+
+// Decimal number at 'p'; returns the end of it, or nullptr. Plain decimals
+// such as "42283.58000000" are read as an integer divided by an exact power
+// of ten, which rounds exactly like strtod; anything else goes to strtod.
+const char* parseNumber(const char* p, const char* end, double& value) {
+	const char* start = p;
+	bool negative = p < end && *p == '-';
+	if (negative) {
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int fraction = 0;
+	for (; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+		mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++, digits++, fraction++) {
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+		}
+	}
+
+	bool plain = digits > 0 && digits <= 19 && mantissa <= kMaxExactMantissa && fraction <= kMaxExactPower &&
+	             (p == end || (*p != 'e' && *p != 'E'));
+	if (plain) {
+		value = static_cast<double>(mantissa) / kPowersOfTen[fraction];
+		if (negative) {
+			value = -value;
+		}
+		return p;
+	}
+
+	// The text isn't terminated where the number ends: copy it out
+	const char* tokenEnd = start;
+	while (tokenEnd < end && *tokenEnd != ',' && *tokenEnd != '\n' && *tokenEnd != '\r') {
+		tokenEnd++;
+	}
+	char buffer[64];
+	size_t length = static_cast<size_t>(tokenEnd - start);
+	if (length == 0 || length >= sizeof(buffer)) {
+		return nullptr;
+	}
+	std::memcpy(buffer, start, length);
+	buffer[length] = '\0';
+	char* parsedEnd = nullptr;
+	value = std::strtod(buffer, &parsedEnd);
+	return parsedEnd == buffer + length ? tokenEnd : nullptr;
+}
+
+// Parse the line [p, lineEnd); returns false for headers and malformed lines
+bool parseLine(const char* p, const char* lineEnd, Candle& candle) {
+	int64_t timestamp = 0;
+	p = parseInteger(p, lineEnd, timestamp);
+	if (!p || p == lineEnd || *p != ',') {
+		return false;
+	}
+
+	double values[5];
+	for (int i = 0; i < 5; i++) {
+		p = parseNumber(p + 1, lineEnd, values[i]);
+		if (!p || (p != lineEnd && *p != ',') || (i < 4 && p == lineEnd)) {
+			return false;
+		}
+	}
+
+	if (timestamp >= kMicrosecondThreshold) {
+		timestamp /= 1000000;
+	} else if (timestamp >= kMillisecondThreshold) {
+		timestamp /= 1000;
+	}
+	candle.timestamp = static_cast<time_t>(timestamp);
+	candle.open = values[0];
+	candle.high = values[1];
+	candle.low = values[2];
+	candle.close = values[3];
+	candle.volume = values[4];
+	return true;
+}
+
+struct ParsedChunk {
+	std::vector<Candle> candles;
+	size_t skipped = 0;
+};
+
+// Parse the whole lines of [p, end); 'atStart' when the first one may be a header
+void parseChunk(const char* p, const char* end, bool atStart, const Candle& prototype, ParsedChunk& out) {
+	Candle candle = prototype;
+	bool firstLine = atStart;
+	while (p < end) {
+		const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		const char* next = newline ? newline + 1 : end;
+		const char* lineEnd = newline ? newline : end;
+		if (lineEnd > p && lineEnd[-1] == '\r') {
+			lineEnd--;
+		}
+
+		if (lineEnd > p && *p != '#') {
+			if (parseLine(p, lineEnd, candle)) {
+				out.candles.push_back(candle);
+			} else if (!firstLine) {
+				out.skipped++;
+			}
+		}
+		firstLine = false;
+		p = next;
+	}
+}
+
+bool inflateRaw(const unsigned char* data, size_t size, size_t rawSize, std::vector<char>& out) {
+	out.resize(rawSize);
+	z_stream stream;
+	std::memset(&stream, 0, sizeof(stream));
+	if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+		return false;
+	}
+	stream.next_in = const_cast<Bytef*>(data);
+	stream.avail_in = static_cast<uInt>(size);
+	stream.next_out = reinterpret_cast<Bytef*>(out.data());
+	stream.avail_out = static_cast<uInt>(rawSize);
+	int rc = inflate(&stream, Z_FINISH);
+	bool ok = rc == Z_STREAM_END && stream.total_out == rawSize;
+	inflateEnd(&stream);
+	return ok;
+}
+
+bool byTimestamp(const Candle& a, const Candle& b) {
+	return a.timestamp < b.timestamp;
+}
+
+} // namespace
+
+CandleFile::CandleFile()
+	: parseThreads(0)
+	, skippedLines(0) {
+}
+
+CandleFile::~CandleFile() {
+}
+
+bool CandleFile::load(const std::string& path, std::vector<Candle>& candles,
+                      const std::string& exchange,
+                      const std::string& symbol,
+                      const std::string& timeframe) {
+	if (endsWith(path, ".bin")) {
+		return loadBinary(path, candles);
+	}
+	if (endsWith(path, ".zip")) {
+		return loadZip(path, candles, exchange, symbol, timeframe);
+	}
+	return loadCSV(path, candles, exchange, symbol, timeframe);
+}
+
+bool CandleFile::loadCSV(const std::string& path, std::vector<Candle>& candles,
+                         const std::string& exchange,
+                         const std::string& symbol,
+                         const std::string& timeframe) {
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		lastError = "Failed to open file: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	if (!parseCSV(file.data, file.size, candles, exchange, symbol, timeframe, path)) {
+		return false;
+	}
+
+	LOG_INFO("Loaded " + std::to_string(candles.size()) + " candles from " + path);
+	return true;
+}
+
+bool CandleFile::loadZip(const std::string& path, std::vector<Candle>& candles,
+                         const std::string& exchange,
+                         const std::string& symbol,
+                         const std::string& timeframe) {
+	MappedFile file(path);
+	if (!file.isOpen()) {
+		lastError = "Failed to open file: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	const unsigned char* base = reinterpret_cast<const unsigned char*>(file.data);
+	const unsigned char* end = base + file.size;
+
+	// The end record is last, followed only by a comment of up to 64 KB
+	const unsigned char* record = nullptr;
+	if (file.size >= kZipEndSize) {
+		const unsigned char* lowest = end - std::min<size_t>(file.size, kZipEndSize + 0xFFFF);
+		for (const unsigned char* p = end - kZipEndSize; p >= lowest && !record; p--) {
+			if (readLE32(p) == kZipEndSignature) {
+				record = p;
+			}
+		}
+	}
+	if (!record) {
+		lastError = "Not a zip file: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	uint16_t entries = readLE16(record + 10);
+	uint32_t directorySize = readLE32(record + 12);
+	uint32_t directoryOffset = readLE32(record + 16);
+	if (static_cast<uint64_t>(directoryOffset) + directorySize > file.size) {
+		lastError = "Corrupt zip file: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	candles.clear();
+	size_t skipped = 0;
+	std::vector<char> text;
+	const unsigned char* entry = base + directoryOffset;
+	for (uint16_t i = 0; i < entries; i++) {
+		if (end - entry < static_cast<ptrdiff_t>(kZipCentralSize) || readLE32(entry) != kZipCentralSignature) {
+			lastError = "Corrupt zip file: " + path;
+			LOG_ERROR(lastError);
+			return false;
+		}
+		uint16_t method = readLE16(entry + 10);
+		uint32_t compressedSize = readLE32(entry + 20);
+		uint32_t rawSize = readLE32(entry + 24);
+		uint16_t nameLength = readLE16(entry + 28);
+		uint32_t localOffset = readLE32(entry + 42);
+		std::string name(reinterpret_cast<const char*>(entry) + kZipCentralSize,
+		                 std::min<size_t>(nameLength, end - entry - kZipCentralSize));
+		entry += kZipCentralSize + nameLength + readLE16(entry + 30) + readLE16(entry + 32);
+
+		if (!endsWith(name, ".csv")) {
+			continue;
+		}
+		if (compressedSize == 0xFFFFFFFF || rawSize == 0xFFFFFFFF || localOffset == 0xFFFFFFFF) {
+			lastError = "ZIP64 archives are not supported: " + path;
+			LOG_ERROR(lastError);
+			return false;
+		}
+
+		// Data follows the local header, whose name and extra field may
+		// differ in length from the central directory's
+		const unsigned char* local = base + localOffset;
+		if (localOffset > file.size || end - local < static_cast<ptrdiff_t>(kZipLocalSize) ||
+		    readLE32(local) != kZipLocalSignature) {
+			lastError = "Corrupt zip file: " + path;
+			LOG_ERROR(lastError);
+			return false;
+		}
+		const unsigned char* data = local + kZipLocalSize + readLE16(local + 26) + readLE16(local + 28);
+		if (data > end || static_cast<size_t>(end - data) < compressedSize) {
+			lastError = "Truncated zip file: " + path;
+			LOG_ERROR(lastError);
+			return false;
+		}
+
+		const char* csv = reinterpret_cast<const char*>(data);
+		size_t csvSize = compressedSize;
+		if (method == kZipDeflated) {
+			if (!inflateRaw(data, compressedSize, rawSize, text)) {
+				lastError = "Failed to decompress " + name + " in " + path;
+				LOG_ERROR(lastError);
+				return false;
+			}
+			csv = text.data();
+			csvSize = text.size();
+		} else if (method != kZipStored) {
+			lastError = "Unsupported compression method " + std::to_string(method) + " in " + path;
+			LOG_ERROR(lastError);
+			return false;
+		}
+
+		std::vector<Candle> part;
+		if (!parseCSV(csv, csvSize, part, exchange, symbol, timeframe, path + ":" + name)) {
+			return false;
+		}
+		skipped += skippedLines;
+		if (candles.empty()) {
+			candles = std::move(part);
+		} else {
+			candles.insert(candles.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+		}
+	}
+	skippedLines = skipped;
+
+	if (!std::is_sorted(candles.begin(), candles.end(), byTimestamp)) {
+		std::stable_sort(candles.begin(), candles.end(), byTimestamp);
+	}
+
+	LOG_INFO("Loaded " + std::to_string(candles.size()) + " candles from " + path);
+	return true;
+}
+
+bool CandleFile::parseCSV(const char* data, size_t size, std::vector<Candle>& candles,
+                          const std::string& exchange,
+                          const std::string& symbol,
+                          const std::string& timeframe,
+                          const std::string& source) {
+	candles.clear();
+	skippedLines = 0;
+	if (size == 0) {
+		return true;
+	}
+
+	Candle prototype;
+	prototype.exchange = exchange;
+	prototype.symbol = symbol;
+	prototype.timeframe = timeframe;
+
+	unsigned int threads = parseThreads > 0 ? parseThreads : std::thread::hardware_concurrency();
+	size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threads, size / kMinChunkBytes + 1));
+
+	// Chunks end just after a newline, so each holds whole lines
+	const char* end = data + size;
+	std::vector<const char*> bounds(1, data);
+	for (size_t i = 1; i < chunkCount; i++) {
+		const char* p = std::max(data + size / chunkCount * i, bounds.back());
+		const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		bounds.push_back(newline ? newline + 1 : end);
+	}
+	bounds.push_back(end);
+
+	std::vector<ParsedChunk> chunks(chunkCount);
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < chunkCount; i++) {
+		workers.emplace_back(parseChunk, bounds[i], bounds[i + 1], false,
+		                     std::cref(prototype), std::ref(chunks[i]));
+	}
+	parseChunk(bounds[0], bounds[1], true, prototype, chunks[0]);
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	size_t total = 0;
+	for (const auto& chunk : chunks) {
+		total += chunk.candles.size();
+		skippedLines += chunk.skipped;
+	}
+	candles = std::move(chunks[0].candles);
+	candles.reserve(total);
+	for (size_t i = 1; i < chunkCount; i++) {
+		candles.insert(candles.end(), std::make_move_iterator(chunks[i].candles.begin()),
+		               std::make_move_iterator(chunks[i].candles.end()));
+	}
+
+	if (skippedLines > 0) {
+		LOG_WARNING("Skipped " + std::to_string(skippedLines) + " malformed lines in " + source);
+	}
+
+	// Dumps concatenated from several files are not guaranteed to be ordered
+	if (!std::is_sorted(candles.begin(), candles.end(), byTimestamp)) {
+		std::stable_sort(candles.begin(), candles.end(), byTimestamp);
+	}
+
+	return true;
+}
+
+bool CandleFile::saveCSV(const std::string& path, const std::vector<Candle>& candles) {
+	FILE* file = fopen(path.c_str(), "w");
+	if (!file) {
+		lastError = "Failed to open file for writing: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	fprintf(file, "timestamp,open,high,low,close,volume\n");
+	for (const auto& candle : candles) {
+		fprintf(file, "%lld,%.17g,%.17g,%.17g,%.17g,%.17g\n",
+		        static_cast<long long>(candle.timestamp),
+		        candle.open, candle.high, candle.low, candle.close, candle.volume);
+	}
+
+	bool ok = (ferror(file) == 0);
+	fclose(file);
+
+	if (!ok) {
+		lastError = "Failed to write file: " + path;
+		LOG_ERROR(lastError);
+	}
+	return ok;
+}
+
+bool CandleFile::loadBinary(const std::string& path, std::vector<Candle>& candles) {
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) {
+		lastError = "Failed to open file: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	uint64_t count = 0;
+	std::string exchange, symbol, timeframe;
+
+	bool ok = fread(magic, sizeof(magic), 1, file) == 1 &&
+	          std::memcmp(magic, kBinaryMagic, sizeof(magic)) == 0 &&
+	          fread(&version, sizeof(version), 1, file) == 1 &&
+	          version == kBinaryVersion &&
+	          readString(file, exchange) &&
+	          readString(file, symbol) &&
+	          readString(file, timeframe) &&
+	          fread(&count, sizeof(count), 1, file) == 1;
+
+	if (!ok) {
+		fclose(file);
+		lastError = "Not a candle file: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	// The records must fill the rest of the file exactly; checked before
+	// allocating, so a corrupt count can't ask for gigabytes
+	long header = ftell(file);
+	struct stat info;
+	if (header < 0 || fstat(fileno(file), &info) != 0 ||
+	    static_cast<uint64_t>(info.st_size) < static_cast<uint64_t>(header) ||
+	    count != (static_cast<uint64_t>(info.st_size) - header) / sizeof(BinaryCandle) ||
+	    (static_cast<uint64_t>(info.st_size) - header) % sizeof(BinaryCandle) != 0) {
+		fclose(file);
+		candles.clear();
+		lastError = "Candle count doesn't match file size: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	candles.clear();
+	candles.resize(static_cast<size_t>(count));
+
+	// Read in blocks to keep the staging buffer small
+	std::vector<BinaryCandle> buffer(std::min<uint64_t>(count, 65536));
+	size_t loaded = 0;
+	while (loaded < count) {
+		size_t want = std::min<size_t>(buffer.size(), static_cast<size_t>(count) - loaded);
+		if (fread(buffer.data(), sizeof(BinaryCandle), want, file) != want) {
+			ok = false;
+			break;
+		}
+
+		for (size_t i = 0; i < want; i++) {
+			Candle& candle = candles[loaded + i];
+			candle.exchange = exchange;
+			candle.symbol = symbol;
+			candle.timeframe = timeframe;
+			candle.timestamp = static_cast<time_t>(buffer[i].timestamp);
+			candle.open = buffer[i].open;
+			candle.high = buffer[i].high;
+			candle.low = buffer[i].low;
+			candle.close = buffer[i].close;
+			candle.volume = buffer[i].volume;
+		}
+		loaded += want;
+	}
+
+	fclose(file);
+
+	if (!ok) {
+		candles.clear();
+		lastError = "Truncated candle file: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	LOG_INFO("Loaded " + std::to_string(candles.size()) + " candles from " + path);
+	return true;
+}
+
+bool CandleFile::saveBinary(const std::string& path, const std::vector<Candle>& candles) {
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) {
+		lastError = "Failed to open file for writing: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	std::string exchange = candles.empty() ? "" : candles.front().exchange;
+	std::string symbol = candles.empty() ? "" : candles.front().symbol;
+	std::string timeframe = candles.empty() ? "" : candles.front().timeframe;
+	uint64_t count = candles.size();
+
+	bool ok = fwrite(kBinaryMagic, sizeof(kBinaryMagic), 1, file) == 1 &&
+	          fwrite(&kBinaryVersion, sizeof(kBinaryVersion), 1, file) == 1 &&
+	          writeString(file, exchange) &&
+	          writeString(file, symbol) &&
+	          writeString(file, timeframe) &&
+	          fwrite(&count, sizeof(count), 1, file) == 1;
+
+	for (size_t i = 0; ok && i < candles.size(); i++) {
+		BinaryCandle record;
+		record.timestamp = static_cast<int64_t>(candles[i].timestamp);
+		record.open = candles[i].open;
+		record.high = candles[i].high;
+		record.low = candles[i].low;
+		record.close = candles[i].close;
+		record.volume = candles[i].volume;
+		ok = fwrite(&record, sizeof(record), 1, file) == 1;
+	}
+
+	fclose(file);
+
+	if (!ok) {
+		lastError = "Failed to write file: " + path;
+		LOG_ERROR(lastError);
+	}
+	return ok;
+}
+
+} // namespace Emiglio
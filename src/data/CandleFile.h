@@ -0,0 +1,70 @@
+#ifndef EMIGLIO_CANDLEFILE_H
+#define EMIGLIO_CANDLEFILE_H
+
+#include "DataStorage.h"
+
+#include <string>
+#include <vector>
+
+namespace Emiglio {
+
+// Reads and writes candle series outside the database.
+//
+// CSV: one candle per line, "timestamp,open,high,low,close,volume[,...]".
+// Extra columns are ignored, so Binance kline dumps load as-is. Timestamps
+// in milliseconds or microseconds are converted to seconds and a header
+// line is skipped. Files are memory-mapped and parsed in parallel chunks.
+//
+// Zip (.zip): the CSV files inside, as published on data.binance.vision.
+//
+// Binary (.bin): a small header followed by fixed-size records, for fast
+// repeated loading of large series.
+class CandleFile {
+public:
+	CandleFile();
+	~CandleFile();
+
+	// Load by extension (.csv, .zip or .bin). 'symbol' and 'timeframe' fill
+	// the candle fields for CSV files, which don't carry them.
+	bool load(const std::string& path, std::vector<Candle>& candles,
+	          const std::string& exchange = "binance",
+	          const std::string& symbol = "",
+	          const std::string& timeframe = "");
+
+	bool loadCSV(const std::string& path, std::vector<Candle>& candles,
+	             const std::string& exchange,
+	             const std::string& symbol,
+	             const std::string& timeframe);
+	bool loadZip(const std::string& path, std::vector<Candle>& candles,
+	             const std::string& exchange,
+	             const std::string& symbol,
+	             const std::string& timeframe);
+	bool saveCSV(const std::string& path, const std::vector<Candle>& candles);
+
+	// Parse CSV text already in memory; 'source' names it in log messages
+	bool parseCSV(const char* data, size_t size, std::vector<Candle>& candles,
+	              const std::string& exchange,
+	              const std::string& symbol,
+	              const std::string& timeframe,
+	              const std::string& source = "");
+
+	bool loadBinary(const std::string& path, std::vector<Candle>& candles);
+	bool saveBinary(const std::string& path, const std::vector<Candle>& candles);
+
+	// Threads used to parse CSV text (default 0: one per core)
+	void setParseThreads(unsigned int threads) { parseThreads = threads; }
+
+	// Lines that were neither candles nor a header in the last load
+	size_t getSkippedLines() const { return skippedLines; }
+
+	std::string getLastError() const { return lastError; }
+
+private:
+	std::string lastError;
+	unsigned int parseThreads;
+	size_t skippedLines;
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_CANDLEFILE_H
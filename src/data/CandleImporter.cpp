@@ -0,0 +1,192 @@
+#include "CandleImporter.h"
+#include "CandleFile.h"
+#include "CandleResampler.h"
+#include "../utils/Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+
+namespace Emiglio {
+
+struct CandleImporter::LoadedFile {
+	std::string path;
+	std::string symbol;
+	std::string timeframe;
+	std::vector<Candle> candles;
+	size_t malformedLines = 0;
+	std::string error;
+};
+
+CandleImporter::CandleImporter(DataStorage& storage)
+	: storage(storage)
+	, exchange("binance")
+	, parseThreads(0) {
+}
+
+CandleImporter::~CandleImporter() {
+}
+
+bool CandleImporter::parseDumpName(const std::string& path, std::string& symbol, std::string& timeframe) {
+	size_t slash = path.find_last_of('/');
+	std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+
+	size_t first = name.find('-');
+	size_t second = first == std::string::npos ? first : name.find('-', first + 1);
+	if (first == 0 || second == std::string::npos) {
+		return false;
+	}
+
+	std::string parsedTimeframe = name.substr(first + 1, second - first - 1);
+	if (CandleResampler::timeframeToSeconds(parsedTimeframe) <= 0) {
+		return false;
+	}
+	symbol = name.substr(0, first);
+	timeframe = parsedTimeframe;
+	return true;
+}
+
+CandleImporter::LoadedFile CandleImporter::load(const std::string& path,
+                                                const std::string& symbol,
+                                                const std::string& timeframe) const {
+	LoadedFile file;
+	file.path = path;
+	file.symbol = symbol;
+	file.timeframe = timeframe;
+
+	std::string nameSymbol, nameTimeframe;
+	if (parseDumpName(path, nameSymbol, nameTimeframe)) {
+		if (file.symbol.empty()) file.symbol = nameSymbol;
+		if (file.timeframe.empty()) file.timeframe = nameTimeframe;
+	}
+	if (file.symbol.empty() || file.timeframe.empty()) {
+		file.error = "No symbol and timeframe given for " + path;
+		return file;
+	}
+	if (CandleResampler::timeframeToSeconds(file.timeframe) <= 0) {
+		file.error = "Unknown timeframe " + file.timeframe + " for " + path;
+		return file;
+	}
+
+	CandleFile reader;
+	reader.setParseThreads(parseThreads);
+	if (!reader.load(path, file.candles, exchange, file.symbol, file.timeframe)) {
+		file.error = reader.getLastError();
+	}
+	file.malformedLines = reader.getSkippedLines();
+	return file;
+}
+
+bool CandleImporter::store(LoadedFile& file) {
+	if (!file.error.empty()) {
+		lastError = file.error;
+		LOG_ERROR(lastError);
+		stats.failedFiles++;
+		return false;
+	}
+
+	std::vector<Candle>& candles = file.candles;
+	stats.parsed += candles.size();
+	stats.malformedLines += file.malformedLines;
+	if (candles.empty()) {
+		LOG_WARNING("No candles in " + file.path);
+		stats.files++;
+		return true;
+	}
+
+	// Sorted by CandleFile; a candle repeated in the file is stored once
+	size_t parsed = candles.size();
+	candles.erase(std::unique(candles.begin(), candles.end(), [](const Candle& a, const Candle& b) {
+		return a.timestamp == b.timestamp;
+	}), candles.end());
+
+	int64_t interval = CandleResampler::timeframeToSeconds(file.timeframe);
+	CandleRange fetched(candles.front().timestamp, candles.back().timestamp);
+
+	// Coverage is kept on interval multiples; 1w and 1M candles aren't, so
+	// those are upserted whole without it
+	bool aligned = std::all_of(candles.begin(), candles.end(), [interval](const Candle& candle) {
+		return candle.timestamp % interval == 0;
+	});
+
+	bool ok;
+	size_t inserted;
+	if (aligned) {
+		// Keep the candles of ranges the series doesn't cover yet
+		std::vector<CandleRange> missing = storage.getMissingRanges(exchange, file.symbol, file.timeframe,
+		                                                            fetched, interval);
+		std::vector<Candle> fresh;
+		size_t range = 0;
+		for (auto& candle : candles) {
+			while (range < missing.size() && missing[range].end < candle.timestamp) {
+				range++;
+			}
+			if (range == missing.size()) {
+				break;
+			}
+			if (candle.timestamp >= missing[range].start) {
+				fresh.push_back(std::move(candle));
+			}
+		}
+		inserted = fresh.size();
+		ok = fresh.empty() || storage.insertCandles(fresh, fetched, interval);
+	} else {
+		inserted = candles.size();
+		ok = storage.insertCandles(candles);
+	}
+
+	if (!ok) {
+		lastError = "Failed to store candles from " + file.path;
+		LOG_ERROR(lastError);
+		stats.failedFiles++;
+		return false;
+	}
+
+	stats.files++;
+	stats.inserted += inserted;
+	stats.skipped += parsed - inserted;
+	LOG_INFO("Imported " + file.path + ": " + std::to_string(inserted) + " new candles, " +
+	         std::to_string(parsed - inserted) + " already stored");
+	return true;
+}
+
+bool CandleImporter::importFiles(const std::vector<std::string>& paths,
+                                 const std::string& symbol,
+                                 const std::string& timeframe) {
+	stats = Stats();
+	lastError.clear();
+	auto started = std::chrono::steady_clock::now();
+
+	// Parse the next file while the current one is written; SQLite takes
+	// one writer, parsing spreads over the cores
+	std::future<LoadedFile> next;
+	if (!paths.empty()) {
+		next = std::async(std::launch::async, &CandleImporter::load, this, paths[0], symbol, timeframe);
+	}
+
+	bool ok = true;
+	for (size_t i = 0; i < paths.size(); i++) {
+		LoadedFile file = next.get();
+		if (i + 1 < paths.size()) {
+			next = std::async(std::launch::async, &CandleImporter::load, this, paths[i + 1], symbol, timeframe);
+		}
+
+		ok = store(file) && ok;
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+		if (progressCallback) {
+			progressCallback(file.path, stats);
+		}
+	}
+
+	LOG_INFO("Imported " + std::to_string(stats.inserted) + " candles from " +
+	         std::to_string(stats.files) + " files in " + std::to_string(stats.seconds) + "s");
+	return ok;
+}
+
+bool CandleImporter::importFile(const std::string& path,
+                                const std::string& symbol,
+                                const std::string& timeframe) {
+	return importFiles(std::vector<std::string>(1, path), symbol, timeframe);
+}
+
+} // namespace Emiglio
@@ -0,0 +1,76 @@
+#ifndef EMIGLIO_CANDLEIMPORTER_H
+#define EMIGLIO_CANDLEIMPORTER_H
+
+#include "DataStorage.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Emiglio {
+
+// Bulk loads candle dumps into storage, such as the monthly and daily kline
+// files Binance publishes on data.binance.vision ("BTCUSDT-1m-2024-01.zip").
+//
+// Files are parsed by CandleFile (memory-mapped, in parallel chunks) while
+// the previous file is being written. Candles in ranges the series already
+// covers are skipped, so re-importing or overlapping dumps only add what is
+// missing, and each file's range is recorded as covered.
+class CandleImporter {
+public:
+	struct Stats {
+		size_t files = 0;           // Imported
+		size_t failedFiles = 0;
+		uint64_t parsed = 0;        // Candles read from files
+		uint64_t inserted = 0;
+		uint64_t skipped = 0;       // Already stored or duplicated in the files
+		uint64_t malformedLines = 0;
+		double seconds = 0.0;
+	};
+
+	// Called after each file with the totals so far
+	using ProgressCallback = std::function<void(const std::string& path, const Stats& stats)>;
+
+	explicit CandleImporter(DataStorage& storage);
+	~CandleImporter();
+
+	void setExchange(const std::string& exchange) { this->exchange = exchange; }
+
+	// Threads used to parse each file (default 0: one per core)
+	void setParseThreads(unsigned int threads) { parseThreads = threads; }
+
+	void setProgressCallback(ProgressCallback callback) { progressCallback = callback; }
+
+	// Import files in order. Symbol and timeframe come from each file name
+	// unless given. Returns false if any file failed; the others are kept.
+	bool importFiles(const std::vector<std::string>& paths,
+	                 const std::string& symbol = "",
+	                 const std::string& timeframe = "");
+	bool importFile(const std::string& path,
+	                const std::string& symbol = "",
+	                const std::string& timeframe = "");
+
+	// Symbol and timeframe of a Binance dump name, "<SYMBOL>-<timeframe>-<date>.zip"
+	static bool parseDumpName(const std::string& path, std::string& symbol, std::string& timeframe);
+
+	const Stats& getStats() const { return stats; }
+	std::string getLastError() const { return lastError; }
+
+private:
+	struct LoadedFile;
+
+	DataStorage& storage;
+	std::string exchange;
+	unsigned int parseThreads;
+	ProgressCallback progressCallback;
+	Stats stats;
+	std::string lastError;
+
+	LoadedFile load(const std::string& path, const std::string& symbol, const std::string& timeframe) const;
+	bool store(LoadedFile& file);
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_CANDLEIMPORTER_H
@@ -0,0 +1,372 @@
+#include "CandleResampler.h"
+#include "../exchange/BinanceWebSocket.h"
+#include "../utils/Logger.h"
+
+#include <algorithm>
+
+namespace Emiglio {
+
+namespace {
+
+const int64_t kDaySeconds = 86400;
+const int64_t kWeekSeconds = 7 * kDaySeconds;
+// 1970-01-01 was a Thursday, the first Monday is 4 days later
+const int64_t kFirstMonday = 4 * kDaySeconds;
+
+int64_t floorDiv(int64_t a, int64_t b) {
+	int64_t q = a / b;
+	if ((a % b != 0) && ((a < 0) != (b < 0))) {
+		q--;
+	}
+	return q;
+}
+
+// Days since epoch for a proleptic Gregorian date (Howard Hinnant's algorithm)
+int64_t daysFromCivil(int64_t y, int64_t m, int64_t d) {
+	y -= m <= 2;
+	const int64_t era = floorDiv(y, 400);
+	const int64_t yoe = y - era * 400;
+	const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+void civilFromDays(int64_t z, int64_t& y, int64_t& m, int64_t& d) {
+	z += 719468;
+	const int64_t era = floorDiv(z, 146097);
+	const int64_t doe = z - era * 146097;
+	const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const int64_t mp = (5 * doy + 2) / 153;
+	d = doy - (153 * mp + 2) / 5 + 1;
+	m = mp + (mp < 10 ? 3 : -9);
+	y = yoe + era * 400 + (m <= 2);
+}
+
+bool isMonthly(const std::string& timeframe) {
+	return timeframe == "1M";
+}
+
+// Source spacing when the candles don't carry a usable timeframe string
+int64_t inferSourceSeconds(const std::vector<Candle>& source) {
+	int64_t seconds = CandleResampler::timeframeToSeconds(source.front().timeframe);
+	if (seconds > 0) {
+		return seconds;
+	}
+
+	int64_t minDelta = 0;
+	size_t limit = std::min<size_t>(source.size(), 64);
+	for (size_t i = 1; i < limit; i++) {
+		int64_t delta = source[i].timestamp - source[i - 1].timestamp;
+		if (delta > 0 && (minDelta == 0 || delta < minDelta)) {
+			minDelta = delta;
+		}
+	}
+	return minDelta;
+}
+
+// Fold 'candle' into an aggregate that already has an open price
+inline void mergeInto(Candle& aggregate, const Candle& candle) {
+	if (candle.high > aggregate.high) aggregate.high = candle.high;
+	if (candle.low < aggregate.low) aggregate.low = candle.low;
+	aggregate.close = candle.close;
+	aggregate.volume += candle.volume;
+}
+
+} // namespace
+
+CandleResampler::CandleResampler(const std::string& sourceTimeframe,
+                                 const std::string& targetTimeframe)
+	: sourceTimeframe(sourceTimeframe)
+	, targetTimeframe(targetTimeframe)
+	, sourceSeconds(timeframeToSeconds(sourceTimeframe))
+	, callback(nullptr)
+	, hasClosedPart(false)
+	, hasOpenPart(false)
+	, bucketStart(0)
+	, bucketEnd(0)
+{
+	if (!canResample(sourceTimeframe, targetTimeframe)) {
+		LOG_WARNING("Cannot resample " + sourceTimeframe + " candles into " + targetTimeframe);
+	}
+}
+
+CandleResampler::~CandleResampler() {
+}
+
+int64_t CandleResampler::timeframeToSeconds(const std::string& timeframe) {
+	if (timeframe == "1s") return 1;
+	if (timeframe == "1m") return 60;
+	if (timeframe == "3m") return 3 * 60;
+	if (timeframe == "5m") return 5 * 60;
+	if (timeframe == "15m") return 15 * 60;
+	if (timeframe == "30m") return 30 * 60;
+	if (timeframe == "1h") return 3600;
+	if (timeframe == "2h") return 2 * 3600;
+	if (timeframe == "4h") return 4 * 3600;
+	if (timeframe == "6h") return 6 * 3600;
+	if (timeframe == "8h") return 8 * 3600;
+	if (timeframe == "12h") return 12 * 3600;
+	if (timeframe == "1d") return kDaySeconds;
+	if (timeframe == "3d") return 3 * kDaySeconds;
+	if (timeframe == "1w") return kWeekSeconds;
+	if (timeframe == "1M") return 30 * kDaySeconds;
+	return 0;
+}
+
+bool CandleResampler::canResample(const std::string& source, const std::string& target) {
+	int64_t sourceSec = timeframeToSeconds(source);
+	int64_t targetSec = timeframeToSeconds(target);
+	if (sourceSec <= 0 || targetSec <= 0) {
+		return false;
+	}
+
+	if (isMonthly(target)) {
+		// Months are whole days, so any source that tiles a day works
+		return isMonthly(source) || kDaySeconds % sourceSec == 0;
+	}
+	if (isMonthly(source)) {
+		return false;
+	}
+
+	return targetSec >= sourceSec && targetSec % sourceSec == 0;
+}
+
+time_t CandleResampler::alignTimestamp(time_t timestamp, const std::string& timeframe) {
+	int64_t ts = static_cast<int64_t>(timestamp);
+
+	if (isMonthly(timeframe)) {
+		int64_t y, m, d;
+		civilFromDays(floorDiv(ts, kDaySeconds), y, m, d);
+		return static_cast<time_t>(daysFromCivil(y, m, 1) * kDaySeconds);
+	}
+
+	int64_t seconds = timeframeToSeconds(timeframe);
+	if (seconds <= 0) {
+		return timestamp;
+	}
+
+	if (timeframe == "1w") {
+		return static_cast<time_t>(floorDiv(ts - kFirstMonday, kWeekSeconds) * kWeekSeconds + kFirstMonday);
+	}
+
+	return static_cast<time_t>(floorDiv(ts, seconds) * seconds);
+}
+
+time_t CandleResampler::nextBucketStart(time_t bucketStart, const std::string& timeframe) {
+	if (isMonthly(timeframe)) {
+		int64_t y, m, d;
+		civilFromDays(floorDiv(static_cast<int64_t>(bucketStart), kDaySeconds), y, m, d);
+		if (++m > 12) {
+			m = 1;
+			y++;
+		}
+		return static_cast<time_t>(daysFromCivil(y, m, 1) * kDaySeconds);
+	}
+
+	return bucketStart + static_cast<time_t>(timeframeToSeconds(timeframe));
+}
+
+std::vector<Candle> CandleResampler::resample(const std::vector<Candle>& source,
+                                              const std::string& targetTimeframe,
+                                              bool completeOnly) {
+	std::vector<Candle> result;
+
+	if (source.empty()) {
+		return result;
+	}
+
+	int64_t targetSeconds = timeframeToSeconds(targetTimeframe);
+	int64_t sourceSeconds = inferSourceSeconds(source);
+	if (targetSeconds <= 0 || sourceSeconds <= 0) {
+		LOG_ERROR("Cannot resample to unknown timeframe: " + targetTimeframe);
+		return result;
+	}
+
+	result.reserve(source.size() / std::max<int64_t>(1, targetSeconds / sourceSeconds) + 2);
+
+	// Bucket bounds are only recomputed when a candle leaves the current
+	// bucket, so the inner loop is a sequential min/max/sum over the source
+	time_t currentStart = 0;
+	time_t currentEnd = 0;
+	Candle* current = nullptr;
+
+	for (const Candle& candle : source) {
+		if (current == nullptr || candle.timestamp >= currentEnd || candle.timestamp < currentStart) {
+			currentStart = alignTimestamp(candle.timestamp, targetTimeframe);
+			currentEnd = nextBucketStart(currentStart, targetTimeframe);
+
+			if (current != nullptr && currentStart == current->timestamp) {
+				// Out-of-order candle within the same bucket
+				mergeInto(*current, candle);
+				continue;
+			}
+
+			result.emplace_back();
+			current = &result.back();
+			current->exchange = candle.exchange;
+			current->symbol = candle.symbol;
+			current->timeframe = targetTimeframe;
+			current->timestamp = currentStart;
+			current->open = candle.open;
+			current->high = candle.high;
+			current->low = candle.low;
+			current->close = candle.close;
+			current->volume = candle.volume;
+			continue;
+		}
+
+		mergeInto(*current, candle);
+	}
+
+	if (completeOnly && !result.empty()) {
+		const Candle& last = source.back();
+		time_t lastBucketEnd = nextBucketStart(result.back().timestamp, targetTimeframe);
+		if (last.timestamp + sourceSeconds < lastBucketEnd) {
+			result.pop_back();
+		}
+	}
+
+	return result;
+}
+
+std::vector<Candle> CandleResampler::loadResampled(DataStorage& storage,
+                                                   const std::string& exchange,
+                                                   const std::string& symbol,
+                                                   const std::string& targetTimeframe,
+                                                   time_t startTime,
+                                                   time_t endTime,
+                                                   const std::string& baseTimeframe) {
+	if (!canResample(baseTimeframe, targetTimeframe)) {
+		LOG_ERROR("Cannot build " + targetTimeframe + " candles from " + baseTimeframe);
+		return {};
+	}
+
+	time_t alignedStart = alignTimestamp(startTime, targetTimeframe);
+	time_t alignedEnd = nextBucketStart(alignTimestamp(endTime, targetTimeframe), targetTimeframe) - 1;
+
+	std::vector<Candle> base = storage.getCandles(exchange, symbol, baseTimeframe,
+	                                              alignedStart, alignedEnd);
+	if (base.empty()) {
+		return {};
+	}
+
+	std::vector<Candle> result = resample(base, targetTimeframe, true);
+
+	// The last bucket may start after endTime only if endTime was not aligned
+	while (!result.empty() && result.back().timestamp > endTime) {
+		result.pop_back();
+	}
+
+	LOG_INFO("Resampled " + std::to_string(base.size()) + " " + baseTimeframe + " candles into " +
+	         std::to_string(result.size()) + " " + targetTimeframe + " candles for " + symbol);
+	return result;
+}
+
+void CandleResampler::setCallback(CandleCallback callback) {
+	this->callback = callback;
+}
+
+void CandleResampler::startBucket(const Candle& candle) {
+	bucketStart = alignTimestamp(candle.timestamp, targetTimeframe);
+	bucketEnd = nextBucketStart(bucketStart, targetTimeframe);
+	hasClosedPart = false;
+	hasOpenPart = false;
+}
+
+void CandleResampler::update(const Candle& candle, bool isClosed) {
+	if (hasClosedPart || hasOpenPart) {
+		if (candle.timestamp < bucketStart) {
+			return;  // Late update for a bucket that was already emitted
+		}
+		if (candle.timestamp >= bucketEnd) {
+			emitBucket();
+			startBucket(candle);
+		}
+	} else if (bucketEnd == 0 || candle.timestamp >= bucketEnd) {
+		startBucket(candle);
+	} else {
+		return;  // Bucket already emitted
+	}
+
+	if (!isClosed) {
+		openPart = candle;
+		hasOpenPart = true;
+		return;
+	}
+
+	// A closed candle replaces any open snapshot of itself
+	if (hasOpenPart && openPart.timestamp <= candle.timestamp) {
+		hasOpenPart = false;
+	}
+
+	if (!hasClosedPart) {
+		closedPart = candle;
+		closedPart.timeframe = targetTimeframe;
+		closedPart.timestamp = bucketStart;
+		hasClosedPart = true;
+	} else {
+		mergeInto(closedPart, candle);
+	}
+
+	// Emit as soon as the last source candle of the bucket closes
+	if (sourceSeconds > 0 && candle.timestamp + sourceSeconds >= bucketEnd) {
+		emitBucket();
+	}
+}
+
+void CandleResampler::update(const KlineUpdate& kline) {
+	Candle candle;
+	candle.exchange = "binance";
+	candle.symbol = kline.symbol;
+	candle.timeframe = kline.interval;
+	candle.timestamp = kline.openTime / 1000;  // Stream times are in ms
+	candle.open = kline.open;
+	candle.high = kline.high;
+	candle.low = kline.low;
+	candle.close = kline.close;
+	candle.volume = kline.volume;
+
+	update(candle, kline.isClosed);
+}
+
+bool CandleResampler::getCurrent(Candle& candle) const {
+	if (!hasClosedPart && !hasOpenPart) {
+		return false;
+	}
+
+	if (!hasClosedPart) {
+		candle = openPart;
+		candle.timeframe = targetTimeframe;
+		candle.timestamp = bucketStart;
+		return true;
+	}
+
+	candle = closedPart;
+	if (hasOpenPart) {
+		mergeInto(candle, openPart);
+	}
+	return true;
+}
+
+void CandleResampler::emitBucket() {
+	Candle candle;
+	if (getCurrent(candle) && callback) {
+		callback(candle);
+	}
+	hasClosedPart = false;
+	hasOpenPart = false;
+}
+
+void CandleResampler::flush() {
+	emitBucket();
+}
+
+void CandleResampler::reset() {
+	hasClosedPart = false;
+	hasOpenPart = false;
+	bucketStart = 0;
+	bucketEnd = 0;
+}
+
+} // namespace Emiglio
@@ -0,0 +1,106 @@
+#ifndef EMIGLIO_CANDLERESAMPLER_H
+#define EMIGLIO_CANDLERESAMPLER_H
+
+#include "DataStorage.h"
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <ctime>
+
+namespace Emiglio {
+
+struct KlineUpdate;
+
+// Builds higher timeframe candles (5m, 15m, 1h, 4h, 1d, ...) from a finer
+// series, usually the stored 1m candles. Buckets are aligned the same way
+// Binance aligns klines: intraday buckets on UTC multiples of the bucket
+// length, 1w on Monday 00:00 UTC and 1M on the first day of the month.
+class CandleResampler {
+public:
+	// Called for every completed bucket in incremental mode
+	using CandleCallback = std::function<void(const Candle&)>;
+
+	CandleResampler(const std::string& sourceTimeframe,
+	                const std::string& targetTimeframe);
+	~CandleResampler();
+
+	// Batch resampling in a single pass over 'source' (must be sorted by
+	// timestamp). When completeOnly is true, a trailing bucket that is not
+	// fully covered by the source series is dropped.
+	static std::vector<Candle> resample(const std::vector<Candle>& source,
+	                                    const std::string& targetTimeframe,
+	                                    bool completeOnly = false);
+
+	// Load 'baseTimeframe' candles from storage for [startTime, endTime]
+	// (widened to bucket boundaries) and resample them to 'targetTimeframe'
+	static std::vector<Candle> loadResampled(DataStorage& storage,
+	                                         const std::string& exchange,
+	                                         const std::string& symbol,
+	                                         const std::string& targetTimeframe,
+	                                         time_t startTime,
+	                                         time_t endTime,
+	                                         const std::string& baseTimeframe = "1m");
+
+	// Duration of a Binance interval string in seconds (0 if unknown).
+	// "1M" is reported as 30 days; use alignTimestamp() for month buckets.
+	static int64_t timeframeToSeconds(const std::string& timeframe);
+
+	// True if 'target' candles can be built from 'source' candles
+	static bool canResample(const std::string& source, const std::string& target);
+
+	// Start of the bucket containing 'timestamp'
+	static time_t alignTimestamp(time_t timestamp, const std::string& timeframe);
+
+	// Start of the bucket following the one that starts at 'bucketStart'
+	static time_t nextBucketStart(time_t bucketStart, const std::string& timeframe);
+
+	// Incremental mode: feed source candles as they arrive. 'isClosed' marks
+	// a final source candle; open ones only update the in-progress bucket.
+	// Nothing in the app feeds it yet: the live view subscribes to tickers
+	// and trades only, and backtests use resample()/loadResampled().
+	void update(const Candle& candle, bool isClosed = true);
+
+	// Incremental mode fed directly from the WebSocket kline stream
+	void update(const KlineUpdate& kline);
+
+	// In-progress bucket including the latest (possibly open) source candle.
+	// Returns false if nothing has been received yet.
+	bool getCurrent(Candle& candle) const;
+
+	// Emit the in-progress bucket even if it is not complete
+	void flush();
+
+	// Drop all incremental state
+	void reset();
+
+	void setCallback(CandleCallback callback);
+
+	const std::string& getTargetTimeframe() const { return targetTimeframe; }
+
+private:
+	std::string sourceTimeframe;
+	std::string targetTimeframe;
+	int64_t sourceSeconds;
+
+	CandleCallback callback;
+
+	// Aggregate of the closed source candles of the current bucket
+	Candle closedPart;
+	bool hasClosedPart;
+
+	// Latest source candle that is not closed yet
+	Candle openPart;
+	bool hasOpenPart;
+
+	time_t bucketStart;
+	time_t bucketEnd;
+
+	void startBucket(const Candle& candle);
+	void emitBucket();
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_CANDLERESAMPLER_H
@@ -1,7 +1,11 @@
 #include "DataStorage.h"
+#include "CandleResampler.h"
 #include "../utils/Logger.h"
 #include <sqlite3.h>
 #include <sstream>
+#include <algorithm>
+#include <limits>
+#include <mutex>
 
 namespace Emiglio {
 
@@ -21,16 +25,52 @@ public:
 	StmtHandle& operator=(const StmtHandle&) = delete;
 };
 
+namespace {
+
+// Charts, backtests and sync each hold a connection; a writer locks the
+// database for the length of a transaction, so wait that out
+const int kBusyTimeoutMs = 5000;
+
+std::mutex listenerMutex;
+std::shared_ptr<DataStorage::CandleWriteListener> candleWriteListener;
+
+void notifyCandlesChanged(const std::string& path, const std::string& exchange,
+                          const std::string& symbol, const std::string& timeframe,
+                          time_t first, time_t last) {
+	std::shared_ptr<DataStorage::CandleWriteListener> listener;
+	{
+		std::lock_guard<std::mutex> lock(listenerMutex);
+		listener = candleWriteListener;
+	}
+	if (listener) {
+		(*listener)(path, exchange, symbol, timeframe, first, last);
+	}
+}
+
+// Coverage steps through open times on multiples of the interval. 1w
+// candles open on Mondays and 1M ones on the first of the month, so those
+// series get no coverage and are always fetched whole (they are short).
+bool hasFixedOpenTimes(const std::string& timeframe) {
+	return timeframe != "1w" && timeframe != "1M";
+}
+
+} // namespace
+
 // Private implementation (PIMPL pattern)
 class DataStorage::Impl {
 public:
 	sqlite3* db;
 	bool initialized;
+	std::string path;
 
-	Impl() : db(nullptr), initialized(false) {}
+	// Candle upsert, prepared once per connection for bulk inserts
+	sqlite3_stmt* insertStmt;
+
+	Impl() : db(nullptr), initialized(false), insertStmt(nullptr) {}
 
 	~Impl() {
 		if (db) {
+			sqlite3_finalize(insertStmt);
 			sqlite3_close(db);
 		}
 	}
@@ -54,7 +94,20 @@ public:
 		return text ? reinterpret_cast<const char*>(text) : "";
 	}
 
+	bool tableExists(const std::string& name) {
+		StmtHandle stmt;
+		if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?",
+		                       -1, stmt.ptr(), nullptr) != SQLITE_OK) {
+			return false;
+		}
+		sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+		return sqlite3_step(stmt) == SQLITE_ROW;
+	}
+
 	bool createTables() {
+		// Databases from before candle_series get it filled once below
+		bool hadSeriesTable = tableExists("candle_series");
+
 		std::string sql = R"(
 			CREATE TABLE IF NOT EXISTS candles (
 				id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -70,8 +123,56 @@ public:
 				UNIQUE(exchange, symbol, timeframe, timestamp)
 			);
 
-			CREATE INDEX IF NOT EXISTS idx_candles_lookup
-			ON candles(exchange, symbol, timeframe, timestamp);
+			-- The UNIQUE constraint's index serves lookups; this copy of
+			-- it only doubled the cost of every insert
+			DROP INDEX IF EXISTS idx_candles_lookup;
+
+			-- One row per series, kept current by the triggers below so
+			-- sync and coverage checks never scan candles
+			CREATE TABLE IF NOT EXISTS candle_series (
+				exchange TEXT NOT NULL,
+				symbol TEXT NOT NULL,
+				timeframe TEXT NOT NULL,
+				first_timestamp INTEGER NOT NULL,
+				last_timestamp INTEGER NOT NULL,
+				candle_count INTEGER NOT NULL,
+				PRIMARY KEY(exchange, symbol, timeframe)
+			);
+
+			CREATE TRIGGER IF NOT EXISTS trg_candles_insert AFTER INSERT ON candles
+			BEGIN
+				INSERT INTO candle_series
+				(exchange, symbol, timeframe, first_timestamp, last_timestamp, candle_count)
+				VALUES (NEW.exchange, NEW.symbol, NEW.timeframe, NEW.timestamp, NEW.timestamp, 1)
+				ON CONFLICT(exchange, symbol, timeframe) DO UPDATE SET
+					first_timestamp = MIN(first_timestamp, excluded.first_timestamp),
+					last_timestamp = MAX(last_timestamp, excluded.last_timestamp),
+					candle_count = candle_count + 1;
+			END;
+
+			CREATE TRIGGER IF NOT EXISTS trg_candles_delete AFTER DELETE ON candles
+			BEGIN
+				UPDATE candle_series SET
+					candle_count = candle_count - 1,
+					first_timestamp = COALESCE((SELECT MIN(timestamp) FROM candles
+						WHERE exchange = OLD.exchange AND symbol = OLD.symbol AND timeframe = OLD.timeframe), 0),
+					last_timestamp = COALESCE((SELECT MAX(timestamp) FROM candles
+						WHERE exchange = OLD.exchange AND symbol = OLD.symbol AND timeframe = OLD.timeframe), 0)
+				WHERE exchange = OLD.exchange AND symbol = OLD.symbol AND timeframe = OLD.timeframe;
+				DELETE FROM candle_series
+				WHERE exchange = OLD.exchange AND symbol = OLD.symbol AND timeframe = OLD.timeframe
+				AND candle_count <= 0;
+			END;
+
+			-- Ranges of each series known to be complete, see getCoverage()
+			CREATE TABLE IF NOT EXISTS candle_coverage (
+				exchange TEXT NOT NULL,
+				symbol TEXT NOT NULL,
+				timeframe TEXT NOT NULL,
+				range_start INTEGER NOT NULL,
+				range_end INTEGER NOT NULL,
+				PRIMARY KEY(exchange, symbol, timeframe, range_start)
+			);
 
 			CREATE TABLE IF NOT EXISTS trades (
 				id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -111,9 +212,205 @@ public:
 
 			CREATE INDEX IF NOT EXISTS idx_backtest_recipe
 			ON backtest_results(recipe_name, created_at);
+
+			CREATE TABLE IF NOT EXISTS backtest_cache (
+				cache_key TEXT PRIMARY KEY,
+				recipe_name TEXT NOT NULL,
+				created_at INTEGER NOT NULL,
+				data BLOB NOT NULL
+			);
 		)";
 
-		return executeSQL(sql);
+		if (!executeSQL(sql)) {
+			return false;
+		}
+
+		if (!hadSeriesTable) {
+			return executeSQL(R"(
+				INSERT OR REPLACE INTO candle_series
+				(exchange, symbol, timeframe, first_timestamp, last_timestamp, candle_count)
+				SELECT exchange, symbol, timeframe, MIN(timestamp), MAX(timestamp), COUNT(*)
+				FROM candles GROUP BY exchange, symbol, timeframe;
+			)");
+		}
+		return true;
+	}
+
+	bool prepareForSeries(StmtHandle& stmt, const char* sql, const std::string& exchange,
+	                      const std::string& symbol, const std::string& timeframe) {
+		if (sqlite3_prepare_v2(db, sql, -1, stmt.ptr(), nullptr) != SQLITE_OK) {
+			LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
+			return false;
+		}
+		sqlite3_bind_text(stmt, 1, exchange.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(stmt, 2, symbol.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(stmt, 3, timeframe.c_str(), -1, SQLITE_TRANSIENT);
+		return true;
+	}
+
+	// Merge 'range' with the coverage rows it overlaps or touches.
+	// Runs inside the caller's transaction.
+	bool mergeCoverage(const std::string& exchange, const std::string& symbol,
+	                   const std::string& timeframe, CandleRange range, int64_t interval) {
+		const char* where = " WHERE exchange = ? AND symbol = ? AND timeframe = ?"
+		                    " AND range_start <= ? AND range_end >= ?";
+		time_t reachEnd = range.end + interval;
+		time_t reachStart = range.start - interval;
+
+		StmtHandle select;
+		std::string selectSql = std::string("SELECT MIN(range_start), MAX(range_end) FROM candle_coverage") + where;
+		if (!prepareForSeries(select, selectSql.c_str(), exchange, symbol, timeframe)) {
+			return false;
+		}
+		sqlite3_bind_int64(select, 4, reachEnd);
+		sqlite3_bind_int64(select, 5, reachStart);
+		if (sqlite3_step(select) == SQLITE_ROW && sqlite3_column_type(select, 0) != SQLITE_NULL) {
+			range.start = std::min<time_t>(range.start, sqlite3_column_int64(select, 0));
+			range.end = std::max<time_t>(range.end, sqlite3_column_int64(select, 1));
+		}
+
+		StmtHandle remove;
+		std::string removeSql = std::string("DELETE FROM candle_coverage") + where;
+		if (!prepareForSeries(remove, removeSql.c_str(), exchange, symbol, timeframe)) {
+			return false;
+		}
+		sqlite3_bind_int64(remove, 4, reachEnd);
+		sqlite3_bind_int64(remove, 5, reachStart);
+		if (sqlite3_step(remove) != SQLITE_DONE) {
+			return false;
+		}
+
+		StmtHandle insert;
+		if (!prepareForSeries(insert,
+		                      "INSERT INTO candle_coverage (exchange, symbol, timeframe, range_start, range_end)"
+		                      " VALUES (?, ?, ?, ?, ?)", exchange, symbol, timeframe)) {
+			return false;
+		}
+		sqlite3_bind_int64(insert, 4, range.start);
+		sqlite3_bind_int64(insert, 5, range.end);
+		return sqlite3_step(insert) == SQLITE_DONE;
+	}
+
+	bool writeCandle(const Candle& candle) {
+		// An upsert rather than INSERT OR REPLACE: REPLACE deletes without
+		// firing the delete trigger, which would over-count candle_series
+		const char* sql = R"(
+			INSERT INTO candles
+			(exchange, symbol, timeframe, timestamp, open, high, low, close, volume)
+			VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+			ON CONFLICT(exchange, symbol, timeframe, timestamp) DO UPDATE SET
+				open = excluded.open, high = excluded.high, low = excluded.low,
+				close = excluded.close, volume = excluded.volume
+		)";
+
+		int rc;
+		if (!insertStmt) {
+			rc = sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &insertStmt, nullptr);
+			if (rc != SQLITE_OK) {
+				LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(db)));
+				return false;
+			}
+		}
+		sqlite3_stmt* stmt = insertStmt;
+
+		sqlite3_bind_text(stmt, 1, candle.exchange.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(stmt, 2, candle.symbol.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(stmt, 3, candle.timeframe.c_str(), -1, SQLITE_TRANSIENT);
+		sqlite3_bind_int64(stmt, 4, candle.timestamp);
+		sqlite3_bind_double(stmt, 5, candle.open);
+		sqlite3_bind_double(stmt, 6, candle.high);
+		sqlite3_bind_double(stmt, 7, candle.low);
+		sqlite3_bind_double(stmt, 8, candle.close);
+		sqlite3_bind_double(stmt, 9, candle.volume);
+
+		rc = sqlite3_step(stmt);
+		sqlite3_reset(stmt);
+
+		if (rc != SQLITE_DONE) {
+			LOG_ERROR("Failed to insert candle: " + std::string(sqlite3_errmsg(db)));
+			return false;
+		}
+
+		return true;
+	}
+
+	// Mark the runs of consecutive candles in 'candles' complete: every
+	// candle in them is stored now. Runs inside the caller's transaction.
+	bool coverStored(const std::vector<Candle>& candles) {
+		size_t runStart = 0;
+		std::vector<time_t> times;
+		for (size_t i = 1; i <= candles.size(); i++) {
+			if (i < candles.size() &&
+			    candles[i].symbol == candles[runStart].symbol &&
+			    candles[i].timeframe == candles[runStart].timeframe &&
+			    candles[i].exchange == candles[runStart].exchange) {
+				continue;
+			}
+			const Candle& series = candles[runStart];
+			int64_t interval = CandleResampler::timeframeToSeconds(series.timeframe);
+			if (interval > 0 && hasFixedOpenTimes(series.timeframe)) {
+				times.clear();
+				for (size_t j = runStart; j < i; j++) {
+					if (candles[j].timestamp % interval == 0) {
+						times.push_back(candles[j].timestamp);
+					}
+				}
+				std::sort(times.begin(), times.end());
+				times.erase(std::unique(times.begin(), times.end()), times.end());
+
+				size_t first = 0;
+				for (size_t j = 1; j <= times.size(); j++) {
+					if (j < times.size() && times[j] == times[j - 1] + interval) {
+						continue;
+					}
+					if (!mergeCoverage(series.exchange, series.symbol, series.timeframe,
+					                   CandleRange(times[first], times[j - 1]), interval)) {
+						LOG_ERROR("Failed to update coverage: " + std::string(sqlite3_errmsg(db)));
+						return false;
+					}
+					first = j;
+				}
+			}
+			runStart = i;
+		}
+		return true;
+	}
+
+	// Tell the write listener which ranges of which series changed
+	void notifyWritten(const std::vector<Candle>& candles) {
+		size_t runStart = 0;
+		for (size_t i = 1; i <= candles.size(); i++) {
+			if (i < candles.size() &&
+			    candles[i].symbol == candles[runStart].symbol &&
+			    candles[i].timeframe == candles[runStart].timeframe &&
+			    candles[i].exchange == candles[runStart].exchange) {
+				continue;
+			}
+			time_t first = candles[runStart].timestamp;
+			time_t last = first;
+			for (size_t j = runStart; j < i; j++) {
+				first = std::min(first, candles[j].timestamp);
+				last = std::max(last, candles[j].timestamp);
+			}
+			notifyCandlesChanged(path, candles[runStart].exchange, candles[runStart].symbol,
+			                     candles[runStart].timeframe, first, last);
+			runStart = i;
+		}
+	}
+
+	static SeriesInfo readSeriesInfo(sqlite3_stmt* stmt) {
+		SeriesInfo info;
+		const unsigned char* text;
+		text = sqlite3_column_text(stmt, 0);
+		info.exchange = text ? reinterpret_cast<const char*>(text) : "";
+		text = sqlite3_column_text(stmt, 1);
+		info.symbol = text ? reinterpret_cast<const char*>(text) : "";
+		text = sqlite3_column_text(stmt, 2);
+		info.timeframe = text ? reinterpret_cast<const char*>(text) : "";
+		info.firstTimestamp = sqlite3_column_int64(stmt, 3);
+		info.lastTimestamp = sqlite3_column_int64(stmt, 4);
+		info.candleCount = sqlite3_column_int64(stmt, 5);
+		return info;
 	}
 };
 
@@ -141,6 +438,8 @@ bool DataStorage::init(const std::string& dbPath) {
 		return false;
 	}
 
+	sqlite3_busy_timeout(pImpl->db, kBusyTimeoutMs);
+
 	// Enable foreign keys
 	pImpl->executeSQL("PRAGMA foreign_keys = ON;");
 
@@ -151,12 +450,24 @@ bool DataStorage::init(const std::string& dbPath) {
 	}
 
 	pImpl->initialized = true;
+	pImpl->path = dbPath;
 	LOG_INFO("DataStorage initialized: " + dbPath);
 	return true;
 }
 
+const std::string& DataStorage::getPath() const {
+	return pImpl->path;
+}
+
+void DataStorage::setCandleWriteListener(CandleWriteListener listener) {
+	std::lock_guard<std::mutex> lock(listenerMutex);
+	candleWriteListener = listener ? std::make_shared<CandleWriteListener>(listener) : nullptr;
+}
+
 void DataStorage::close() {
 	if (pImpl->initialized && pImpl->db) {
+		sqlite3_finalize(pImpl->insertStmt);
+		pImpl->insertStmt = nullptr;
 		sqlite3_close(pImpl->db);
 		pImpl->db = nullptr;
 		pImpl->initialized = false;
@@ -170,39 +481,18 @@ bool DataStorage::insertCandle(const Candle& candle) {
 		return false;
 	}
 
-	const char* sql = R"(
-		INSERT OR REPLACE INTO candles
-		(exchange, symbol, timeframe, timestamp, open, high, low, close, volume)
-		VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
-	)";
-
-	// Fixed: Use RAII wrapper to ensure finalize on all paths
-	StmtHandle stmt;
-	int rc = sqlite3_prepare_v2(pImpl->db, sql, -1, stmt.ptr(), nullptr);
-	if (rc != SQLITE_OK) {
-		LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(pImpl->db)));
-		return false;  // ✅ Automatic cleanup
+	std::vector<Candle> written(1, candle);
+	pImpl->executeSQL("BEGIN TRANSACTION;");
+	if (!pImpl->writeCandle(candle) || !pImpl->coverStored(written)) {
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
 	}
-
-	sqlite3_bind_text(stmt, 1, candle.exchange.c_str(), -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text(stmt, 2, candle.symbol.c_str(), -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text(stmt, 3, candle.timeframe.c_str(), -1, SQLITE_TRANSIENT);
-	sqlite3_bind_int64(stmt, 4, candle.timestamp);
-	sqlite3_bind_double(stmt, 5, candle.open);
-	sqlite3_bind_double(stmt, 6, candle.high);
-	sqlite3_bind_double(stmt, 7, candle.low);
-	sqlite3_bind_double(stmt, 8, candle.close);
-	sqlite3_bind_double(stmt, 9, candle.volume);
-
-	rc = sqlite3_step(stmt);
-	// ✅ Automatic cleanup via destructor
-
-	if (rc != SQLITE_DONE) {
-		LOG_ERROR("Failed to insert candle: " + std::string(sqlite3_errmsg(pImpl->db)));
-		return false;  // ✅ Automatic cleanup
+	if (!pImpl->executeSQL("COMMIT;")) {
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
 	}
-
-	return true;  // ✅ Automatic cleanup
+	pImpl->notifyWritten(written);
+	return true;
 }
 
 bool DataStorage::insertCandles(const std::vector<Candle>& candles) {
@@ -215,13 +505,22 @@ bool DataStorage::insertCandles(const std::vector<Candle>& candles) {
 	pImpl->executeSQL("BEGIN TRANSACTION;");
 
 	for (const auto& candle : candles) {
-		if (!insertCandle(candle)) {
+		if (!pImpl->writeCandle(candle)) {
 			pImpl->executeSQL("ROLLBACK;");
 			return false;
 		}
 	}
 
-	pImpl->executeSQL("COMMIT;");
+	if (!pImpl->coverStored(candles)) {
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
+	}
+
+	if (!pImpl->executeSQL("COMMIT;")) {
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
+	}
+	pImpl->notifyWritten(candles);
 	LOG_INFO("Inserted " + std::to_string(candles.size()) + " candles");
 	return true;
 }
@@ -282,33 +581,338 @@ std::vector<Candle> DataStorage::getCandles(const std::string& exchange,
 int DataStorage::getCandleCount(const std::string& exchange,
                                  const std::string& symbol,
                                  const std::string& timeframe) {
+	SeriesInfo info;
+	return getSeriesInfo(exchange, symbol, timeframe, info) ? static_cast<int>(info.candleCount) : 0;
+}
+
+bool DataStorage::getSeriesInfo(const std::string& exchange,
+                                const std::string& symbol,
+                                const std::string& timeframe,
+                                SeriesInfo& info) {
 	if (!pImpl->initialized) {
-		return 0;
+		return false;
 	}
 
 	const char* sql = R"(
-		SELECT COUNT(*) FROM candles
+		SELECT exchange, symbol, timeframe, first_timestamp, last_timestamp, candle_count
+		FROM candle_series
 		WHERE exchange = ? AND symbol = ? AND timeframe = ?
 	)";
 
-	// Fixed: Use RAII wrapper to ensure finalize on all paths
 	StmtHandle stmt;
-	int rc = sqlite3_prepare_v2(pImpl->db, sql, -1, stmt.ptr(), nullptr);
-	if (rc != SQLITE_OK) {
-		return 0;  // ✅ Automatic cleanup
+	if (sqlite3_prepare_v2(pImpl->db, sql, -1, stmt.ptr(), nullptr) != SQLITE_OK) {
+		LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(pImpl->db)));
+		return false;
 	}
 
 	sqlite3_bind_text(stmt, 1, exchange.c_str(), -1, SQLITE_TRANSIENT);
 	sqlite3_bind_text(stmt, 2, symbol.c_str(), -1, SQLITE_TRANSIENT);
 	sqlite3_bind_text(stmt, 3, timeframe.c_str(), -1, SQLITE_TRANSIENT);
 
-	int count = 0;
-	if (sqlite3_step(stmt) == SQLITE_ROW) {
-		count = sqlite3_column_int(stmt, 0);
+	if (sqlite3_step(stmt) != SQLITE_ROW) {
+		return false;
 	}
+	info = Impl::readSeriesInfo(stmt);
+	return true;
+}
 
-	// ✅ Automatic cleanup via destructor
-	return count;
+std::vector<SeriesInfo> DataStorage::getAllSeriesInfo() {
+	std::vector<SeriesInfo> result;
+
+	if (!pImpl->initialized) {
+		return result;
+	}
+
+	const char* sql = R"(
+		SELECT exchange, symbol, timeframe, first_timestamp, last_timestamp, candle_count
+		FROM candle_series
+		ORDER BY exchange, symbol, timeframe
+	)";
+
+	StmtHandle stmt;
+	if (sqlite3_prepare_v2(pImpl->db, sql, -1, stmt.ptr(), nullptr) != SQLITE_OK) {
+		LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(pImpl->db)));
+		return result;
+	}
+
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		result.push_back(Impl::readSeriesInfo(stmt));
+	}
+	return result;
+}
+
+// Round 'range' inward to candle open times
+static CandleRange alignRange(const CandleRange& range, int64_t interval) {
+	time_t start = ((range.start + interval - 1) / interval) * interval;
+	time_t end = (range.end / interval) * interval;
+	return CandleRange(start, end);
+}
+
+bool DataStorage::insertCandles(const std::vector<Candle>& candles,
+                                const CandleRange& fetched,
+                                int64_t intervalSeconds) {
+	if (!pImpl->initialized) {
+		LOG_ERROR("DataStorage not initialized");
+		return false;
+	}
+	if (candles.empty() || intervalSeconds <= 0) {
+		return false;
+	}
+
+	pImpl->executeSQL("BEGIN TRANSACTION;");
+
+	for (const auto& candle : candles) {
+		if (!pImpl->writeCandle(candle)) {
+			pImpl->executeSQL("ROLLBACK;");
+			return false;
+		}
+	}
+
+	if (!pImpl->coverStored(candles)) {
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
+	}
+
+	const Candle& first = candles.front();
+	CandleRange covered = alignRange(fetched, intervalSeconds);
+	if (hasFixedOpenTimes(first.timeframe) && covered.end >= covered.start &&
+	    !pImpl->mergeCoverage(first.exchange, first.symbol, first.timeframe, covered, intervalSeconds)) {
+		LOG_ERROR("Failed to update coverage: " + std::string(sqlite3_errmsg(pImpl->db)));
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
+	}
+
+	if (!pImpl->executeSQL("COMMIT;")) {
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
+	}
+	pImpl->notifyWritten(candles);
+	LOG_INFO("Inserted " + std::to_string(candles.size()) + " candles");
+	return true;
+}
+
+bool DataStorage::addCoverage(const std::string& exchange,
+                              const std::string& symbol,
+                              const std::string& timeframe,
+                              const CandleRange& range,
+                              int64_t intervalSeconds) {
+	if (!pImpl->initialized || intervalSeconds <= 0) {
+		return false;
+	}
+
+	CandleRange covered = alignRange(range, intervalSeconds);
+	if (covered.end < covered.start || !hasFixedOpenTimes(timeframe)) {
+		return true;
+	}
+
+	pImpl->executeSQL("BEGIN TRANSACTION;");
+	if (!pImpl->mergeCoverage(exchange, symbol, timeframe, covered, intervalSeconds)) {
+		LOG_ERROR("Failed to update coverage: " + std::string(sqlite3_errmsg(pImpl->db)));
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
+	}
+	if (!pImpl->executeSQL("COMMIT;")) {
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
+	}
+	return true;
+}
+
+std::vector<CandleRange> DataStorage::getCoverage(const std::string& exchange,
+                                                  const std::string& symbol,
+                                                  const std::string& timeframe) {
+	std::vector<CandleRange> result;
+
+	if (!pImpl->initialized) {
+		return result;
+	}
+
+	StmtHandle stmt;
+	if (!pImpl->prepareForSeries(stmt,
+	                             "SELECT range_start, range_end FROM candle_coverage"
+	                             " WHERE exchange = ? AND symbol = ? AND timeframe = ?"
+	                             " ORDER BY range_start", exchange, symbol, timeframe)) {
+		return result;
+	}
+
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		result.push_back(CandleRange(sqlite3_column_int64(stmt, 0), sqlite3_column_int64(stmt, 1)));
+	}
+	return result;
+}
+
+std::vector<CandleRange> DataStorage::getMissingRanges(const std::string& exchange,
+                                                       const std::string& symbol,
+                                                       const std::string& timeframe,
+                                                       const CandleRange& range,
+                                                       int64_t intervalSeconds) {
+	std::vector<CandleRange> missing;
+
+	if (!pImpl->initialized || intervalSeconds <= 0) {
+		return missing;
+	}
+	if (!hasFixedOpenTimes(timeframe)) {
+		if (range.end >= range.start) {
+			missing.push_back(range);
+		}
+		return missing;
+	}
+
+	CandleRange wanted = alignRange(range, intervalSeconds);
+	if (wanted.end < wanted.start) {
+		return missing;
+	}
+
+	std::vector<CandleRange> coverage = getCoverage(exchange, symbol, timeframe);
+	SeriesInfo info;
+	if (coverage.empty() && getSeriesInfo(exchange, symbol, timeframe, info)) {
+		rebuildCoverage(exchange, symbol, timeframe, intervalSeconds);
+		coverage = getCoverage(exchange, symbol, timeframe);
+	}
+
+	// Coverage is sorted and disjoint: walk it once
+	time_t next = wanted.start;
+	for (const auto& covered : coverage) {
+		if (covered.end < next) {
+			continue;
+		}
+		if (covered.start > wanted.end) {
+			break;
+		}
+		if (covered.start > next) {
+			missing.push_back(CandleRange(next, covered.start - intervalSeconds));
+		}
+		next = covered.end + intervalSeconds;
+	}
+	if (next <= wanted.end) {
+		missing.push_back(CandleRange(next, wanted.end));
+	}
+	return missing;
+}
+
+std::vector<CandleRange> DataStorage::findGaps(const std::string& exchange,
+                                               const std::string& symbol,
+                                               const std::string& timeframe,
+                                               const CandleRange& range,
+                                               int64_t intervalSeconds) {
+	std::vector<CandleRange> gaps;
+
+	if (!pImpl->initialized || intervalSeconds <= 0) {
+		return gaps;
+	}
+	if (!hasFixedOpenTimes(timeframe)) {
+		LOG_WARNING("No gap scan for " + timeframe + " candles");
+		return gaps;
+	}
+
+	CandleRange wanted = alignRange(range, intervalSeconds);
+	if (wanted.end < wanted.start) {
+		return gaps;
+	}
+
+	// Consecutive stored timestamps further apart than one interval, from
+	// the (exchange, symbol, timeframe, timestamp) index alone. The first
+	// row has no predecessor; it stands in for the start of the range.
+	const char* sql = R"(
+		SELECT prev, timestamp FROM (
+			SELECT timestamp, LAG(timestamp, 1, ? - ?) OVER (ORDER BY timestamp) AS prev
+			FROM candles
+			WHERE exchange = ? AND symbol = ? AND timeframe = ?
+			AND timestamp >= ? AND timestamp <= ?
+		)
+		WHERE timestamp - prev > ?
+	)";
+
+	StmtHandle stmt;
+	if (sqlite3_prepare_v2(pImpl->db, sql, -1, stmt.ptr(), nullptr) != SQLITE_OK) {
+		LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(pImpl->db)));
+		return gaps;
+	}
+
+	sqlite3_bind_int64(stmt, 1, wanted.start);
+	sqlite3_bind_int64(stmt, 2, intervalSeconds);
+	sqlite3_bind_text(stmt, 3, exchange.c_str(), -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text(stmt, 4, symbol.c_str(), -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text(stmt, 5, timeframe.c_str(), -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int64(stmt, 6, wanted.start);
+	sqlite3_bind_int64(stmt, 7, wanted.end);
+	sqlite3_bind_int64(stmt, 8, intervalSeconds);
+
+	while (sqlite3_step(stmt) == SQLITE_ROW) {
+		time_t prev = sqlite3_column_int64(stmt, 0);
+		time_t timestamp = sqlite3_column_int64(stmt, 1);
+		gaps.push_back(CandleRange(prev + intervalSeconds, timestamp - intervalSeconds));
+	}
+
+	// After the last stored candle
+	StmtHandle last;
+	if (!pImpl->prepareForSeries(last,
+	                             "SELECT MAX(timestamp) FROM candles"
+	                             " WHERE exchange = ? AND symbol = ? AND timeframe = ?"
+	                             " AND timestamp >= ? AND timestamp <= ?", exchange, symbol, timeframe)) {
+		return gaps;
+	}
+	sqlite3_bind_int64(last, 4, wanted.start);
+	sqlite3_bind_int64(last, 5, wanted.end);
+	if (sqlite3_step(last) == SQLITE_ROW && sqlite3_column_type(last, 0) != SQLITE_NULL) {
+		time_t lastTimestamp = sqlite3_column_int64(last, 0);
+		if (lastTimestamp < wanted.end) {
+			gaps.push_back(CandleRange(lastTimestamp + intervalSeconds, wanted.end));
+		}
+	} else {
+		gaps.push_back(wanted);  // Nothing stored in the range
+	}
+
+	return gaps;
+}
+
+bool DataStorage::rebuildCoverage(const std::string& exchange,
+                                  const std::string& symbol,
+                                  const std::string& timeframe,
+                                  int64_t intervalSeconds) {
+	if (!pImpl->initialized || intervalSeconds <= 0 || !hasFixedOpenTimes(timeframe)) {
+		return false;
+	}
+
+	SeriesInfo info;
+	std::vector<CandleRange> gaps;
+	bool hasCandles = getSeriesInfo(exchange, symbol, timeframe, info);
+	if (hasCandles) {
+		gaps = findGaps(exchange, symbol, timeframe,
+		                CandleRange(info.firstTimestamp, info.lastTimestamp), intervalSeconds);
+	}
+
+	pImpl->executeSQL("BEGIN TRANSACTION;");
+
+	StmtHandle remove;
+	if (!pImpl->prepareForSeries(remove,
+	                             "DELETE FROM candle_coverage WHERE exchange = ? AND symbol = ? AND timeframe = ?",
+	                             exchange, symbol, timeframe) ||
+	    sqlite3_step(remove) != SQLITE_DONE) {
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
+	}
+
+	// The runs between the gaps
+	if (hasCandles) {
+		time_t runStart = info.firstTimestamp;
+		gaps.push_back(CandleRange(info.lastTimestamp + intervalSeconds, info.lastTimestamp));
+		for (const auto& gap : gaps) {
+			CandleRange run(runStart, gap.start - intervalSeconds);
+			if (run.end >= run.start &&
+			    !pImpl->mergeCoverage(exchange, symbol, timeframe, run, intervalSeconds)) {
+				pImpl->executeSQL("ROLLBACK;");
+				return false;
+			}
+			runStart = gap.end + intervalSeconds;
+		}
+	}
+
+	if (!pImpl->executeSQL("COMMIT;")) {
+		pImpl->executeSQL("ROLLBACK;");
+		return false;
+	}
+	return true;
 }
 
 bool DataStorage::insertTrade(const Trade& trade) {
@@ -462,6 +1066,70 @@ std::vector<BacktestResult> DataStorage::getAllBacktestResults() {
 	return results;
 }
 
+bool DataStorage::insertBacktestCache(const std::string& cacheKey,
+                                      const std::string& recipeName,
+                                      const std::string& data) {
+	if (!pImpl->initialized) {
+		LOG_ERROR("DataStorage not initialized");
+		return false;
+	}
+
+	const char* sql = R"(
+		INSERT OR REPLACE INTO backtest_cache (cache_key, recipe_name, created_at, data)
+		VALUES (?, ?, ?, ?)
+	)";
+
+	StmtHandle stmt;
+	int rc = sqlite3_prepare_v2(pImpl->db, sql, -1, stmt.ptr(), nullptr);
+	if (rc != SQLITE_OK) {
+		LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(pImpl->db)));
+		return false;
+	}
+
+	sqlite3_bind_text(stmt, 1, cacheKey.c_str(), -1, SQLITE_TRANSIENT);
+	sqlite3_bind_text(stmt, 2, recipeName.c_str(), -1, SQLITE_TRANSIENT);
+	sqlite3_bind_int64(stmt, 3, std::time(nullptr));
+	sqlite3_bind_blob(stmt, 4, data.data(), static_cast<int>(data.size()), SQLITE_TRANSIENT);
+
+	rc = sqlite3_step(stmt);
+	return (rc == SQLITE_DONE);
+}
+
+bool DataStorage::getBacktestCache(const std::string& cacheKey, std::string& data) {
+	if (!pImpl->initialized) {
+		LOG_ERROR("DataStorage not initialized");
+		return false;
+	}
+
+	const char* sql = "SELECT data FROM backtest_cache WHERE cache_key = ?";
+
+	StmtHandle stmt;
+	int rc = sqlite3_prepare_v2(pImpl->db, sql, -1, stmt.ptr(), nullptr);
+	if (rc != SQLITE_OK) {
+		LOG_ERROR("Failed to prepare statement: " + std::string(sqlite3_errmsg(pImpl->db)));
+		return false;
+	}
+
+	sqlite3_bind_text(stmt, 1, cacheKey.c_str(), -1, SQLITE_TRANSIENT);
+
+	if (sqlite3_step(stmt) != SQLITE_ROW) {
+		return false;
+	}
+
+	const void* blob = sqlite3_column_blob(stmt, 0);
+	int size = sqlite3_column_bytes(stmt, 0);
+	data.assign(blob ? static_cast<const char*>(blob) : "", blob ? size : 0);
+	return true;
+}
+
+bool DataStorage::clearBacktestCache() {
+	if (!pImpl->initialized) {
+		return false;
+	}
+
+	return pImpl->executeSQL("DELETE FROM backtest_cache;");
+}
+
 bool DataStorage::clearCandles(const std::string& exchange,
                                 const std::string& symbol,
                                 const std::string& timeframe) {
@@ -492,6 +1160,19 @@ bool DataStorage::clearCandles(const std::string& exchange,
 		return false;  // ✅ Automatic cleanup
 	}
 
+	// Nothing is covered any more
+	StmtHandle coverage;
+	if (!pImpl->prepareForSeries(coverage,
+	                             "DELETE FROM candle_coverage WHERE exchange = ? AND symbol = ? AND timeframe = ?",
+	                             exchange, symbol, timeframe) ||
+	    sqlite3_step(coverage) != SQLITE_DONE) {
+		LOG_ERROR("Failed to delete coverage: " + std::string(sqlite3_errmsg(pImpl->db)));
+		return false;
+	}
+
+	notifyCandlesChanged(pImpl->path, exchange, symbol, timeframe,
+	                     std::numeric_limits<time_t>::min(), std::numeric_limits<time_t>::max());
+
 	return true;  // ✅ Automatic cleanup
 }
 
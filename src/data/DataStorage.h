@@ -4,7 +4,9 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
 #include <ctime>
+#include <cstdint>
 
 namespace Emiglio {
 
@@ -24,6 +26,41 @@ struct Candle {
 		: timestamp(0), open(0), high(0), low(0), close(0), volume(0) {}
 };
 
+// Summary of one stored candle series, kept by the database as candles
+// come and go, so reading it costs one index lookup
+struct SeriesInfo {
+	std::string exchange;
+	std::string symbol;
+	std::string timeframe;
+	time_t firstTimestamp;
+	time_t lastTimestamp;
+	int64_t candleCount;
+
+	SeriesInfo()
+		: firstTimestamp(0), lastTimestamp(0), candleCount(0) {}
+
+	// Candles missing between the first and the last one
+	int64_t missingCandles(int64_t intervalSeconds) const {
+		if (candleCount == 0 || intervalSeconds <= 0) {
+			return 0;
+		}
+		return (lastTimestamp - firstTimestamp) / intervalSeconds + 1 - candleCount;
+	}
+};
+
+// Open times of the first and last candle of a run, both included
+struct CandleRange {
+	time_t start;
+	time_t end;
+
+	CandleRange() : start(0), end(0) {}
+	CandleRange(time_t start, time_t end) : start(start), end(end) {}
+
+	int64_t candles(int64_t intervalSeconds) const {
+		return intervalSeconds > 0 && end >= start ? (end - start) / intervalSeconds + 1 : 0;
+	}
+};
+
 // Trade record structure (used for both backtesting and market trades)
 struct Trade {
 	int64_t id;                   // Database ID (backtesting) or market trade ID
@@ -77,6 +114,21 @@ public:
 	// Close database
 	void close();
 
+	// Path given to init()
+	const std::string& getPath() const;
+
+	// Called after candles were inserted, updated or deleted through any
+	// DataStorage in the process, with the database path, the series and
+	// the range of open times touched. Runs on the writing thread, after
+	// the commit. One listener per process (CandleCache installs itself).
+	typedef std::function<void(const std::string& path,
+	                           const std::string& exchange,
+	                           const std::string& symbol,
+	                           const std::string& timeframe,
+	                           time_t first,
+	                           time_t last)> CandleWriteListener;
+	static void setCandleWriteListener(CandleWriteListener listener);
+
 	// Candle operations
 	bool insertCandle(const Candle& candle);
 	bool insertCandles(const std::vector<Candle>& candles);
@@ -89,6 +141,60 @@ public:
 	                   const std::string& symbol,
 	                   const std::string& timeframe);
 
+	// First/last timestamp and count of a series; false when it has no
+	// candles. Read from the candle_series summary, not the candles.
+	bool getSeriesInfo(const std::string& exchange,
+	                   const std::string& symbol,
+	                   const std::string& timeframe,
+	                   SeriesInfo& info);
+	std::vector<SeriesInfo> getAllSeriesInfo();
+
+	// Coverage: per series, the ranges known to be complete. A range is
+	// complete when it was fetched from the exchange (it may still lack
+	// candles the exchange doesn't have) or every candle in it is stored.
+	// Every insert records the runs of consecutive candles it writes, in
+	// the same transaction. Adjacent and overlapping ranges are merged, so
+	// a series has a row per hole rather than per download. Ranges are
+	// kept on multiples of the interval; 1w and 1M candles aren't, so
+	// those series are never covered and always count as missing.
+
+	// Store 'candles' (one series) and mark 'fetched' complete, in one
+	// transaction
+	bool insertCandles(const std::vector<Candle>& candles,
+	                   const CandleRange& fetched,
+	                   int64_t intervalSeconds);
+	bool addCoverage(const std::string& exchange,
+	                 const std::string& symbol,
+	                 const std::string& timeframe,
+	                 const CandleRange& range,
+	                 int64_t intervalSeconds);
+	std::vector<CandleRange> getCoverage(const std::string& exchange,
+	                                     const std::string& symbol,
+	                                     const std::string& timeframe);
+
+	// Parts of 'range' not covered yet, i.e. what to download for it.
+	// Answered from the coverage rows; a series stored before coverage
+	// was tracked gets its coverage rebuilt from the candles first.
+	std::vector<CandleRange> getMissingRanges(const std::string& exchange,
+	                                          const std::string& symbol,
+	                                          const std::string& timeframe,
+	                                          const CandleRange& range,
+	                                          int64_t intervalSeconds);
+
+	// Holes in the stored candles of 'range', found by walking the
+	// timestamp index (no candle rows are read)
+	std::vector<CandleRange> findGaps(const std::string& exchange,
+	                                  const std::string& symbol,
+	                                  const std::string& timeframe,
+	                                  const CandleRange& range,
+	                                  int64_t intervalSeconds);
+
+	// Replace a series' coverage with the runs of stored candles
+	bool rebuildCoverage(const std::string& exchange,
+	                     const std::string& symbol,
+	                     const std::string& timeframe,
+	                     int64_t intervalSeconds);
+
 	// Trade operations
 	bool insertTrade(const Trade& trade);
 	std::vector<Trade> getTrades(const std::string& strategyName,
@@ -101,6 +207,13 @@ public:
 	BacktestResult getBacktestResult(const std::string& id);
 	std::vector<BacktestResult> getAllBacktestResults();
 
+	// Backtest cache operations (opaque serialized results keyed by content hash)
+	bool insertBacktestCache(const std::string& cacheKey,
+	                         const std::string& recipeName,
+	                         const std::string& data);
+	bool getBacktestCache(const std::string& cacheKey, std::string& data);
+	bool clearBacktestCache();
+
 	// Utility operations
 	bool clearCandles(const std::string& exchange,
 	                  const std::string& symbol,
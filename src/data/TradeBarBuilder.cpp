@@ -0,0 +1,269 @@
+#include "TradeBarBuilder.h"
+#include "CandleResampler.h"
+#include "../exchange/BinanceWebSocket.h"
+#include "../utils/Logger.h"
+
+#include <cstdlib>
+
+namespace Emiglio {
+
+namespace {
+
+// After a long outage, don't emit more than this many flat bars at once
+const int64_t kMaxFlatBars = 3600;
+
+int64_t floorDiv(int64_t a, int64_t b) {
+	int64_t q = a / b;
+	if ((a % b != 0) && ((a < 0) != (b < 0))) {
+		q--;
+	}
+	return q;
+}
+
+bool parsePositive(const std::string& text, double& value) {
+	if (text.empty()) {
+		return false;
+	}
+	char* end = nullptr;
+	value = std::strtod(text.c_str(), &end);
+	return end == text.c_str() + text.size() && value > 0.0;
+}
+
+} // namespace
+
+TradeBarBuilder::TradeBarBuilder(const std::string& symbol, const std::string& spec,
+                                 const std::string& exchange)
+	: type(BarType::TIME)
+	, threshold(0.0)
+	, intervalMs(0)
+	, calendar(spec == "1w" || spec == "1M")
+	, callback(nullptr)
+	, storage(nullptr)
+	, fillGaps(true)
+	, hasBar(false)
+	, accumulated(0.0)
+	, barEndMs(0)
+	, nextStartMs(0)
+	, lastClose(0.0)
+	, barCount(0)
+{
+	bar.exchange = exchange;
+	bar.symbol = symbol;
+	bar.timeframe = spec;
+
+	if (!parseSpec(spec, type, threshold)) {
+		LOG_WARNING("Unknown bar spec: " + spec);
+		threshold = 0.0;
+	}
+	if (type == BarType::TIME) {
+		intervalMs = static_cast<int64_t>(threshold) * 1000;
+	}
+}
+
+TradeBarBuilder::~TradeBarBuilder() {
+}
+
+// For time bars 'threshold' is the interval in seconds
+bool TradeBarBuilder::parseSpec(const std::string& spec, BarType& type, double& threshold) {
+	size_t colon = spec.find(':');
+	if (colon != std::string::npos) {
+		std::string kind = spec.substr(0, colon);
+		if (kind == "tick") {
+			type = BarType::TICK;
+		} else if (kind == "volume") {
+			type = BarType::VOLUME;
+		} else if (kind == "dollar") {
+			type = BarType::DOLLAR;
+		} else {
+			return false;
+		}
+		return parsePositive(spec.substr(colon + 1), threshold);
+	}
+
+	type = BarType::TIME;
+	int64_t seconds = CandleResampler::timeframeToSeconds(spec);
+	if (seconds <= 0 && spec.size() > 1 && spec.back() == 's') {
+		// Sub-minute bars: 5s, 10s, 15s, ...
+		double value = 0.0;
+		if (parsePositive(spec.substr(0, spec.size() - 1), value) && value == static_cast<int64_t>(value)) {
+			seconds = static_cast<int64_t>(value);
+		}
+	}
+	threshold = static_cast<double>(seconds);
+	return seconds > 0;
+}
+
+void TradeBarBuilder::addTrade(double price, double quantity, int64_t timeMs) {
+	if (!isValid()) {
+		return;
+	}
+
+	if (type == BarType::TIME) {
+		int64_t startMs = barStartMs(timeMs);
+		if (hasBar && startMs >= barEndMs) {
+			emitBar();
+		}
+		if (!hasBar) {
+			// A late trade of an already emitted bar opens the next one
+			if (nextStartMs > 0 && startMs < nextStartMs) {
+				startMs = nextStartMs;
+			}
+			emitFlatBars(startMs);
+			openBar(static_cast<time_t>(startMs / 1000), price);
+			barEndMs = barEndFor(startMs);
+		}
+	} else if (!hasBar) {
+		time_t timestamp = static_cast<time_t>(floorDiv(timeMs, 1000));
+		if (barCount > 0 && timestamp <= bar.timestamp) {
+			timestamp = bar.timestamp + 1;
+		}
+		openBar(timestamp, price);
+	}
+
+	if (price > bar.high) bar.high = price;
+	if (price < bar.low) bar.low = price;
+	bar.close = price;
+	bar.volume += quantity;
+
+	switch (type) {
+		case BarType::TICK:
+			accumulated += 1.0;
+			break;
+		case BarType::VOLUME:
+			accumulated += quantity;
+			break;
+		case BarType::DOLLAR:
+			accumulated += price * quantity;
+			break;
+		case BarType::TIME:
+			return;
+	}
+
+	// The trade that crosses the threshold belongs to the bar it completes
+	if (accumulated >= threshold) {
+		emitBar();
+	}
+}
+
+void TradeBarBuilder::update(const TradeUpdate& trade) {
+	addTrade(trade.price, trade.quantity, trade.timestamp);
+}
+
+void TradeBarBuilder::update(const AggTradeUpdate& trade) {
+	addTrade(trade.price, trade.quantity, trade.timestamp);
+}
+
+void TradeBarBuilder::advanceTime(int64_t nowMs) {
+	if (type != BarType::TIME || !isValid()) {
+		return;
+	}
+
+	if (hasBar && nowMs >= barEndMs) {
+		emitBar();
+	}
+	if (!hasBar && nextStartMs > 0) {
+		// Flat bars for the intervals that are over
+		emitFlatBars(barStartMs(nowMs));
+	}
+}
+
+// Start of the time bar containing 'timeMs'
+int64_t TradeBarBuilder::barStartMs(int64_t timeMs) const {
+	if (calendar) {
+		time_t start = CandleResampler::alignTimestamp(static_cast<time_t>(floorDiv(timeMs, 1000)), bar.timeframe);
+		return static_cast<int64_t>(start) * 1000;
+	}
+	return floorDiv(timeMs, intervalMs) * intervalMs;
+}
+
+// End of the time bar starting at 'startMs'; months differ in length
+int64_t TradeBarBuilder::barEndFor(int64_t startMs) const {
+	if (calendar) {
+		return static_cast<int64_t>(CandleResampler::nextBucketStart(static_cast<time_t>(startMs / 1000), bar.timeframe)) * 1000;
+	}
+	return startMs + intervalMs;
+}
+
+void TradeBarBuilder::openBar(time_t timestamp, double price) {
+	bar.timestamp = timestamp;
+	bar.open = price;
+	bar.high = price;
+	bar.low = price;
+	bar.close = price;
+	bar.volume = 0.0;
+	accumulated = 0.0;
+	hasBar = true;
+}
+
+void TradeBarBuilder::emitBar() {
+	if (!hasBar) {
+		return;
+	}
+
+	if (callback) {
+		callback(bar);
+	}
+	if (storage && !storage->insertCandle(bar)) {
+		LOG_WARNING("Failed to store " + bar.timeframe + " bar for " + bar.symbol);
+	}
+
+	barCount++;
+	lastClose = bar.close;
+	if (type == BarType::TIME) {
+		nextStartMs = barEndMs;
+	}
+	hasBar = false;
+	accumulated = 0.0;
+}
+
+// Emit zero-volume bars from nextStartMs up to (not including) 'untilMs'
+void TradeBarBuilder::emitFlatBars(int64_t untilMs) {
+	if (nextStartMs <= 0 || untilMs <= nextStartMs) {
+		return;
+	}
+
+	int64_t missing = (untilMs - nextStartMs) / intervalMs;
+	if (!fillGaps || missing > kMaxFlatBars) {
+		if (fillGaps) {
+			LOG_WARNING("Skipping " + std::to_string(missing) + " empty " + bar.timeframe +
+			            " bars for " + bar.symbol);
+		}
+		nextStartMs = untilMs;
+		return;
+	}
+
+	while (nextStartMs < untilMs) {
+		openBar(static_cast<time_t>(nextStartMs / 1000), lastClose);
+		barEndMs = barEndFor(nextStartMs);
+		emitBar();
+	}
+}
+
+bool TradeBarBuilder::getCurrent(Candle& candle) const {
+	if (!hasBar) {
+		return false;
+	}
+	candle = bar;
+	return true;
+}
+
+void TradeBarBuilder::flush() {
+	emitBar();
+}
+
+void TradeBarBuilder::reset() {
+	hasBar = false;
+	accumulated = 0.0;
+	barEndMs = 0;
+	nextStartMs = 0;
+}
+
+void TradeBarBuilder::setCallback(BarCallback callback) {
+	this->callback = callback;
+}
+
+void TradeBarBuilder::setStorage(DataStorage* storage) {
+	this->storage = storage;
+}
+
+} // namespace Emiglio
@@ -0,0 +1,112 @@
+#ifndef EMIGLIO_TRADEBARBUILDER_H
+#define EMIGLIO_TRADEBARBUILDER_H
+
+#include "DataStorage.h"
+
+#include <string>
+#include <functional>
+#include <cstdint>
+#include <ctime>
+
+namespace Emiglio {
+
+struct TradeUpdate;
+struct AggTradeUpdate;
+
+// Builds candles straight from the trade stream, for bars Binance doesn't
+// offer as klines:
+//   "1s", "5s", "10s", "1m", ...  time bars (any kline interval or <n>s;
+//                                 "1w" opens on Mondays, "1M" on the 1st,
+//                                 like Binance klines)
+//   "tick:<n>"                    a bar every n trades
+//   "volume:<x>"                  a bar every x units of base asset traded
+//   "dollar:<x>"                  a bar every x units of quote asset traded
+//
+// The in-progress bar is kept in place and only its numeric fields change
+// per trade, so feeding trades never allocates. Completed bars go to the
+// callback (e.g. a CandleResampler or indicator update) and, if set, to
+// storage, with the spec as the candle's timeframe.
+class TradeBarBuilder {
+public:
+	enum class BarType {
+		TIME,
+		TICK,
+		VOLUME,
+		DOLLAR
+	};
+
+	using BarCallback = std::function<void(const Candle&)>;
+
+	TradeBarBuilder(const std::string& symbol, const std::string& spec,
+	                const std::string& exchange = "binance");
+	~TradeBarBuilder();
+
+	// False if the spec wasn't understood; such a builder ignores trades
+	bool isValid() const { return threshold > 0.0; }
+
+	static bool parseSpec(const std::string& spec, BarType& type, double& threshold);
+
+	// 'timeMs' is the trade time in milliseconds
+	void addTrade(double price, double quantity, int64_t timeMs);
+	void update(const TradeUpdate& trade);
+	void update(const AggTradeUpdate& trade);
+
+	// Time bars: close the current bar once 'nowMs' is past its end, without
+	// waiting for the next trade. Call it from a timer on quiet markets.
+	void advanceTime(int64_t nowMs);
+
+	// In-progress bar; false if it has no trades yet
+	bool getCurrent(Candle& candle) const;
+
+	// Emit the in-progress bar even if it is not complete
+	void flush();
+
+	// Drop the in-progress bar
+	void reset();
+
+	void setCallback(BarCallback callback);
+
+	// Also store completed bars (nullptr to stop). Activity bars that open
+	// in the same second get consecutive timestamps so each keeps its own
+	// row.
+	void setStorage(DataStorage* storage);
+
+	// Time bars: emit flat, zero-volume bars for intervals without trades,
+	// as Binance klines do (on by default)
+	void setFillGaps(bool fill) { fillGaps = fill; }
+
+	BarType getType() const { return type; }
+	const std::string& getSpec() const { return bar.timeframe; }
+	uint64_t getBarCount() const { return barCount; }
+
+private:
+	BarType type;
+	double threshold;      // Trades, volume or quote volume per bar
+	int64_t intervalMs;    // Time bars only
+	bool calendar;         // "1w" and "1M": buckets aren't epoch multiples
+
+	BarCallback callback;
+	DataStorage* storage;
+	bool fillGaps;
+
+	// In-progress bar; its strings are set once in the constructor
+	Candle bar;
+	bool hasBar;
+	double accumulated;    // Progress towards 'threshold'
+	int64_t barEndMs;      // Time bars: end of the current bar
+
+	// Continuity between bars
+	int64_t nextStartMs;   // Time bars: start of the bar after the last emitted one
+	double lastClose;
+	uint64_t barCount;
+
+	int64_t barStartMs(int64_t timeMs) const;
+	int64_t barEndFor(int64_t startMs) const;
+	void openBar(time_t timestamp, double price);
+	void emitBar();
+	void emitFlatBars(int64_t untilMs);
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_TRADEBARBUILDER_H
@@ -1,4 +1,5 @@
 #include "BinanceAPI.h"
+#include "BinanceRestDecoder.h"
 #include "../utils/Logger.h"
 #include "../utils/JsonParser.h"
 
@@ -6,18 +7,46 @@
 #include <sstream>
 #include <iomanip>
 #include <chrono>
-#include <deque>
-#include <mutex>   // For thread safety
+#include <algorithm>
 #include <openssl/hmac.h>
 #include <openssl/sha.h>
 #include <cstdio>  // For popen/pclose
+#include <cstdlib> // For getenv
 #include <array>   // For std::array
-#ifdef __HAIKU__
-#include <OS.h>  // For snooze()
-#endif
 
 namespace Emiglio {
 
+static std::string defaultBaseUrl() {
+	const char* url = std::getenv("EMIGLIO_BINANCE_API_URL");
+	return (url && *url) ? url : "https://api.binance.com";
+}
+
+// Longest a request waits for the rate limiter before giving up
+static const std::chrono::milliseconds kDefaultMaxRateLimitWait(60000);
+
+// Request weight of a GET endpoint, as listed in Binance's API docs
+static int requestWeight(const std::string& endpoint, const std::map<std::string, std::string>& params) {
+	auto limit = params.find("limit");
+	bool hasSymbol = params.count("symbol") > 0;
+
+	if (endpoint == "/api/v3/depth") {
+		int depth = limit != params.end() ? std::atoi(limit->second.c_str()) : 100;
+		if (depth <= 100) return 5;
+		if (depth <= 500) return 25;
+		if (depth <= 1000) return 50;
+		return 250;
+	}
+	if (endpoint == "/api/v3/ticker/24hr") return hasSymbol ? 2 : 80;
+	if (endpoint == "/api/v3/ticker/price") return hasSymbol ? 2 : 4;
+	if (endpoint == "/api/v3/openOrders") return hasSymbol ? 6 : 80;
+	if (endpoint == "/api/v3/klines") return 2;
+	if (endpoint == "/api/v3/trades") return 25;
+	if (endpoint == "/api/v3/exchangeInfo") return 20;
+	if (endpoint == "/api/v3/account") return 20;
+	if (endpoint == "/api/v3/allOrders") return 20;
+	if (endpoint == "/api/v3/order") return 4;
+	return 1;  // ping, time
+}
 
 // Private implementation using PIMPL pattern
 class BinanceAPI::Impl {
@@ -35,58 +64,22 @@ public:
 	std::map<std::string, CachedTicker> tickerCache;
 	int cacheDurationSeconds;
 
-	// Rate limiting
-	// Fixed: Added mutex for thread-safe access to shared data
-	struct RateLimiter {
-		std::deque<time_t> requestTimes;
-		int maxRequests;      // 1200 per minute
-		int windowSeconds;    // 60 seconds
-		mutable std::mutex mtx;  // Thread safety for shared data access
-
-		RateLimiter() : maxRequests(1200), windowSeconds(60) {}
-
-		bool canMakeRequest() {
-			std::lock_guard<std::mutex> lock(mtx);  // Thread-safe access
-			time_t now = std::time(nullptr);
-
-			// Remove requests older than window
-			while (!requestTimes.empty() &&
-			       (now - requestTimes.front()) >= windowSeconds) {
-				requestTimes.pop_front();
-			}
-
-			return requestTimes.size() < static_cast<size_t>(maxRequests);
-		}
+	// Request weight and order limits, shared with every BinanceAPI on the
+	// same host
+	std::shared_ptr<RateLimiter> rateLimiter;
+	std::chrono::milliseconds maxRateLimitWait;
+	int lastStatus;
 
-		void recordRequest() {
-			std::lock_guard<std::mutex> lock(mtx);  // Thread-safe access
-			requestTimes.push_back(std::time(nullptr));
-		}
-
-		int remainingRequests() const {
-			std::lock_guard<std::mutex> lock(mtx);  // Thread-safe access
-			return maxRequests - static_cast<int>(requestTimes.size());
-		}
-	};
-	RateLimiter rateLimiter;
-
-	Impl() : baseUrl("https://api.binance.com"),
+	Impl() : baseUrl(defaultBaseUrl()),
 	         initialized(false),
-	         cacheDurationSeconds(1) {  // Cache for 1 second by default
+	         cacheDurationSeconds(1),  // Cache for 1 second by default
+	         rateLimiter(RateLimiter::forHost(baseUrl)),
+	         maxRateLimitWait(kDefaultMaxRateLimitWait),
+	         lastStatus(0) {
 	}
 
 	// HTTP request helper (public endpoints) using curl
 	std::string httpGet(const std::string& endpoint, const std::map<std::string, std::string>& params = {}) {
-		// Rate limiting check
-		if (!rateLimiter.canMakeRequest()) {
-			LOG_WARNING("Rate limit reached! Waiting 1 second...");
-#ifdef __HAIKU__
-			snooze(1000000);  // 1 second in microseconds
-#else
-			std::this_thread::sleep_for(std::chrono::seconds(1));
-#endif
-		}
-
 		std::string url = baseUrl + endpoint;
 
 		// Add query parameters
@@ -101,45 +94,14 @@ public:
 		}
 
 		LOG_INFO("HTTP GET: " + url);
-
-		// Record request for rate limiting
-		rateLimiter.recordRequest();
-
-		// Use curl via popen
-		std::string curlCmd = "curl -s \"" + url + "\"";
-		FILE* pipe = popen(curlCmd.c_str(), "r");
-		if (!pipe) {
-			LOG_ERROR("Failed to execute curl");
-			return "";
-		}
-
-		// Read response
-		std::string response;
-		std::array<char, 4096> buffer;
-		while (fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
-			response += buffer.data();
-		}
-
-		int status = pclose(pipe);
-		if (status != 0) {
-			LOG_WARNING("curl returned non-zero status: " + std::to_string(status));
-		}
-
+		std::string response = execute("curl -s -i \"" + url + "\"", requestWeight(endpoint, params));
 		LOG_INFO("Response received: " + std::to_string(response.length()) + " bytes");
 		return response;
 	}
 
 	// HTTP request helper (signed endpoints - requires HMAC) using curl
 	std::string httpGetSigned(const std::string& endpoint, std::map<std::string, std::string> params = {}) {
-		// Rate limiting check
-		if (!rateLimiter.canMakeRequest()) {
-			LOG_WARNING("Rate limit reached! Waiting 1 second...");
-#ifdef __HAIKU__
-			snooze(1000000);  // 1 second in microseconds
-#else
-			std::this_thread::sleep_for(std::chrono::seconds(1));
-#endif
-		}
+		int weight = requestWeight(endpoint, params);
 
 		// Add timestamp
 		auto now = std::chrono::system_clock::now();
@@ -163,15 +125,26 @@ public:
 		std::string url = baseUrl + endpoint + "?" + queryString + "&signature=" + signature;
 
 		LOG_INFO("HTTP GET (signed): " + url);
+		std::string response = execute("curl -s -i -H \"X-MBX-APIKEY: " + apiKey + "\" \"" + url + "\"", weight);
+		LOG_INFO("Signed response received: " + std::to_string(response.length()) + " bytes");
+		return response;
+	}
 
-		// Record request for rate limiting
-		rateLimiter.recordRequest();
+	// Run a curl command (with -i) once the rate limiter allows, feed the
+	// limit headers back to it and return the body
+	std::string execute(const std::string& curlCmd, int weight) {
+		lastStatus = 0;
+		if (!rateLimiter->acquire(weight, false, maxRateLimitWait)) {
+			LOG_ERROR("Rate limit: request would wait longer than " +
+			          std::to_string(maxRateLimitWait.count()) + " ms, not sent");
+			return "";
+		}
 
-		// Use curl via popen with API key header
-		std::string curlCmd = "curl -s -H \"X-MBX-APIKEY: " + apiKey + "\" \"" + url + "\"";
+		RateLimitFeedback feedback;
 		FILE* pipe = popen(curlCmd.c_str(), "r");
 		if (!pipe) {
-			LOG_ERROR("Failed to execute curl for signed request");
+			LOG_ERROR("Failed to execute curl");
+			rateLimiter->complete(weight, feedback);
 			return "";
 		}
 
@@ -187,8 +160,53 @@ public:
 			LOG_WARNING("curl returned non-zero status: " + std::to_string(status));
 		}
 
-		LOG_INFO("Signed response received: " + std::to_string(response.length()) + " bytes");
-		return response;
+		std::string body = splitHeaders(response, feedback);
+		rateLimiter->complete(weight, feedback);
+		lastStatus = feedback.status;
+		if (feedback.status >= 400) {
+			LOG_WARNING("HTTP " + std::to_string(feedback.status) + ": " + body);
+		}
+		return body;
+	}
+
+	// Strip the status line and headers curl -i puts before the body,
+	// keeping what the rate limiter needs. Proxies and 100 Continue add
+	// extra header blocks.
+	static std::string splitHeaders(const std::string& response, RateLimitFeedback& feedback) {
+		size_t pos = 0;
+		while (response.compare(pos, 5, "HTTP/") == 0) {
+			size_t end = response.find("\r\n\r\n", pos);
+			if (end == std::string::npos) {
+				return "";
+			}
+
+			size_t space = response.find(' ', pos);
+			feedback.status = space < end ? std::atoi(response.c_str() + space + 1) : 0;
+
+			size_t line = response.find("\r\n", pos);
+			while (line < end) {
+				size_t next = response.find("\r\n", line + 2);
+				std::string header = response.substr(line + 2, next - line - 2);
+				size_t colon = header.find(':');
+				if (colon != std::string::npos) {
+					std::string name = header.substr(0, colon);
+					std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+					int value = std::atoi(header.c_str() + colon + 1);
+					if (name == "x-mbx-used-weight-1m" || (name == "x-mbx-used-weight" && feedback.usedWeight < 0)) {
+						feedback.usedWeight = value;
+					} else if (name == "x-mbx-order-count-10s") {
+						feedback.orderCount10s = value;
+					} else if (name == "x-mbx-order-count-1d") {
+						feedback.orderCount1d = value;
+					} else if (name == "retry-after") {
+						feedback.retryAfterSeconds = value;
+					}
+				}
+				line = next;
+			}
+			pos = end + 4;
+		}
+		return response.substr(pos);
 	}
 
 	// Generate HMAC SHA256 signature
@@ -248,6 +266,30 @@ bool BinanceAPI::init(const std::string& apiKey, const std::string& apiSecret) {
 	return true;
 }
 
+void BinanceAPI::setBaseUrl(const std::string& url) {
+	pImpl->baseUrl = url;
+	while (!pImpl->baseUrl.empty() && pImpl->baseUrl.back() == '/') {
+		pImpl->baseUrl.pop_back();
+	}
+	pImpl->rateLimiter = RateLimiter::forHost(pImpl->baseUrl);
+}
+
+std::string BinanceAPI::getBaseUrl() const {
+	return pImpl->baseUrl;
+}
+
+std::shared_ptr<RateLimiter> BinanceAPI::getRateLimiter() const {
+	return pImpl->rateLimiter;
+}
+
+void BinanceAPI::setMaxRateLimitWait(std::chrono::milliseconds maxWait) {
+	pImpl->maxRateLimitWait = maxWait;
+}
+
+int BinanceAPI::getLastStatus() const {
+	return pImpl->lastStatus;
+}
+
 std::string BinanceAPI::getName() const {
 	return "Binance";
 }
@@ -306,15 +348,9 @@ Ticker BinanceAPI::getTicker(const std::string& symbol) {
 	std::string response = pImpl->httpGet("/api/v3/ticker/24hr", params);
 
 	// Parse JSON response
-	JsonParser parser;
-	if (parser.parse(response)) {
-		ticker.lastPrice = parser.getDouble("lastPrice", 0.0);
-		ticker.priceChange = parser.getDouble("priceChange", 0.0);
-		ticker.priceChangePercent = parser.getDouble("priceChangePercent", 0.0);
-		ticker.highPrice = parser.getDouble("highPrice", 0.0);
-		ticker.lowPrice = parser.getDouble("lowPrice", 0.0);
-		ticker.volume = parser.getDouble("volume", 0.0);
-		ticker.quoteVolume = parser.getDouble("quoteVolume", 0.0);
+	BinanceRestDecoder decoder;
+	if (decoder.decodeTicker(response, ticker)) {
+		ticker.symbol = symbol;
 		ticker.timestamp = now;
 
 		// Store in cache
@@ -331,32 +367,22 @@ std::vector<Ticker> BinanceAPI::getAllTickers() {
 	// Use ticker/24hr without symbol parameter to get ALL symbols
 	std::string response = pImpl->httpGet("/api/v3/ticker/24hr");
 
-	JsonParser parser;
-	if (parser.parse(response)) {
-		size_t count = parser.getArraySize("");
-
-		LOG_INFO("Fetched " + std::to_string(count) + " tickers in 1 request (vs " +
-		         std::to_string(count) + " individual requests)");
+	BinanceRestDecoder decoder;
+	std::vector<Ticker> decoded;
+	if (decoder.decodeTickers(response, decoded)) {
+		LOG_INFO("Fetched " + std::to_string(decoded.size()) + " tickers in 1 request (vs " +
+		         std::to_string(decoded.size()) + " individual requests)");
 
 		time_t now = std::time(nullptr);
+		tickers.reserve(decoded.size());
 
-		for (size_t i = 0; i < count; i++) {
-			Ticker ticker;
-			ticker.symbol = parser.getArrayObjectString("", i, "symbol", "");
-			ticker.lastPrice = parser.getArrayObjectDouble("", i, "lastPrice", 0.0);
-			ticker.priceChange = parser.getArrayObjectDouble("", i, "priceChange", 0.0);
-			ticker.priceChangePercent = parser.getArrayObjectDouble("", i, "priceChangePercent", 0.0);
-			ticker.highPrice = parser.getArrayObjectDouble("", i, "highPrice", 0.0);
-			ticker.lowPrice = parser.getArrayObjectDouble("", i, "lowPrice", 0.0);
-			ticker.volume = parser.getArrayObjectDouble("", i, "volume", 0.0);
-			ticker.quoteVolume = parser.getArrayObjectDouble("", i, "quoteVolume", 0.0);
+		for (auto& ticker : decoded) {
 			ticker.timestamp = now;
 
 			if (!ticker.symbol.empty()) {
-				tickers.push_back(ticker);
-
 				// Also populate cache
 				pImpl->tickerCache[ticker.symbol] = {ticker, now};
+				tickers.push_back(std::move(ticker));
 			}
 		}
 
@@ -384,27 +410,15 @@ std::vector<Candle> BinanceAPI::getCandles(const std::string& symbol,
 
 	// Parse JSON response: array of arrays
 	// Each candle: [timestamp, open, high, low, close, volume, close_time, quote_volume, trades, taker_buy_base, taker_buy_quote, ignore]
-	JsonParser parser;
-	if (parser.parse(response)) {
-		// Response is array at root level, so keyPath is empty
-		size_t count = parser.getArraySize("");
-
-		for (size_t i = 0; i < count; i++) {
-			Candle candle;
-			candle.symbol = symbol;
-			candle.timestamp = parser.getNestedArrayInt64("", i, 0, 0) / 1000; // Convert ms to seconds
-			candle.open = parser.getNestedArrayDouble("", i, 1, 0.0);
-			candle.high = parser.getNestedArrayDouble("", i, 2, 0.0);
-			candle.low = parser.getNestedArrayDouble("", i, 3, 0.0);
-			candle.close = parser.getNestedArrayDouble("", i, 4, 0.0);
-			candle.volume = parser.getNestedArrayDouble("", i, 5, 0.0);
-
-			candles.push_back(candle);
-		}
-
+	BinanceRestDecoder decoder;
+	if (decoder.decodeKlines(response, candles, symbol, timeframe)) {
 		LOG_INFO("Parsed " + std::to_string(candles.size()) + " candles");
 	} else {
-		LOG_ERROR("Failed to parse candles response");
+		LOG_ERROR("Failed to parse candles response: " + decoder.getLastError());
+		// An unreadable body is no answer, whatever the status said
+		if (pImpl->lastStatus < 400) {
+			pImpl->lastStatus = 0;
+		}
 	}
 
 	return candles;
@@ -421,31 +435,13 @@ OrderBook BinanceAPI::getOrderBook(const std::string& symbol, int limit) {
 
 	std::string response = pImpl->httpGet("/api/v3/depth", params);
 
-	// Parse JSON response: {"bids": [[price, quantity], ...], "asks": [[price, quantity], ...]}
-	JsonParser parser;
-	if (parser.parse(response)) {
-		// Parse bids
-		size_t bidCount = parser.getArraySize("bids");
-		for (size_t i = 0; i < bidCount; i++) {
-			OrderBookLevel bid;
-			bid.price = parser.getNestedArrayDouble("bids", i, 0, 0.0);
-			bid.quantity = parser.getNestedArrayDouble("bids", i, 1, 0.0);
-			orderBook.bids.push_back(bid);
-		}
-
-		// Parse asks
-		size_t askCount = parser.getArraySize("asks");
-		for (size_t i = 0; i < askCount; i++) {
-			OrderBookLevel ask;
-			ask.price = parser.getNestedArrayDouble("asks", i, 0, 0.0);
-			ask.quantity = parser.getNestedArrayDouble("asks", i, 1, 0.0);
-			orderBook.asks.push_back(ask);
-		}
-
+	// Parse JSON response: {"lastUpdateId": N, "bids": [[price, quantity], ...], "asks": [[price, quantity], ...]}
+	BinanceRestDecoder decoder;
+	if (decoder.decodeDepth(response, orderBook)) {
 		LOG_INFO("Parsed order book: " + std::to_string(orderBook.bids.size()) +
 		         " bids, " + std::to_string(orderBook.asks.size()) + " asks");
 	} else {
-		LOG_ERROR("Failed to parse order book response");
+		LOG_ERROR("Failed to parse order book response: " + decoder.getLastError());
 	}
 
 	return orderBook;
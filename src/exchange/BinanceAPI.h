@@ -2,6 +2,8 @@
 #define BINANCEAPI_H
 
 #include "ExchangeAPI.h"
+#include "RateLimiter.h"
+#include <chrono>
 #include <memory>
 
 namespace Emiglio {
@@ -49,6 +51,23 @@ public:
 	std::vector<Order> getOpenOrders(const std::string& symbol = "") override;
 	std::vector<Order> getAllOrders(const std::string& symbol, int limit = 100) override;
 
+	// REST root, "https://api.binance.com" unless the EMIGLIO_BINANCE_API_URL
+	// environment variable says otherwise (e.g. http://127.0.0.1:9700 for
+	// emiglio_mock_binance)
+	void setBaseUrl(const std::string& url);
+	std::string getBaseUrl() const;
+
+	// Requests wait for their endpoint's weight in the host's RateLimiter,
+	// up to 'maxWait' (default one minute); beyond that they fail without
+	// being sent
+	std::shared_ptr<RateLimiter> getRateLimiter() const;
+	void setMaxRateLimitWait(std::chrono::milliseconds maxWait);
+
+	// HTTP status of the last request, 0 when it wasn't sent (held back by
+	// the rate limiter) or no readable answer came. Tells an empty result
+	// (200 with nothing in it) from a failed request.
+	int getLastStatus() const;
+
 	// Utility
 	std::string getName() const override;
 	std::string getExchangeInfo() override;
@@ -0,0 +1,563 @@
+#include "BinanceRestDecoder.h"
+#include "../utils/FastNumber.h"
+#include "../utils/Logger.h"
+
+#include "rapidjson/reader.h"
+#include "rapidjson/error/en.h"
+
+#include <cstring>
+
+using namespace rapidjson;
+
+namespace Emiglio {
+
+namespace {
+
+// Funnels RapidJSON's scalar events into onNumber()/onString() and
+// records Binance error bodies ({"code":..., "msg":...}) seen at the
+// top-level object.
+template <typename Derived>
+struct ScalarHandler : public BaseReaderHandler<UTF8<>, Derived> {
+	enum class ErrorKey { NONE, CODE, MSG };
+
+	ErrorKey errorKey = ErrorKey::NONE;
+	int64_t errorCode = 0;
+	std::string errorMessage;
+	bool hasError = false;
+
+	Derived& self() { return static_cast<Derived&>(*this); }
+
+	bool Null() { return self().onSkip(); }
+	bool Bool(bool) { return self().onSkip(); }
+	bool Int(int i) { return self().onNumber(i, i); }
+	bool Uint(unsigned u) { return self().onNumber(u, u); }
+	bool Int64(int64_t i) { return self().onNumber(i, static_cast<double>(i)); }
+	bool Uint64(uint64_t u) { return self().onNumber(static_cast<int64_t>(u), static_cast<double>(u)); }
+	bool Double(double d) { return self().onNumber(static_cast<int64_t>(d), d); }
+	bool String(const char* str, SizeType length, bool) { return self().onString(str, length); }
+
+	// For keys of the top-level object
+	bool checkErrorKey(const char* key, SizeType length) {
+		errorKey = ErrorKey::NONE;
+		if (length == 4 && std::memcmp(key, "code", 4) == 0) {
+			errorKey = ErrorKey::CODE;
+			hasError = true;
+			return true;
+		}
+		if (length == 3 && std::memcmp(key, "msg", 3) == 0) {
+			errorKey = ErrorKey::MSG;
+			return true;
+		}
+		return false;
+	}
+
+	bool errorValue(int64_t number, const char* str, SizeType length) {
+		if (errorKey == ErrorKey::CODE) {
+			errorCode = number;
+		} else if (errorKey == ErrorKey::MSG && str) {
+			errorMessage.assign(str, length);
+		}
+		errorKey = ErrorKey::NONE;
+		return true;
+	}
+
+	std::string errorText() const {
+		return "Binance error " + std::to_string(errorCode) + ": " + errorMessage;
+	}
+};
+
+// Kline arrays: only the first six columns are decoded
+struct KlineHandler : public ScalarHandler<KlineHandler> {
+	std::vector<Candle>& candles;
+	Candle current;
+	int depth = 0;
+	int column = 0;
+	bool inErrorBody = false;
+
+	KlineHandler(std::vector<Candle>& candles, const std::string& symbol, const std::string& timeframe)
+		: candles(candles) {
+		current.exchange = "binance";
+		current.symbol = symbol;
+		current.timeframe = timeframe;
+	}
+
+	bool StartArray() {
+		if (++depth == 2) {
+			column = 0;
+		}
+		return true;
+	}
+
+	bool EndArray(SizeType) {
+		if (depth-- == 2) {
+			if (column < 6) {
+				return false;
+			}
+			candles.push_back(current);
+		}
+		return true;
+	}
+
+	bool StartObject() {
+		inErrorBody = (depth == 0);
+		return true;
+	}
+
+	bool EndObject(SizeType) { return true; }
+
+	bool Key(const char* key, SizeType length, bool) {
+		if (inErrorBody) {
+			checkErrorKey(key, length);
+		}
+		return true;
+	}
+
+	bool onSkip() {
+		if (depth == 2) {
+			column++;
+		}
+		return true;
+	}
+
+	bool onNumber(int64_t integer, double number) {
+		if (inErrorBody) {
+			return errorValue(integer, nullptr, 0);
+		}
+		if (depth != 2) {
+			return true;
+		}
+		switch (column++) {
+			case 0: current.timestamp = static_cast<time_t>(integer / 1000); break;
+			case 1: current.open = number; break;
+			case 2: current.high = number; break;
+			case 3: current.low = number; break;
+			case 4: current.close = number; break;
+			case 5: current.volume = number; break;
+			default: break;
+		}
+		return true;
+	}
+
+	bool onString(const char* str, SizeType length) {
+		if (inErrorBody) {
+			return errorValue(0, str, length);
+		}
+		if (depth != 2) {
+			return true;
+		}
+
+		double* field = nullptr;
+		switch (column++) {
+			case 1: field = &current.open; break;
+			case 2: field = &current.high; break;
+			case 3: field = &current.low; break;
+			case 4: field = &current.close; break;
+			case 5: field = &current.volume; break;
+			default: return true;
+		}
+		return FastNumber::parseDouble(str, length, *field);
+	}
+};
+
+// 24h ticker objects, either the root object or the elements of the root array
+struct TickerHandler : public ScalarHandler<TickerHandler> {
+	std::vector<Ticker>* tickers;
+	Ticker* single;
+	Ticker* current = nullptr;
+	int depth = 0;
+	bool rootIsObject = false;
+	double* field = nullptr;
+	bool symbolKey = false;
+
+	TickerHandler(std::vector<Ticker>* tickers, Ticker* single)
+		: tickers(tickers), single(single) {}
+
+	static void reset(Ticker& ticker) {
+		ticker.symbol.clear();
+		ticker.lastPrice = 0.0;
+		ticker.priceChange = 0.0;
+		ticker.priceChangePercent = 0.0;
+		ticker.highPrice = 0.0;
+		ticker.lowPrice = 0.0;
+		ticker.volume = 0.0;
+		ticker.quoteVolume = 0.0;
+		ticker.timestamp = 0;
+	}
+
+	bool StartObject() {
+		if (depth++ == 0) {
+			rootIsObject = true;
+			if (!single) {
+				// An object where an array is expected; only an error body fits
+				return true;
+			}
+			current = single;
+		} else if (depth == 2 && tickers) {
+			tickers->emplace_back();
+			current = &tickers->back();
+		} else {
+			return true;
+		}
+		reset(*current);
+		return true;
+	}
+
+	bool EndObject(SizeType) {
+		depth--;
+		if (depth == 0 || (depth == 1 && !rootIsObject)) {
+			current = nullptr;
+		}
+		return true;
+	}
+
+	bool StartArray() { depth++; return true; }
+	bool EndArray(SizeType) { depth--; return true; }
+
+	bool Key(const char* key, SizeType length, bool) {
+		field = nullptr;
+		symbolKey = false;
+		if (depth == 1 && rootIsObject && checkErrorKey(key, length)) {
+			return true;
+		}
+		if (!current || depth != (rootIsObject ? 1 : 2)) {
+			return true;
+		}
+
+		switch (length) {
+			case 6:
+				if (std::memcmp(key, "symbol", 6) == 0) symbolKey = true;
+				else if (std::memcmp(key, "volume", 6) == 0) field = &current->volume;
+				break;
+			case 8:
+				if (std::memcmp(key, "lowPrice", 8) == 0) field = &current->lowPrice;
+				break;
+			case 9:
+				if (std::memcmp(key, "lastPrice", 9) == 0) field = &current->lastPrice;
+				else if (std::memcmp(key, "highPrice", 9) == 0) field = &current->highPrice;
+				break;
+			case 11:
+				if (std::memcmp(key, "priceChange", 11) == 0) field = &current->priceChange;
+				else if (std::memcmp(key, "quoteVolume", 11) == 0) field = &current->quoteVolume;
+				break;
+			case 18:
+				if (std::memcmp(key, "priceChangePercent", 18) == 0) field = &current->priceChangePercent;
+				break;
+			default:
+				break;
+		}
+		return true;
+	}
+
+	bool onSkip() {
+		field = nullptr;
+		symbolKey = false;
+		return true;
+	}
+
+	bool onNumber(int64_t integer, double number) {
+		if (errorKey != ErrorKey::NONE) {
+			return errorValue(integer, nullptr, 0);
+		}
+		if (field) {
+			*field = number;
+		}
+		return onSkip();
+	}
+
+	bool onString(const char* str, SizeType length) {
+		if (errorKey != ErrorKey::NONE) {
+			return errorValue(0, str, length);
+		}
+		if (symbolKey) {
+			current->symbol.assign(str, length);
+		} else if (field && !FastNumber::parseDouble(str, length, *field)) {
+			return false;
+		}
+		return onSkip();
+	}
+};
+
+// Depth snapshot: price levels of the "bids" and "asks" arrays
+struct DepthHandler : public ScalarHandler<DepthHandler> {
+	OrderBook& book;
+	std::vector<OrderBookLevel>* side = nullptr;
+	OrderBookLevel level;
+	int depth = 0;
+	int column = 0;
+
+	bool inLastUpdateId = false;
+
+	explicit DepthHandler(OrderBook& book) : book(book) {}
+
+	bool StartObject() { depth++; return true; }
+	bool EndObject(SizeType) { depth--; return true; }
+
+	bool StartArray() {
+		if (++depth == 3) {
+			column = 0;
+		}
+		return true;
+	}
+
+	bool EndArray(SizeType) {
+		if (depth-- == 3) {
+			if (column < 2) {
+				return false;
+			}
+			side->push_back(level);
+		} else if (depth == 1) {
+			side = nullptr;
+		}
+		return true;
+	}
+
+	bool Key(const char* key, SizeType length, bool) {
+		if (depth != 1) {
+			return true;
+		}
+		side = nullptr;
+		inLastUpdateId = false;
+		if (checkErrorKey(key, length)) {
+			return true;
+		}
+		if (length == 12 && std::memcmp(key, "lastUpdateId", 12) == 0) {
+			inLastUpdateId = true;
+		} else if (length == 4 && std::memcmp(key, "bids", 4) == 0) {
+			side = &book.bids;
+		} else if (length == 4 && std::memcmp(key, "asks", 4) == 0) {
+			side = &book.asks;
+		}
+		return true;
+	}
+
+	bool onSkip() {
+		if (depth == 3) {
+			column++;
+		}
+		return true;
+	}
+
+	bool onNumber(int64_t integer, double number) {
+		if (errorKey != ErrorKey::NONE) {
+			return errorValue(integer, nullptr, 0);
+		}
+		if (inLastUpdateId) {
+			book.lastUpdateId = integer;
+			inLastUpdateId = false;
+		}
+		if (depth == 3 && side) {
+			if (column == 0) level.price = number;
+			else if (column == 1) level.quantity = number;
+		}
+		return onSkip();
+	}
+
+	bool onString(const char* str, SizeType length) {
+		if (errorKey != ErrorKey::NONE) {
+			return errorValue(0, str, length);
+		}
+		if (depth == 3 && side && column < 2) {
+			double& value = (column == 0) ? level.price : level.quantity;
+			if (!FastNumber::parseDouble(str, length, value)) {
+				return false;
+			}
+		}
+		return onSkip();
+	}
+};
+
+// Fast path for the kline layout Binance actually sends: rows of an
+// integer open time followed by quoted decimals. Only the first six columns
+// are read; the rest of each row is skipped with memchr. Returns false on
+// anything unexpected (error bodies, whitespace variants, unquoted values)
+// so the caller can fall back to the SAX parser.
+bool scanKlines(const char* p, const char* end, std::vector<Candle>& candles, const Candle& prototype) {
+	auto skipSpace = [&]() {
+		while (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+			p++;
+		}
+	};
+
+	skipSpace();
+	if (p == end || *p++ != '[') {
+		return false;
+	}
+	skipSpace();
+	if (p != end && *p == ']') {
+		p++;
+		skipSpace();
+		return p == end;
+	}
+
+	Candle candle = prototype;
+	double* fields[5] = {&candle.open, &candle.high, &candle.low, &candle.close, &candle.volume};
+
+	while (true) {
+		skipSpace();
+		if (p == end || *p++ != '[') {
+			return false;
+		}
+
+		// Open time (ms)
+		const char* comma = static_cast<const char*>(std::memchr(p, ',', end - p));
+		int64_t openTime = 0;
+		if (!comma || !FastNumber::parseInt64(p, comma, openTime)) {
+			return false;
+		}
+		candle.timestamp = static_cast<time_t>(openTime / 1000);
+		p = comma + 1;
+
+		// open, high, low, close, volume
+		char separator = ',';
+		for (int i = 0; i < 5; i++) {
+			if (p == end || *p++ != '"') {
+				return false;
+			}
+			const char* quote = static_cast<const char*>(std::memchr(p, '"', end - p));
+			if (!quote || !FastNumber::parseDouble(p, quote, *fields[i])) {
+				return false;
+			}
+			p = quote + 1;
+			separator = (p != end) ? *p++ : '\0';
+			if (separator != ',' && !(separator == ']' && i == 4)) {
+				return false;
+			}
+		}
+
+		// Remaining columns hold no brackets
+		if (separator == ',') {
+			const char* close = static_cast<const char*>(std::memchr(p, ']', end - p));
+			if (!close) {
+				return false;
+			}
+			p = close + 1;
+		}
+		candles.push_back(candle);
+
+		skipSpace();
+		if (p == end) {
+			return false;
+		}
+		if (*p == ',') {
+			p++;
+			continue;
+		}
+		if (*p++ != ']') {
+			return false;
+		}
+		skipSpace();
+		return p == end;
+	}
+}
+
+// Run 'handler' over 'json' in place. 'what' names the response in errors.
+template <typename Handler>
+bool parseInPlace(std::string& json, Handler& handler, const char* what, std::string& lastError) {
+	if (json.empty()) {
+		lastError = std::string("Empty ") + what + " response";
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	Reader reader;
+	InsituStringStream stream(&json[0]);
+	ParseResult result = reader.Parse<kParseInsituFlag>(stream, handler);
+
+	if (handler.hasError) {
+		lastError = handler.errorText();
+		LOG_ERROR(std::string("Failed to decode ") + what + ": " + lastError);
+		return false;
+	}
+
+	if (!result) {
+		if (result.Code() == kParseErrorTermination) {
+			lastError = std::string("Unexpected value in ") + what + " response at offset " +
+			            std::to_string(result.Offset());
+		} else {
+			lastError = std::string("Invalid ") + what + " response: " +
+			            GetParseError_En(result.Code()) + " at offset " + std::to_string(result.Offset());
+		}
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	return true;
+}
+
+} // namespace
+
+BinanceRestDecoder::BinanceRestDecoder() {
+}
+
+BinanceRestDecoder::~BinanceRestDecoder() {
+}
+
+bool BinanceRestDecoder::decodeKlines(std::string& json, std::vector<Candle>& candles,
+                                      const std::string& symbol,
+                                      const std::string& timeframe) {
+	// A kline row is ~150 bytes of JSON; reserving avoids regrowth
+	candles.reserve(candles.size() + json.size() / 128);
+
+	size_t initialSize = candles.size();
+
+	Candle prototype;
+	prototype.exchange = "binance";
+	prototype.symbol = symbol;
+	prototype.timeframe = timeframe;
+	if (scanKlines(json.data(), json.data() + json.size(), candles, prototype)) {
+		return true;
+	}
+	candles.resize(initialSize);
+
+	KlineHandler handler(candles, symbol, timeframe);
+	if (!parseInPlace(json, handler, "klines", lastError)) {
+		candles.resize(initialSize);
+		return false;
+	}
+	return true;
+}
+
+bool BinanceRestDecoder::decodeTicker(std::string& json, Ticker& ticker) {
+	// Decode into a temporary so 'ticker' is untouched on failure
+	Ticker decoded;
+	TickerHandler handler(nullptr, &decoded);
+	if (!parseInPlace(json, handler, "ticker", lastError)) {
+		return false;
+	}
+	if (!handler.rootIsObject) {
+		lastError = "Expected a ticker object";
+		LOG_ERROR(lastError);
+		return false;
+	}
+	ticker = std::move(decoded);
+	return true;
+}
+
+bool BinanceRestDecoder::decodeTickers(std::string& json, std::vector<Ticker>& tickers) {
+	size_t initialSize = tickers.size();
+	TickerHandler handler(&tickers, nullptr);
+	bool ok = parseInPlace(json, handler, "tickers", lastError);
+	if (ok && handler.rootIsObject) {
+		lastError = "Expected an array of tickers";
+		LOG_ERROR(lastError);
+		ok = false;
+	}
+	if (!ok) {
+		tickers.resize(initialSize);
+	}
+	return ok;
+}
+
+bool BinanceRestDecoder::decodeDepth(std::string& json, OrderBook& book) {
+	OrderBook decoded;
+	DepthHandler handler(decoded);
+	if (!parseInPlace(json, handler, "depth", lastError)) {
+		return false;
+	}
+	book.bids = std::move(decoded.bids);
+	book.asks = std::move(decoded.asks);
+	book.lastUpdateId = decoded.lastUpdateId;
+	return true;
+}
+
+} // namespace Emiglio
@@ -0,0 +1,48 @@
+#ifndef EMIGLIO_BINANCERESTDECODER_H
+#define EMIGLIO_BINANCERESTDECODER_H
+
+#include "ExchangeAPI.h"
+
+#include <string>
+#include <vector>
+
+namespace Emiglio {
+
+// One-pass decoders for the hot Binance REST responses.
+//
+// The response is parsed in place with RapidJSON's SAX reader: values are
+// written straight into the output structs as the parser reaches them, no
+// DOM is built and no strings are copied. The input buffer is modified
+// (string terminators are written into it) and must not be reused.
+//
+// Binance error bodies ({"code":-1121,"msg":"Invalid symbol."}) are
+// recognised and reported through getLastError(). On failure the outputs
+// are left unchanged.
+class BinanceRestDecoder {
+public:
+	BinanceRestDecoder();
+	~BinanceRestDecoder();
+
+	// /api/v3/klines: [[openTime, "open", "high", "low", "close", "volume",
+	// closeTime, ...], ...]. Candles are appended with timestamps in seconds.
+	bool decodeKlines(std::string& json, std::vector<Candle>& candles,
+	                  const std::string& symbol,
+	                  const std::string& timeframe = "");
+
+	// /api/v3/ticker/24hr with a symbol (one object) or without (an array)
+	bool decodeTicker(std::string& json, Ticker& ticker);
+	bool decodeTickers(std::string& json, std::vector<Ticker>& tickers);
+
+	// /api/v3/depth: {"lastUpdateId":..., "bids":[["p","q"],...], "asks":[...]}.
+	// Replaces the bids and asks of 'book'.
+	bool decodeDepth(std::string& json, OrderBook& book);
+
+	std::string getLastError() const { return lastError; }
+
+private:
+	std::string lastError;
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_BINANCERESTDECODER_H
@@ -0,0 +1,476 @@
+#include "BinanceStreamDecoder.h"
+#include "../utils/FastNumber.h"
+
+#include <cstring>
+
+namespace Emiglio {
+
+namespace {
+
+typedef BinanceStreamDecoder::Field Field;
+
+enum Kind : uint8_t {
+	KIND_STRING,
+	KIND_NUMBER,
+	KIND_TRUE,
+	KIND_FALSE,
+	KIND_NULL,
+	KIND_OBJECT,
+	KIND_ARRAY
+};
+
+inline void skipSpace(const char*& p, const char* end) {
+	while (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+		p++;
+	}
+}
+
+// p at the opening quote; leaves p after the closing quote. Escapes are
+// skipped, not decoded (Binance symbols and numbers never contain any).
+inline bool scanString(const char*& p, const char* end, const char*& start, size_t& length) {
+	start = ++p;
+	while (true) {
+		const char* quote = static_cast<const char*>(std::memchr(p, '"', end - p));
+		if (!quote) {
+			return false;
+		}
+
+		// An odd run of backslashes escapes the quote
+		const char* b = quote;
+		while (b != start && *(b - 1) == '\\') {
+			b--;
+		}
+		p = quote + 1;
+		if (((quote - b) & 1) == 0) {
+			length = static_cast<size_t>(quote - start);
+			return true;
+		}
+	}
+}
+
+// Skip an object or array; p at '{' or '['
+bool skipComposite(const char*& p, const char* end) {
+	int depth = 0;
+	while (p != end) {
+		char c = *p;
+		if (c == '"') {
+			const char* start;
+			size_t length;
+			if (!scanString(p, end, start, length)) {
+				return false;
+			}
+			continue;
+		}
+		if (c == '{' || c == '[') {
+			depth++;
+		} else if (c == '}' || c == ']') {
+			if (--depth == 0) {
+				p++;
+				return true;
+			}
+		}
+		p++;
+	}
+	return false;
+}
+
+// Scan one value into 'field'; p at its first character
+bool scanValue(const char*& p, const char* end, Field& field) {
+	if (p == end) {
+		return false;
+	}
+
+	const char* start = p;
+	switch (*p) {
+		case '"': {
+			size_t length;
+			if (!scanString(p, end, field.data, length)) {
+				return false;
+			}
+			field.length = static_cast<uint32_t>(length);
+			field.kind = KIND_STRING;
+			return true;
+		}
+		case '{':
+		case '[':
+			field.kind = (*p == '{') ? KIND_OBJECT : KIND_ARRAY;
+			if (!skipComposite(p, end)) {
+				return false;
+			}
+			break;
+		case 't':
+			if (end - p < 4 || std::memcmp(p, "true", 4) != 0) return false;
+			field.kind = KIND_TRUE;
+			p += 4;
+			break;
+		case 'f':
+			if (end - p < 5 || std::memcmp(p, "false", 5) != 0) return false;
+			field.kind = KIND_FALSE;
+			p += 5;
+			break;
+		case 'n':
+			if (end - p < 4 || std::memcmp(p, "null", 4) != 0) return false;
+			field.kind = KIND_NULL;
+			p += 4;
+			break;
+		default:
+			while (p != end && ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' ||
+			                    *p == '.' || *p == 'e' || *p == 'E')) {
+				p++;
+			}
+			if (p == start) {
+				return false;
+			}
+			field.kind = KIND_NUMBER;
+			break;
+	}
+
+	field.data = start;
+	field.length = static_cast<uint32_t>(p - start);
+	return true;
+}
+
+// Iterate the members of the object at p ('{'), calling onMember(key,
+// keyLength) with p at the member's value. onMember must consume the value.
+template <typename OnMember>
+bool forEachMember(const char*& p, const char* end, OnMember onMember) {
+	if (p == end || *p != '{') {
+		return false;
+	}
+	p++;
+	skipSpace(p, end);
+	if (p != end && *p == '}') {
+		p++;
+		return true;
+	}
+
+	while (true) {
+		skipSpace(p, end);
+		if (p == end || *p != '"') {
+			return false;
+		}
+		const char* key;
+		size_t keyLength;
+		if (!scanString(p, end, key, keyLength)) {
+			return false;
+		}
+		skipSpace(p, end);
+		if (p == end || *p++ != ':') {
+			return false;
+		}
+		skipSpace(p, end);
+		if (!onMember(key, keyLength)) {
+			return false;
+		}
+		skipSpace(p, end);
+		if (p == end) {
+			return false;
+		}
+		if (*p == ',') {
+			p++;
+			continue;
+		}
+		if (*p == '}') {
+			p++;
+			return true;
+		}
+		return false;
+	}
+}
+
+inline const Field* get(const Field* table, char key, uint32_t generation) {
+	const Field& field = table[static_cast<unsigned char>(key)];
+	return field.generation == generation ? &field : nullptr;
+}
+
+inline double toDouble(const Field* field) {
+	double value = 0.0;
+	if (field && (field->kind == KIND_STRING || field->kind == KIND_NUMBER)) {
+		FastNumber::parseDouble(field->data, field->length, value);
+	}
+	return value;
+}
+
+inline int64_t toInt64(const Field* field, int64_t defaultValue = 0) {
+	int64_t value = defaultValue;
+	if (field && field->kind == KIND_NUMBER) {
+		if (!FastNumber::parseInt64(field->data, field->data + field->length, value)) {
+			value = defaultValue;
+		}
+	}
+	return value;
+}
+
+inline bool toBool(const Field* field) {
+	return field && field->kind == KIND_TRUE;
+}
+
+inline bool equals(const Field* field, const char* literal, size_t length) {
+	return field && field->kind == KIND_STRING && field->length == length &&
+	       std::memcmp(field->data, literal, length) == 0;
+}
+
+// [["price","qty"], ...] into 'levels'
+bool parseLevels(const Field* field, std::vector<StreamPriceLevel>& levels) {
+	levels.clear();
+	if (!field) {
+		return true;
+	}
+	if (field->kind != KIND_ARRAY) {
+		return false;
+	}
+
+	const char* p = field->data + 1;
+	const char* end = field->data + field->length - 1;  // Before the closing ']'
+	while (true) {
+		skipSpace(p, end);
+		if (p == end) {
+			return true;
+		}
+		if (*p++ != '[') {
+			return false;
+		}
+
+		StreamPriceLevel level;
+		Field price, quantity;
+		skipSpace(p, end);
+		if (!scanValue(p, end, price)) {
+			return false;
+		}
+		skipSpace(p, end);
+		if (p == end || *p++ != ',') {
+			return false;
+		}
+		skipSpace(p, end);
+		if (!scanValue(p, end, quantity)) {
+			return false;
+		}
+		skipSpace(p, end);
+		if (p == end || *p++ != ']') {
+			return false;
+		}
+		if (!FastNumber::parseDouble(price.data, price.length, level.price) ||
+		    !FastNumber::parseDouble(quantity.data, quantity.length, level.quantity)) {
+			return false;
+		}
+		levels.push_back(level);
+
+		skipSpace(p, end);
+		if (p != end && *p == ',') {
+			p++;
+		}
+	}
+}
+
+} // namespace
+
+StreamEvent::StreamEvent()
+	: type(StreamEventType::UNKNOWN)
+	, streamId(SymbolTable::kNotFound)
+	, symbolId(SymbolTable::kNotFound)
+	, eventTime(0)
+	, trade()
+	, kline()
+	, ticker()
+	, depth() {
+}
+
+BinanceStreamDecoder::BinanceStreamDecoder()
+	: generation(1) {
+	std::memset(fields, 0, sizeof(fields));
+	std::memset(klineFields, 0, sizeof(klineFields));
+	std::memset(&previousFinalUpdateId, 0, sizeof(previousFinalUpdateId));
+}
+
+BinanceStreamDecoder::~BinanceStreamDecoder() {
+}
+
+bool BinanceStreamDecoder::fail(const char* error) {
+	lastError = error;
+	return false;
+}
+
+bool BinanceStreamDecoder::decode(const char* data, size_t length, StreamEvent& event) {
+	// A new generation invalidates all fields of the previous message
+	if (++generation == 0) {
+		std::memset(fields, 0, sizeof(fields));
+		std::memset(klineFields, 0, sizeof(klineFields));
+		std::memset(&previousFinalUpdateId, 0, sizeof(previousFinalUpdateId));
+		generation = 1;
+	}
+
+	event.type = StreamEventType::UNKNOWN;
+	event.streamId = SymbolTable::kNotFound;
+	event.symbolId = SymbolTable::kNotFound;
+
+	const char* p = data;
+	const char* end = data + length;
+	const uint32_t current = generation;
+
+	// Payload member: one-letter keys are recorded, "k" is descended into
+	auto payloadMember = [&](const char* key, size_t keyLength) -> bool {
+		if (keyLength == 1 && key[0] == 'k' && p != end && *p == '{') {
+			const char* start = p;
+			bool parsed = forEachMember(p, end, [&](const char* k, size_t kLength) -> bool {
+				Field field;
+				if (!scanValue(p, end, field)) {
+					return false;
+				}
+				if (kLength == 1 && static_cast<unsigned char>(k[0]) < 128) {
+					field.generation = current;
+					klineFields[static_cast<unsigned char>(k[0])] = field;
+				}
+				return true;
+			});
+
+			Field& kline = fields[static_cast<unsigned char>('k')];
+			kline.data = start;
+			kline.length = static_cast<uint32_t>(p - start);
+			kline.kind = KIND_OBJECT;
+			kline.generation = current;
+			return parsed;
+		}
+
+		Field field;
+		if (!scanValue(p, end, field)) {
+			return false;
+		}
+		field.generation = current;
+		if (keyLength == 1 && static_cast<unsigned char>(key[0]) < 128) {
+			fields[static_cast<unsigned char>(key[0])] = field;
+		} else if (keyLength == 2 && key[0] == 'p' && key[1] == 'u') {
+			previousFinalUpdateId = field;
+		}
+		return true;
+	};
+
+	skipSpace(p, end);
+	bool ok = forEachMember(p, end, [&](const char* key, size_t keyLength) -> bool {
+		if (keyLength == 6 && std::memcmp(key, "stream", 6) == 0) {
+			Field stream;
+			if (!scanValue(p, end, stream)) {
+				return false;
+			}
+			if (stream.kind == KIND_STRING) {
+				event.streamId = streams.find(stream.data, stream.length);
+			}
+			return true;
+		}
+		if (keyLength == 4 && std::memcmp(key, "data", 4) == 0 && p != end && *p == '{') {
+			return forEachMember(p, end, payloadMember);
+		}
+		// Raw (single stream) payload
+		return payloadMember(key, keyLength);
+	});
+
+	if (!ok) {
+		return fail("Malformed stream message");
+	}
+	return fill(event);
+}
+
+bool BinanceStreamDecoder::fill(StreamEvent& event) {
+	const uint32_t current = generation;
+	const Field* eventType = get(fields, 'e', current);
+	if (!eventType) {
+		// Not a market event (e.g. a reply to SUBSCRIBE)
+		return true;
+	}
+	if (eventType->kind != KIND_STRING) {
+		return fail("Invalid event type");
+	}
+
+	const Field* symbol = get(fields, 's', current);
+	if (symbol && symbol->kind == KIND_STRING) {
+		event.symbolId = symbols.intern(symbol->data, symbol->length);
+	} else {
+		event.symbolId = SymbolTable::kNotFound;
+	}
+	event.eventTime = toInt64(get(fields, 'E', current));
+
+	if (equals(eventType, "trade", 5)) {
+		event.type = StreamEventType::TRADE;
+		StreamTrade& trade = event.trade;
+		trade.tradeId = toInt64(get(fields, 't', current));
+		trade.firstTradeId = trade.tradeId;
+		trade.lastTradeId = trade.tradeId;
+		trade.price = toDouble(get(fields, 'p', current));
+		trade.quantity = toDouble(get(fields, 'q', current));
+		trade.tradeTime = toInt64(get(fields, 'T', current));
+		trade.isBuyerMaker = toBool(get(fields, 'm', current));
+		return true;
+	}
+
+	if (equals(eventType, "aggTrade", 8)) {
+		event.type = StreamEventType::AGG_TRADE;
+		StreamTrade& trade = event.trade;
+		trade.tradeId = toInt64(get(fields, 'a', current));
+		trade.firstTradeId = toInt64(get(fields, 'f', current));
+		trade.lastTradeId = toInt64(get(fields, 'l', current));
+		trade.price = toDouble(get(fields, 'p', current));
+		trade.quantity = toDouble(get(fields, 'q', current));
+		trade.tradeTime = toInt64(get(fields, 'T', current));
+		trade.isBuyerMaker = toBool(get(fields, 'm', current));
+		return true;
+	}
+
+	if (equals(eventType, "kline", 5)) {
+		if (!get(fields, 'k', current)) {
+			return fail("Kline event without kline data");
+		}
+		event.type = StreamEventType::KLINE;
+		StreamKline& kline = event.kline;
+		kline.openTime = toInt64(get(klineFields, 't', current));
+		kline.closeTime = toInt64(get(klineFields, 'T', current));
+		kline.open = toDouble(get(klineFields, 'o', current));
+		kline.high = toDouble(get(klineFields, 'h', current));
+		kline.low = toDouble(get(klineFields, 'l', current));
+		kline.close = toDouble(get(klineFields, 'c', current));
+		kline.volume = toDouble(get(klineFields, 'v', current));
+		kline.quoteVolume = toDouble(get(klineFields, 'q', current));
+		kline.tradeCount = toInt64(get(klineFields, 'n', current));
+		kline.isClosed = toBool(get(klineFields, 'x', current));
+
+		kline.interval[0] = '\0';
+		const Field* interval = get(klineFields, 'i', current);
+		if (interval && interval->kind == KIND_STRING && interval->length < sizeof(kline.interval)) {
+			std::memcpy(kline.interval, interval->data, interval->length);
+			kline.interval[interval->length] = '\0';
+		}
+		return true;
+	}
+
+	if (equals(eventType, "24hrTicker", 10)) {
+		event.type = StreamEventType::TICKER;
+		StreamTicker& ticker = event.ticker;
+		ticker.lastPrice = toDouble(get(fields, 'c', current));
+		ticker.openPrice = toDouble(get(fields, 'o', current));
+		ticker.priceChange = toDouble(get(fields, 'p', current));
+		ticker.priceChangePercent = toDouble(get(fields, 'P', current));
+		ticker.highPrice = toDouble(get(fields, 'h', current));
+		ticker.lowPrice = toDouble(get(fields, 'l', current));
+		ticker.volume = toDouble(get(fields, 'v', current));
+		ticker.quoteVolume = toDouble(get(fields, 'q', current));
+		ticker.bidPrice = toDouble(get(fields, 'b', current));
+		ticker.askPrice = toDouble(get(fields, 'a', current));
+		return true;
+	}
+
+	if (equals(eventType, "depthUpdate", 11)) {
+		event.type = StreamEventType::DEPTH_UPDATE;
+		StreamDepth& depth = event.depth;
+		depth.firstUpdateId = toInt64(get(fields, 'U', current));
+		depth.finalUpdateId = toInt64(get(fields, 'u', current));
+		depth.prevFinalUpdateId = previousFinalUpdateId.generation == current
+			? toInt64(&previousFinalUpdateId, -1) : -1;
+		if (!parseLevels(get(fields, 'b', current), depth.bids) ||
+		    !parseLevels(get(fields, 'a', current), depth.asks)) {
+			return fail("Malformed depth levels");
+		}
+		return true;
+	}
+
+	return fail("Unknown stream event type");
+}
+
+} // namespace Emiglio
@@ -0,0 +1,145 @@
+#ifndef EMIGLIO_BINANCESTREAMDECODER_H
+#define EMIGLIO_BINANCESTREAMDECODER_H
+
+#include "SymbolTable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Emiglio {
+
+enum class StreamEventType {
+	UNKNOWN,
+	TRADE,         // <symbol>@trade
+	AGG_TRADE,     // <symbol>@aggTrade
+	KLINE,         // <symbol>@kline_<interval>
+	TICKER,        // <symbol>@ticker (24hrTicker)
+	DEPTH_UPDATE   // <symbol>@depth / @depth@100ms
+};
+
+struct StreamPriceLevel {
+	double price;
+	double quantity;
+};
+
+// trade and aggTrade
+struct StreamTrade {
+	int64_t tradeId;        // t (trade) or a (aggTrade)
+	int64_t firstTradeId;   // aggTrade only
+	int64_t lastTradeId;    // aggTrade only
+	double price;
+	double quantity;
+	int64_t tradeTime;      // ms
+	bool isBuyerMaker;
+};
+
+struct StreamKline {
+	int64_t openTime;       // ms
+	int64_t closeTime;      // ms
+	char interval[8];       // NUL-terminated, e.g. "1m"
+	double open;
+	double high;
+	double low;
+	double close;
+	double volume;
+	double quoteVolume;
+	int64_t tradeCount;
+	bool isClosed;
+};
+
+struct StreamTicker {
+	double lastPrice;
+	double openPrice;
+	double priceChange;
+	double priceChangePercent;
+	double highPrice;
+	double lowPrice;
+	double volume;
+	double quoteVolume;
+	double bidPrice;
+	double askPrice;
+};
+
+struct StreamDepth {
+	int64_t firstUpdateId;      // U
+	int64_t finalUpdateId;      // u
+	int64_t prevFinalUpdateId;  // pu (futures streams only, else -1)
+	std::vector<StreamPriceLevel> bids;
+	std::vector<StreamPriceLevel> asks;
+};
+
+// One decoded event. Only the member matching 'type' is filled. Reuse the
+// same object across decode() calls: the depth vectors keep their capacity.
+struct StreamEvent {
+	StreamEventType type;
+	uint32_t streamId;   // Interned "stream" of the envelope, or SymbolTable::kNotFound
+	uint32_t symbolId;   // Interned "s"
+	int64_t eventTime;   // E, ms
+
+	StreamTrade trade;
+	StreamKline kline;
+	StreamTicker ticker;
+	StreamDepth depth;
+
+	StreamEvent();
+};
+
+// Single-pass decoder for Binance market stream payloads, either wrapped in
+// the combined-stream envelope {"stream":"...","data":{...}} or raw.
+//
+// The payload's one-letter fields are located in one scan without building
+// a DOM, then converted for the event type only. Symbols and stream names
+// are interned so callers can route events with an array index; once every
+// symbol has been seen, decoding doesn't allocate.
+class BinanceStreamDecoder {
+public:
+	BinanceStreamDecoder();
+	~BinanceStreamDecoder();
+
+	// Register a stream name (e.g. "btcusdt@trade") and return its ID.
+	// Events of unregistered streams are decoded with streamId = kNotFound.
+	uint32_t internStream(const std::string& stream) { return streams.intern(stream); }
+	uint32_t findStream(const std::string& stream) const { return streams.find(stream); }
+	const std::string& streamName(uint32_t id) const { return streams.name(id); }
+
+	uint32_t internSymbol(const std::string& symbol) { return symbols.intern(symbol); }
+	const std::string& symbolName(uint32_t id) const { return symbols.name(id); }
+
+	// False for malformed JSON and unknown event types. Messages without an
+	// "e" field (replies to requests) decode with type UNKNOWN.
+	bool decode(const char* data, size_t length, StreamEvent& event);
+	bool decode(const std::string& message, StreamEvent& event) {
+		return decode(message.data(), message.size(), event);
+	}
+
+	std::string getLastError() const { return lastError; }
+
+	// Raw position of one field inside the message
+	struct Field {
+		const char* data;   // Without quotes for strings
+		uint32_t length;
+		uint8_t kind;
+		uint32_t generation;
+	};
+
+private:
+	SymbolTable streams;
+	SymbolTable symbols;
+
+	// Payload and kline ("k") fields, indexed by their one-letter key
+	Field fields[128];
+	Field klineFields[128];
+	Field previousFinalUpdateId;  // "pu"
+	uint32_t generation;
+
+	std::string lastError;
+
+	bool fail(const char* error);
+	bool fill(StreamEvent& event);
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_BINANCESTREAMDECODER_H
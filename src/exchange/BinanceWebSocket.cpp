@@ -1,69 +1,287 @@
 #include "BinanceWebSocket.h"
 #include "WebSocketClient.h"
-#include "../utils/Logger.h"
+#include "WebSocketReactor.h"
+#include "BinanceStreamDecoder.h"
+#include "BinanceAPI.h"
+#include "StreamCapture.h"
+#include "../data/CandleResampler.h"
 #include "../utils/JsonParser.h"
+#include "../utils/Logger.h"
+#include "../utils/LatencyTracker.h"
 
 #include <thread>
 #include <mutex>
-#include <queue>
-#include <map>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <cstdlib>
 #include <ctime>
+#include <map>
 
 #ifdef __HAIKU__
 #include <OS.h>
-#else
-#include <chrono>
 #endif
 
 namespace Emiglio {
 
+namespace {
+
+// Binance limits per connection
+const size_t kMaxStreamsPerConnection = 1024;
+const size_t kMaxControlMessagesPerSecond = 5;
+
+const char* kDefaultStreamUrl = "wss://stream.binance.com:9443";
+
+// Klines per REST request when backfilling
+const int kBackfillPageSize = 1000;
+
+std::string defaultStreamUrl() {
+	const char* url = std::getenv("EMIGLIO_BINANCE_STREAM_URL");
+	return (url && *url) ? url : kDefaultStreamUrl;
+}
+
+int64_t nowMs() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Default backfill source: public klines endpoint
+std::vector<Candle> fetchKlines(const std::string& symbol, const std::string& interval,
+                                time_t startTime, time_t endTime) {
+	BinanceAPI api;
+	return api.getCandles(symbol, interval, startTime, endTime, kBackfillPageSize);
+}
+
+} // namespace
+
 // Private implementation using PIMPL pattern
 class BinanceWebSocket::Impl {
 public:
-	// WebSocket client
-	WebSocketClient wsClient;
+	// One combined-stream connection. Streams beyond the per-connection
+	// limit go to additional shards.
+	struct Shard {
+		WebSocketClient client;
+		size_t streamCount = 0;
+
+		// Control messages not sent yet, batched per processMessages() call
+		std::vector<std::string> toSubscribe;
+		std::vector<std::string> toUnsubscribe;
+
+		// Send times of recent control messages, for the rate limit
+		std::vector<std::chrono::steady_clock::time_point> controlTimes;
+
+		// Streams named in the connection URL, which the server restores
+		// by itself on reconnect
+		std::vector<std::string> urlStreams;
+
+		// Set by the network thread after an automatic reconnect
+		std::atomic<bool> reconnected{false};
+	};
+
+	// A SUBSCRIBE/UNSUBSCRIBE waiting for its reply
+	struct Request {
+		int shard;
+		bool subscribe;
+		std::vector<std::string> streams;
+	};
+
+	// Missing closed klines of one stream, fetched over REST after a reconnect
+	struct BackfillJob {
+		uint32_t stream;
+		std::string symbol;
+		std::string interval;
+		time_t startTime;  // Open time of the first missing kline, seconds
+	};
+
+	struct BackfillResult {
+		uint32_t stream;
+		std::vector<Candle> candles;
+	};
+
+	// One I/O thread reads every connection, and the capture records what
+	// they receive; declared first so they outlive them
+	WebSocketReactor reactor;
+	StreamCaptureWriter capture;
+	std::vector<std::unique_ptr<Shard>> shards;
 	bool connected;
+	size_t maxStreamsPerConnection;
+	bool compression;
+	std::string streamUrl;
+
+	std::map<int64_t, Request> pendingRequests;
+	int64_t nextRequestId;
+
+	// Callbacks of one subscribed stream
+	struct Route {
+		TickerCallback ticker;
+		TradeCallback trade;
+		AggTradeCallback aggTrade;
+		KlineCallback kline;
+		DepthCallback depth;
+		int shard = -1;  // Connection carrying the stream, -1 if none
+
+		// Kline continuity across reconnects
+		int64_t lastClosedOpenTime = 0;      // ms, last closed kline delivered
+		bool backfilling = false;            // Live klines are held meanwhile
+		std::vector<KlineUpdate> heldKlines;
+
+		bool empty() const {
+			return !ticker && !trade && !aggTrade && !kline && !depth;
+		}
+	};
 
-	// Callbacks
-	std::map<std::string, TickerCallback> tickerCallbacks;
-	std::map<std::string, TradeCallback> tradeCallbacks;
-	std::map<std::string, KlineCallback> klineCallbacks;
+	// Indexed by the decoder's stream ID
+	std::vector<Route> routes;
 	ErrorCallback errorCallback;
 
-	// Subscribed streams
-	std::vector<std::string> subscribedStreams;
-
-	// CRITICAL FIX: Message queue for thread-safe callback handling
+	// CRITICAL FIX: Message queue for thread-safe callback handling.
+	// Double-buffered: the network threads fill pendingMessages, the main
+	// thread swaps it with processingMessages. Slots are reused, so their
+	// capacity is kept and steady-state traffic doesn't allocate.
 	std::mutex messageMutex;
-	std::queue<std::string> messageQueue;
+	std::vector<std::string> pendingMessages;
+	size_t pendingCount;
+	std::vector<std::string> processingMessages;
+
+	// Socket read and enqueue times per slot, for the latency histograms
+	struct MessageTiming {
+		int64_t received;
+		int64_t queued;
+	};
+	std::vector<MessageTiming> pendingTimes;
+	std::vector<MessageTiming> processingTimes;
+
+	// Consumer wakeup: set when anything is queued for processMessages(),
+	// cleared when it runs. The callback fires only when the flag goes up,
+	// so a burst of messages costs one wakeup.
+	bool eventsPending;
+	std::condition_variable eventCondition;
+	BinanceWebSocket::WakeupCallback wakeupCallback;
+
+	// Reused for every message
+	BinanceStreamDecoder decoder;
+	StreamEvent event;
+	DepthUpdate depthUpdate;  // Keeps its level capacity across messages
+	JsonParser replyParser;   // Control replies; its pool is made once
+
+	// Backfill worker; results are handed over under messageMutex
+	BinanceWebSocket::KlineFetcher klineFetcher;
+	std::deque<BackfillJob> backfillJobs;
+	std::vector<BackfillResult> backfillResults;
+	std::thread backfillThread;
+	bool backfillRunning;
+	std::atomic<bool> stopBackfill;
+
+	Impl()
+		: connected(false)
+		, maxStreamsPerConnection(kMaxStreamsPerConnection)
+		, compression(true)
+		, streamUrl(defaultStreamUrl())
+		, nextRequestId(1)
+		, pendingCount(0)
+		, eventsPending(false)
+		, klineFetcher(fetchKlines)
+		, backfillRunning(false)
+		, stopBackfill(false) {
+	}
+
+	~Impl() {
+		disconnect();
+		stopBackfill = true;
+		if (backfillThread.joinable()) {
+			backfillThread.join();
+		}
+	}
+
+	// Called by the network and backfill threads with messageMutex held
+	// after queueing something; releases the lock
+	void wakeConsumer(std::unique_lock<std::mutex>& lock) {
+		if (eventsPending) {
+			// The consumer hasn't run since the last wakeup
+			return;
+		}
+		eventsPending = true;
+		BinanceWebSocket::WakeupCallback callback = wakeupCallback;
+		lock.unlock();
 
-	Impl() : connected(false) {
-		// Setup WebSocket callbacks
-		wsClient.onConnect([this]() {
-			LOG_INFO("WebSocket connected successfully");
-			connected = true;
+		eventCondition.notify_all();
+		if (callback) {
+			callback();
+		}
+	}
+
+	// Network threads (and replay): queue 'message' for processMessages()
+	void enqueueMessage(const std::string& message) {
+		// CRITICAL FIX: Queue messages instead of processing them directly
+		// This avoids calling UI callbacks from background thread
+		MessageTiming timing = { LatencyTracker::getTickOrigin(), 0 };
+		if (timing.received != 0) {
+			timing.queued = LatencyTracker::now();
+		}
+
+		std::unique_lock<std::mutex> lock(messageMutex);
+		if (pendingCount < pendingMessages.size()) {
+			pendingMessages[pendingCount].assign(message);
+			pendingTimes[pendingCount] = timing;
+		} else {
+			pendingMessages.push_back(message);
+			pendingTimes.push_back(timing);
+		}
+		pendingCount++;
+		wakeConsumer(lock);
+	}
+
+	// Open a connection carrying 'streams' and return its index, or -1
+	int openShard(const std::vector<std::string>& streams) {
+		std::unique_ptr<Shard> shard(new Shard());
+		int index = static_cast<int>(shards.size());
+
+		shard->client.onConnect([index]() {
+			LOG_INFO("WebSocket connection " + std::to_string(index) + " established");
 		});
 
-		wsClient.onMessage([this](const std::string& message) {
-			// CRITICAL FIX: Queue messages instead of processing them directly
-			// This avoids calling UI callbacks from background thread
-			std::lock_guard<std::mutex> lock(messageMutex);
-			messageQueue.push(message);
+		shard->client.onMessage([this](const std::string& message) {
+			enqueueMessage(message);
 		});
+		shard->client.setCapture(&capture, static_cast<uint32_t>(index));
+
+		Shard* shardPtr = shard.get();
+		shard->client.onReconnect([this, shardPtr]() {
+			// Resubscribing and backfilling happen in processMessages()
+			shardPtr->reconnected = true;
+			std::unique_lock<std::mutex> lock(messageMutex);
+			wakeConsumer(lock);
+		});
+		shard->client.setAutoReconnect(true);
+		shard->client.setReactor(&reactor);
+		shard->client.setCompression(compression);
 
-		wsClient.onError([this](const std::string& error) {
+		shard->client.onError([this](const std::string& error) {
 			LOG_ERROR("WebSocket error: " + error);
 			if (errorCallback) {
 				errorCallback(error);
 			}
 		});
-	}
 
-	~Impl() {
-		disconnect();
+		// Initial streams go in the URL, later ones through SUBSCRIBE
+		std::string url = streamUrl + "/stream?streams=";
+		for (size_t i = 0; i < streams.size(); i++) {
+			if (i > 0) url += "/";
+			url += streams[i];
+		}
+		LOG_INFO("WebSocket URL: " + url);
+
+		if (!shard->client.connect(url)) {
+			return -1;
+		}
+
+		shard->streamCount = streams.size();
+		shard->urlStreams = streams;
+		shards.push_back(std::move(shard));
+		return index;
 	}
 
 	bool connect() {
@@ -72,172 +290,626 @@ public:
 			return true;
 		}
 
-		if (subscribedStreams.empty()) {
+		std::vector<uint32_t> ids;
+		for (uint32_t id = 0; id < routes.size(); id++) {
+			if (!routes[id].empty()) {
+				ids.push_back(id);
+			}
+		}
+
+		if (ids.empty()) {
 			LOG_WARNING("No streams subscribed, cannot connect");
 			return false;
 		}
 
 		LOG_INFO("Connecting to Binance WebSocket...");
 
-		// Build URL with streams
-		std::string streams;
-		for (size_t i = 0; i < subscribedStreams.size(); i++) {
-			if (i > 0) streams += "/";
-			streams += subscribedStreams[i];
-		}
+		// Split the streams across as many connections as the limit needs
+		for (size_t first = 0; first < ids.size(); first += maxStreamsPerConnection) {
+			size_t last = std::min(first + maxStreamsPerConnection, ids.size());
+			std::vector<std::string> streams;
+			for (size_t i = first; i < last; i++) {
+				streams.push_back(decoder.streamName(ids[i]));
+			}
 
-		std::string url = "wss://stream.binance.com:9443/stream?streams=" + streams;
-		LOG_INFO("WebSocket URL: " + url);
+			int shard = openShard(streams);
+			if (shard < 0) {
+				// disconnect() only acts once connected
+				closeShards();
+				return false;
+			}
+			for (size_t i = first; i < last; i++) {
+				routes[ids[i]].shard = shard;
+			}
+		}
 
-		return wsClient.connect(url);
+		connected = true;
+		return true;
 	}
 
 	void disconnect() {
 		if (!connected) return;
 
 		LOG_INFO("Disconnecting from WebSocket...");
-		wsClient.disconnect();
+		closeShards();
 		connected = false;
-		subscribedStreams.clear();
 		LOG_INFO("WebSocket disconnected");
 	}
 
-	// Handle incoming WebSocket messages
-	void handleMessage(const std::string& message) {
-		// Parse JSON message
-		JsonParser wrapper;
-		if (!wrapper.parse(message)) {
-			LOG_WARNING("Failed to parse WebSocket message");
+	// Close every connection and unroute the streams they carried
+	void closeShards() {
+		for (auto& shard : shards) {
+			shard->client.disconnect();
+		}
+		shards.clear();
+		reactor.stop();
+		pendingRequests.clear();
+		for (auto& route : routes) {
+			route.shard = -1;
+		}
+	}
+
+	bool isConnected() const {
+		for (const auto& shard : shards) {
+			if (shard->client.isConnected()) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Start delivering stream 'id' if it isn't live yet. Before connect()
+	// nothing is sent; connect() picks up every stream with a callback.
+	bool activate(uint32_t id) {
+		Route& route = routes[id];
+		if (route.shard >= 0 || !connected) {
+			return true;
+		}
+
+		const std::string& streamName = decoder.streamName(id);
+		for (size_t i = 0; i < shards.size(); i++) {
+			Shard& shard = *shards[i];
+			if (shard.streamCount < maxStreamsPerConnection) {
+				// Undo a pending UNSUBSCRIBE of the same stream instead of
+				// sending both
+				auto pending = std::find(shard.toUnsubscribe.begin(), shard.toUnsubscribe.end(), streamName);
+				if (pending != shard.toUnsubscribe.end()) {
+					shard.toUnsubscribe.erase(pending);
+				} else {
+					shard.toSubscribe.push_back(streamName);
+				}
+				shard.streamCount++;
+				route.shard = static_cast<int>(i);
+				return true;
+			}
+		}
+
+		// Every connection is full
+		int shard = openShard({streamName});
+		if (shard < 0) {
+			return false;
+		}
+		route.shard = shard;
+		return true;
+	}
+
+	// Stop delivering stream 'id' once no callback is left
+	void release(uint32_t id) {
+		Route& route = routes[id];
+		if (!route.empty() || route.shard < 0) {
 			return;
 		}
 
-		// Binance sends messages in format: {"stream":"btcusdt@trade","data":{...}}
-		std::string eventType = wrapper.getString("data.e", "");
-		if (!eventType.empty()) {
-			parseAndDispatchNested(wrapper);
+		Shard& shard = *shards[route.shard];
+		const std::string& streamName = decoder.streamName(id);
+		auto pending = std::find(shard.toSubscribe.begin(), shard.toSubscribe.end(), streamName);
+		if (pending != shard.toSubscribe.end()) {
+			shard.toSubscribe.erase(pending);
+		} else {
+			shard.toUnsubscribe.push_back(streamName);
 		}
+		shard.streamCount--;
+		route.shard = -1;
 	}
 
-	bool subscribeTicker(const std::string& symbol, TickerCallback callback) {
-		std::string lowerSymbol = symbol;
-		std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
+	void unsubscribe(const std::string& streamName, void (*clear)(Route&)) {
+		uint32_t id = decoder.findStream(streamName);
+		if (id < routes.size()) {
+			clear(routes[id]);
+			release(id);
+		}
+	}
 
-		tickerCallbacks[lowerSymbol] = callback;
+	// Send queued SUBSCRIBE/UNSUBSCRIBE messages, one per method and
+	// connection, within Binance's control message rate limit
+	void flushControlMessages() {
+		auto now = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < shards.size(); i++) {
+			Shard* shard = shards[i].get();
+			auto& times = shard->controlTimes;
+			times.erase(std::remove_if(times.begin(), times.end(), [now](const std::chrono::steady_clock::time_point& t) {
+				return now - t >= std::chrono::seconds(1);
+			}), times.end());
+
+			// Unsubscribes first; each request counts against the limit
+			std::vector<std::string> messages;
+			std::vector<bool> subscribes;
+			if (!shard->toUnsubscribe.empty() && times.size() < kMaxControlMessagesPerSecond) {
+				messages.push_back(controlMessage(nextRequestId, false, shard->toUnsubscribe));
+				subscribes.push_back(false);
+			}
+			if (!shard->toSubscribe.empty() && times.size() + messages.size() < kMaxControlMessagesPerSecond) {
+				messages.push_back(controlMessage(nextRequestId + messages.size(), true, shard->toSubscribe));
+				subscribes.push_back(true);
+			}
+			if (messages.empty()) {
+				continue;
+			}
 
-		// Build stream name: btcusdt@ticker
-		std::string streamName = lowerSymbol + "@ticker";
-		subscribedStreams.push_back(streamName);
+			// Both requests in one write
+			if (!shard->client.send(messages)) {
+				continue;
+			}
 
-		LOG_INFO("Subscribed to ticker stream: " + streamName);
-		return true;
+			for (size_t m = 0; m < messages.size(); m++) {
+				std::vector<std::string>& streams = subscribes[m] ? shard->toSubscribe : shard->toUnsubscribe;
+				pendingRequests[nextRequestId++] = Request{static_cast<int>(i), subscribes[m], streams};
+				streams.clear();
+				times.push_back(now);
+				LOG_DEBUG("Sent " + messages[m]);
+			}
+		}
 	}
 
-	bool subscribeTrades(const std::string& symbol, TradeCallback callback) {
-		std::string lowerSymbol = symbol;
-		std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
+	static std::string controlMessage(int64_t id, bool subscribe, const std::vector<std::string>& streams) {
+		// {"method":"SUBSCRIBE","params":["btcusdt@trade"],"id":1}
+		std::string message = subscribe ? "{\"method\":\"SUBSCRIBE\",\"params\":["
+		                                 : "{\"method\":\"UNSUBSCRIBE\",\"params\":[";
+		for (size_t i = 0; i < streams.size(); i++) {
+			if (i > 0) message += ",";
+			message += "\"" + streams[i] + "\"";
+		}
+		message += "],\"id\":" + std::to_string(id) + "}";
+		return message;
+	}
 
-		tradeCallbacks[lowerSymbol] = callback;
+	// After a shard reconnected: restore its subscriptions and backfill
+	// the klines missed while it was down
+	void handleReconnects() {
+		for (size_t i = 0; i < shards.size(); i++) {
+			Shard& shard = *shards[i];
+			if (!shard.reconnected.exchange(false)) {
+				continue;
+			}
 
-		// Build stream name: btcusdt@trade
-		std::string streamName = lowerSymbol + "@trade";
-		subscribedStreams.push_back(streamName);
+			// Requests in flight on the old connection will never be answered
+			for (auto it = pendingRequests.begin(); it != pendingRequests.end();) {
+				if (it->second.shard == static_cast<int>(i)) {
+					it = pendingRequests.erase(it);
+				} else {
+					++it;
+				}
+			}
 
-		LOG_INFO("Subscribed to trade stream: " + streamName);
+			// The URL brings back its own streams; subscribe the ones added
+			// since and drop the ones removed since
+			shard.toSubscribe.clear();
+			shard.toUnsubscribe.clear();
+			std::vector<std::string> live;
+			std::vector<BackfillJob> jobs;
+			for (uint32_t id = 0; id < routes.size(); id++) {
+				Route& route = routes[id];
+				if (route.shard != static_cast<int>(i)) {
+					continue;
+				}
+				const std::string& streamName = decoder.streamName(id);
+				live.push_back(streamName);
+				if (std::find(shard.urlStreams.begin(), shard.urlStreams.end(), streamName) == shard.urlStreams.end()) {
+					shard.toSubscribe.push_back(streamName);
+				}
+
+				BackfillJob job;
+				if (route.kline && route.lastClosedOpenTime > 0 && makeBackfillJob(id, job)) {
+					route.backfilling = true;
+					jobs.push_back(job);
+				}
+			}
+			for (const auto& streamName : shard.urlStreams) {
+				if (std::find(live.begin(), live.end(), streamName) == live.end()) {
+					shard.toUnsubscribe.push_back(streamName);
+				}
+			}
+
+			LOG_INFO("WebSocket connection " + std::to_string(i) + " restored, backfilling " +
+			         std::to_string(jobs.size()) + " kline stream(s)");
+			startBackfill(jobs);
+		}
+	}
+
+	// Kline streams are named <symbol>@kline_<interval>
+	bool makeBackfillJob(uint32_t id, BackfillJob& job) {
+		const std::string& streamName = decoder.streamName(id);
+		size_t at = streamName.find("@kline_");
+		if (at == std::string::npos) {
+			return false;
+		}
+
+		job.stream = id;
+		job.symbol = streamName.substr(0, at);
+		std::transform(job.symbol.begin(), job.symbol.end(), job.symbol.begin(), ::toupper);
+		job.interval = streamName.substr(at + 7);
+
+		int64_t intervalSeconds = CandleResampler::timeframeToSeconds(job.interval);
+		if (intervalSeconds <= 0) {
+			return false;
+		}
+		// Months differ in length; the next kline opens on the 1st
+		job.startTime = CandleResampler::nextBucketStart(
+			static_cast<time_t>(routes[id].lastClosedOpenTime / 1000), job.interval);
 		return true;
 	}
 
-	bool subscribeKlines(const std::string& symbol, const std::string& interval, KlineCallback callback) {
-		std::string lowerSymbol = symbol;
-		std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
+	void startBackfill(const std::vector<BackfillJob>& jobs) {
+		if (jobs.empty()) {
+			return;
+		}
 
-		std::string key = lowerSymbol + "_" + interval;
-		klineCallbacks[key] = callback;
+		std::lock_guard<std::mutex> lock(messageMutex);
+		backfillJobs.insert(backfillJobs.end(), jobs.begin(), jobs.end());
+		if (backfillRunning) {
+			return;
+		}
 
-		// Build stream name: btcusdt@kline_1m
-		std::string streamName = lowerSymbol + "@kline_" + interval;
-		subscribedStreams.push_back(streamName);
+		// The previous worker has already taken its last job
+		if (backfillThread.joinable()) {
+			backfillThread.join();
+		}
+		backfillRunning = true;
+		backfillThread = std::thread(&Impl::backfillLoop, this);
+	}
 
-		LOG_INFO("Subscribed to kline stream: " + streamName);
+	// Worker thread: page through the missing klines of each job
+	void backfillLoop() {
+		while (!stopBackfill) {
+			BackfillJob job;
+			KlineFetcher fetch;
+			{
+				std::lock_guard<std::mutex> lock(messageMutex);
+				if (backfillJobs.empty()) {
+					backfillRunning = false;
+					return;
+				}
+				job = backfillJobs.front();
+				backfillJobs.pop_front();
+				fetch = klineFetcher;
+			}
+
+			BackfillResult result;
+			result.stream = job.stream;
+			time_t endTime = nowMs() / 1000;
+			time_t startTime = job.startTime;
+			while (!stopBackfill && startTime <= endTime) {
+				std::vector<Candle> page = fetch(job.symbol, job.interval, startTime, endTime);
+				if (page.empty()) {
+					break;
+				}
+				result.candles.insert(result.candles.end(), page.begin(), page.end());
+				time_t next = CandleResampler::nextBucketStart(page.back().timestamp, job.interval);
+				if (next <= startTime) {
+					break;
+				}
+				startTime = next;
+			}
+
+			std::unique_lock<std::mutex> lock(messageMutex);
+			backfillResults.push_back(std::move(result));
+			wakeConsumer(lock);
+		}
+
+		std::lock_guard<std::mutex> lock(messageMutex);
+		backfillRunning = false;
+	}
+
+	// Deliver backfilled klines in timestamp order, then the live klines
+	// held meanwhile
+	void applyBackfill(BackfillResult& result) {
+		if (result.stream >= routes.size()) {
+			return;
+		}
+		Route& route = routes[result.stream];
+		route.backfilling = false;
+
+		std::sort(result.candles.begin(), result.candles.end(), [](const Candle& a, const Candle& b) {
+			return a.timestamp < b.timestamp;
+		});
+
+		size_t delivered = 0;
+		int64_t now = nowMs();
+		for (const auto& candle : result.candles) {
+			KlineUpdate update;
+			update.symbol = candle.symbol;
+			update.interval = candle.timeframe;
+			update.openTime = static_cast<time_t>(candle.timestamp) * 1000;
+			update.closeTime = static_cast<time_t>(CandleResampler::nextBucketStart(
+				candle.timestamp, candle.timeframe)) * 1000 - 1;
+			update.open = candle.open;
+			update.high = candle.high;
+			update.low = candle.low;
+			update.close = candle.close;
+			update.volume = candle.volume;
+			update.isClosed = true;
+
+			// The last REST kline may still be open
+			if (update.closeTime >= now) {
+				break;
+			}
+			if (deliverKline(route, update)) {
+				delivered++;
+			}
+		}
+
+		std::vector<KlineUpdate> held;
+		held.swap(route.heldKlines);
+		for (const auto& update : held) {
+			deliverKline(route, update);
+		}
+
+		LOG_INFO("Backfilled " + std::to_string(delivered) + " kline(s) for " +
+		         decoder.streamName(result.stream));
+	}
+
+	// Pass a kline on unless it is older than what was already delivered
+	bool deliverKline(Route& route, const KlineUpdate& update) {
+		if (!route.kline || update.openTime < route.lastClosedOpenTime ||
+		    (update.isClosed && update.openTime == route.lastClosedOpenTime)) {
+			return false;
+		}
+		if (update.isClosed) {
+			route.lastClosedOpenTime = update.openTime;
+		}
+		route.kline(update);
 		return true;
 	}
 
-	// Parse nested data (for stream format: {"stream":"...","data":{...}})
-	void parseAndDispatchNested(JsonParser& wrapper) {
-		// Determine message type from nested data.e field
-		std::string eventType = wrapper.getString("data.e", "");
+	// Replies to control messages: {"result":null,"id":1} or
+	// {"error":{"code":2,"msg":"..."},"id":1}
+	void handleReply(const std::string& message) {
+		JsonParser& parser = replyParser;
+		if (!parser.parse(message) || !parser.has("id")) {
+			return;
+		}
+
+		int64_t id = parser.getInt64("id");
+		auto it = pendingRequests.find(id);
+		if (it == pendingRequests.end()) {
+			return;
+		}
 
-		if (eventType == "24hrTicker") {
-			dispatchTickerNested(wrapper);
-		} else if (eventType == "trade") {
-			dispatchTradeNested(wrapper);
-		} else if (eventType == "kline") {
-			dispatchKlineNested(wrapper);
+		if (parser.has("error")) {
+			std::string error = "Stream request " + std::to_string(id) + " failed: " +
+			                    parser.getString("error.msg");
+			LOG_ERROR(error);
+
+			// Streams that failed to subscribe are not live
+			if (it->second.subscribe) {
+				for (const auto& streamName : it->second.streams) {
+					uint32_t stream = decoder.findStream(streamName);
+					if (stream < routes.size() && routes[stream].shard >= 0) {
+						shards[routes[stream].shard]->streamCount--;
+						routes[stream].shard = -1;
+					}
+				}
+			}
+			if (errorCallback) {
+				errorCallback(error);
+			}
 		} else {
-			LOG_WARNING("Unknown WebSocket event type: " + eventType);
+			LOG_DEBUG("Stream request " + std::to_string(id) + " acknowledged");
 		}
+		pendingRequests.erase(it);
 	}
 
-	void dispatchTickerNested(JsonParser& wrapper) {
-		TickerUpdate update;
-		update.symbol = wrapper.getString("data.s", "");
-		update.lastPrice = wrapper.getDouble("data.c", 0.0);
-		update.priceChange = wrapper.getDouble("data.p", 0.0);
-		update.priceChangePercent = wrapper.getDouble("data.P", 0.0);
-		update.highPrice = wrapper.getDouble("data.h", 0.0);
-		update.lowPrice = wrapper.getDouble("data.l", 0.0);
-		update.volume = wrapper.getDouble("data.v", 0.0);
-		update.quoteVolume = wrapper.getDouble("data.q", 0.0);
-		update.timestamp = wrapper.getInt64("data.E", 0);
+	// Handle incoming WebSocket messages
+	void handleMessage(const std::string& message) {
+		LatencyTracker& latency = LatencyTracker::getInstance();
+		bool timed = LatencyTracker::getTickOrigin() != 0;
+		int64_t start = timed ? LatencyTracker::now() : 0;
 
-		std::string lowerSymbol = update.symbol;
-		std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
+		// Binance sends messages in format: {"stream":"btcusdt@trade","data":{...}}
+		if (!decoder.decode(message, event)) {
+			LOG_WARNING("Failed to decode WebSocket message: " + decoder.getLastError());
+			return;
+		}
+
+		if (timed) {
+			int64_t decoded = LatencyTracker::now();
+			latency.record(LatencyStage::JSON_DECODE, decoded - start);
+			start = decoded;
+		}
+
+		if (event.type == StreamEventType::UNKNOWN) {
+			handleReply(message);
+			return;
+		}
 
-		auto it = tickerCallbacks.find(lowerSymbol);
-		if (it != tickerCallbacks.end()) {
-			it->second(update);
+		if (event.streamId < routes.size()) {
+			dispatch(routes[event.streamId]);
+			if (timed) {
+				latency.recordSince(LatencyStage::DISPATCH, start);
+			}
 		}
 	}
 
-	void dispatchTradeNested(JsonParser& wrapper) {
-		TradeUpdate update;
-		update.symbol = wrapper.getString("data.s", "");
-		update.tradeId = wrapper.getInt64("data.t", 0);
-		update.price = wrapper.getDouble("data.p", 0.0);
-		update.quantity = wrapper.getDouble("data.q", 0.0);
-		update.timestamp = wrapper.getInt64("data.T", 0);
-		update.isBuyerMaker = wrapper.getBool("data.m", false);
+	// Register 'streamName' and return its route
+	Route& addStream(const std::string& streamName) {
+		uint32_t id = decoder.internStream(streamName);
+		if (id >= routes.size()) {
+			routes.resize(id + 1);
+		}
+		return routes[id];
+	}
 
-		std::string lowerSymbol = update.symbol;
+	static std::string toLower(const std::string& symbol) {
+		std::string lowerSymbol = symbol;
 		std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
+		return lowerSymbol;
+	}
 
-		auto it = tradeCallbacks.find(lowerSymbol);
-		if (it != tradeCallbacks.end()) {
-			it->second(update);
+	bool subscribeTicker(const std::string& symbol, TickerCallback callback) {
+		// Build stream name: btcusdt@ticker
+		std::string streamName = toLower(symbol) + "@ticker";
+		addStream(streamName).ticker = callback;
+		if (!activate(decoder.findStream(streamName))) {
+			return false;
 		}
+
+		LOG_INFO("Subscribed to ticker stream: " + streamName);
+		return true;
 	}
 
-	void dispatchKlineNested(JsonParser& wrapper) {
-		// Similar to dispatchKline but with "data." prefix
-		KlineUpdate update;
-		update.symbol = wrapper.getString("data.s", "");
-		update.interval = wrapper.getString("data.i", "");
-		update.openTime = wrapper.getInt64("data.t", 0);
-		update.closeTime = wrapper.getInt64("data.T", 0);
-		update.open = wrapper.getDouble("data.o", 0.0);
-		update.high = wrapper.getDouble("data.h", 0.0);
-		update.low = wrapper.getDouble("data.l", 0.0);
-		update.close = wrapper.getDouble("data.c", 0.0);
-		update.volume = wrapper.getDouble("data.v", 0.0);
-		update.isClosed = wrapper.getBool("data.x", false);
+	bool subscribeTrades(const std::string& symbol, TradeCallback callback) {
+		// Build stream name: btcusdt@trade
+		std::string streamName = toLower(symbol) + "@trade";
+		addStream(streamName).trade = callback;
+		if (!activate(decoder.findStream(streamName))) {
+			return false;
+		}
 
-		std::string lowerSymbol = update.symbol;
-		std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
+		LOG_INFO("Subscribed to trade stream: " + streamName);
+		return true;
+	}
 
-		std::string key = lowerSymbol + "_" + update.interval;
+	bool subscribeAggTrades(const std::string& symbol, AggTradeCallback callback) {
+		// Build stream name: btcusdt@aggTrade
+		std::string streamName = toLower(symbol) + "@aggTrade";
+		addStream(streamName).aggTrade = callback;
+		if (!activate(decoder.findStream(streamName))) {
+			return false;
+		}
+
+		LOG_INFO("Subscribed to aggregate trade stream: " + streamName);
+		return true;
+	}
+
+	bool subscribeKlines(const std::string& symbol, const std::string& interval, KlineCallback callback) {
+		// Build stream name: btcusdt@kline_1m
+		std::string streamName = toLower(symbol) + "@kline_" + interval;
+		addStream(streamName).kline = callback;
+		if (!activate(decoder.findStream(streamName))) {
+			return false;
+		}
+
+		LOG_INFO("Subscribed to kline stream: " + streamName);
+		return true;
+	}
+
+	bool subscribeDepth(const std::string& symbol, DepthCallback callback) {
+		// Build stream name: btcusdt@depth@100ms
+		std::string streamName = toLower(symbol) + "@depth@100ms";
+		addStream(streamName).depth = callback;
+		if (!activate(decoder.findStream(streamName))) {
+			return false;
+		}
+
+		LOG_INFO("Subscribed to depth stream: " + streamName);
+		return true;
+	}
+
+	static void copyLevels(const std::vector<StreamPriceLevel>& from, std::vector<OrderBookLevel>& to) {
+		to.resize(from.size());
+		for (size_t i = 0; i < from.size(); i++) {
+			to[i].price = from[i].price;
+			to[i].quantity = from[i].quantity;
+		}
+	}
+
+	const std::string& eventSymbol() const {
+		static const std::string empty;
+		return event.symbolId == SymbolTable::kNotFound ? empty : decoder.symbolName(event.symbolId);
+	}
 
-		auto it = klineCallbacks.find(key);
-		if (it != klineCallbacks.end()) {
-			it->second(update);
+	void dispatch(Route& route) {
+		switch (event.type) {
+			case StreamEventType::TICKER:
+				if (route.ticker) {
+					TickerUpdate update;
+					update.symbol = eventSymbol();
+					update.lastPrice = event.ticker.lastPrice;
+					update.priceChange = event.ticker.priceChange;
+					update.priceChangePercent = event.ticker.priceChangePercent;
+					update.highPrice = event.ticker.highPrice;
+					update.lowPrice = event.ticker.lowPrice;
+					update.volume = event.ticker.volume;
+					update.quoteVolume = event.ticker.quoteVolume;
+					update.timestamp = event.eventTime;
+					route.ticker(update);
+				}
+				break;
+
+			case StreamEventType::TRADE:
+				if (route.trade) {
+					TradeUpdate update;
+					update.symbol = eventSymbol();
+					update.tradeId = event.trade.tradeId;
+					update.price = event.trade.price;
+					update.quantity = event.trade.quantity;
+					update.timestamp = event.trade.tradeTime;
+					update.isBuyerMaker = event.trade.isBuyerMaker;
+					route.trade(update);
+				}
+				break;
+
+			case StreamEventType::AGG_TRADE:
+				if (route.aggTrade) {
+					AggTradeUpdate update;
+					update.symbol = eventSymbol();
+					update.aggTradeId = event.trade.tradeId;
+					update.firstTradeId = event.trade.firstTradeId;
+					update.lastTradeId = event.trade.lastTradeId;
+					update.price = event.trade.price;
+					update.quantity = event.trade.quantity;
+					update.timestamp = event.trade.tradeTime;
+					update.isBuyerMaker = event.trade.isBuyerMaker;
+					route.aggTrade(update);
+				}
+				break;
+
+			case StreamEventType::KLINE:
+				if (route.kline) {
+					KlineUpdate update;
+					update.symbol = eventSymbol();
+					update.interval = event.kline.interval;
+					update.openTime = event.kline.openTime;
+					update.closeTime = event.kline.closeTime;
+					update.open = event.kline.open;
+					update.high = event.kline.high;
+					update.low = event.kline.low;
+					update.close = event.kline.close;
+					update.volume = event.kline.volume;
+					update.isClosed = event.kline.isClosed;
+					if (route.backfilling) {
+						route.heldKlines.push_back(update);
+					} else {
+						deliverKline(route, update);
+					}
+				}
+				break;
+
+			case StreamEventType::DEPTH_UPDATE:
+				if (route.depth) {
+					depthUpdate.symbol = eventSymbol();
+					depthUpdate.firstUpdateId = event.depth.firstUpdateId;
+					depthUpdate.finalUpdateId = event.depth.finalUpdateId;
+					depthUpdate.prevFinalUpdateId = event.depth.prevFinalUpdateId;
+					copyLevels(event.depth.bids, depthUpdate.bids);
+					copyLevels(event.depth.asks, depthUpdate.asks);
+					depthUpdate.timestamp = event.eventTime;
+					route.depth(depthUpdate);
+				}
+				break;
+
+			default:
+				break;
 		}
 	}
 
@@ -265,7 +937,38 @@ void BinanceWebSocket::disconnect() {
 }
 
 bool BinanceWebSocket::isConnected() const {
-	return pImpl->connected;
+	return pImpl->isConnected();
+}
+
+size_t BinanceWebSocket::getConnectionCount() const {
+	return pImpl->shards.size();
+}
+
+void BinanceWebSocket::setMaxStreamsPerConnection(size_t maxStreams) {
+	pImpl->maxStreamsPerConnection = std::max<size_t>(1, std::min(maxStreams, kMaxStreamsPerConnection));
+}
+
+void BinanceWebSocket::setStreamUrl(const std::string& url) {
+	pImpl->streamUrl = url;
+	while (!pImpl->streamUrl.empty() && pImpl->streamUrl.back() == '/') {
+		pImpl->streamUrl.pop_back();
+	}
+}
+
+void BinanceWebSocket::setCompression(bool enabled) {
+	pImpl->compression = enabled;
+}
+
+bool BinanceWebSocket::startCapture(const std::string& path) {
+	return pImpl->capture.open(path);
+}
+
+void BinanceWebSocket::stopCapture() {
+	pImpl->capture.close();
+}
+
+void BinanceWebSocket::injectMessage(const std::string& message) {
+	pImpl->enqueueMessage(message);
 }
 
 bool BinanceWebSocket::subscribeTicker(const std::string& symbol, TickerCallback callback) {
@@ -280,45 +983,107 @@ bool BinanceWebSocket::subscribeKlines(const std::string& symbol, const std::str
 	return pImpl->subscribeKlines(symbol, interval, callback);
 }
 
+bool BinanceWebSocket::subscribeAggTrades(const std::string& symbol, AggTradeCallback callback) {
+	return pImpl->subscribeAggTrades(symbol, callback);
+}
+
+bool BinanceWebSocket::subscribeDepth(const std::string& symbol, DepthCallback callback) {
+	return pImpl->subscribeDepth(symbol, callback);
+}
+
 void BinanceWebSocket::unsubscribeTicker(const std::string& symbol) {
-	std::string lowerSymbol = symbol;
-	std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
-	pImpl->tickerCallbacks.erase(lowerSymbol);
+	pImpl->unsubscribe(Impl::toLower(symbol) + "@ticker", [](Impl::Route& route) { route.ticker = nullptr; });
 	LOG_INFO("Unsubscribed from ticker: " + symbol);
 }
 
 void BinanceWebSocket::unsubscribeTrades(const std::string& symbol) {
-	std::string lowerSymbol = symbol;
-	std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
-	pImpl->tradeCallbacks.erase(lowerSymbol);
+	pImpl->unsubscribe(Impl::toLower(symbol) + "@trade", [](Impl::Route& route) { route.trade = nullptr; });
 	LOG_INFO("Unsubscribed from trades: " + symbol);
 }
 
+void BinanceWebSocket::unsubscribeAggTrades(const std::string& symbol) {
+	pImpl->unsubscribe(Impl::toLower(symbol) + "@aggTrade", [](Impl::Route& route) { route.aggTrade = nullptr; });
+	LOG_INFO("Unsubscribed from aggregate trades: " + symbol);
+}
+
 void BinanceWebSocket::unsubscribeKlines(const std::string& symbol, const std::string& interval) {
-	std::string lowerSymbol = symbol;
-	std::transform(lowerSymbol.begin(), lowerSymbol.end(), lowerSymbol.begin(), ::tolower);
-	std::string key = lowerSymbol + "_" + interval;
-	pImpl->klineCallbacks.erase(key);
+	pImpl->unsubscribe(Impl::toLower(symbol) + "@kline_" + interval, [](Impl::Route& route) { route.kline = nullptr; });
 	LOG_INFO("Unsubscribed from klines: " + symbol + " " + interval);
 }
 
+void BinanceWebSocket::unsubscribeDepth(const std::string& symbol) {
+	pImpl->unsubscribe(Impl::toLower(symbol) + "@depth@100ms", [](Impl::Route& route) { route.depth = nullptr; });
+	LOG_INFO("Unsubscribed from depth: " + symbol);
+}
+
+void BinanceWebSocket::setKlineBackfill(KlineFetcher fetcher) {
+	std::lock_guard<std::mutex> lock(pImpl->messageMutex);
+	pImpl->klineFetcher = fetcher ? fetcher : KlineFetcher(fetchKlines);
+}
+
 void BinanceWebSocket::setErrorCallback(ErrorCallback callback) {
 	pImpl->errorCallback = callback;
 }
 
+void BinanceWebSocket::setWakeupCallback(WakeupCallback callback) {
+	std::lock_guard<std::mutex> lock(pImpl->messageMutex);
+	pImpl->wakeupCallback = callback;
+}
+
+bool BinanceWebSocket::waitForMessages(int timeoutMs) {
+	std::unique_lock<std::mutex> lock(pImpl->messageMutex);
+	return pImpl->eventCondition.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+		[this]() { return pImpl->eventsPending; });
+}
+
 void BinanceWebSocket::processMessages() {
 	// CRITICAL FIX: Process queued messages in main thread
-	// This function MUST be called periodically from the main thread (e.g., via BMessageRunner)
-	std::lock_guard<std::mutex> lock(pImpl->messageMutex);
+	// Call it when woken (setWakeupCallback/waitForMessages) and from a slow
+	// timer, which also sends subscription changes held back by the rate limit.
+	{
+		// Anything queued from now on wakes the consumer again; at worst
+		// that is one extra, empty call
+		std::lock_guard<std::mutex> lock(pImpl->messageMutex);
+		pImpl->eventsPending = false;
+	}
 
-	// Process all queued messages
-	while (!pImpl->messageQueue.empty()) {
-		std::string message = pImpl->messageQueue.front();
-		pImpl->messageQueue.pop();
+	pImpl->handleReconnects();
+
+	size_t count;
+	std::vector<Impl::BackfillResult> backfills;
+	{
+		// Take the whole batch; the network thread keeps queueing into the
+		// other buffer while callbacks run
+		std::lock_guard<std::mutex> lock(pImpl->messageMutex);
+		count = pImpl->pendingCount;
+		pImpl->pendingMessages.swap(pImpl->processingMessages);
+		pImpl->pendingTimes.swap(pImpl->processingTimes);
+		pImpl->pendingCount = 0;
+		backfills.swap(pImpl->backfillResults);
+	}
 
-		// Now it's safe to call handleMessage (we're in the main thread)
-		pImpl->handleMessage(message);
+	// Now it's safe to call handleMessage (we're in the main thread).
+	// Callbacks see the socket read time as their tick origin, so a signal
+	// generated from them is timed from the wire.
+	LatencyTracker& latency = LatencyTracker::getInstance();
+	int64_t dequeued = latency.isEnabled() ? LatencyTracker::now() : 0;
+	for (size_t i = 0; i < count; i++) {
+		const Impl::MessageTiming& timing = pImpl->processingTimes[i];
+		if (dequeued != 0 && timing.queued != 0) {
+			latency.record(LatencyStage::QUEUE_WAIT, dequeued - timing.queued);
+			LatencyTracker::setTickOrigin(timing.received);
+		}
+		pImpl->handleMessage(pImpl->processingMessages[i]);
+		LatencyTracker::setTickOrigin(0);
 	}
+
+	// Backfilled klines first, then the live ones held while fetching them
+	for (auto& result : backfills) {
+		pImpl->applyBackfill(result);
+	}
+
+	// Apply subscription changes made since the last call
+	pImpl->flushControlMessages();
 }
 
 } // namespace Emiglio
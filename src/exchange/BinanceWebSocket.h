@@ -1,6 +1,9 @@
 #ifndef BINANCE_WEBSOCKET_H
 #define BINANCE_WEBSOCKET_H
 
+#include "ExchangeAPI.h"
+
+#include <cstdint>
 #include <string>
 #include <functional>
 #include <memory>
@@ -41,6 +44,18 @@ struct TradeUpdate {
 	bool isBuyerMaker;
 };
 
+// Aggregate trade update (fills of one taker order at one price)
+struct AggTradeUpdate {
+	std::string symbol;
+	long aggTradeId;
+	long firstTradeId;
+	long lastTradeId;
+	double price;
+	double quantity;
+	time_t timestamp;
+	bool isBuyerMaker;
+};
+
 // Kline (candlestick) update
 struct KlineUpdate {
 	std::string symbol;
@@ -55,10 +70,24 @@ struct KlineUpdate {
 	bool isClosed;  // true if kline is closed
 };
 
+// Order book diff (<symbol>@depth@100ms). Quantities are absolute; 0 removes
+// the level. See LocalOrderBook for applying diffs to a snapshot.
+struct DepthUpdate {
+	std::string symbol;
+	int64_t firstUpdateId;      // U
+	int64_t finalUpdateId;      // u
+	int64_t prevFinalUpdateId;  // pu, futures streams only, else -1
+	std::vector<OrderBookLevel> bids;
+	std::vector<OrderBookLevel> asks;
+	time_t timestamp;
+};
+
 // Callback types
 using TickerCallback = std::function<void(const TickerUpdate&)>;
 using TradeCallback = std::function<void(const TradeUpdate&)>;
+using AggTradeCallback = std::function<void(const AggTradeUpdate&)>;
 using KlineCallback = std::function<void(const KlineUpdate&)>;
+using DepthCallback = std::function<void(const DepthUpdate&)>;
 using ErrorCallback = std::function<void(const std::string&)>;
 
 // Binance WebSocket client
@@ -72,20 +101,71 @@ public:
 	void disconnect();
 	bool isConnected() const;
 
-	// Subscribe to streams
+	// Binance allows 1024 streams per connection; subscriptions beyond the
+	// limit open additional connections. Lower limits are for testing.
+	size_t getConnectionCount() const;
+	void setMaxStreamsPerConnection(size_t maxStreams);
+
+	// Stream server root, "wss://stream.binance.com:9443" unless the
+	// EMIGLIO_BINANCE_STREAM_URL environment variable says otherwise (e.g.
+	// ws://127.0.0.1:9700 for emiglio_mock_binance). Set before connect().
+	void setStreamUrl(const std::string& url);
+
+	// Negotiate permessage-deflate on new connections (default on). Cuts
+	// bandwidth a lot on array streams like !ticker@arr at some CPU cost.
+	void setCompression(bool enabled);
+
+	// Subscribe to streams. While connected, changes are sent as
+	// SUBSCRIBE/UNSUBSCRIBE requests on the next processMessages() call,
+	// without reconnecting.
 	bool subscribeTicker(const std::string& symbol, TickerCallback callback);
 	bool subscribeTrades(const std::string& symbol, TradeCallback callback);
+	bool subscribeAggTrades(const std::string& symbol, AggTradeCallback callback);
 	bool subscribeKlines(const std::string& symbol, const std::string& interval, KlineCallback callback);
+	bool subscribeDepth(const std::string& symbol, DepthCallback callback);
 
 	// Unsubscribe from streams
 	void unsubscribeTicker(const std::string& symbol);
 	void unsubscribeTrades(const std::string& symbol);
+	void unsubscribeAggTrades(const std::string& symbol);
 	void unsubscribeKlines(const std::string& symbol, const std::string& interval);
+	void unsubscribeDepth(const std::string& symbol);
+
+	// Source of closed klines missed while a connection was down. After an
+	// automatic reconnect every kline stream is backfilled from it, in
+	// timestamp order, before live klines resume. Defaults to the REST API.
+	using KlineFetcher = std::function<std::vector<Candle>(const std::string& symbol,
+	                                                       const std::string& interval,
+	                                                       time_t startTime,
+	                                                       time_t endTime)>;
+	void setKlineBackfill(KlineFetcher fetcher);
 
 	// Set error callback
 	void setErrorCallback(ErrorCallback callback);
 
-	// Process incoming messages (call from main thread periodically)
+	// Called from a network thread when messages (or a reconnect, or
+	// backfilled klines) are waiting, so the consumer can call
+	// processMessages() right away instead of polling. Wakeups are
+	// coalesced: after one fires, no other does until processMessages()
+	// has run. Keep it cheap, e.g. post a message to the UI thread.
+	using WakeupCallback = std::function<void()>;
+	void setWakeupCallback(WakeupCallback callback);
+
+	// For a dedicated consumer thread: block until something is waiting
+	// or 'timeoutMs' passes. True if processMessages() has work.
+	bool waitForMessages(int timeoutMs);
+
+	// Record every message the connections receive to 'path' (appended
+	// when it exists), for StreamReplay. Works while connected.
+	bool startCapture(const std::string& path);
+	void stopCapture();
+
+	// Queue 'message' as if a connection had received it; the next
+	// processMessages() dispatches it. Subscribe first, connecting isn't
+	// needed. Used by StreamReplay.
+	void injectMessage(const std::string& message);
+
+	// Process incoming messages (call from the consumer thread)
 	void processMessages();
 
 private:
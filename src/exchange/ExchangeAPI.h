@@ -1,6 +1,7 @@
 #ifndef EXCHANGEAPI_H
 #define EXCHANGEAPI_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
@@ -60,6 +61,7 @@ struct OrderBook {
 	std::vector<OrderBookLevel> bids;
 	std::vector<OrderBookLevel> asks;
 	time_t timestamp;
+	int64_t lastUpdateId = 0;  // Sequence number for syncing with depth streams
 };
 
 // Account balance
@@ -0,0 +1,252 @@
+#include "LocalOrderBook.h"
+#include "../utils/Logger.h"
+
+#include <algorithm>
+#include <ctime>
+
+namespace Emiglio {
+
+// ============================================================================
+// Side
+// ============================================================================
+
+// Index of 'price', or where it would be inserted
+size_t LocalOrderBook::Side::lowerBound(double price) const {
+	if (descending) {
+		return std::lower_bound(prices.begin(), prices.end(), price,
+		                        [](double a, double b) { return a > b; }) - prices.begin();
+	}
+	return std::lower_bound(prices.begin(), prices.end(), price) - prices.begin();
+}
+
+void LocalOrderBook::Side::set(double price, double qty) {
+	// Most updates hit the top of the book, which is the back: check it
+	// before searching
+	size_t index;
+	if (!prices.empty() && prices.back() == price) {
+		index = prices.size() - 1;
+	} else {
+		index = lowerBound(price);
+	}
+
+	bool found = index < prices.size() && prices[index] == price;
+	if (qty == 0.0) {
+		if (found) {
+			prices.erase(prices.begin() + index);
+			quantities.erase(quantities.begin() + index);
+		}
+	} else if (found) {
+		quantities[index] = qty;
+	} else {
+		prices.insert(prices.begin() + index, price);
+		quantities.insert(quantities.begin() + index, qty);
+	}
+}
+
+double LocalOrderBook::Side::quantity(double price) const {
+	size_t index = lowerBound(price);
+	return (index < prices.size() && prices[index] == price) ? quantities[index] : 0.0;
+}
+
+// ============================================================================
+// LocalOrderBook
+// ============================================================================
+
+LocalOrderBook::LocalOrderBook(const std::string& symbol, size_t maxBufferedDiffs)
+	: symbol(symbol)
+	, bids(false)
+	, asks(true)
+	, lastUpdateId(0)
+	, synced(false)
+	, awaitingFirstDiff(false)
+	, maxBufferedDiffs(maxBufferedDiffs) {
+}
+
+void LocalOrderBook::reset() {
+	bids.clear();
+	asks.clear();
+	lastUpdateId = 0;
+	synced = false;
+	awaitingFirstDiff = false;
+	buffered.clear();
+}
+
+bool LocalOrderBook::applySnapshot(const OrderBook& snapshot) {
+	// The first buffered diff must not start after the snapshot ends,
+	// otherwise updates in between are missing
+	if (!buffered.empty() && snapshot.lastUpdateId + 1 < buffered.front().firstUpdateId) {
+		lastError = "Snapshot " + std::to_string(snapshot.lastUpdateId) +
+		            " is older than buffered diffs starting at " +
+		            std::to_string(buffered.front().firstUpdateId);
+		return false;
+	}
+
+	// Build each side in one pass instead of inserting level by level
+	auto load = [](const std::vector<OrderBookLevel>& levels, Side& side) {
+		std::vector<OrderBookLevel> sorted;
+		sorted.reserve(levels.size());
+		for (const auto& level : levels) {
+			if (level.quantity > 0.0) {
+				sorted.push_back(level);
+			}
+		}
+		bool descending = side.descending;
+		std::sort(sorted.begin(), sorted.end(), [descending](const OrderBookLevel& a, const OrderBookLevel& b) {
+			return descending ? a.price > b.price : a.price < b.price;
+		});
+
+		side.clear();
+		side.prices.reserve(sorted.size());
+		side.quantities.reserve(sorted.size());
+		for (const auto& level : sorted) {
+			side.prices.push_back(level.price);
+			side.quantities.push_back(level.quantity);
+		}
+	};
+	load(snapshot.bids, bids);
+	load(snapshot.asks, asks);
+
+	lastUpdateId = snapshot.lastUpdateId;
+	synced = true;
+	awaitingFirstDiff = true;
+
+	// Replay what arrived while the snapshot was in flight
+	std::deque<DepthUpdate> pending;
+	pending.swap(buffered);
+	size_t replayed = 0;
+	while (!pending.empty()) {
+		if (applyDiff(pending.front()) == DiffResult::GAP) {
+			// applyDiff() reset the book and buffered this diff; keep the rest
+			pending.pop_front();
+			for (auto& diff : pending) {
+				buffered.push_back(std::move(diff));
+			}
+			return false;
+		}
+		pending.pop_front();
+		replayed++;
+	}
+
+	LOG_DEBUG("Order book " + symbol + " synced at " + std::to_string(lastUpdateId) +
+	          " (" + std::to_string(replayed) + " buffered diffs)");
+	return true;
+}
+
+LocalOrderBook::DiffResult LocalOrderBook::applyDiff(const DepthUpdate& diff) {
+	if (!synced) {
+		if (buffered.size() >= maxBufferedDiffs) {
+			buffered.pop_front();
+		}
+		buffered.push_back(diff);
+		return DiffResult::BUFFERED;
+	}
+
+	if (diff.finalUpdateId <= lastUpdateId) {
+		return DiffResult::STALE;
+	}
+
+	// The first diff after a snapshot may overlap it. After that, futures
+	// streams link diffs with pu; spot diffs start right after the last one.
+	bool continues;
+	if (awaitingFirstDiff) {
+		continues = diff.firstUpdateId <= lastUpdateId + 1;
+	} else if (diff.prevFinalUpdateId >= 0) {
+		continues = diff.prevFinalUpdateId == lastUpdateId;
+	} else {
+		continues = diff.firstUpdateId == lastUpdateId + 1;
+	}
+
+	if (!continues) {
+		lastError = "Depth gap on " + symbol + ": book at " + std::to_string(lastUpdateId) +
+		            ", diff covers " + std::to_string(diff.firstUpdateId) + "-" + std::to_string(diff.finalUpdateId);
+		LOG_WARNING(lastError + ", resyncing");
+		reset();
+		buffered.push_back(diff);
+		return DiffResult::GAP;
+	}
+
+	apply(diff);
+	return DiffResult::APPLIED;
+}
+
+void LocalOrderBook::apply(const DepthUpdate& diff) {
+	for (const auto& level : diff.bids) {
+		bids.set(level.price, level.quantity);
+	}
+	for (const auto& level : diff.asks) {
+		asks.set(level.price, level.quantity);
+	}
+	lastUpdateId = diff.finalUpdateId;
+	awaitingFirstDiff = false;
+}
+
+bool LocalOrderBook::bestBid(OrderBookLevel& level) const {
+	if (bids.prices.empty()) {
+		return false;
+	}
+	level.price = bids.prices.back();
+	level.quantity = bids.quantities.back();
+	return true;
+}
+
+bool LocalOrderBook::bestAsk(OrderBookLevel& level) const {
+	if (asks.prices.empty()) {
+		return false;
+	}
+	level.price = asks.prices.back();
+	level.quantity = asks.quantities.back();
+	return true;
+}
+
+double LocalOrderBook::spread() const {
+	if (bids.prices.empty() || asks.prices.empty()) {
+		return 0.0;
+	}
+	return asks.prices.back() - bids.prices.back();
+}
+
+double LocalOrderBook::midPrice() const {
+	if (bids.prices.empty() || asks.prices.empty()) {
+		return 0.0;
+	}
+	return (asks.prices.back() + bids.prices.back()) / 2.0;
+}
+
+double LocalOrderBook::simulateMarketOrder(OrderSide side, double quantity, double& averagePrice) const {
+	const Side& book = (side == OrderSide::BUY) ? asks : bids;
+
+	double filled = 0.0;
+	double cost = 0.0;
+	for (size_t i = book.prices.size(); i > 0 && filled < quantity; i--) {
+		double take = std::min(book.quantities[i - 1], quantity - filled);
+		filled += take;
+		cost += take * book.prices[i - 1];
+	}
+
+	averagePrice = filled > 0.0 ? cost / filled : 0.0;
+	return filled;
+}
+
+OrderBook LocalOrderBook::toOrderBook(size_t depth) const {
+	OrderBook book;
+	book.symbol = symbol;
+	book.timestamp = std::time(nullptr);
+	book.lastUpdateId = lastUpdateId;
+
+	auto copy = [depth](const Side& side, std::vector<OrderBookLevel>& levels) {
+		size_t count = side.prices.size();
+		if (depth > 0 && depth < count) {
+			count = depth;
+		}
+		levels.reserve(count);
+		for (size_t i = 0; i < count; i++) {
+			size_t index = side.prices.size() - 1 - i;
+			levels.push_back({side.prices[index], side.quantities[index]});
+		}
+	};
+	copy(bids, book.bids);
+	copy(asks, book.asks);
+	return book;
+}
+
+} // namespace Emiglio
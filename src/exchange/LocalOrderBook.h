@@ -0,0 +1,115 @@
+#ifndef EMIGLIO_LOCALORDERBOOK_H
+#define EMIGLIO_LOCALORDERBOOK_H
+
+#include "ExchangeAPI.h"
+#include "BinanceWebSocket.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace Emiglio {
+
+// Local L2 order book kept in sync with a Binance diff-depth stream.
+//
+// Sync follows Binance's procedure:
+//   1. Subscribe to <symbol>@depth@100ms; diffs received before the book has
+//      a snapshot are buffered (applyDiff returns BUFFERED).
+//   2. When needsSnapshot() is true, fetch GET /api/v3/depth and pass it to
+//      applySnapshot(). Buffered diffs older than the snapshot are dropped,
+//      the rest are replayed.
+//   3. From then on every diff must continue the previous one (U == last u
+//      + 1, or pu == last u on futures streams). A gap clears the book and
+//      goes back to step 2 (applyDiff returns GAP).
+//
+// Each side is a flat array sorted so the best level is at the back: best
+// bid/ask are O(1), lookups are a binary search over a contiguous price
+// array, and since most updates touch the top of the book, inserts and
+// erases only move the few levels behind them.
+class LocalOrderBook {
+public:
+	enum class DiffResult {
+		APPLIED,    // Book updated
+		BUFFERED,   // Waiting for a snapshot
+		STALE,      // Already covered by the snapshot, ignored
+		GAP         // Sequence broken; book cleared, new snapshot needed
+	};
+
+	explicit LocalOrderBook(const std::string& symbol = "", size_t maxBufferedDiffs = 1000);
+
+	const std::string& getSymbol() const { return symbol; }
+
+	// Drop all levels and wait for a new snapshot
+	void reset();
+
+	// False if the snapshot is older than the buffered diffs (fetch a newer
+	// one) or doesn't connect to them.
+	bool applySnapshot(const OrderBook& snapshot);
+
+	DiffResult applyDiff(const DepthUpdate& diff);
+
+	bool isSynced() const { return synced; }
+	bool needsSnapshot() const { return !synced; }
+	int64_t getLastUpdateId() const { return lastUpdateId; }
+
+	// Best levels; false if that side is empty
+	bool bestBid(OrderBookLevel& level) const;
+	bool bestAsk(OrderBookLevel& level) const;
+
+	// 0 if either side is empty
+	double spread() const;
+	double midPrice() const;
+
+	size_t bidLevels() const { return bids.prices.size(); }
+	size_t askLevels() const { return asks.prices.size(); }
+
+	// Resting quantity at 'price', 0 if there is no such level
+	double bidQuantity(double price) const { return bids.quantity(price); }
+	double askQuantity(double price) const { return asks.quantity(price); }
+
+	// Average fill price of a market order of 'quantity' walking the book
+	// (BUY consumes asks, SELL bids). Returns the filled quantity, which is
+	// less than requested if the book is too thin.
+	double simulateMarketOrder(OrderSide side, double quantity, double& averagePrice) const;
+
+	// Top 'depth' levels per side, best first (0 = all)
+	OrderBook toOrderBook(size_t depth = 0) const;
+
+	std::string getLastError() const { return lastError; }
+
+private:
+	// Structure-of-arrays side; best price at the back
+	struct Side {
+		std::vector<double> prices;
+		std::vector<double> quantities;
+		bool descending;  // Asks: prices decrease towards the back
+
+		explicit Side(bool descending) : descending(descending) {}
+
+		size_t lowerBound(double price) const;
+		void set(double price, double quantity);  // quantity 0 removes the level
+		double quantity(double price) const;
+		void clear() { prices.clear(); quantities.clear(); }
+	};
+
+	std::string symbol;
+	Side bids;
+	Side asks;
+	int64_t lastUpdateId;
+	bool synced;
+	bool awaitingFirstDiff;
+
+	// Diffs received while waiting for a snapshot
+	std::deque<DepthUpdate> buffered;
+	size_t maxBufferedDiffs;
+
+	std::string lastError;
+
+	void apply(const DepthUpdate& diff);
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_LOCALORDERBOOK_H
@@ -0,0 +1,188 @@
+#include "RateLimiter.h"
+#include "../utils/Logger.h"
+
+#include <algorithm>
+#include <map>
+#include <thread>
+
+namespace Emiglio {
+
+namespace {
+
+// Binance bans for a while when 429s are ignored; without Retry-After,
+// hold off for the rest of a window
+const int kDefaultRetryAfterSeconds = 60;
+
+// Waits shorter than this aren't worth a log line
+const int64_t kLogWaitMs = 1000;
+
+} // namespace
+
+RateLimiter::RateLimiter()
+	: lastRefill(Clock::now())
+	, pausedUntil(Clock::now())
+	, inFlightWeight(0)
+	, rejectedCount(0)
+	, totalWaitMs(0) {
+	for (auto& bucket : buckets) {
+		bucket.capacity = bucket.tokens = 1;
+		bucket.refillPerSecond = 1;
+	}
+	setLimit(REQUEST_WEIGHT, 6000, 60);
+	setLimit(ORDERS_10S, 100, 10);
+	setLimit(ORDERS_1D, 200000, 86400);
+}
+
+std::shared_ptr<RateLimiter> RateLimiter::forHost(const std::string& baseUrl) {
+	static std::mutex registryMutex;
+	static std::map<std::string, std::shared_ptr<RateLimiter>> registry;
+
+	std::lock_guard<std::mutex> lock(registryMutex);
+	std::shared_ptr<RateLimiter>& limiter = registry[baseUrl];
+	if (!limiter) {
+		limiter = std::make_shared<RateLimiter>();
+	}
+	return limiter;
+}
+
+void RateLimiter::setLimit(Bucket bucket, int capacity, int windowSeconds) {
+	std::lock_guard<std::mutex> lock(mutex);
+	TokenBucket& target = buckets[bucket];
+	double used = target.capacity - target.tokens;
+	target.capacity = std::max(1, capacity);
+	target.refillPerSecond = target.capacity / std::max(1, windowSeconds);
+	target.tokens = target.capacity - used;
+}
+
+int RateLimiter::getCapacity(Bucket bucket) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return static_cast<int>(buckets[bucket].capacity);
+}
+
+void RateLimiter::refill(Clock::time_point now) {
+	double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+	if (elapsed <= 0) {
+		return;
+	}
+	for (auto& bucket : buckets) {
+		bucket.tokens = std::min(bucket.capacity, bucket.tokens + elapsed * bucket.refillPerSecond);
+	}
+	lastRefill = now;
+}
+
+// When the buckets will have refilled enough to cover the request
+RateLimiter::Clock::time_point RateLimiter::readyTime(int weight, bool order, Clock::time_point now) const {
+	Clock::time_point ready = std::max(now, pausedUntil);
+	auto wait = [&](const TokenBucket& bucket, int cost) {
+		// A request heavier than the bucket waits for a full one
+		double after = bucket.tokens - std::min<double>(cost, bucket.capacity);
+		if (after < 0) {
+			ready = std::max(ready, now + std::chrono::duration_cast<Clock::duration>(
+				std::chrono::duration<double>(-after / bucket.refillPerSecond)));
+		}
+	};
+	wait(buckets[REQUEST_WEIGHT], weight);
+	if (order) {
+		wait(buckets[ORDERS_10S], 1);
+		wait(buckets[ORDERS_1D], 1);
+	}
+	return ready;
+}
+
+void RateLimiter::take(int weight, bool order) {
+	buckets[REQUEST_WEIGHT].tokens -= std::min<double>(weight, buckets[REQUEST_WEIGHT].capacity);
+	if (order) {
+		buckets[ORDERS_10S].tokens -= 1;
+		buckets[ORDERS_1D].tokens -= 1;
+	}
+	inFlightWeight += weight;
+}
+
+RateLimiter::Clock::time_point RateLimiter::reserve(int weight, bool order) {
+	std::lock_guard<std::mutex> lock(mutex);
+	Clock::time_point now = Clock::now();
+	refill(now);
+	Clock::time_point ready = readyTime(weight, order, now);
+	take(weight, order);
+	totalWaitMs += std::chrono::duration_cast<std::chrono::milliseconds>(ready - now).count();
+	return ready;
+}
+
+bool RateLimiter::acquire(int weight, bool order, std::chrono::milliseconds maxWait) {
+	Clock::time_point ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Clock::time_point now = Clock::now();
+		refill(now);
+		ready = readyTime(weight, order, now);
+		if (ready - now > maxWait) {
+			return false;
+		}
+		take(weight, order);
+		int64_t waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(ready - now).count();
+		totalWaitMs += waitMs;
+		if (waitMs >= kLogWaitMs) {
+			LOG_WARNING("Rate limit: waiting " + std::to_string(waitMs) + " ms");
+		}
+	}
+	std::this_thread::sleep_until(ready);
+	return true;
+}
+
+// The server counted 'used' in the current window: tokens can't be more
+// than what's left of it, minus requests it hasn't seen yet. Only ever
+// lowers, the server's window resets on the minute while ours slides.
+void RateLimiter::lowerTo(Bucket bucket, int used) {
+	TokenBucket& target = buckets[bucket];
+	double pending = bucket == REQUEST_WEIGHT ? inFlightWeight : 0;
+	target.tokens = std::min(target.tokens, target.capacity - used - pending);
+}
+
+void RateLimiter::complete(int weight, const RateLimitFeedback& feedback) {
+	std::lock_guard<std::mutex> lock(mutex);
+	Clock::time_point now = Clock::now();
+	refill(now);
+	inFlightWeight = std::max(0, inFlightWeight - weight);
+
+	if (feedback.usedWeight >= 0) {
+		lowerTo(REQUEST_WEIGHT, feedback.usedWeight);
+	}
+	if (feedback.orderCount10s >= 0) {
+		lowerTo(ORDERS_10S, feedback.orderCount10s);
+	}
+	if (feedback.orderCount1d >= 0) {
+		lowerTo(ORDERS_1D, feedback.orderCount1d);
+	}
+
+	// 429: over the limit, 418: banned for ignoring 429s
+	if (feedback.status == 429 || feedback.status == 418) {
+		rejectedCount++;
+		int seconds = feedback.retryAfterSeconds > 0 ? feedback.retryAfterSeconds : kDefaultRetryAfterSeconds;
+		pausedUntil = std::max(pausedUntil, now + std::chrono::seconds(seconds));
+		buckets[REQUEST_WEIGHT].tokens = std::min(buckets[REQUEST_WEIGHT].tokens, 0.0);
+		if (feedback.status == 418) {
+			LOG_ERROR("IP banned by exchange, holding requests for " + std::to_string(seconds) + " s");
+		} else {
+			LOG_WARNING("Rate limited by exchange, holding requests for " + std::to_string(seconds) + " s");
+		}
+	}
+}
+
+double RateLimiter::getAvailable(Bucket bucket) const {
+	std::lock_guard<std::mutex> lock(mutex);
+	const TokenBucket& target = buckets[bucket];
+	double elapsed = std::chrono::duration<double>(Clock::now() - lastRefill).count();
+	return std::min(target.capacity, target.tokens + std::max(0.0, elapsed) * target.refillPerSecond);
+}
+
+uint64_t RateLimiter::getRejectedCount() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return rejectedCount;
+}
+
+int64_t RateLimiter::getTotalWaitMs() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return totalWaitMs;
+}
+
+} // namespace Emiglio
@@ -0,0 +1,93 @@
+#ifndef EMIGLIO_RATELIMITER_H
+#define EMIGLIO_RATELIMITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace Emiglio {
+
+// What a response says about the limits. -1 where a header was missing.
+struct RateLimitFeedback {
+	int status = 0;              // HTTP status, 0 when the request failed
+	int usedWeight = -1;         // X-MBX-USED-WEIGHT-1M
+	int orderCount10s = -1;      // X-MBX-ORDER-COUNT-10S
+	int orderCount1d = -1;       // X-MBX-ORDER-COUNT-1D
+	int retryAfterSeconds = -1;  // Retry-After
+};
+
+// Token buckets for an exchange's REST limits: request weight per minute
+// and orders per 10 seconds and per day. Buckets refill continuously.
+//
+// reserve() takes the tokens right away and returns when the request may
+// go out, so concurrent callers queue in arrival order without holding a
+// lock or sleeping inside the limiter. complete() feeds back the used
+// weight the server reports, which lowers the local estimate when other
+// clients share the IP, and Retry-After from 429/418 responses, which
+// holds back every request until it passes.
+class RateLimiter {
+public:
+	enum Bucket {
+		REQUEST_WEIGHT = 0,
+		ORDERS_10S,
+		ORDERS_1D,
+		BUCKET_COUNT
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	RateLimiter();
+
+	// Shared limiter for a REST root. Binance counts per IP, so every
+	// BinanceAPI talking to the same host draws from the same buckets.
+	static std::shared_ptr<RateLimiter> forHost(const std::string& baseUrl);
+
+	// 'capacity' tokens per 'windowSeconds'. Defaults are Binance's spot
+	// limits: 6000 weight/min, 100 orders/10s, 200000 orders/day.
+	void setLimit(Bucket bucket, int capacity, int windowSeconds);
+	int getCapacity(Bucket bucket) const;
+
+	// Take 'weight' (plus one order from the order buckets when 'order')
+	// and return when the request may be sent. Never blocks.
+	Clock::time_point reserve(int weight, bool order = false);
+
+	// reserve() and sleep until then. When that would take longer than
+	// 'maxWait' nothing is taken and false is returned.
+	bool acquire(int weight, bool order, std::chrono::milliseconds maxWait);
+
+	// After the response to a reserved request arrived (or didn't)
+	void complete(int weight, const RateLimitFeedback& feedback);
+
+	// Tokens left now; negative when callers are queued
+	double getAvailable(Bucket bucket) const;
+
+	// Requests answered with 429/418, and total time callers were told to wait
+	uint64_t getRejectedCount() const;
+	int64_t getTotalWaitMs() const;
+
+private:
+	struct TokenBucket {
+		double capacity;
+		double tokens;
+		double refillPerSecond;
+	};
+
+	void refill(Clock::time_point now);
+	Clock::time_point readyTime(int weight, bool order, Clock::time_point now) const;
+	void take(int weight, bool order);
+	void lowerTo(Bucket bucket, int used);
+
+	mutable std::mutex mutex;
+	TokenBucket buckets[BUCKET_COUNT];
+	Clock::time_point lastRefill;
+	Clock::time_point pausedUntil;
+	int inFlightWeight;
+	uint64_t rejectedCount;
+	int64_t totalWaitMs;
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_RATELIMITER_H
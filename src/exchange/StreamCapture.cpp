@@ -0,0 +1,229 @@
+#include "StreamCapture.h"
+#include "../utils/Logger.h"
+
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+
+namespace Emiglio {
+
+namespace {
+
+const char kCaptureMagic[4] = {'E', 'M', 'G', 'W'};
+const uint32_t kCaptureVersion = 1;
+
+// Anything larger is a corrupt length, not a message
+const uint32_t kMaxPayloadSize = 64 * 1024 * 1024;
+
+// Record header on disk
+struct RecordHeader {
+	int64_t timestamp;
+	uint32_t connection;
+	uint32_t length;
+};
+
+const size_t kWriteBufferSize = 1 << 20;
+
+// Offset just past the last complete record; 'file' is positioned after
+// the file header
+off_t validEnd(FILE* file) {
+	off_t end = ftello(file);
+	RecordHeader header;
+	while (fread(&header, sizeof(header), 1, file) == 1 && header.length <= kMaxPayloadSize) {
+		off_t next = end + static_cast<off_t>(sizeof(header)) + header.length;
+		if (fseeko(file, 0, SEEK_END) != 0 || ftello(file) < next || fseeko(file, next, SEEK_SET) != 0) {
+			break;
+		}
+		end = next;
+	}
+	return end;
+}
+
+} // namespace
+
+// StreamCaptureWriter
+
+StreamCaptureWriter::StreamCaptureWriter()
+	: file(nullptr)
+	, opened(false)
+	, recordCount(0) {
+}
+
+StreamCaptureWriter::~StreamCaptureWriter() {
+	close();
+}
+
+int64_t StreamCaptureWriter::now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool StreamCaptureWriter::open(const std::string& path) {
+	close();
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// An existing capture must be ours, and is appended to
+	bool exists = false;
+	if (FILE* existing = fopen(path.c_str(), "rb")) {
+		char magic[4];
+		uint32_t version = 0;
+		size_t read = fread(magic, 1, sizeof(magic), existing);
+		exists = read > 0;
+		bool valid = read == sizeof(magic) &&
+		             std::memcmp(magic, kCaptureMagic, sizeof(magic)) == 0 &&
+		             fread(&version, sizeof(version), 1, existing) == 1 &&
+		             version == kCaptureVersion;
+		off_t end = validEnd(existing);
+		fseeko(existing, 0, SEEK_END);
+		bool torn = valid && ftello(existing) != end;
+		fclose(existing);
+		if (exists && !valid) {
+			lastError = "Not a stream capture: " + path;
+			LOG_ERROR(lastError);
+			return false;
+		}
+		if (torn) {
+			LOG_WARNING("Dropping incomplete last record of " + path);
+			if (truncate(path.c_str(), end) != 0) {
+				lastError = "Failed to repair capture: " + path;
+				LOG_ERROR(lastError);
+				return false;
+			}
+		}
+	}
+
+	file = fopen(path.c_str(), "ab");
+	if (!file) {
+		lastError = "Failed to open file for writing: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+	setvbuf(file, nullptr, _IOFBF, kWriteBufferSize);
+
+	if (!exists &&
+	    (fwrite(kCaptureMagic, sizeof(kCaptureMagic), 1, file) != 1 ||
+	     fwrite(&kCaptureVersion, sizeof(kCaptureVersion), 1, file) != 1)) {
+		fclose(file);
+		file = nullptr;
+		lastError = "Failed to write file: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	recordCount = 0;
+	opened = true;
+	LOG_INFO("Capturing stream messages to " + path);
+	return true;
+}
+
+void StreamCaptureWriter::close() {
+	std::lock_guard<std::mutex> lock(mutex);
+	opened = false;
+	if (file) {
+		fclose(file);
+		file = nullptr;
+		LOG_INFO("Stream capture closed after " + std::to_string(recordCount.load()) + " messages");
+	}
+}
+
+bool StreamCaptureWriter::append(uint32_t connection, int64_t timestamp, const char* payload, size_t length) {
+	if (!opened) {
+		return false;
+	}
+	if (length > kMaxPayloadSize) {
+		return false;
+	}
+
+	RecordHeader header;
+	memset(&header, 0, sizeof(header));
+	header.timestamp = timestamp;
+	header.connection = connection;
+	header.length = static_cast<uint32_t>(length);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!file) {
+		return false;
+	}
+	if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+	    (length > 0 && fwrite(payload, 1, length, file) != length)) {
+		lastError = "Failed to write capture record";
+		return false;
+	}
+	recordCount++;
+	return true;
+}
+
+bool StreamCaptureWriter::flush() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return file && fflush(file) == 0;
+}
+
+// StreamCaptureReader
+
+StreamCaptureReader::StreamCaptureReader()
+	: file(nullptr)
+	, truncated(false) {
+}
+
+StreamCaptureReader::~StreamCaptureReader() {
+	close();
+}
+
+bool StreamCaptureReader::open(const std::string& path) {
+	close();
+	truncated = false;
+
+	file = fopen(path.c_str(), "rb");
+	if (!file) {
+		lastError = "Failed to open file: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version = 0;
+	if (fread(magic, sizeof(magic), 1, file) != 1 ||
+	    std::memcmp(magic, kCaptureMagic, sizeof(magic)) != 0 ||
+	    fread(&version, sizeof(version), 1, file) != 1 ||
+	    version != kCaptureVersion) {
+		close();
+		lastError = "Not a stream capture: " + path;
+		LOG_ERROR(lastError);
+		return false;
+	}
+	return true;
+}
+
+void StreamCaptureReader::close() {
+	if (file) {
+		fclose(file);
+		file = nullptr;
+	}
+}
+
+bool StreamCaptureReader::next(CaptureRecord& record) {
+	if (!file) {
+		return false;
+	}
+
+	RecordHeader header;
+	size_t read = fread(&header, 1, sizeof(header), file);
+	if (read == 0) {
+		return false;
+	}
+	if (read != sizeof(header) || header.length > kMaxPayloadSize) {
+		truncated = true;
+		return false;
+	}
+
+	record.timestamp = header.timestamp;
+	record.connection = header.connection;
+	record.payload.resize(header.length);
+	if (header.length > 0 && fread(&record.payload[0], 1, header.length, file) != header.length) {
+		truncated = true;
+		return false;
+	}
+	return true;
+}
+
+} // namespace Emiglio
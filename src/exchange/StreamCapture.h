@@ -0,0 +1,86 @@
+#ifndef EMIGLIO_STREAMCAPTURE_H
+#define EMIGLIO_STREAMCAPTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+namespace Emiglio {
+
+// Append-only recording of raw WebSocket messages, for replaying a live
+// session offline (see StreamReplay).
+//
+// Layout: the magic "EMGW" and a uint32 version, then one record per
+// message: int64 receive time (ns since the Unix epoch), uint32 connection
+// index, uint32 payload length and the payload (the text message as
+// delivered, after inflating). Integers are in host byte order, like
+// CandleFile's binary format.
+
+struct CaptureRecord {
+	int64_t timestamp;    // ns since the Unix epoch
+	uint32_t connection;
+	std::string payload;  // Reused by StreamCaptureReader::next()
+};
+
+class StreamCaptureWriter {
+public:
+	StreamCaptureWriter();
+	~StreamCaptureWriter();
+
+	// Create 'path', or append to an existing capture (dropping a record
+	// left incomplete by a crash)
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return opened; }
+
+	// Thread-safe; a no-op when closed. Records are buffered, so call
+	// flush() (or close()) before reading the file.
+	bool append(uint32_t connection, int64_t timestamp, const char* payload, size_t length);
+	bool flush();
+
+	uint64_t getRecordCount() const { return recordCount; }
+	std::string getLastError() const { return lastError; }
+
+	// Wall clock in ns, the time base of records
+	static int64_t now();
+
+	StreamCaptureWriter(const StreamCaptureWriter&) = delete;
+	StreamCaptureWriter& operator=(const StreamCaptureWriter&) = delete;
+
+private:
+	std::mutex mutex;
+	FILE* file;
+	std::atomic<bool> opened;  // Lets closed writers skip the lock
+	std::atomic<uint64_t> recordCount;
+	std::string lastError;
+};
+
+class StreamCaptureReader {
+public:
+	StreamCaptureReader();
+	~StreamCaptureReader();
+
+	bool open(const std::string& path);
+	void close();
+
+	// Next record, false at the end. A record cut short by a crash while
+	// recording ends the capture too; isTruncated() tells.
+	bool next(CaptureRecord& record);
+	bool isTruncated() const { return truncated; }
+
+	std::string getLastError() const { return lastError; }
+
+	StreamCaptureReader(const StreamCaptureReader&) = delete;
+	StreamCaptureReader& operator=(const StreamCaptureReader&) = delete;
+
+private:
+	FILE* file;
+	bool truncated;
+	std::string lastError;
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_STREAMCAPTURE_H
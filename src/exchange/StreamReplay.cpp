@@ -0,0 +1,102 @@
+#include "StreamReplay.h"
+#include "BinanceWebSocket.h"
+#include "../utils/Logger.h"
+#include "../utils/LatencyTracker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace Emiglio {
+
+namespace {
+
+// Messages queued before processMessages() runs when playing flat out
+const size_t kMaxBatch = 256;
+
+// Longest sleep between checks of stop()
+const std::chrono::milliseconds kMaxSleep(100);
+
+} // namespace
+
+StreamReplay::StreamReplay()
+	: speed(0.0)
+	, stopping(false) {
+}
+
+StreamReplay::~StreamReplay() {
+}
+
+bool StreamReplay::open(const std::string& path) {
+	if (!reader.open(path)) {
+		lastError = reader.getLastError();
+		return false;
+	}
+	return true;
+}
+
+void StreamReplay::setSpeed(double newSpeed) {
+	speed = std::max(0.0, newSpeed);
+}
+
+void StreamReplay::stop() {
+	stopping = true;
+}
+
+size_t StreamReplay::play(BinanceWebSocket& webSocket) {
+	stopping = false;
+	LatencyTracker& latency = LatencyTracker::getInstance();
+
+	CaptureRecord record;
+	size_t played = 0;
+	size_t queued = 0;
+	int64_t firstTimestamp = 0;
+	auto start = std::chrono::steady_clock::now();
+
+	while (!stopping && reader.next(record)) {
+		if (played == 0) {
+			firstTimestamp = record.timestamp;
+		}
+
+		if (speed > 0.0) {
+			auto due = start + std::chrono::nanoseconds(
+				static_cast<int64_t>((record.timestamp - firstTimestamp) / speed));
+
+			// Dispatch what arrived before the gap, then wait it out
+			if (due > std::chrono::steady_clock::now() && queued > 0) {
+				webSocket.processMessages();
+				queued = 0;
+			}
+			while (!stopping && due > std::chrono::steady_clock::now()) {
+				std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+					due - std::chrono::steady_clock::now(), kMaxSleep));
+			}
+			if (stopping) {
+				break;
+			}
+		}
+
+		// Timed from the moment it is "received", as a socket read would be
+		LatencyTracker::setTickOrigin(latency.isEnabled() ? LatencyTracker::now() : 0);
+		webSocket.injectMessage(record.payload);
+		LatencyTracker::setTickOrigin(0);
+		played++;
+
+		if (++queued >= kMaxBatch) {
+			webSocket.processMessages();
+			queued = 0;
+		}
+	}
+
+	if (queued > 0) {
+		webSocket.processMessages();
+	}
+
+	if (reader.isTruncated()) {
+		LOG_WARNING("Stream capture ends with an incomplete record");
+	}
+	LOG_INFO("Replayed " + std::to_string(played) + " stream messages");
+	return played;
+}
+
+} // namespace Emiglio
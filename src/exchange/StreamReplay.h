@@ -0,0 +1,50 @@
+#ifndef EMIGLIO_STREAMREPLAY_H
+#define EMIGLIO_STREAMREPLAY_H
+
+#include "StreamCapture.h"
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace Emiglio {
+
+class BinanceWebSocket;
+
+// Plays a stream capture (see StreamCaptureWriter) back through
+// BinanceWebSocket's queue and dispatch, without a network. Subscribe the
+// callbacks to replay into first; the same decode -> callback -> indicator
+// -> signal path runs as live, so timings and incidents reproduce offline.
+class StreamReplay {
+public:
+	StreamReplay();
+	~StreamReplay();
+
+	bool open(const std::string& path);
+
+	// 1.0 keeps the recorded gaps between messages, 10.0 plays ten times
+	// faster, 0 (the default) as fast as possible
+	void setSpeed(double speed);
+
+	// Queue each message into 'webSocket' when it's due and dispatch it
+	// with processMessages() on the calling thread. Messages already due
+	// are dispatched in batches, as after a busy socket read. Returns the
+	// number of messages played.
+	size_t play(BinanceWebSocket& webSocket);
+
+	// Make a running play() return early (from another thread)
+	void stop();
+
+	bool isTruncated() const { return reader.isTruncated(); }
+	std::string getLastError() const { return lastError; }
+
+private:
+	StreamCaptureReader reader;
+	double speed;
+	std::atomic<bool> stopping;
+	std::string lastError;
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_STREAMREPLAY_H
@@ -0,0 +1,78 @@
+#include "SymbolTable.h"
+
+#include <cstring>
+
+namespace Emiglio {
+
+namespace {
+
+const size_t kInitialSlots = 64;
+
+} // namespace
+
+const uint32_t SymbolTable::kNotFound;
+
+SymbolTable::SymbolTable()
+	: slots(kInitialSlots, kNotFound)
+	, mask(kInitialSlots - 1) {
+}
+
+// FNV-1a
+uint32_t SymbolTable::hash(const char* name, size_t length) {
+	uint32_t h = 2166136261u;
+	for (size_t i = 0; i < length; i++) {
+		h ^= static_cast<unsigned char>(name[i]);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+uint32_t SymbolTable::find(const char* name, size_t length) const {
+	size_t slot = hash(name, length) & mask;
+	while (slots[slot] != kNotFound) {
+		const std::string& candidate = names[slots[slot]];
+		if (candidate.size() == length && std::memcmp(candidate.data(), name, length) == 0) {
+			return slots[slot];
+		}
+		slot = (slot + 1) & mask;
+	}
+	return kNotFound;
+}
+
+uint32_t SymbolTable::intern(const char* name, size_t length) {
+	uint32_t id = find(name, length);
+	if (id != kNotFound) {
+		return id;
+	}
+
+	// Keep the load factor under 1/2
+	if ((names.size() + 1) * 2 > slots.size()) {
+		grow();
+	}
+
+	id = static_cast<uint32_t>(names.size());
+	names.emplace_back(name, length);
+
+	size_t slot = hash(name, length) & mask;
+	while (slots[slot] != kNotFound) {
+		slot = (slot + 1) & mask;
+	}
+	slots[slot] = id;
+	return id;
+}
+
+void SymbolTable::grow() {
+	std::vector<uint32_t> larger(slots.size() * 2, kNotFound);
+	mask = larger.size() - 1;
+
+	for (uint32_t id = 0; id < names.size(); id++) {
+		size_t slot = hash(names[id].data(), names[id].size()) & mask;
+		while (larger[slot] != kNotFound) {
+			slot = (slot + 1) & mask;
+		}
+		larger[slot] = id;
+	}
+	slots.swap(larger);
+}
+
+} // namespace Emiglio
@@ -0,0 +1,43 @@
+#ifndef EMIGLIO_SYMBOLTABLE_H
+#define EMIGLIO_SYMBOLTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Emiglio {
+
+// Interns short names (symbols, stream names) to dense integer IDs so hot
+// paths can route with an array index instead of a string map. Lookups take
+// a pointer and length, so callers can probe with bytes straight out of a
+// network buffer without building a std::string.
+class SymbolTable {
+public:
+	static const uint32_t kNotFound = 0xFFFFFFFFu;
+
+	SymbolTable();
+
+	// ID of 'name', adding it if needed. IDs start at 0 and never change.
+	uint32_t intern(const char* name, size_t length);
+	uint32_t intern(const std::string& name) { return intern(name.data(), name.size()); }
+
+	// ID of 'name' or kNotFound; never allocates
+	uint32_t find(const char* name, size_t length) const;
+	uint32_t find(const std::string& name) const { return find(name.data(), name.size()); }
+
+	const std::string& name(uint32_t id) const { return names[id]; }
+	size_t size() const { return names.size(); }
+
+private:
+	std::vector<std::string> names;
+	std::vector<uint32_t> slots;  // Open addressing; kNotFound marks an empty slot
+	size_t mask;
+
+	static uint32_t hash(const char* name, size_t length);
+	void grow();
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_SYMBOLTABLE_H
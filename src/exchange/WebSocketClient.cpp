@@ -1,10 +1,16 @@
 #include "WebSocketClient.h"
+#include "WebSocketReactor.h"
+#include "StreamCapture.h"
 #include "../utils/Logger.h"
+#include "../utils/LatencyTracker.h"
 
 #include <cerrno>
+#include <csignal>
 #include <cstring>
 #include <cstdlib>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
@@ -13,11 +19,16 @@
 #include <openssl/sha.h>
 #include <openssl/bio.h>
 #include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <zlib.h>
+#include <algorithm>
 #include <sstream>
 #include <random>
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 
 namespace Emiglio {
 
@@ -113,36 +124,150 @@ enum class Opcode : uint8_t {
     PONG = 0xA
 };
 
+// How long a send may wait for a full non-blocking socket to drain
+static const int kWriteTimeoutMs = 5000;
+
+// Largest message accepted after inflating (guards against deflate bombs)
+static const size_t kMaxMessageSize = 64 * 1024 * 1024;
+
+// Value of HTTP header 'name' (lowercase) in 'response', empty if missing
+static std::string header_value(const std::string& response, const std::string& name) {
+    size_t lineStart = response.find("\r\n");
+    while (lineStart != std::string::npos) {
+        lineStart += 2;
+        size_t lineEnd = response.find("\r\n", lineStart);
+        if (lineEnd == std::string::npos || lineEnd == lineStart) {
+            break;
+        }
+        size_t colon = response.find(':', lineStart);
+        if (colon != std::string::npos && colon < lineEnd && colon - lineStart == name.size()) {
+            std::string field = response.substr(lineStart, colon - lineStart);
+            std::transform(field.begin(), field.end(), field.begin(), ::tolower);
+            if (field == name) {
+                size_t valueStart = response.find_first_not_of(" \t", colon + 1);
+                if (valueStart == std::string::npos || valueStart > lineEnd) {
+                    return "";
+                }
+                return response.substr(valueStart, lineEnd - valueStart);
+            }
+        }
+        lineStart = lineEnd;
+    }
+    return "";
+}
+
+static std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
 struct WebSocketClient::Impl {
     int sockfd;
     SSL_CTX* ssl_ctx;
     SSL* ssl;
-    bool connected;
+    std::atomic<bool> connected;
     std::atomic<bool> shouldStop;
     std::thread readerThread;
+    std::string url;
 
     MessageCallback messageCallback;
     ErrorCallback errorCallback;
     ConnectCallback connectCallback;
+    ConnectCallback reconnectCallback;
 
+    // Automatic reconnect with exponential backoff
+    bool autoReconnect;
+    int initialDelayMs;
+    int maxDelayMs;
+    std::mutex stopMutex;
+    std::condition_variable stopCondition;  // Wakes the backoff wait on disconnect
+
+    std::mutex connectionMutex;  // Guards sockfd/ssl while the reader replaces them
     std::mutex writeMutex;
+    std::vector<uint8_t> sendBuffer;  // Outgoing frames, guarded by writeMutex
+    uint64_t maskState;               // Masking key generator, guarded by writeMutex
     std::vector<uint8_t> frameBuffer; // Buffer for partial frames
 
-    Impl() : sockfd(-1), ssl_ctx(nullptr), ssl(nullptr), connected(false), shouldStop(false) {
+    // Reactor mode: no reader thread, the reactor calls on_readable().
+    // readerThread then only runs reconnects.
+    WebSocketReactor* reactor;
+    std::atomic<int> attachedFd;
+    std::mutex handlerMutex;  // Held while on_readable() runs
+    std::vector<uint8_t> readBuffer;
+
+    // permessage-deflate, used only by the reading thread once connected
+    bool compressionEnabled;
+    std::atomic<bool> compressed;      // Negotiated on this connection
+    bool noContextTakeover;            // Server resets its window per message
+    z_stream inflater;
+    bool inflaterReady;
+    std::string inflateBuffer;         // Inflated message, keeps its capacity
+    std::string textBuffer;            // Uncompressed message, likewise
+
+    // Raw message recording
+    std::atomic<StreamCaptureWriter*> capture;
+    std::atomic<uint32_t> captureConnection;
+
+    // Message split over CONTINUATION frames
+    Opcode messageOpcode;
+    bool messageCompressed;
+    std::string fragmentBuffer;
+
+    Impl()
+        : sockfd(-1), ssl_ctx(nullptr), ssl(nullptr), connected(false), shouldStop(false),
+          autoReconnect(false), initialDelayMs(1000), maxDelayMs(60000),
+          maskState(0), reactor(nullptr), attachedFd(-1),
+          compressionEnabled(true), compressed(false), noContextTakeover(false),
+          inflaterReady(false), capture(nullptr), captureConnection(0),
+          messageOpcode(Opcode::TEXT), messageCompressed(false) {
+        memset(&inflater, 0, sizeof(inflater));
         // Initialize OpenSSL
         SSL_load_error_strings();
         SSL_library_init();
         OpenSSL_add_all_algorithms();
+
+        // A write to a connection the server dropped (including the TLS
+        // close_notify on disconnect) must fail with EPIPE, not kill the app
+        signal(SIGPIPE, SIG_IGN);
     }
 
     ~Impl() {
         disconnect();
-        if (ssl_ctx) {
-            SSL_CTX_free(ssl_ctx);
+        if (inflaterReady) {
+            inflateEnd(&inflater);
+        }
+    }
+
+    bool connect_socket(const std::string& targetUrl) {
+        url = targetUrl;
+        shouldStop = false;
+
+        if (!open_connection()) {
+            return false;
         }
+
+        connected = true;
+
+        if (reactor) {
+            if (!attach()) {
+                return false;
+            }
+        } else {
+            // Start reader thread
+            readerThread = std::thread(&Impl::reader_loop, this);
+        }
+
+        if (connectCallback) connectCallback();
+
+        return true;
     }
 
-    bool connect_socket(const std::string& url) {
+    // Resolve, connect, TLS and WebSocket handshake for 'url'
+    bool open_connection() {
         UrlComponents components;
         if (!parse_url(url, components)) {
             if (errorCallback) errorCallback("Invalid WebSocket URL");
@@ -164,64 +289,125 @@ struct WebSocketClient::Impl {
         }
 
         // Create socket
-        sockfd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
-        if (sockfd < 0) {
+        int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+        if (fd < 0) {
             if (errorCallback) errorCallback("Failed to create socket");
             freeaddrinfo(result);
             return false;
         }
 
         // Connect
-        if (::connect(sockfd, result->ai_addr, result->ai_addrlen) < 0) {
+        if (::connect(fd, result->ai_addr, result->ai_addrlen) < 0) {
             if (errorCallback) errorCallback("Failed to connect: " + std::string(strerror(errno)));
-            close(sockfd);
-            sockfd = -1;
+            close(fd);
             freeaddrinfo(result);
             return false;
         }
 
         freeaddrinfo(result);
 
+        {
+            std::lock_guard<std::mutex> lock(connectionMutex);
+            sockfd = fd;
+        }
+
         // Setup SSL if needed
         if (components.secure) {
-            ssl_ctx = SSL_CTX_new(TLS_client_method());
-            if (!ssl_ctx) {
+            SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+            if (!ctx) {
                 if (errorCallback) errorCallback("Failed to create SSL context");
-                close(sockfd);
-                sockfd = -1;
+                close_connection();
                 return false;
             }
 
-            ssl = SSL_new(ssl_ctx);
-            SSL_set_fd(ssl, sockfd);
+            SSL* session = SSL_new(ctx);
+            SSL_set_fd(session, fd);
+            {
+                std::lock_guard<std::mutex> lock(connectionMutex);
+                ssl_ctx = ctx;
+                ssl = session;
+            }
 
-            if (SSL_connect(ssl) <= 0) {
+            if (SSL_connect(session) <= 0) {
                 if (errorCallback) errorCallback("SSL handshake failed");
-                SSL_free(ssl);
-                SSL_CTX_free(ssl_ctx);
-                ssl = nullptr;
-                ssl_ctx = nullptr;
-                close(sockfd);
-                sockfd = -1;
+                close_connection();
                 return false;
             }
         }
 
+        seed_mask();
+
         // Perform WebSocket handshake
         if (!perform_handshake(components)) {
-            disconnect();
+            close_connection();
             return false;
         }
 
-        connected = true;
-        shouldStop = false;
+        return true;
+    }
 
-        // Start reader thread
-        readerThread = std::thread(&Impl::reader_loop, this);
+    // Release the socket and TLS session
+    void close_connection() {
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        if (ssl) {
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+            ssl = nullptr;
+        }
+        if (ssl_ctx) {
+            SSL_CTX_free(ssl_ctx);
+            ssl_ctx = nullptr;
+        }
+        if (sockfd >= 0) {
+            close(sockfd);
+            sockfd = -1;
+        }
+    }
 
-        if (connectCallback) connectCallback();
+    // After the connection dropped: reconnect if enabled. False means the
+    // reader should exit.
+    bool recover() {
+        connected = false;
+        if (!autoReconnect) {
+            return false;
+        }
+        close_connection();
+        return reconnect();
+    }
 
-        return true;
+    // Reconnect to 'url' until it works or disconnect() is called. Waits
+    // initialDelayMs * 2^attempt between attempts, capped at maxDelayMs,
+    // with full jitter so many clients don't retry in lockstep.
+    bool reconnect() {
+        std::mt19937 rng(std::random_device{}());
+        int64_t delay = initialDelayMs;
+
+        for (int attempt = 1; !shouldStop; attempt++) {
+            int64_t wait = std::uniform_int_distribution<int64_t>(delay / 2, delay)(rng);
+            LOG_WARNING("WebSocket reconnect attempt " + std::to_string(attempt) +
+                        " in " + std::to_string(wait) + " ms");
+            {
+                std::unique_lock<std::mutex> lock(stopMutex);
+                stopCondition.wait_for(lock, std::chrono::milliseconds(wait), [this]() {
+                    return shouldStop.load();
+                });
+            }
+            if (shouldStop) {
+                break;
+            }
+
+            frameBuffer.clear();
+            if (open_connection()) {
+                connected = true;
+                LOG_INFO("WebSocket reconnected after " + std::to_string(attempt) + " attempt(s)");
+                // Before any message of the new connection is delivered
+                if (reconnectCallback) reconnectCallback();
+                return !reactor || attach();
+            }
+
+            delay = std::min<int64_t>(delay * 2, maxDelayMs);
+        }
+        return false;
     }
 
     bool perform_handshake(const UrlComponents& components) {
@@ -234,6 +420,9 @@ struct WebSocketClient::Impl {
         request << "Connection: Upgrade\r\n";
         request << "Sec-WebSocket-Key: " << key << "\r\n";
         request << "Sec-WebSocket-Version: 13\r\n";
+        if (compressionEnabled) {
+            request << "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n";
+        }
         request << "\r\n";
 
         std::string req_str = request.str();
@@ -250,8 +439,7 @@ struct WebSocketClient::Impl {
             return false;
         }
 
-        buffer[received] = '\0';
-        std::string response(buffer);
+        std::string response(buffer, received);
 
         // Check for 101 Switching Protocols
         if (response.find("101") == std::string::npos) {
@@ -259,40 +447,189 @@ struct WebSocketClient::Impl {
             return false;
         }
 
+        if (!negotiate_compression(header_value(response, "sec-websocket-extensions"))) {
+            return false;
+        }
+
+        // Frames sent right after the handshake can arrive in the same read
+        size_t headerEnd = response.find("\r\n\r\n");
+        if (headerEnd != std::string::npos && headerEnd + 4 < response.size()) {
+            frameBuffer.insert(frameBuffer.end(), response.begin() + headerEnd + 4, response.end());
+        }
+
         LOG_INFO("WebSocket handshake successful");
         return true;
     }
 
+    // Apply the server's answer to our permessage-deflate offer and start a
+    // fresh inflate context for the connection
+    bool negotiate_compression(const std::string& extensions) {
+        compressed = false;
+        noContextTakeover = false;
+        fragmentBuffer.clear();
+        if (extensions.empty()) {
+            return true;
+        }
+
+        std::vector<std::string> params;
+        std::istringstream stream(extensions);
+        std::string param;
+        while (std::getline(stream, param, ';')) {
+            params.push_back(trim(param));
+        }
+        if (!compressionEnabled || params.empty() || params[0] != "permessage-deflate") {
+            if (errorCallback) errorCallback("Server accepted an extension that was not offered: " + extensions);
+            return false;
+        }
+        for (size_t i = 1; i < params.size(); i++) {
+            if (params[i] == "server_no_context_takeover") {
+                noContextTakeover = true;
+            }
+            // Window sizes need nothing: a 32KB inflate window reads any
+            // smaller one, and we send uncompressed
+        }
+
+        int ret = inflaterReady ? inflateReset(&inflater) : inflateInit2(&inflater, -MAX_WBITS);
+        if (ret != Z_OK) {
+            if (errorCallback) errorCallback("Failed to initialize inflate");
+            return false;
+        }
+        inflaterReady = true;
+        compressed = true;
+        LOG_INFO(std::string("permessage-deflate negotiated") +
+                 (noContextTakeover ? " (no context takeover)" : ""));
+        return true;
+    }
+
+    // Inflate one compressed message into inflateBuffer. The stream carries
+    // over between messages, so it must see every compressed message in
+    // order.
+    bool inflate_message(const char* data, size_t length) {
+        // Senders strip the empty stored block that ends each message
+        static const uint8_t kTail[4] = { 0x00, 0x00, 0xFF, 0xFF };
+
+        inflater.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        inflater.avail_in = static_cast<uInt>(length);
+        bool tailAdded = false;
+        size_t produced = 0;
+        inflateBuffer.resize(std::max<size_t>(4096, length * 4));
+
+        while (true) {
+            if (produced == inflateBuffer.size()) {
+                if (inflateBuffer.size() >= kMaxMessageSize) {
+                    if (errorCallback) errorCallback("Inflated message exceeds size limit");
+                    return false;
+                }
+                inflateBuffer.resize(std::min(inflateBuffer.size() * 2, kMaxMessageSize));
+            }
+
+            inflater.next_out = reinterpret_cast<Bytef*>(&inflateBuffer[produced]);
+            inflater.avail_out = static_cast<uInt>(inflateBuffer.size() - produced);
+            int ret = inflate(&inflater, Z_SYNC_FLUSH);
+            produced = inflateBuffer.size() - inflater.avail_out;
+
+            if (ret == Z_STREAM_END) {
+                // A final block ends the context; the next message starts anew
+                inflateReset(&inflater);
+                break;
+            }
+            if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                if (errorCallback) errorCallback("Failed to inflate message");
+                return false;
+            }
+            if (inflater.avail_in == 0 && inflater.avail_out != 0) {
+                if (tailAdded) {
+                    break;
+                }
+                inflater.next_in = const_cast<Bytef*>(kTail);
+                inflater.avail_in = sizeof(kTail);
+                tailAdded = true;
+            }
+        }
+
+        inflateBuffer.resize(produced);
+        if (noContextTakeover) {
+            inflateReset(&inflater);
+        }
+        return true;
+    }
+
     void disconnect() {
-        if (!connected) return;
+        bool active;
+        {
+            // The reactor thread starts reconnect threads under stopMutex
+            std::lock_guard<std::mutex> lock(stopMutex);
+            active = connected || readerThread.joinable();
+            shouldStop = true;
+        }
+        stopCondition.notify_all();
 
-        shouldStop = true;
+        // Reactor mode: a handler may still be cleaning up a lost connection
+        if (reactor) {
+            std::lock_guard<std::mutex> lock(handlerMutex);
+        }
+        if (!active) return;
         connected = false;
 
+        // Unblock a reader waiting in recv/SSL_read
+        {
+            std::lock_guard<std::mutex> lock(connectionMutex);
+            if (sockfd >= 0) {
+                ::shutdown(sockfd, SHUT_RDWR);
+            }
+        }
+
         if (readerThread.joinable()) {
             readerThread.join();
         }
 
-        if (ssl) {
-            SSL_shutdown(ssl);
-            SSL_free(ssl);
-            ssl = nullptr;
-        }
-
-        if (sockfd >= 0) {
-            close(sockfd);
-            sockfd = -1;
-        }
+        detach();
+        close_connection();
 
         LOG_INFO("WebSocket disconnected");
     }
 
+    // Write all of 'data'. In reactor mode the socket is non-blocking, so
+    // wait for it to drain when full.
     bool write_data(const char* data, size_t length) {
-        if (ssl) {
-            return SSL_write(ssl, data, length) > 0;
-        } else {
-            return ::send(sockfd, data, length, 0) > 0;
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        size_t written = 0;
+        while (written < length) {
+            if (sockfd < 0) {
+                return false;
+            }
+
+            int sent;
+            short waitFor = POLLOUT;
+            if (ssl) {
+                // After WANT_*, SSL_write must be retried with the same buffer
+                sent = SSL_write(ssl, data + written, length - written);
+                if (sent <= 0) {
+                    int error = SSL_get_error(ssl, sent);
+                    if (error == SSL_ERROR_WANT_READ) {
+                        waitFor = POLLIN;
+                    } else if (error != SSL_ERROR_WANT_WRITE) {
+                        return false;
+                    }
+                }
+            } else {
+                sent = ::send(sockfd, data + written, length - written, 0);
+                if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    return false;
+                }
+            }
+
+            if (sent > 0) {
+                written += sent;
+                continue;
+            }
+
+            struct pollfd pfd = { sockfd, waitFor, 0 };
+            if (poll(&pfd, 1, kWriteTimeoutMs) <= 0) {
+                return false;
+            }
         }
+        return true;
     }
 
     int read_data(char* buffer, size_t length) {
@@ -303,134 +640,385 @@ struct WebSocketClient::Impl {
         }
     }
 
+    // Reactor mode: bytes read, 0 if the socket would block, -1 if the
+    // connection is gone
+    int read_available(char* buffer, size_t length) {
+        std::lock_guard<std::mutex> lock(connectionMutex);
+        if (sockfd < 0) {
+            return -1;
+        }
+
+        if (ssl) {
+            int received = SSL_read(ssl, buffer, length);
+            if (received > 0) {
+                return received;
+            }
+            int error = SSL_get_error(ssl, received);
+            return (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) ? 0 : -1;
+        }
+
+        ssize_t received = ::recv(sockfd, buffer, length, 0);
+        if (received > 0) {
+            return static_cast<int>(received);
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return 0;
+        }
+        return -1;
+    }
+
+    // Reactor mode: make the socket non-blocking and register it
+    bool attach() {
+        int fd;
+        {
+            std::lock_guard<std::mutex> lock(connectionMutex);
+            fd = sockfd;
+        }
+
+        // Set first: the handler may run (and detach) before add() returns
+        attachedFd = fd;
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0 ||
+            !reactor->add(fd, [this]() { on_readable(); })) {
+            if (errorCallback) errorCallback("Failed to register connection with reactor");
+            attachedFd = -1;
+            connected = false;
+            close_connection();
+            return false;
+        }
+        return true;
+    }
+
+    void detach() {
+        int fd = attachedFd.exchange(-1);
+        if (reactor && fd >= 0) {
+            reactor->remove(fd);
+        }
+    }
+
+    // Reactor thread: read until the socket would block, delivering
+    // frames as they complete
+    void on_readable() {
+        std::lock_guard<std::mutex> busy(handlerMutex);
+        LatencyTracker& latency = LatencyTracker::getInstance();
+        if (readBuffer.empty()) {
+            readBuffer.resize(16384);
+        }
+
+        // Frames that came with the handshake
+        if (!frameBuffer.empty() && !parse_frames(latency.isEnabled() ? LatencyTracker::now() : 0)) {
+            handle_loss(true);
+            return;
+        }
+
+        while (!shouldStop) {
+            int received = read_available(reinterpret_cast<char*>(readBuffer.data()), readBuffer.size());
+            if (received == 0) {
+                return;
+            }
+            if (received < 0) {
+                handle_loss(false);
+                return;
+            }
+
+            int64_t readTime = latency.isEnabled() ? LatencyTracker::now() : 0;
+            frameBuffer.insert(frameBuffer.end(), readBuffer.begin(), readBuffer.begin() + received);
+            if (!parse_frames(readTime)) {
+                handle_loss(true);
+                return;
+            }
+        }
+    }
+
+    // Reactor thread: the connection dropped or the server closed it.
+    // Reconnecting blocks, so it runs on a short-lived thread that attaches
+    // the new connection when done.
+    void handle_loss(bool closedByServer) {
+        detach();
+        connected = false;
+        close_connection();
+
+        if (shouldStop) {
+            return;
+        }
+        if (!closedByServer && errorCallback) errorCallback("Connection lost");
+        if (!autoReconnect) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(stopMutex);
+        if (shouldStop) {
+            return;
+        }
+        if (readerThread.joinable()) {
+            readerThread.join();
+        }
+        readerThread = std::thread([this]() { reconnect(); });
+    }
+
     bool send_frame(Opcode opcode, const std::string& payload) {
         std::lock_guard<std::mutex> lock(writeMutex);
+        sendBuffer.clear();
+        append_frame(opcode, payload.data(), payload.size());
+        return write_data(reinterpret_cast<const char*>(sendBuffer.data()), sendBuffer.size());
+    }
+
+    // Several frames in one write, so small messages share a TLS record
+    bool send_frames(Opcode opcode, const std::vector<std::string>& payloads) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        sendBuffer.clear();
+        for (const auto& payload : payloads) {
+            append_frame(opcode, payload.data(), payload.size());
+        }
+        return sendBuffer.empty() ||
+               write_data(reinterpret_cast<const char*>(sendBuffer.data()), sendBuffer.size());
+    }
 
-        std::vector<uint8_t> frame;
+    // Append a masked frame to sendBuffer (writeMutex held). The buffer
+    // keeps its capacity, so steady-state sends don't allocate.
+    void append_frame(Opcode opcode, const char* payload, size_t payload_len) {
+        uint8_t header[14];
+        size_t header_len = 0;
 
         // First byte: FIN + opcode
-        frame.push_back(0x80 | static_cast<uint8_t>(opcode));
+        header[header_len++] = 0x80 | static_cast<uint8_t>(opcode);
 
         // Second byte: MASK + payload length
-        size_t payload_len = payload.length();
         if (payload_len < 126) {
-            frame.push_back(0x80 | static_cast<uint8_t>(payload_len));
+            header[header_len++] = 0x80 | static_cast<uint8_t>(payload_len);
         } else if (payload_len < 65536) {
-            frame.push_back(0x80 | 126);
-            frame.push_back((payload_len >> 8) & 0xFF);
-            frame.push_back(payload_len & 0xFF);
+            header[header_len++] = 0x80 | 126;
+            header[header_len++] = (payload_len >> 8) & 0xFF;
+            header[header_len++] = payload_len & 0xFF;
         } else {
-            frame.push_back(0x80 | 127);
+            header[header_len++] = 0x80 | 127;
             for (int i = 7; i >= 0; i--) {
-                frame.push_back((payload_len >> (i * 8)) & 0xFF);
+                header[header_len++] = (static_cast<uint64_t>(payload_len) >> (i * 8)) & 0xFF;
             }
         }
 
         // Masking key (client must mask)
+        uint32_t key = next_mask();
         uint8_t mask[4];
-        for (int i = 0; i < 4; i++) {
-            mask[i] = rand() % 256;
-            frame.push_back(mask[i]);
-        }
+        memcpy(mask, &key, 4);
+        memcpy(header + header_len, mask, 4);
+        header_len += 4;
+
+        size_t offset = sendBuffer.size();
+        sendBuffer.resize(offset + header_len + payload_len);
+        memcpy(&sendBuffer[offset], header, header_len);
+        mask_payload(&sendBuffer[offset + header_len],
+                     reinterpret_cast<const uint8_t*>(payload), payload_len, mask);
+    }
 
-        // Masked payload
-        for (size_t i = 0; i < payload_len; i++) {
-            frame.push_back(payload[i] ^ mask[i % 4]);
+    // XOR with the 4-byte mask, a 64-bit word at a time (four per step,
+    // which compilers turn into SIMD); 'out' and 'in' may be unaligned
+    static void mask_payload(uint8_t* out, const uint8_t* in, size_t length, const uint8_t mask[4]) {
+        uint8_t pattern[8] = { mask[0], mask[1], mask[2], mask[3], mask[0], mask[1], mask[2], mask[3] };
+        uint64_t mask64;
+        memcpy(&mask64, pattern, 8);
+
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            uint64_t words[4];
+            memcpy(words, in + i, 32);
+            words[0] ^= mask64;
+            words[1] ^= mask64;
+            words[2] ^= mask64;
+            words[3] ^= mask64;
+            memcpy(out + i, words, 32);
+        }
+        for (; i + 8 <= length; i += 8) {
+            uint64_t word;
+            memcpy(&word, in + i, 8);
+            word ^= mask64;
+            memcpy(out + i, &word, 8);
         }
+        // 'i' is a multiple of 8 here, so the mask phase is unchanged
+        for (; i < length; i++) {
+            out[i] = in[i] ^ mask[i & 3];
+        }
+    }
 
-        return write_data(reinterpret_cast<const char*>(frame.data()), frame.size());
+    // Masking keys: splitmix64 seeded from OpenSSL's CSPRNG per connection.
+    // Unpredictable to the page (RFC 6455 10.3) without a RAND_bytes call
+    // per frame.
+    uint32_t next_mask() {
+        maskState += 0x9E3779B97F4A7C15ULL;
+        uint64_t z = maskState;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return static_cast<uint32_t>(z ^ (z >> 31));
+    }
+
+    void seed_mask() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (RAND_bytes(reinterpret_cast<unsigned char*>(&maskState), sizeof(maskState)) != 1) {
+            std::random_device device;
+            maskState = (static_cast<uint64_t>(device()) << 32) ^ device();
+        }
     }
 
     void reader_loop() {
         std::vector<uint8_t> readBuffer;
         readBuffer.resize(8192);
+        LatencyTracker& latency = LatencyTracker::getInstance();
+
+        // Frames that came with the handshake
+        bool open = frameBuffer.empty() || parse_frames(latency.isEnabled() ? LatencyTracker::now() : 0);
+
+        while (!shouldStop) {
+            // Binance closes every connection after 24h
+            if (!open) {
+                if (shouldStop || !recover()) {
+                    break;
+                }
+                open = frameBuffer.empty() || parse_frames(latency.isEnabled() ? LatencyTracker::now() : 0);
+                continue;
+            }
 
-        while (!shouldStop && connected) {
             int received = read_data(reinterpret_cast<char*>(readBuffer.data()), readBuffer.size());
+            int64_t readTime = latency.isEnabled() ? LatencyTracker::now() : 0;
 
             if (received <= 0) {
-                if (!shouldStop) {
-                    if (errorCallback) errorCallback("Connection lost");
-                    connected = false;
+                if (shouldStop) {
+                    break;
                 }
-                break;
+                if (errorCallback) errorCallback("Connection lost");
+                if (!recover()) {
+                    break;
+                }
+                open = frameBuffer.empty() || parse_frames(latency.isEnabled() ? LatencyTracker::now() : 0);
+                continue;
             }
 
             // Append new data to frame buffer
             frameBuffer.insert(frameBuffer.end(), readBuffer.begin(), readBuffer.begin() + received);
+            open = parse_frames(readTime);
+        }
+    }
+
+    // Deliver the complete frames in frameBuffer and answer pings. False
+    // once a CLOSE frame arrived.
+    bool parse_frames(int64_t readTime) {
+        LatencyTracker& latency = LatencyTracker::getInstance();
+        StreamCaptureWriter* recorder = capture;
+        int64_t captureTime = (recorder && recorder->isOpen()) ? StreamCaptureWriter::now() : 0;
+
+        // Parse WebSocket frames from buffer
+        size_t offset = 0;
+        bool closed = false;
+        while (offset + 2 <= frameBuffer.size()) {
+            uint8_t byte1 = frameBuffer[offset];
+            uint8_t byte2 = frameBuffer[offset + 1];
+
+            bool fin = (byte1 & 0x80) != 0;
+            bool rsv1 = (byte1 & 0x40) != 0;  // Compressed (first frame only)
+            Opcode opcode = static_cast<Opcode>(byte1 & 0x0F);
+            bool masked = (byte2 & 0x80) != 0;
+            uint64_t payload_len = byte2 & 0x7F;
+
+            size_t header_size = 2;
+
+            // Extended payload length
+            if (payload_len == 126) {
+                if (offset + 4 > frameBuffer.size()) break; // Need more data
+                payload_len = (frameBuffer[offset + 2] << 8) | frameBuffer[offset + 3];
+                header_size += 2;
+            } else if (payload_len == 127) {
+                if (offset + 10 > frameBuffer.size()) break; // Need more data
+                payload_len = 0;
+                for (int i = 0; i < 8; i++) {
+                    payload_len = (payload_len << 8) | frameBuffer[offset + 2 + i];
+                }
+                header_size += 8;
+            }
 
-            // Parse WebSocket frames from buffer
-            size_t offset = 0;
-            while (offset + 2 <= frameBuffer.size()) {
-                uint8_t byte1 = frameBuffer[offset];
-                uint8_t byte2 = frameBuffer[offset + 1];
-
-                bool fin = (byte1 & 0x80) != 0;
-                Opcode opcode = static_cast<Opcode>(byte1 & 0x0F);
-                bool masked = (byte2 & 0x80) != 0;
-                uint64_t payload_len = byte2 & 0x7F;
-
-                size_t header_size = 2;
-
-                // Extended payload length
-                if (payload_len == 126) {
-                    if (offset + 4 > frameBuffer.size()) break; // Need more data
-                    payload_len = (frameBuffer[offset + 2] << 8) | frameBuffer[offset + 3];
-                    header_size += 2;
-                } else if (payload_len == 127) {
-                    if (offset + 10 > frameBuffer.size()) break; // Need more data
-                    payload_len = 0;
-                    for (int i = 0; i < 8; i++) {
-                        payload_len = (payload_len << 8) | frameBuffer[offset + 2 + i];
+            // Skip mask (server should not mask)
+            if (masked) {
+                header_size += 4;
+            }
+
+            // Check if we have the complete frame
+            if (offset + header_size + payload_len > frameBuffer.size()) {
+                break; // Need more data
+            }
+
+            const char* data = reinterpret_cast<char*>(&frameBuffer[offset + header_size]);
+
+            // Move offset past this frame
+            offset += header_size + payload_len;
+
+            // Handle frame
+            if (opcode == Opcode::TEXT || opcode == Opcode::BINARY || opcode == Opcode::CONTINUATION) {
+                if (opcode != Opcode::CONTINUATION) {
+                    messageOpcode = opcode;
+                    messageCompressed = rsv1 && compressed;
+                    fragmentBuffer.clear();
+                }
+
+                // Collect fragments until the final one
+                if (!fin || !fragmentBuffer.empty()) {
+                    fragmentBuffer.append(data, payload_len);
+                    if (!fin) {
+                        continue;
                     }
-                    header_size += 8;
+                    data = fragmentBuffer.data();
+                    payload_len = fragmentBuffer.size();
                 }
 
-                // Skip mask (server should not mask)
-                if (masked) {
-                    header_size += 4;
+                // Compressed messages advance the inflate context even when
+                // nobody listens
+                if (messageCompressed && !inflate_message(data, payload_len)) {
+                    closed = true;
+                    break;
                 }
 
-                // Check if we have the complete frame
-                if (offset + header_size + payload_len > frameBuffer.size()) {
-                    break; // Need more data
+                if (messageOpcode == Opcode::TEXT && captureTime != 0) {
+                    if (messageCompressed) {
+                        recorder->append(captureConnection, captureTime, inflateBuffer.data(), inflateBuffer.size());
+                    } else {
+                        recorder->append(captureConnection, captureTime, data, payload_len);
+                    }
                 }
 
-                // Extract payload
-                std::string payload(
-                    reinterpret_cast<char*>(&frameBuffer[offset + header_size]),
-                    payload_len
-                );
-
-                // Move offset past this frame
-                offset += header_size + payload_len;
-
-                // Handle frame
-                if (opcode == Opcode::TEXT && messageCallback) {
-                    messageCallback(payload);
-                } else if (opcode == Opcode::CLOSE) {
-                    LOG_INFO("WebSocket close frame received");
-                    connected = false;
-                    // Remove processed data and exit
-                    frameBuffer.erase(frameBuffer.begin(), frameBuffer.begin() + offset);
-                    return;
-                } else if (opcode == Opcode::PING) {
-                    // Respond with PONG
-                    send_frame(Opcode::PONG, payload);
+                if (messageOpcode == Opcode::TEXT && messageCallback) {
+                    // Callbacks see the read time as their tick origin
+                    if (readTime != 0) {
+                        latency.recordSince(LatencyStage::FRAME_DECODE, readTime);
+                        LatencyTracker::setTickOrigin(readTime);
+                    }
+                    if (messageCompressed) {
+                        messageCallback(inflateBuffer);
+                    } else {
+                        textBuffer.assign(data, payload_len);
+                        messageCallback(textBuffer);
+                    }
+                    LatencyTracker::setTickOrigin(0);
                 }
+                fragmentBuffer.clear();
+            } else if (opcode == Opcode::CLOSE) {
+                LOG_INFO("WebSocket close frame received");
+                closed = true;
+                break;
+            } else if (opcode == Opcode::PING) {
+                // Respond with PONG
+                send_frame(Opcode::PONG, std::string(data, payload_len));
             }
+        }
 
-            // Remove processed data from buffer
-            if (offset > 0) {
-                frameBuffer.erase(frameBuffer.begin(), frameBuffer.begin() + offset);
-            }
+        // Remove processed data from buffer
+        if (offset > 0) {
+            frameBuffer.erase(frameBuffer.begin(), frameBuffer.begin() + offset);
+        }
 
-            // Prevent buffer from growing indefinitely if we have garbage data
-            if (frameBuffer.size() > 1024 * 1024) { // 1MB limit
-                LOG_ERROR("Frame buffer exceeded 1MB, clearing (possible corrupt data)");
-                frameBuffer.clear();
-            }
+        // Prevent buffer from growing indefinitely if we have garbage data
+        if (frameBuffer.size() > 1024 * 1024) { // 1MB limit
+            LOG_ERROR("Frame buffer exceeded 1MB, clearing (possible corrupt data)");
+            frameBuffer.clear();
         }
+
+        return !closed;
     }
 };
 
@@ -450,6 +1038,11 @@ bool WebSocketClient::send(const std::string& message) {
     return pImpl->send_frame(Opcode::TEXT, message);
 }
 
+bool WebSocketClient::send(const std::vector<std::string>& messages) {
+    if (!pImpl->connected) return false;
+    return pImpl->send_frames(Opcode::TEXT, messages);
+}
+
 void WebSocketClient::disconnect() {
     pImpl->disconnect();
 }
@@ -470,4 +1063,31 @@ void WebSocketClient::onConnect(ConnectCallback callback) {
     pImpl->connectCallback = callback;
 }
 
+void WebSocketClient::onReconnect(ConnectCallback callback) {
+    pImpl->reconnectCallback = callback;
+}
+
+void WebSocketClient::setReactor(WebSocketReactor* reactor) {
+    pImpl->reactor = reactor;
+}
+
+void WebSocketClient::setCompression(bool enabled) {
+    pImpl->compressionEnabled = enabled;
+}
+
+bool WebSocketClient::isCompressed() const {
+    return pImpl->compressed;
+}
+
+void WebSocketClient::setCapture(StreamCaptureWriter* capture, uint32_t connection) {
+    pImpl->captureConnection = connection;
+    pImpl->capture = capture;
+}
+
+void WebSocketClient::setAutoReconnect(bool enabled, int initialDelayMs, int maxDelayMs) {
+    pImpl->autoReconnect = enabled;
+    pImpl->initialDelayMs = std::max(1, initialDelayMs);
+    pImpl->maxDelayMs = std::max(pImpl->initialDelayMs, maxDelayMs);
+}
+
 } // namespace Emiglio
@@ -2,6 +2,7 @@
 #define WEBSOCKET_CLIENT_H
 
 #include <string>
+#include <cstdint>
 #include <functional>
 #include <thread>
 #include <atomic>
@@ -10,6 +11,9 @@
 
 namespace Emiglio {
 
+class WebSocketReactor;
+class StreamCaptureWriter;
+
 // Simple WebSocket client using BSD sockets + OpenSSL
 class WebSocketClient {
 public:
@@ -27,6 +31,10 @@ public:
     // Send text message
     bool send(const std::string& message);
 
+    // Send several text messages with a single write (one TLS record
+    // when they fit), e.g. a burst of subscription or order requests
+    bool send(const std::vector<std::string>& messages);
+
     // Disconnect
     void disconnect();
 
@@ -38,6 +46,35 @@ public:
     void onError(ErrorCallback callback);
     void onConnect(ConnectCallback callback);
 
+    // Called from the reader thread after an automatic reconnect
+    void onReconnect(ConnectCallback callback);
+
+    // When enabled, a dropped connection is retried from the reader thread
+    // with exponential backoff (initialDelayMs doubling up to maxDelayMs,
+    // jittered) until it succeeds or disconnect() is called.
+    void setAutoReconnect(bool enabled, int initialDelayMs = 1000, int maxDelayMs = 60000);
+
+    // Read through 'reactor' instead of a reader thread of its own (set
+    // before connect; the reactor must outlive the connection). Callbacks
+    // then run on the reactor thread, and a reconnect runs on a temporary
+    // thread.
+    void setReactor(WebSocketReactor* reactor);
+
+    // Offer permessage-deflate (RFC 7692) in the handshake; on by default.
+    // Compressed messages are inflated through one zlib stream kept for the
+    // whole connection (context takeover, unless the server refuses it).
+    // Turn off when CPU rather than bandwidth is the bottleneck; applies
+    // from the next connect.
+    void setCompression(bool enabled);
+
+    // True if the current connection negotiated permessage-deflate
+    bool isCompressed() const;
+
+    // Record every text message received into 'capture' (nullptr stops),
+    // tagged with 'connection'. May be changed while connected; the writer
+    // must outlive the connection.
+    void setCapture(StreamCaptureWriter* capture, uint32_t connection = 0);
+
 private:
     struct Impl;
     Impl* pImpl;
@@ -0,0 +1,248 @@
+#include "WebSocketReactor.h"
+#include "../utils/Logger.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+namespace Emiglio {
+
+namespace {
+
+const int kMaxEvents = 64;
+
+} // namespace
+
+WebSocketReactor::WebSocketReactor()
+	: dispatchingFd(-1)
+	, running(false)
+	, stopping(false)
+	, pollFd(-1) {
+	wakePipe[0] = -1;
+	wakePipe[1] = -1;
+}
+
+WebSocketReactor::~WebSocketReactor() {
+	stop();
+}
+
+bool WebSocketReactor::start() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (running) {
+		return true;
+	}
+
+	if (pipe(wakePipe) != 0) {
+		LOG_ERROR("Reactor: failed to create wake pipe: " + std::string(strerror(errno)));
+		return false;
+	}
+	fcntl(wakePipe[0], F_SETFL, fcntl(wakePipe[0], F_GETFL) | O_NONBLOCK);
+	fcntl(wakePipe[1], F_SETFL, fcntl(wakePipe[1], F_GETFL) | O_NONBLOCK);
+
+#ifdef __linux__
+	pollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (pollFd < 0) {
+		LOG_ERROR("Reactor: epoll_create1 failed: " + std::string(strerror(errno)));
+		close(wakePipe[0]);
+		close(wakePipe[1]);
+		return false;
+	}
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.fd = wakePipe[0];
+	epoll_ctl(pollFd, EPOLL_CTL_ADD, wakePipe[0], &event);
+	for (const auto& entry : handlers) {
+		event.data.fd = entry.first;
+		epoll_ctl(pollFd, EPOLL_CTL_ADD, entry.first, &event);
+	}
+#endif
+
+	stopping = false;
+	running = true;
+	thread = std::thread(&WebSocketReactor::loop, this);
+	return true;
+}
+
+void WebSocketReactor::stop() {
+	if (!running) {
+		return;
+	}
+
+	stopping = true;
+	wake();
+	if (thread.joinable()) {
+		thread.join();
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	running = false;
+	if (pollFd >= 0) {
+		close(pollFd);
+		pollFd = -1;
+	}
+	close(wakePipe[0]);
+	close(wakePipe[1]);
+	wakePipe[0] = -1;
+	wakePipe[1] = -1;
+}
+
+bool WebSocketReactor::add(int fd, ReadyCallback onReadable) {
+	if (fd < 0 || !onReadable) {
+		return false;
+	}
+	if (!running && !start()) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	std::shared_ptr<Handler> handler(new Handler());
+	handler->onReadable = onReadable;
+	handlers[fd] = handler;
+
+#ifdef __linux__
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN | EPOLLRDHUP;
+	event.data.fd = fd;
+	if (epoll_ctl(pollFd, EPOLL_CTL_ADD, fd, &event) != 0 &&
+	    (errno != EEXIST || epoll_ctl(pollFd, EPOLL_CTL_MOD, fd, &event) != 0)) {
+		LOG_ERROR("Reactor: epoll_ctl failed: " + std::string(strerror(errno)));
+		handlers.erase(fd);
+		return false;
+	}
+#endif
+
+	initialDispatch.push_back(fd);
+	wake();
+	return true;
+}
+
+void WebSocketReactor::remove(int fd) {
+	std::unique_lock<std::mutex> lock(mutex);
+	if (handlers.erase(fd) == 0) {
+		return;
+	}
+
+#ifdef __linux__
+	if (pollFd >= 0) {
+		epoll_ctl(pollFd, EPOLL_CTL_DEL, fd, nullptr);
+	}
+#endif
+
+	if (!isReactorThread()) {
+		handlerDone.wait(lock, [this, fd]() { return dispatchingFd != fd; });
+	}
+}
+
+bool WebSocketReactor::isReactorThread() const {
+	return std::this_thread::get_id() == thread.get_id();
+}
+
+size_t WebSocketReactor::getConnectionCount() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return handlers.size();
+}
+
+void WebSocketReactor::wake() {
+	if (wakePipe[1] >= 0) {
+		char byte = 1;
+		// A full pipe already guarantees a wakeup
+		ssize_t written = write(wakePipe[1], &byte, 1);
+		(void)written;
+	}
+}
+
+void WebSocketReactor::loop() {
+	std::vector<int> ready;
+	ready.reserve(kMaxEvents);
+
+	while (!stopping) {
+		ready.clear();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ready.swap(initialDispatch);
+		}
+		if (ready.empty()) {
+			waitReady(ready);
+		}
+
+		for (int fd : ready) {
+			if (stopping) {
+				break;
+			}
+			dispatch(fd);
+		}
+	}
+}
+
+// Block until sockets are readable; fills 'ready' (may be empty after a wake)
+void WebSocketReactor::waitReady(std::vector<int>& ready) {
+	bool woken = false;
+
+#ifdef __linux__
+	struct epoll_event events[kMaxEvents];
+	int count = epoll_wait(pollFd, events, kMaxEvents, -1);
+	for (int i = 0; i < count; i++) {
+		if (events[i].data.fd == wakePipe[0]) {
+			woken = true;
+		} else {
+			ready.push_back(events[i].data.fd);
+		}
+	}
+#else
+	std::vector<struct pollfd> fds;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		fds.reserve(handlers.size() + 1);
+		fds.push_back({ wakePipe[0], POLLIN, 0 });
+		for (const auto& entry : handlers) {
+			fds.push_back({ entry.first, POLLIN, 0 });
+		}
+	}
+	if (poll(fds.data(), fds.size(), -1) > 0) {
+		woken = fds[0].revents != 0;
+		for (size_t i = 1; i < fds.size(); i++) {
+			if (fds[i].revents != 0) {
+				ready.push_back(fds[i].fd);
+			}
+		}
+	}
+#endif
+
+	if (woken) {
+		char buffer[64];
+		while (read(wakePipe[0], buffer, sizeof(buffer)) > 0) {
+		}
+	}
+}
+
+// Run the handler of 'fd', unless it was removed meanwhile
+void WebSocketReactor::dispatch(int fd) {
+	std::shared_ptr<Handler> handler;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = handlers.find(fd);
+		if (it == handlers.end()) {
+			return;
+		}
+		handler = it->second;
+		dispatchingFd = fd;
+	}
+
+	handler->onReadable();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		dispatchingFd = -1;
+	}
+	handlerDone.notify_all();
+}
+
+} // namespace Emiglio
@@ -0,0 +1,74 @@
+#ifndef WEBSOCKET_REACTOR_H
+#define WEBSOCKET_REACTOR_H
+
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <map>
+#include <vector>
+
+namespace Emiglio {
+
+// One I/O thread for many non-blocking sockets.
+//
+// WebSocketClients attached to a reactor (see WebSocketClient::setReactor)
+// don't run a reader thread each: the reactor waits on all their sockets
+// (epoll on Linux, poll() elsewhere) and calls the socket's handler on its
+// thread when it becomes readable. Handlers must not block; they read until
+// the socket would block.
+class WebSocketReactor {
+public:
+	using ReadyCallback = std::function<void()>;
+
+	WebSocketReactor();
+	~WebSocketReactor();
+
+	// Start/stop the I/O thread. add() starts it if needed.
+	bool start();
+	void stop();
+	bool isRunning() const { return running; }
+
+	// Watch 'fd' (already non-blocking) for input. The handler also runs
+	// once right after registration, for data that was read ahead (e.g.
+	// buffered by TLS during the handshake).
+	bool add(int fd, ReadyCallback onReadable);
+
+	// Stop watching 'fd'. From another thread this waits for a running
+	// handler of 'fd' to return, so the caller may close it afterwards.
+	void remove(int fd);
+
+	bool isReactorThread() const;
+	size_t getConnectionCount() const;
+
+	WebSocketReactor(const WebSocketReactor&) = delete;
+	WebSocketReactor& operator=(const WebSocketReactor&) = delete;
+
+private:
+	struct Handler {
+		ReadyCallback onReadable;
+	};
+
+	mutable std::mutex mutex;
+	std::condition_variable handlerDone;
+	std::map<int, std::shared_ptr<Handler>> handlers;
+	std::vector<int> initialDispatch;  // Added since the last wait
+	int dispatchingFd;
+
+	std::thread thread;
+	std::atomic<bool> running;
+	std::atomic<bool> stopping;
+	int pollFd;       // epoll instance, -1 with poll()
+	int wakePipe[2];  // Interrupts the wait for stop() and add()
+
+	void loop();
+	void wake();
+	void dispatch(int fd);
+	void waitReady(std::vector<int>& ready);
+};
+
+} // namespace Emiglio
+
+#endif // WEBSOCKET_REACTOR_H
@@ -44,6 +44,11 @@ bool RecipeLoader::loadFromString(const std::string& jsonStr, Recipe& recipe) {
 		return false;
 	}
 
+	// Recipes use either snake_case or camelCase section names
+	auto key = [&parser](const std::string& snake, const std::string& camel) {
+		return parser.has(snake) ? snake : camel;
+	};
+
 	// Parse basic info
 	recipe.name = parser.getString("name", "");
 	recipe.description = parser.getString("description", "");
@@ -67,7 +72,7 @@ bool RecipeLoader::loadFromString(const std::string& jsonStr, Recipe& recipe) {
 
 	// Parse capital config
 	recipe.capital.initial = parser.getDouble("capital.initial", 0.0);
-	recipe.capital.positionSizePercent = parser.getDouble("capital.position_size_percent", 10.0);
+	recipe.capital.positionSizePercent = parser.getDouble(key("capital.position_size_percent", "capital.positionSizePercent"), 10.0);
 
 	if (recipe.capital.initial <= 0) {
 		lastError = "Initial capital must be > 0";
@@ -76,10 +81,10 @@ bool RecipeLoader::loadFromString(const std::string& jsonStr, Recipe& recipe) {
 	}
 
 	// Parse risk config
-	recipe.risk.stopLossPercent = parser.getDouble("risk_management.stop_loss_percent", 0.0);
-	recipe.risk.takeProfitPercent = parser.getDouble("risk_management.take_profit_percent", 0.0);
-	recipe.risk.maxDailyLossPercent = parser.getDouble("risk_management.max_daily_loss_percent", 5.0);
-	recipe.risk.maxOpenPositions = parser.getInt("risk_management.max_open_positions", 1);
+	recipe.risk.stopLossPercent = parser.getDouble(key("risk_management.stop_loss_percent", "risk.stopLossPercent"), 0.0);
+	recipe.risk.takeProfitPercent = parser.getDouble(key("risk_management.take_profit_percent", "risk.takeProfitPercent"), 0.0);
+	recipe.risk.maxDailyLossPercent = parser.getDouble(key("risk_management.max_daily_loss_percent", "risk.maxDailyLossPercent"), 5.0);
+	recipe.risk.maxOpenPositions = parser.getInt(key("risk_management.max_open_positions", "risk.maxOpenPositions"), 1);
 
 	// Parse indicators array
 	size_t indicatorCount = parser.getArraySize("indicators");
@@ -89,6 +94,10 @@ bool RecipeLoader::loadFromString(const std::string& jsonStr, Recipe& recipe) {
 		IndicatorConfig indicator;
 		indicator.name = parser.getArrayObjectString("indicators", i, "name", "");
 		indicator.period = static_cast<int>(parser.getArrayObjectInt64("indicators", i, "period", 14));
+		indicator.timeframe = parser.getArrayObjectString("indicators", i, "timeframe", "");
+		if (indicator.timeframe == recipe.market.timeframe) {
+			indicator.timeframe.clear();
+		}
 
 		// Parse additional parameters (e.g., oversold, overbought for RSI)
 		// For now, we'll support common parameters as direct fields
@@ -102,22 +111,26 @@ bool RecipeLoader::loadFromString(const std::string& jsonStr, Recipe& recipe) {
 
 		if (!indicator.name.empty()) {
 			recipe.indicators.push_back(indicator);
-			LOG_DEBUG("Added indicator: " + indicator.name + " (period=" + std::to_string(indicator.period) + ")");
+			LOG_DEBUG("Added indicator: " + indicator.name + " (period=" + std::to_string(indicator.period) +
+			          (indicator.timeframe.empty() ? "" : ", timeframe=" + indicator.timeframe) + ")");
 		}
 	}
 
 	// Parse entry conditions
-	recipe.entryConditions.logic = parser.getString("entry_conditions.logic", "AND");
+	std::string entryKey = key("entry_conditions", "entryConditions");
+	std::string entryRules = entryKey + ".rules";
+	recipe.entryConditions.logic = parser.getString(entryKey + ".logic", "AND");
 
-	size_t entryRuleCount = parser.getArraySize("entry_conditions.rules");
+	size_t entryRuleCount = parser.getArraySize(entryRules);
 	LOG_INFO("Found " + std::to_string(entryRuleCount) + " entry rules");
 
 	for (size_t i = 0; i < entryRuleCount; i++) {
 		TradingRule rule;
-		rule.indicator = parser.getArrayObjectString("entry_conditions.rules", i, "indicator", "");
-		rule.operatorStr = parser.getArrayObjectString("entry_conditions.rules", i, "operator", "");
-		rule.value = parser.getArrayObjectDouble("entry_conditions.rules", i, "value", 0.0);
-		rule.compareWith = parser.getArrayObjectString("entry_conditions.rules", i, "compare_with", "");
+		rule.indicator = parser.getArrayObjectString(entryRules, i, "indicator", "");
+		rule.operatorStr = parser.getArrayObjectString(entryRules, i, "operator", "");
+		rule.value = parser.getArrayObjectDouble(entryRules, i, "value", 0.0);
+		rule.compareWith = parser.getArrayObjectString(entryRules, i, "compare_with",
+			parser.getArrayObjectString(entryRules, i, "compareWith", ""));
 
 		if (!rule.indicator.empty() && !rule.operatorStr.empty()) {
 			recipe.entryConditions.rules.push_back(rule);
@@ -126,17 +139,20 @@ bool RecipeLoader::loadFromString(const std::string& jsonStr, Recipe& recipe) {
 	}
 
 	// Parse exit conditions
-	recipe.exitConditions.logic = parser.getString("exit_conditions.logic", "OR");
+	std::string exitKey = key("exit_conditions", "exitConditions");
+	std::string exitRules = exitKey + ".rules";
+	recipe.exitConditions.logic = parser.getString(exitKey + ".logic", "OR");
 
-	size_t exitRuleCount = parser.getArraySize("exit_conditions.rules");
+	size_t exitRuleCount = parser.getArraySize(exitRules);
 	LOG_INFO("Found " + std::to_string(exitRuleCount) + " exit rules");
 
 	for (size_t i = 0; i < exitRuleCount; i++) {
 		TradingRule rule;
-		rule.indicator = parser.getArrayObjectString("exit_conditions.rules", i, "indicator", "");
-		rule.operatorStr = parser.getArrayObjectString("exit_conditions.rules", i, "operator", "");
-		rule.value = parser.getArrayObjectDouble("exit_conditions.rules", i, "value", 0.0);
-		rule.compareWith = parser.getArrayObjectString("exit_conditions.rules", i, "compare_with", "");
+		rule.indicator = parser.getArrayObjectString(exitRules, i, "indicator", "");
+		rule.operatorStr = parser.getArrayObjectString(exitRules, i, "operator", "");
+		rule.value = parser.getArrayObjectDouble(exitRules, i, "value", 0.0);
+		rule.compareWith = parser.getArrayObjectString(exitRules, i, "compare_with",
+			parser.getArrayObjectString(exitRules, i, "compareWith", ""));
 
 		if (!rule.indicator.empty() && !rule.operatorStr.empty()) {
 			recipe.exitConditions.rules.push_back(rule);
@@ -194,6 +210,9 @@ bool RecipeLoader::saveToFile(const std::string& filename, const Recipe& recipe)
 		file << "    {\n";
 		file << "      \"name\": \"" << ind.name << "\",\n";
 		file << "      \"period\": " << ind.period;
+		if (!ind.timeframe.empty()) {
+			file << ",\n      \"timeframe\": \"" << ind.timeframe << "\"";
+		}
 
 		// Add params if any
 		for (const auto& [key, value] : ind.params) {
@@ -26,6 +26,7 @@ struct IndicatorConfig {
 	std::string name;               // e.g., "rsi", "sma", "ema", "macd", "bollinger"
 	int period;                     // Period for calculation (e.g., 14 for RSI)
 	std::map<std::string, double> params; // Additional parameters (e.g., {"overbought": 70, "oversold": 30})
+	std::string timeframe;          // Optional: higher timeframe (e.g., "1d"), empty = market timeframe
 };
 
 // Market configuration
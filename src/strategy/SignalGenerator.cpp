@@ -1,5 +1,8 @@
 #include "SignalGenerator.h"
+#include "../data/CandleResampler.h"
 #include "../utils/Logger.h"
+#include "../utils/LatencyTracker.h"
+#include <algorithm>
 #include <cmath>
 
 namespace Emiglio {
@@ -24,89 +27,226 @@ bool SignalGenerator::loadRecipe(const Recipe& recipe) {
 	return true;
 }
 
-// Calculate all indicators for the recipe
-bool SignalGenerator::calculateIndicators(const std::vector<Candle>& candles) {
-	if (candles.empty()) {
-		lastError = "No candles provided";
-		LOG_ERROR(lastError);
-		return false;
-	}
+// Calculate one indicator into 'output' (keys without timeframe suffix)
+void SignalGenerator::computeIndicator(const IndicatorConfig& indConfig,
+                                       const std::vector<Candle>& candles,
+                                       const std::vector<double>& closes,
+                                       std::map<std::string, std::vector<double>>& output) {
+	std::string name = indConfig.name;
+	int period = indConfig.period;
+
+	LOG_DEBUG("Calculating indicator: " + name + " (period=" + std::to_string(period) + ")");
+
+	if (name == "sma") {
+		output["sma"] = Indicators::sma(closes, period);
+
+	} else if (name == "ema") {
+		output["ema"] = Indicators::ema(closes, period);
+
+	} else if (name == "rsi") {
+		output["rsi"] = Indicators::rsi(closes, period);
+
+	} else if (name == "macd") {
+		int fastPeriod = 12;
+		int slowPeriod = 26;
+		int signalPeriod = 9;
+
+		// Allow custom periods from params
+		if (indConfig.params.count("fast_period")) fastPeriod = static_cast<int>(indConfig.params.at("fast_period"));
+		if (indConfig.params.count("slow_period")) slowPeriod = static_cast<int>(indConfig.params.at("slow_period"));
+		if (indConfig.params.count("signal_period")) signalPeriod = static_cast<int>(indConfig.params.at("signal_period"));
+
+		auto macdResult = Indicators::macd(closes, fastPeriod, slowPeriod, signalPeriod);
+		output["macd"] = macdResult.macdLine;
+		output["macd_signal"] = macdResult.signalLine;
+		output["macd_histogram"] = macdResult.histogram;
+		return;
+
+	} else if (name == "bollinger" || name == "bbands") {
+		double multiplier = 2.0;
+		if (indConfig.params.count("multiplier")) {
+			multiplier = indConfig.params.at("multiplier");
+		}
 
-	indicatorCache.clear();
+		auto bbResult = Indicators::bollingerBands(closes, period, multiplier);
+		output["bb_upper"] = bbResult.upper;
+		output["bb_middle"] = bbResult.middle;
+		output["bb_lower"] = bbResult.lower;
+		return;
 
-	// Extract price data
-	std::vector<double> closes = Indicators::getClosePrices(candles);
+	} else if (name == "atr") {
+		output["atr"] = Indicators::atr(candles, period);
 
-	// Always calculate closing prices (used by many rules)
-	indicatorCache["close"] = closes;
+	} else if (name == "stochastic" || name == "stoch") {
+		int kPeriod = period;
+		int dPeriod = 3;
+		if (indConfig.params.count("d_period")) {
+			dPeriod = static_cast<int>(indConfig.params.at("d_period"));
+		}
 
-	// Calculate each indicator defined in recipe
-	for (const auto& indConfig : recipe.indicators) {
-		std::string name = indConfig.name;
-		int period = indConfig.period;
+		auto stochResult = Indicators::stochastic(candles, kPeriod, dPeriod);
+		output["stoch_k"] = stochResult.k;
+		output["stoch_d"] = stochResult.d;
+		return;
 
-		LOG_DEBUG("Calculating indicator: " + name + " (period=" + std::to_string(period) + ")");
+	} else if (name == "obv") {
+		output["obv"] = Indicators::obv(candles);
+		return;
 
-		if (name == "sma") {
-			indicatorCache["sma"] = Indicators::sma(closes, period);
+	} else if (name == "adx") {
+		output["adx"] = Indicators::adx(candles, period);
 
-		} else if (name == "ema") {
-			indicatorCache["ema"] = Indicators::ema(closes, period);
+	} else if (name == "cci") {
+		output["cci"] = Indicators::cci(candles, period);
 
-		} else if (name == "rsi") {
-			indicatorCache["rsi"] = Indicators::rsi(closes, period);
+	} else {
+		LOG_WARNING("Unknown indicator: " + name);
+		return;
+	}
 
-		} else if (name == "macd") {
-			int fastPeriod = 12;
-			int slowPeriod = 26;
-			int signalPeriod = 9;
+	// Single-output indicators are also available as "<name>_<period>"
+	// so recipes can use several periods of the same indicator (e.g. ema_21, ema_50)
+	output[name + "_" + std::to_string(period)] = output[name];
+}
+
+// Build the base -> higher timeframe index map. For every base candle it holds
+// the index of the last higher timeframe candle that had already closed when
+// the base candle closed (-1 if none), so no value from the future is visible.
+std::vector<int> SignalGenerator::buildTimeframeIndexMap(const std::vector<Candle>& baseCandles,
+                                                         const std::string& baseTimeframe,
+                                                         const std::vector<Candle>& higherCandles,
+                                                         const std::string& higherTimeframe) {
+	std::vector<int> indexMap(baseCandles.size(), -1);
+
+	int64_t baseSeconds = CandleResampler::timeframeToSeconds(baseTimeframe);
+	if (baseSeconds <= 0 && baseCandles.size() > 1) {
+		baseSeconds = baseCandles[1].timestamp - baseCandles[0].timestamp;
+	}
+
+	// Two-pointer pass: both series are sorted, so the map is built in O(n + m)
+	size_t next = 0;
+	int last = -1;
+	for (size_t i = 0; i < baseCandles.size(); i++) {
+		time_t baseClose = baseCandles[i].timestamp + static_cast<time_t>(baseSeconds);
+		while (next < higherCandles.size() &&
+		       CandleResampler::nextBucketStart(higherCandles[next].timestamp, higherTimeframe) <= baseClose) {
+			last = static_cast<int>(next);
+			next++;
+		}
+		indexMap[i] = last;
+	}
 
-			// Allow custom periods from params
-			if (indConfig.params.count("fast_period")) fastPeriod = static_cast<int>(indConfig.params.at("fast_period"));
-			if (indConfig.params.count("slow_period")) slowPeriod = static_cast<int>(indConfig.params.at("slow_period"));
-			if (indConfig.params.count("signal_period")) signalPeriod = static_cast<int>(indConfig.params.at("signal_period"));
+	return indexMap;
+}
 
-			auto macdResult = Indicators::macd(closes, fastPeriod, slowPeriod, signalPeriod);
-			indicatorCache["macd"] = macdResult.macdLine;
-			indicatorCache["macd_signal"] = macdResult.signalLine;
-			indicatorCache["macd_histogram"] = macdResult.histogram;
+// Provide a higher timeframe series directly (e.g. loaded from storage with
+// more history than the base series). Without it the base candles are resampled.
+void SignalGenerator::setTimeframeCandles(const std::string& timeframe, const std::vector<Candle>& candles) {
+	timeframeSeries[timeframe] = candles;
+}
 
-		} else if (name == "bollinger" || name == "bbands") {
-			double multiplier = 2.0;
-			if (indConfig.params.count("multiplier")) {
-				multiplier = indConfig.params.at("multiplier");
+std::map<std::string, int> SignalGenerator::getTimeframeWarmup(const Recipe& recipe) {
+	std::map<std::string, int> warmup;
+	for (const auto& indConfig : recipe.indicators) {
+		if (indConfig.timeframe.empty()) {
+			continue;
+		}
+		int longest = indConfig.period;
+		for (const auto& [key, value] : indConfig.params) {
+			if (key.find("period") != std::string::npos) {
+				longest = std::max(longest, static_cast<int>(value));
 			}
+		}
+		int& candles = warmup[indConfig.timeframe];
+		candles = std::max(candles, 2 * longest);
+	}
+	return warmup;
+}
 
-			auto bbResult = Indicators::bollingerBands(closes, period, multiplier);
-			indicatorCache["bb_upper"] = bbResult.upper;
-			indicatorCache["bb_middle"] = bbResult.middle;
-			indicatorCache["bb_lower"] = bbResult.lower;
+// Calculate indicators declared on a higher timeframe and align them to base indices
+bool SignalGenerator::calculateTimeframeIndicators(const std::vector<Candle>& candles,
+                                                   const std::string& timeframe) {
+	if (!CandleResampler::canResample(recipe.market.timeframe, timeframe)) {
+		lastError = "Cannot derive " + timeframe + " indicators from " + recipe.market.timeframe + " candles";
+		LOG_ERROR(lastError);
+		return false;
+	}
 
-		} else if (name == "atr") {
-			indicatorCache["atr"] = Indicators::atr(candles, period);
+	std::vector<Candle> higherCandles;
+	auto seriesIt = timeframeSeries.find(timeframe);
+	if (seriesIt != timeframeSeries.end()) {
+		higherCandles = seriesIt->second;
+	} else {
+		higherCandles = CandleResampler::resample(candles, timeframe);
 
-		} else if (name == "stochastic" || name == "stoch") {
-			int kPeriod = period;
-			int dPeriod = 3;
-			if (indConfig.params.count("d_period")) {
-				dPeriod = static_cast<int>(indConfig.params.at("d_period"));
-			}
+		// A first bucket that starts before the base series is incomplete
+		if (!higherCandles.empty() && higherCandles.front().timestamp < candles.front().timestamp) {
+			higherCandles.erase(higherCandles.begin());
+		}
+	}
 
-			auto stochResult = Indicators::stochastic(candles, kPeriod, dPeriod);
-			indicatorCache["stoch_k"] = stochResult.k;
-			indicatorCache["stoch_d"] = stochResult.d;
+	std::vector<int>& indexMap = timeframeIndexMaps[timeframe];
+	indexMap = buildTimeframeIndexMap(candles, recipe.market.timeframe, higherCandles, timeframe);
 
-		} else if (name == "obv") {
-			indicatorCache["obv"] = Indicators::obv(candles);
+	std::map<std::string, std::vector<double>> higherValues;
+	std::vector<double> higherCloses = Indicators::getClosePrices(higherCandles);
+	higherValues["close"] = higherCloses;
 
-		} else if (name == "adx") {
-			indicatorCache["adx"] = Indicators::adx(candles, period);
+	for (const auto& indConfig : recipe.indicators) {
+		if (indConfig.timeframe == timeframe) {
+			computeIndicator(indConfig, higherCandles, higherCloses, higherValues);
+		}
+	}
 
-		} else if (name == "cci") {
-			indicatorCache["cci"] = Indicators::cci(candles, period);
+	// Materialize aligned series so rule evaluation stays a plain index lookup
+	for (const auto& [name, values] : higherValues) {
+		std::vector<double>& aligned = indicatorCache[name + "@" + timeframe];
+		aligned.resize(indexMap.size());
+		for (size_t i = 0; i < indexMap.size(); i++) {
+			int j = indexMap[i];
+			aligned[i] = (j >= 0 && static_cast<size_t>(j) < values.size()) ? values[j] : NAN;
+		}
+	}
 
-		} else {
-			LOG_WARNING("Unknown indicator: " + name);
+	LOG_DEBUG("Aligned " + std::to_string(higherValues.size()) + " " + timeframe +
+	          " series from " + std::to_string(higherCandles.size()) + " candles");
+	return true;
+}
+
+// Calculate all indicators for the recipe
+bool SignalGenerator::calculateIndicators(const std::vector<Candle>& candles) {
+	if (candles.empty()) {
+		lastError = "No candles provided";
+		LOG_ERROR(lastError);
+		return false;
+	}
+
+	indicatorCache.clear();
+	timeframeIndexMaps.clear();
+
+	// Extract price data
+	std::vector<double> closes = Indicators::getClosePrices(candles);
+
+	// Always calculate closing prices (used by many rules)
+	indicatorCache["close"] = closes;
+
+	// Calculate each indicator defined in recipe on the market timeframe
+	std::vector<std::string> higherTimeframes;
+	for (const auto& indConfig : recipe.indicators) {
+		if (!indConfig.timeframe.empty()) {
+			if (std::find(higherTimeframes.begin(), higherTimeframes.end(), indConfig.timeframe) == higherTimeframes.end()) {
+				higherTimeframes.push_back(indConfig.timeframe);
+			}
+			continue;
+		}
+
+		computeIndicator(indConfig, candles, closes, indicatorCache);
+	}
+
+	// Higher timeframe indicators are exposed as "<name>@<timeframe>" (e.g. "rsi@1d")
+	for (const auto& timeframe : higherTimeframes) {
+		if (!calculateTimeframeIndicators(candles, timeframe)) {
+			return false;
 		}
 	}
 
@@ -279,30 +419,45 @@ Signal SignalGenerator::generateSignal(const std::vector<Candle>& candles) {
 	signal.price = lastCandle.close;
 	signal.timestamp = lastCandle.timestamp;
 
+	// Live ticks carry their socket read time; time the stages for them
+	LatencyTracker& latency = LatencyTracker::getInstance();
+	bool timed = LatencyTracker::getTickOrigin() != 0 && latency.isEnabled();
+	int64_t start = timed ? LatencyTracker::now() : 0;
+
 	// Calculate indicators
 	if (!calculateIndicators(candles)) {
 		signal.reason = "Failed to calculate indicators";
 		return signal;
 	}
 
-	// Check entry conditions (BUY signal)
+	if (timed) {
+		int64_t calculated = LatencyTracker::now();
+		latency.record(LatencyStage::INDICATOR_UPDATE, calculated - start);
+		start = calculated;
+	}
+
 	if (checkEntryConditions(candles)) {
+		// Entry conditions (BUY signal)
 		signal.type = SignalType::BUY;
 		signal.reason = "Entry conditions met";
-		LOG_INFO("BUY signal generated for " + signal.symbol + " at " + std::to_string(signal.price));
-		return signal;
-	}
-
-	// Check exit conditions (SELL signal)
-	if (checkExitConditions(candles)) {
+	} else if (checkExitConditions(candles)) {
+		// Exit conditions (SELL signal)
 		signal.type = SignalType::SELL;
 		signal.reason = "Exit conditions met";
-		LOG_INFO("SELL signal generated for " + signal.symbol + " at " + std::to_string(signal.price));
-		return signal;
+	} else {
+		signal.reason = "No conditions met";
 	}
 
-	// No signal
-	signal.reason = "No conditions met";
+	if (timed) {
+		latency.recordSince(LatencyStage::SIGNAL_EVAL, start);
+		latency.recordTickToSignal();
+	}
+
+	if (signal.type == SignalType::BUY) {
+		LOG_INFO("BUY signal generated for " + signal.symbol + " at " + std::to_string(signal.price));
+	} else if (signal.type == SignalType::SELL) {
+		LOG_INFO("SELL signal generated for " + signal.symbol + " at " + std::to_string(signal.price));
+	}
 	return signal;
 }
 
@@ -57,6 +57,22 @@ public:
 	bool checkEntryConditionsAt(size_t index);
 	bool checkExitConditionsAt(size_t index);
 
+	// Use 'candles' for indicators declared on 'timeframe' instead of
+	// resampling the base candles
+	void setTimeframeCandles(const std::string& timeframe, const std::vector<Candle>& candles);
+
+	// Higher timeframes the recipe's indicators are declared on, each with
+	// the candles of history to load before the first base candle (twice
+	// the longest period on that timeframe)
+	static std::map<std::string, int> getTimeframeWarmup(const Recipe& recipe);
+
+	// For each base candle, index of the last higher timeframe candle closed
+	// at or before the base candle's close (-1 if none)
+	static std::vector<int> buildTimeframeIndexMap(const std::vector<Candle>& baseCandles,
+	                                               const std::string& baseTimeframe,
+	                                               const std::vector<Candle>& higherCandles,
+	                                               const std::string& higherTimeframe);
+
 	// Get current recipe
 	const Recipe& getRecipe() const { return recipe; }
 
@@ -70,9 +86,24 @@ private:
 	// Cache of calculated indicators
 	std::map<std::string, std::vector<double>> indicatorCache;
 
+	// Higher timeframe series supplied by the caller
+	std::map<std::string, std::vector<Candle>> timeframeSeries;
+
+	// Base index -> higher timeframe index, per timeframe
+	std::map<std::string, std::vector<int>> timeframeIndexMaps;
+
 	// Calculate all indicators for the recipe
 	bool calculateIndicators(const std::vector<Candle>& candles);
 
+	// Calculate a single indicator into 'output'
+	void computeIndicator(const IndicatorConfig& indConfig,
+	                      const std::vector<Candle>& candles,
+	                      const std::vector<double>& closes,
+	                      std::map<std::string, std::vector<double>>& output);
+
+	// Calculate indicators on 'timeframe' and align them to the base candles
+	bool calculateTimeframeIndicators(const std::vector<Candle>& candles, const std::string& timeframe);
+
 	// Evaluate a single rule
 	bool evaluateRule(const TradingRule& rule, size_t index);
 
@@ -0,0 +1,349 @@
+#include "../backtest/BacktestCache.h"
+#include "../data/DataStorage.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace Emiglio;
+using Emiglio::Backtest::BacktestCache;
+using Emiglio::Backtest::BacktestConfig;
+using Emiglio::Backtest::EquityPoint;
+using Emiglio::Backtest::TradeStatus;
+using Emiglio::Backtest::TradeType;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+const char* kDbPath = "/tmp/test_backtest_cache.db";
+
+Recipe makeRecipe() {
+    Recipe recipe;
+    recipe.name = "RSI test";
+    recipe.market = { "binance", "BTCUSDT", "1h" };
+    recipe.capital = { 1000.0, 50.0 };
+    recipe.risk = { 5.0, 10.0, 0.0, 1 };
+
+    IndicatorConfig rsi;
+    rsi.name = "rsi";
+    rsi.period = 14;
+    rsi.params["overbought"] = 70.0;
+    recipe.indicators.push_back(rsi);
+
+    recipe.entryConditions.logic = "AND";
+    recipe.entryConditions.rules.push_back({ "rsi", "<", 30.0, "" });
+    recipe.exitConditions.logic = "OR";
+    recipe.exitConditions.rules.push_back({ "rsi", ">", 70.0, "" });
+    return recipe;
+}
+
+std::vector<Candle> makeCandles(size_t count) {
+    std::vector<Candle> candles;
+    for (size_t i = 0; i < count; i++) {
+        Candle candle;
+        candle.exchange = "binance";
+        candle.symbol = "BTCUSDT";
+        candle.timeframe = "1h";
+        candle.timestamp = 1704067200 + static_cast<time_t>(i) * 3600;
+        candle.open = 100.0 + i;
+        candle.high = 101.0 + i;
+        candle.low = 99.0 + i;
+        candle.close = 100.5 + i;
+        candle.volume = 10.0;
+        candles.push_back(candle);
+    }
+    return candles;
+}
+
+Backtest::Trade makeTrade(int n) {
+    Backtest::Trade trade;
+    trade.id = "trade-" + std::to_string(n);
+    trade.symbol = "BTCUSDT";
+    trade.type = n % 2 ? TradeType::SHORT : TradeType::LONG;
+    trade.status = n % 2 ? TradeStatus::CANCELLED : TradeStatus::CLOSED;
+    trade.entryPrice = 100.25 + n;
+    trade.exitPrice = 105.5 + n;
+    trade.quantity = 0.125 * (n + 1);
+    trade.entryTime = 1704067200 + n * 7200;
+    trade.exitTime = 1704070800 + n * 7200;
+    trade.commission = 0.2 + n;
+    trade.slippage = 0.05 + n;
+    trade.pnl = n % 2 ? -3.75 : 4.5;
+    trade.pnlPercent = n % 2 ? -1.5 : 2.25;
+    trade.entryReason = "rsi < 30";
+    trade.exitReason = n % 2 ? "Stop-Loss" : "Signal \"exit\"\n";
+    trade.stopLossPrice = 95.0 + n;
+    trade.takeProfitPrice = 110.0 + n;
+    return trade;
+}
+
+// A result with every field set to a distinct value
+Backtest::BacktestResult makeResult(const std::string& name) {
+    Backtest::BacktestResult result;
+    result.recipeName = name;
+    result.symbol = "BTCUSDT";
+    result.startTime = 1704067200;
+    result.endTime = 1704153600;
+    result.totalCandles = 24;
+    result.initialCapital = 1000.0;
+    result.finalEquity = 1012.5;
+    result.peakEquity = 1020.75;
+    result.trades = { makeTrade(0), makeTrade(1) };
+    result.totalTrades = 2;
+    result.winningTrades = 1;
+    result.losingTrades = 1;
+    for (int i = 0; i < 24; i++) {
+        result.equityCurve.push_back(EquityPoint(1704067200 + i * 3600, 1000.0 + i, 900.0 - i, 100.0 + 2 * i));
+    }
+    result.totalCommission = 1.4;
+    result.totalSlippage = 0.3;
+    result.totalReturn = 1.25;
+    result.totalReturnPercent = 1.26;
+    result.annualizedReturn = 456.0;
+    result.sharpeRatio = 1.5;
+    result.sortinoRatio = 2.5;
+    result.maxDrawdown = 3.5;
+    result.maxDrawdownPercent = 3.6;
+    result.winRate = 50.0;
+    result.profitFactor = 1.2;
+    result.expectancy = 0.375;
+    result.averageWin = 4.5;
+    result.averageLoss = -3.75;
+    return result;
+}
+
+bool sameTrade(const Backtest::Trade& a, const Backtest::Trade& b) {
+    return a.id == b.id && a.symbol == b.symbol && a.type == b.type && a.status == b.status &&
+           a.entryPrice == b.entryPrice && a.exitPrice == b.exitPrice && a.quantity == b.quantity &&
+           a.entryTime == b.entryTime && a.exitTime == b.exitTime &&
+           a.commission == b.commission && a.slippage == b.slippage &&
+           a.pnl == b.pnl && a.pnlPercent == b.pnlPercent &&
+           a.entryReason == b.entryReason && a.exitReason == b.exitReason &&
+           a.stopLossPrice == b.stopLossPrice && a.takeProfitPrice == b.takeProfitPrice;
+}
+
+bool sameResult(const Backtest::BacktestResult& a, const Backtest::BacktestResult& b) {
+    if (a.trades.size() != b.trades.size() || a.equityCurve.size() != b.equityCurve.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.trades.size(); i++) {
+        if (!sameTrade(a.trades[i], b.trades[i])) return false;
+    }
+    for (size_t i = 0; i < a.equityCurve.size(); i++) {
+        const EquityPoint& p = a.equityCurve[i];
+        const EquityPoint& q = b.equityCurve[i];
+        if (p.timestamp != q.timestamp || p.equity != q.equity || p.cash != q.cash ||
+            p.positionValue != q.positionValue) {
+            return false;
+        }
+    }
+    return a.recipeName == b.recipeName && a.symbol == b.symbol &&
+           a.startTime == b.startTime && a.endTime == b.endTime && a.totalCandles == b.totalCandles &&
+           a.initialCapital == b.initialCapital && a.finalEquity == b.finalEquity &&
+           a.peakEquity == b.peakEquity && a.totalTrades == b.totalTrades &&
+           a.winningTrades == b.winningTrades && a.losingTrades == b.losingTrades &&
+           a.totalCommission == b.totalCommission && a.totalSlippage == b.totalSlippage &&
+           a.totalReturn == b.totalReturn && a.totalReturnPercent == b.totalReturnPercent &&
+           a.annualizedReturn == b.annualizedReturn && a.sharpeRatio == b.sharpeRatio &&
+           a.sortinoRatio == b.sortinoRatio && a.maxDrawdown == b.maxDrawdown &&
+           a.maxDrawdownPercent == b.maxDrawdownPercent && a.winRate == b.winRate &&
+           a.profitFactor == b.profitFactor && a.expectancy == b.expectancy &&
+           a.averageWin == b.averageWin && a.averageLoss == b.averageLoss;
+}
+
+// Test: every field and trade survives serialize/deserialize; damaged
+// data is rejected
+TEST(serialize_round_trip) {
+    Backtest::BacktestResult result = makeResult("Round trip");
+    std::string data = BacktestCache::serialize(result);
+
+    Backtest::BacktestResult loaded;
+    ASSERT_TRUE(BacktestCache::deserialize(data, loaded));
+    ASSERT_TRUE(sameResult(result, loaded));
+
+    // An empty result too
+    Backtest::BacktestResult empty;
+    ASSERT_TRUE(BacktestCache::deserialize(BacktestCache::serialize(empty), loaded));
+    ASSERT_TRUE(sameResult(empty, loaded));
+
+    // Truncated, extended or of another version: rejected, output untouched
+    Backtest::BacktestResult untouched = makeResult("Untouched");
+    ASSERT_FALSE(BacktestCache::deserialize(data.substr(0, data.size() - 1), untouched));
+    ASSERT_FALSE(BacktestCache::deserialize(data.substr(0, data.size() / 2), untouched));
+    ASSERT_FALSE(BacktestCache::deserialize(data + "x", untouched));
+    ASSERT_FALSE(BacktestCache::deserialize("", untouched));
+    std::string otherVersion = data;
+    otherVersion[0]++;
+    ASSERT_FALSE(BacktestCache::deserialize(otherVersion, untouched));
+    ASSERT_TRUE(untouched.recipeName == "Untouched");
+}
+
+// Test: keys are stable, and each part changes with its own input only
+TEST(key_sensitivity) {
+    Recipe recipe = makeRecipe();
+    BacktestConfig config;
+    std::vector<Candle> candles = makeCandles(100);
+
+    std::string key = BacktestCache::computeKey(recipe, config, candles);
+    ASSERT_TRUE(key.size() == 48);
+    ASSERT_TRUE(key == BacktestCache::computeKey(makeRecipe(), BacktestConfig(), makeCandles(100)));
+
+    // Recipe hash, config hash, candle fingerprint
+    auto part = [](const std::string& k, int i) { return k.substr(i * 16, 16); };
+    auto changed = [&](const Recipe& r, const BacktestConfig& c, const std::vector<Candle>& v, int expected) {
+        std::string other = BacktestCache::computeKey(r, c, v);
+        for (int i = 0; i < 3; i++) {
+            if ((part(other, i) != part(key, i)) != (i == expected)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    Recipe r = makeRecipe();
+    r.entryConditions.rules[0].value = 25.0;
+    ASSERT_TRUE(changed(r, config, candles, 0));
+    r = makeRecipe();
+    r.indicators[0].params["overbought"] = 75.0;
+    ASSERT_TRUE(changed(r, config, candles, 0));
+    r = makeRecipe();
+    r.indicators[0].timeframe = "4h";
+    ASSERT_TRUE(changed(r, config, candles, 0));
+    r = makeRecipe();
+    r.risk.stopLossPercent = 4.0;
+    ASSERT_TRUE(changed(r, config, candles, 0));
+    // Length-prefixed strings: moving a character between fields matters
+    r = makeRecipe();
+    r.entryConditions.rules[0].indicator = "rs";
+    r.entryConditions.rules[0].operatorStr = "i<";
+    ASSERT_TRUE(changed(r, config, candles, 0));
+
+    BacktestConfig c;
+    c.commissionPercent = 0.002;
+    ASSERT_TRUE(changed(recipe, c, candles, 1));
+    c = BacktestConfig();
+    c.useStopLoss = false;
+    ASSERT_TRUE(changed(recipe, c, candles, 1));
+    // -0.0 and 0.0 are the same setting
+    BacktestConfig zero;
+    zero.slippagePercent = 0.0;
+    BacktestConfig negativeZero;
+    negativeZero.slippagePercent = -0.0;
+    ASSERT_TRUE(BacktestCache::hashConfig(zero) == BacktestCache::hashConfig(negativeZero));
+
+    std::vector<Candle> v = makeCandles(100);
+    v[57].close += 0.01;
+    ASSERT_TRUE(changed(recipe, config, v, 2));
+    v = makeCandles(100);
+    v.pop_back();
+    ASSERT_TRUE(changed(recipe, config, v, 2));
+    v = makeCandles(100);
+    for (auto& candle : v) candle.symbol = "ETHUSDT";
+    ASSERT_TRUE(changed(recipe, config, v, 2));
+}
+
+// Test: memory keeps the 64 most recently used results (no database yet)
+TEST(lru_eviction) {
+    BacktestCache& cache = BacktestCache::getInstance();
+    cache.clear();
+
+    for (int i = 0; i < 64; i++) {
+        cache.put("key" + std::to_string(i), makeResult("Result " + std::to_string(i)));
+    }
+
+    // Using key0 makes key1 the oldest
+    Backtest::BacktestResult result;
+    ASSERT_TRUE(cache.get("key0", result));
+    ASSERT_TRUE(result.recipeName == "Result 0");
+    cache.put("key64", makeResult("Result 64"));
+
+    size_t misses = cache.getMisses();
+    ASSERT_FALSE(cache.get("key1", result));
+    ASSERT_TRUE(cache.getMisses() == misses + 1);
+    ASSERT_TRUE(cache.get("key0", result));
+    ASSERT_TRUE(cache.get("key64", result) && result.recipeName == "Result 64");
+    for (int i = 2; i < 64; i++) {
+        ASSERT_TRUE(cache.get("key" + std::to_string(i), result));
+    }
+
+    // Storing a key again replaces it without evicting another
+    cache.put("key2", makeResult("Result 2b"));
+    ASSERT_TRUE(cache.get("key2", result) && result.recipeName == "Result 2b");
+    ASSERT_TRUE(cache.get("key3", result));
+
+    cache.clear();
+    ASSERT_FALSE(cache.get("key0", result));
+}
+
+// Test: results are persisted in backtest_cache and read back from it
+// once they are no longer in memory
+TEST(reload_from_table) {
+    std::remove(kDbPath);
+    BacktestCache& cache = BacktestCache::getInstance();
+    ASSERT_TRUE(cache.init(kDbPath));
+
+    // Written by another process: only in the table
+    Backtest::BacktestResult stored = makeResult("From table");
+    {
+        DataStorage storage;
+        ASSERT_TRUE(storage.init(kDbPath));
+        ASSERT_TRUE(storage.insertBacktestCache("stored", stored.recipeName, BacktestCache::serialize(stored)));
+        ASSERT_TRUE(storage.insertBacktestCache("damaged", "Damaged", "not a result"));
+    }
+
+    Backtest::BacktestResult result;
+    size_t hits = cache.getHits();
+    ASSERT_TRUE(cache.get("stored", result));
+    ASSERT_TRUE(sameResult(stored, result));
+    ASSERT_TRUE(cache.getHits() == hits + 1);
+    ASSERT_FALSE(cache.get("damaged", result));
+
+    // Evicted from memory, still in the table
+    for (int i = 0; i < 70; i++) {
+        cache.put("key" + std::to_string(i), makeResult("Result " + std::to_string(i)));
+    }
+    ASSERT_TRUE(cache.get("key0", result) && result.recipeName == "Result 0");
+    ASSERT_TRUE(cache.get("stored", result) && sameResult(stored, result));
+    {
+        DataStorage storage;
+        ASSERT_TRUE(storage.init(kDbPath));
+        std::string data;
+        ASSERT_TRUE(storage.getBacktestCache("key5", data));
+        ASSERT_TRUE(BacktestCache::deserialize(data, result) && result.recipeName == "Result 5");
+    }
+
+    // clear() empties the table as well
+    cache.clear();
+    ASSERT_FALSE(cache.get("key0", result));
+    ASSERT_FALSE(cache.get("stored", result));
+
+    std::remove(kDbPath);
+}
+
+int main() {
+    std::cout << "=== Backtest Cache Tests ===" << std::endl;
+
+    RUN_TEST(serialize_round_trip);
+    RUN_TEST(key_sensitivity);
+    RUN_TEST(lru_eviction);
+    // Last: init() keeps the database for the rest of the process
+    RUN_TEST(reload_from_table);
+
+    std::cout << "\nAll backtest cache tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,268 @@
+#include "../backtest/BacktestJob.h"
+#include "../backtest/BacktestCache.h"
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace Emiglio;
+using Emiglio::Backtest::BacktestCache;
+using Emiglio::Backtest::BacktestConfig;
+using Emiglio::Backtest::BacktestJob;
+using Emiglio::Backtest::BacktestSimulator;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+// Hourly candles on a sine wave, so RSI crosses its bands now and then
+std::vector<Candle> makeCandles(size_t count) {
+    std::vector<Candle> candles;
+    for (size_t i = 0; i < count; i++) {
+        Candle candle;
+        candle.exchange = "binance";
+        candle.symbol = "BTCUSDT";
+        candle.timeframe = "1h";
+        candle.timestamp = 1704067200 + static_cast<time_t>(i) * 3600;
+        candle.open = 100.0 + 10.0 * std::sin(i / 10.0);
+        candle.close = 100.0 + 10.0 * std::sin((i + 1) / 10.0);
+        candle.high = std::max(candle.open, candle.close) + 0.5;
+        candle.low = std::min(candle.open, candle.close) - 0.5;
+        candle.volume = 10.0;
+        candles.push_back(candle);
+    }
+    return candles;
+}
+
+Recipe makeRecipe() {
+    Recipe recipe;
+    recipe.name = "RSI test";
+    recipe.market = { "binance", "BTCUSDT", "1h" };
+    recipe.capital = { 1000.0, 50.0 };
+    recipe.risk = { 5.0, 10.0, 0.0, 1 };
+
+    IndicatorConfig rsi;
+    rsi.name = "rsi";
+    rsi.period = 14;
+    recipe.indicators.push_back(rsi);
+
+    recipe.entryConditions.logic = "AND";
+    recipe.entryConditions.rules.push_back({ "rsi", "<", 30.0, "" });
+    recipe.exitConditions.logic = "OR";
+    recipe.exitConditions.rules.push_back({ "rsi", ">", 70.0, "" });
+    return recipe;
+}
+
+// Test: a run whose indicators can't be calculated fails and isn't cached
+TEST(failed_run_not_cached) {
+    Recipe recipe = makeRecipe();
+    // 15m values can't be derived from 1h candles
+    recipe.indicators[0].timeframe = "15m";
+    recipe.entryConditions.rules[0].indicator = "rsi@15m";
+
+    std::vector<Candle> candles = makeCandles(500);
+    BacktestConfig config;
+    std::string key = BacktestCache::computeKey(recipe, config, candles);
+
+    BacktestJob job(recipe, config);
+    job.setCandles(candles);
+    ASSERT_TRUE(job.start());
+    job.wait();
+
+    ASSERT_TRUE(job.getState() == BacktestJob::State::FAILED);
+    ASSERT_TRUE(job.getLastError().find("15m") != std::string::npos);
+    Backtest::BacktestResult result;
+    ASSERT_FALSE(BacktestCache::getInstance().get(key, result));
+}
+
+// Test: a supplied higher timeframe series reaches the simulator and the key
+TEST(timeframe_candles) {
+    Recipe recipe = makeRecipe();
+    IndicatorConfig sma;
+    sma.name = "sma";
+    sma.period = 3;
+    sma.timeframe = "1d";
+    recipe.indicators.push_back(sma);
+    recipe.entryConditions.rules[0] = { "sma_3@1d", ">", 0.0, "" };
+    recipe.exitConditions.rules[0] = { "close", "<", 0.0, "" };
+
+    std::vector<Candle> candles = makeCandles(500);
+    std::vector<Candle> daily;
+    for (int i = 0; i < 10; i++) {
+        Candle candle = candles[0];
+        candle.timeframe = "1d";
+        candle.timestamp = candles[0].timestamp - (10 - i) * 86400;
+        daily.push_back(candle);
+    }
+
+    BacktestJob resampled(recipe, BacktestConfig());
+    resampled.setCandles(candles);
+    ASSERT_TRUE(resampled.start());
+    resampled.wait();
+
+    BacktestJob supplied(recipe, BacktestConfig());
+    supplied.setCandles(candles);
+    supplied.setTimeframeCandles("1d", daily);
+    ASSERT_TRUE(supplied.start());
+    supplied.wait();
+
+    ASSERT_TRUE(resampled.getState() == BacktestJob::State::COMPLETED);
+    ASSERT_TRUE(supplied.getState() == BacktestJob::State::COMPLETED);
+    ASSERT_TRUE(supplied.getCacheKey() != resampled.getCacheKey());
+    ASSERT_TRUE(supplied.getCacheKey().substr(0, 32) == resampled.getCacheKey().substr(0, 32));
+
+    // Resampled, three days must close first; the supplied days are warm
+    ASSERT_FALSE(resampled.getResult().trades.empty());
+    ASSERT_FALSE(supplied.getResult().trades.empty());
+    ASSERT_TRUE(supplied.getResult().trades[0].entryTime < candles[23].timestamp);
+    ASSERT_TRUE(resampled.getResult().trades[0].entryTime >= candles[71].timestamp);
+}
+
+// Test: the simulator reports after pre-calculation and every block
+TEST(simulator_progress) {
+    std::vector<Candle> candles = makeCandles(5500);
+    BacktestSimulator simulator(makeRecipe(), BacktestConfig());
+    std::vector<size_t> reported;
+    simulator.setProgressCallback([&reported](size_t processed, size_t total) {
+        ASSERT_TRUE(total == 5500);
+        reported.push_back(processed);
+        return true;
+    }, 1000);
+
+    Backtest::BacktestResult result = simulator.run(candles);
+    ASSERT_FALSE(result.cancelled);
+    ASSERT_TRUE(simulator.getLastError().empty());
+    ASSERT_TRUE(reported == std::vector<size_t>({ 0, 1000, 2000, 3000, 4000, 5000, 5500 }));
+}
+
+// Test: returning false stops the run at the end of that block
+TEST(simulator_cancel) {
+    std::vector<Candle> candles = makeCandles(5500);
+    std::vector<size_t> reported;
+    BacktestSimulator simulator(makeRecipe(), BacktestConfig());
+    simulator.setProgressCallback([&reported](size_t processed, size_t) {
+        reported.push_back(processed);
+        return processed < 2000;
+    }, 1000);
+
+    Backtest::BacktestResult result = simulator.run(candles);
+    ASSERT_TRUE(result.cancelled);
+    ASSERT_TRUE(simulator.getLastError() == "Backtest cancelled");
+    ASSERT_TRUE(reported == std::vector<size_t>({ 0, 1000, 2000 }));
+
+    // A cancel that came in during pre-calculation: no candle is processed
+    reported.clear();
+    simulator.setProgressCallback([&reported](size_t processed, size_t) {
+        reported.push_back(processed);
+        return false;
+    }, 1000);
+    result = simulator.run(candles);
+    ASSERT_TRUE(result.cancelled);
+    ASSERT_TRUE(result.trades.empty());
+    ASSERT_TRUE(reported == std::vector<size_t>({ 0 }));
+
+    // The next run starts over
+    simulator.setProgressCallback(nullptr);
+    result = simulator.run(candles);
+    ASSERT_FALSE(result.cancelled);
+    ASSERT_TRUE(simulator.getLastError().empty());
+}
+
+// Test: job progress never goes back and ends at 100%
+TEST(progress_monotonic) {
+    std::vector<Candle> candles = makeCandles(50000);
+    std::vector<double> percents;
+    std::mutex mutex;
+
+    BacktestJob job(makeRecipe(), BacktestConfig());
+    job.setCandles(candles);
+    job.setUseCache(false);
+    job.setProgressCallback([&](double percent, const std::string&) {
+        std::lock_guard<std::mutex> lock(mutex);
+        percents.push_back(percent);
+    });
+    ASSERT_TRUE(job.start());
+    job.wait();
+
+    ASSERT_TRUE(job.getState() == BacktestJob::State::COMPLETED);
+    ASSERT_FALSE(job.getResult().cancelled);
+    ASSERT_TRUE(percents.size() > 10);
+    ASSERT_TRUE(std::is_sorted(percents.begin(), percents.end()));
+    ASSERT_TRUE(percents.front() >= 0.0);
+    ASSERT_TRUE(percents.back() == 100.0);
+}
+
+// Test: cancel() stops the simulation between blocks and nothing is cached
+TEST(cancel_not_cached) {
+    std::vector<Candle> candles = makeCandles(50000);
+    BacktestConfig config;
+    config.initialCapital = 1234.0;  // A key no other test has stored
+    std::string key = BacktestCache::computeKey(makeRecipe(), config, candles);
+
+    BacktestJob job(makeRecipe(), config);
+    job.setCandles(candles);
+    double last = 0.0;
+    job.setProgressCallback([&job, &last](double percent, const std::string&) {
+        last = percent;
+        if (percent >= 50.0) {
+            job.cancel();
+        }
+    });
+    ASSERT_TRUE(job.start());
+    job.wait();
+
+    ASSERT_TRUE(job.getState() == BacktestJob::State::CANCELLED);
+    ASSERT_TRUE(job.getResult().cancelled);
+    ASSERT_TRUE(job.isCancelled());
+    ASSERT_TRUE(last < 90.0);  // Stopped before analysis
+    ASSERT_TRUE(job.getCacheKey() == key);
+    Backtest::BacktestResult result;
+    ASSERT_FALSE(BacktestCache::getInstance().get(key, result));
+
+    // Cancelled before it started: nothing runs
+    BacktestJob early(makeRecipe(), config);
+    early.setCandles(candles);
+    early.cancel();
+    ASSERT_TRUE(early.start());
+    early.wait();
+    ASSERT_TRUE(early.getState() == BacktestJob::State::CANCELLED);
+    ASSERT_FALSE(BacktestCache::getInstance().get(key, result));
+
+    // The same run, not cancelled, is cached
+    BacktestJob full(makeRecipe(), config);
+    full.setCandles(candles);
+    ASSERT_TRUE(full.start());
+    full.wait();
+    ASSERT_TRUE(full.getState() == BacktestJob::State::COMPLETED);
+    ASSERT_TRUE(BacktestCache::getInstance().get(key, result));
+}
+
+int main() {
+    std::cout << "=== Backtest Job Tests ===" << std::endl;
+
+    RUN_TEST(failed_run_not_cached);
+    RUN_TEST(timeframe_candles);
+    RUN_TEST(simulator_progress);
+    RUN_TEST(simulator_cancel);
+    RUN_TEST(progress_monotonic);
+    RUN_TEST(cancel_not_cached);
+
+    std::cout << "\nAll backtest job tests passed!" << std::endl;
+    return 0;
+}
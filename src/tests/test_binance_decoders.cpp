@@ -0,0 +1,299 @@
+#include "../exchange/BinanceRestDecoder.h"
+#include "../exchange/BinanceStreamDecoder.h"
+#include "../utils/FastNumber.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+bool parse(const char* str, double& value) {
+    return FastNumber::parseDouble(str, std::strlen(str), value);
+}
+
+// Test: fast path must agree bit-for-bit with strtod
+TEST(fast_double) {
+    double value = 0.0;
+    ASSERT_TRUE(parse("42123.45000000", value) && value == 42123.45);
+    ASSERT_TRUE(parse("0.00001000", value) && value == 0.00001);
+    ASSERT_TRUE(parse("-1.5", value) && value == -1.5);
+    ASSERT_TRUE(parse("100000000.00000000", value) && value == 1e8);
+    ASSERT_TRUE(parse("1e-7", value) && value == 1e-7);
+    ASSERT_TRUE(parse("12345678901234567890.5", value) && value == std::strtod("12345678901234567890.5", nullptr));
+    ASSERT_TRUE(parse("0", value) && value == 0.0);
+
+    ASSERT_FALSE(parse("", value));
+    ASSERT_FALSE(parse("abc", value));
+    ASSERT_FALSE(parse("1.2.3", value));
+    ASSERT_FALSE(parse("1e", value));
+
+    // Random 8-decimal prices, as Binance formats them
+    std::mt19937_64 rng(42);
+    char buffer[64];
+    for (int i = 0; i < 100000; i++) {
+        unsigned long long whole = rng() % 10000000ULL;
+        unsigned long long fraction = rng() % 100000000ULL;
+        snprintf(buffer, sizeof(buffer), "%llu.%08llu", whole, fraction);
+        ASSERT_TRUE(parse(buffer, value));
+        ASSERT_TRUE(value == std::strtod(buffer, nullptr));
+    }
+
+    int64_t integer = 0;
+    const char* ts = "1704067200000";
+    ASSERT_TRUE(FastNumber::parseInt64(ts, ts + std::strlen(ts), integer) && integer == 1704067200000LL);
+}
+
+// Test: kline arrays
+TEST(klines) {
+    std::string json =
+        "[[1704067200000,\"42283.58000000\",\"42554.57000000\",\"42261.02000000\",\"42475.23000000\","
+        "\"1271.68108000\",1704070799999,\"53957248.97050730\",47134,\"682.57581000\",\"28957416.81997000\",\"0\"],"
+        "[1704070800000,\"42475.23000000\",\"42775.00000000\",\"42431.65000000\",\"42613.56000000\","
+        "\"1196.37856000\",1704074399999,\"50984893.07558360\",44634,\"630.55658000\",\"26870828.03946770\",\"0\"]]";
+
+    BinanceRestDecoder decoder;
+    std::vector<Candle> candles;
+    ASSERT_TRUE(decoder.decodeKlines(json, candles, "BTCUSDT", "1h"));
+    ASSERT_TRUE(candles.size() == 2);
+    ASSERT_TRUE(candles[0].timestamp == 1704067200);
+    ASSERT_TRUE(candles[0].open == 42283.58);
+    ASSERT_TRUE(candles[0].high == 42554.57);
+    ASSERT_TRUE(candles[0].low == 42261.02);
+    ASSERT_TRUE(candles[0].close == 42475.23);
+    ASSERT_TRUE(candles[0].volume == 1271.68108);
+    ASSERT_TRUE(candles[1].timestamp == 1704070800);
+    ASSERT_TRUE(candles[1].symbol == "BTCUSDT");
+    ASSERT_TRUE(candles[1].timeframe == "1h");
+
+    std::string empty = "[]";
+    candles.clear();
+    ASSERT_TRUE(decoder.decodeKlines(empty, candles, "BTCUSDT"));
+    ASSERT_TRUE(candles.empty());
+}
+
+// Test: error bodies and malformed input leave the output untouched
+TEST(errors) {
+    BinanceRestDecoder decoder;
+    std::vector<Candle> candles;
+
+    std::string error = "{\"code\":-1121,\"msg\":\"Invalid symbol.\"}";
+    ASSERT_FALSE(decoder.decodeKlines(error, candles, "NOPE"));
+    ASSERT_TRUE(decoder.getLastError() == "Binance error -1121: Invalid symbol.");
+
+    std::string truncated = "[[1704067200000,\"1.0\",\"2.0\",\"0.5\",\"1.5\",\"10.0\"],[1704070800000,\"1.0\"";
+    ASSERT_FALSE(decoder.decodeKlines(truncated, candles, "BTCUSDT"));
+    ASSERT_TRUE(candles.empty());
+
+    std::string badNumber = "[[1704067200000,\"1.0\",\"x\",\"0.5\",\"1.5\",\"10.0\"]]";
+    ASSERT_FALSE(decoder.decodeKlines(badNumber, candles, "BTCUSDT"));
+
+    std::string empty;
+    ASSERT_FALSE(decoder.decodeKlines(empty, candles, "BTCUSDT"));
+
+    std::vector<Ticker> tickers;
+    std::string tickerError = "{\"code\":-1003,\"msg\":\"Too many requests.\"}";
+    ASSERT_FALSE(decoder.decodeTickers(tickerError, tickers));
+    ASSERT_TRUE(tickers.empty());
+}
+
+// Test: single and batch 24h tickers
+TEST(tickers) {
+    std::string one =
+        "{\"symbol\":\"BTCUSDT\",\"priceChange\":\"-94.99999800\",\"priceChangePercent\":\"-0.224\","
+        "\"weightedAvgPrice\":\"42335.1\",\"lastPrice\":\"42250.01000000\",\"bidQty\":\"1.0\","
+        "\"highPrice\":\"42700.00000000\",\"lowPrice\":\"41950.00000000\",\"volume\":\"24567.12300000\","
+        "\"quoteVolume\":\"1040000000.50000000\",\"openTime\":1704000000000,\"count\":76}";
+
+    BinanceRestDecoder decoder;
+    Ticker ticker;
+    ASSERT_TRUE(decoder.decodeTicker(one, ticker));
+    ASSERT_TRUE(ticker.symbol == "BTCUSDT");
+    ASSERT_TRUE(ticker.lastPrice == 42250.01);
+    ASSERT_TRUE(ticker.priceChange == -94.999998);
+    ASSERT_TRUE(ticker.priceChangePercent == -0.224);
+    ASSERT_TRUE(ticker.highPrice == 42700.0);
+    ASSERT_TRUE(ticker.lowPrice == 41950.0);
+    ASSERT_TRUE(ticker.volume == 24567.123);
+    ASSERT_TRUE(ticker.quoteVolume == 1040000000.5);
+
+    std::string many =
+        "[{\"symbol\":\"ETHBTC\",\"lastPrice\":\"0.05\",\"volume\":\"10\"},"
+        "{\"symbol\":\"BNBBTC\",\"lastPrice\":\"0.007\",\"nested\":{\"lastPrice\":\"9\"}}]";
+    std::vector<Ticker> tickers;
+    ASSERT_TRUE(decoder.decodeTickers(many, tickers));
+    ASSERT_TRUE(tickers.size() == 2);
+    ASSERT_TRUE(tickers[0].symbol == "ETHBTC" && tickers[0].lastPrice == 0.05 && tickers[0].volume == 10.0);
+    ASSERT_TRUE(tickers[1].symbol == "BNBBTC" && tickers[1].lastPrice == 0.007 && tickers[1].volume == 0.0);
+}
+
+// Test: depth snapshot
+TEST(depth) {
+    std::string json =
+        "{\"lastUpdateId\":1027024,\"bids\":[[\"4.00000000\",\"431.00000000\"],[\"3.99000000\",\"9.00000000\"]],"
+        "\"asks\":[[\"4.00000200\",\"12.00000000\"]]}";
+
+    BinanceRestDecoder decoder;
+    OrderBook book;
+    ASSERT_TRUE(decoder.decodeDepth(json, book));
+    ASSERT_TRUE(book.lastUpdateId == 1027024);
+    ASSERT_TRUE(book.bids.size() == 2);
+    ASSERT_TRUE(book.asks.size() == 1);
+    ASSERT_TRUE(book.bids[0].price == 4.0 && book.bids[0].quantity == 431.0);
+    ASSERT_TRUE(book.bids[1].price == 3.99 && book.bids[1].quantity == 9.0);
+    ASSERT_TRUE(book.asks[0].price == 4.000002 && book.asks[0].quantity == 12.0);
+}
+
+// Test: symbol interning
+TEST(symbol_table) {
+    SymbolTable table;
+    uint32_t btc = table.intern("BTCUSDT");
+    uint32_t eth = table.intern("ETHUSDT");
+    ASSERT_TRUE(btc == 0 && eth == 1);
+    ASSERT_TRUE(table.intern("BTCUSDT") == btc);
+    ASSERT_TRUE(table.find("ETHUSDT", 7) == eth);
+    ASSERT_TRUE(table.find("ETHUSD", 6) == SymbolTable::kNotFound);
+
+    // IDs survive rehashing
+    for (int i = 0; i < 1000; i++) {
+        table.intern("SYM" + std::to_string(i));
+    }
+    ASSERT_TRUE(table.find("BTCUSDT") == btc);
+    ASSERT_TRUE(table.name(table.find("SYM999")) == "SYM999");
+    ASSERT_TRUE(table.size() == 1002);
+}
+
+// Test: trade and aggTrade events, routed by stream ID
+TEST(stream_trades) {
+    BinanceStreamDecoder decoder;
+    uint32_t tradeStream = decoder.internStream("btcusdt@trade");
+
+    std::string trade =
+        "{\"stream\":\"btcusdt@trade\",\"data\":{\"e\":\"trade\",\"E\":1704067260123,\"s\":\"BTCUSDT\","
+        "\"t\":3456789012,\"p\":\"42283.58000000\",\"q\":\"0.01200000\",\"T\":1704067260120,"
+        "\"m\":true,\"M\":true}}";
+    StreamEvent event;
+    ASSERT_TRUE(decoder.decode(trade, event));
+    ASSERT_TRUE(event.type == StreamEventType::TRADE);
+    ASSERT_TRUE(event.streamId == tradeStream);
+    ASSERT_TRUE(decoder.symbolName(event.symbolId) == "BTCUSDT");
+    ASSERT_TRUE(event.eventTime == 1704067260123LL);
+    ASSERT_TRUE(event.trade.tradeId == 3456789012LL);
+    ASSERT_TRUE(event.trade.price == 42283.58);
+    ASSERT_TRUE(event.trade.quantity == 0.012);
+    ASSERT_TRUE(event.trade.tradeTime == 1704067260120LL);
+    ASSERT_TRUE(event.trade.isBuyerMaker);
+
+    // Raw payload of an unregistered stream
+    std::string aggTrade =
+        "{\"e\":\"aggTrade\",\"E\":123456789,\"s\":\"ETHUSDT\",\"a\":12345,\"p\":\"0.001\",\"q\":\"100\","
+        "\"f\":100,\"l\":105,\"T\":123456785,\"m\":false,\"M\":true}";
+    ASSERT_TRUE(decoder.decode(aggTrade, event));
+    ASSERT_TRUE(event.type == StreamEventType::AGG_TRADE);
+    ASSERT_TRUE(event.streamId == SymbolTable::kNotFound);
+    ASSERT_TRUE(decoder.symbolName(event.symbolId) == "ETHUSDT");
+    ASSERT_TRUE(event.trade.tradeId == 12345);
+    ASSERT_TRUE(event.trade.firstTradeId == 100 && event.trade.lastTradeId == 105);
+    ASSERT_FALSE(event.trade.isBuyerMaker);
+}
+
+// Test: kline, ticker and depth events
+TEST(stream_market_data) {
+    BinanceStreamDecoder decoder;
+    StreamEvent event;
+
+    std::string kline =
+        "{\"stream\":\"btcusdt@kline_1m\",\"data\":{\"e\":\"kline\",\"E\":1704067260000,\"s\":\"BTCUSDT\","
+        "\"k\":{\"t\":1704067200000,\"T\":1704067259999,\"s\":\"BTCUSDT\",\"i\":\"1m\",\"f\":100,\"L\":200,"
+        "\"o\":\"42283.58\",\"c\":\"42290.01\",\"h\":\"42300.00\",\"l\":\"42280.00\",\"v\":\"12.5\","
+        "\"n\":100,\"x\":true,\"q\":\"528000.1\",\"V\":\"1\",\"Q\":\"2\",\"B\":\"0\"}}}";
+    ASSERT_TRUE(decoder.decode(kline, event));
+    ASSERT_TRUE(event.type == StreamEventType::KLINE);
+    ASSERT_TRUE(std::string(event.kline.interval) == "1m");
+    ASSERT_TRUE(event.kline.openTime == 1704067200000LL);
+    ASSERT_TRUE(event.kline.closeTime == 1704067259999LL);
+    ASSERT_TRUE(event.kline.open == 42283.58 && event.kline.close == 42290.01);
+    ASSERT_TRUE(event.kline.high == 42300.0 && event.kline.low == 42280.0);
+    ASSERT_TRUE(event.kline.volume == 12.5 && event.kline.tradeCount == 100);
+    ASSERT_TRUE(event.kline.isClosed);
+
+    std::string ticker =
+        "{\"e\":\"24hrTicker\",\"E\":123456789,\"s\":\"BNBBTC\",\"p\":\"0.0015\",\"P\":\"250.00\","
+        "\"c\":\"0.0025\",\"b\":\"0.0024\",\"a\":\"0.0026\",\"o\":\"0.0010\",\"h\":\"0.0025\","
+        "\"l\":\"0.0010\",\"v\":\"10000\",\"q\":\"18\",\"n\":18151}";
+    ASSERT_TRUE(decoder.decode(ticker, event));
+    ASSERT_TRUE(event.type == StreamEventType::TICKER);
+    ASSERT_TRUE(event.ticker.lastPrice == 0.0025 && event.ticker.priceChangePercent == 250.0);
+    ASSERT_TRUE(event.ticker.bidPrice == 0.0024 && event.ticker.askPrice == 0.0026);
+
+    std::string depth =
+        "{\"stream\":\"btcusdt@depth@100ms\",\"data\":{\"e\":\"depthUpdate\",\"E\":123456789,"
+        "\"s\":\"BTCUSDT\",\"U\":157,\"u\":160,\"b\":[[\"0.0024\",\"10\"],[\"0.0023\",\"0\"]],"
+        "\"a\":[[\"0.0026\",\"100\"]]}}";
+    ASSERT_TRUE(decoder.decode(depth, event));
+    ASSERT_TRUE(event.type == StreamEventType::DEPTH_UPDATE);
+    ASSERT_TRUE(event.depth.firstUpdateId == 157 && event.depth.finalUpdateId == 160);
+    ASSERT_TRUE(event.depth.prevFinalUpdateId == -1);
+    ASSERT_TRUE(event.depth.bids.size() == 2 && event.depth.asks.size() == 1);
+    ASSERT_TRUE(event.depth.bids[1].price == 0.0023 && event.depth.bids[1].quantity == 0.0);
+    ASSERT_TRUE(event.depth.asks[0].price == 0.0026 && event.depth.asks[0].quantity == 100.0);
+
+    // Fields of the previous message must not leak into the next
+    std::string sparse = "{\"e\":\"depthUpdate\",\"s\":\"BTCUSDT\",\"U\":161,\"u\":161,\"pu\":160}";
+    ASSERT_TRUE(decoder.decode(sparse, event));
+    ASSERT_TRUE(event.depth.bids.empty() && event.depth.asks.empty());
+    ASSERT_TRUE(event.depth.prevFinalUpdateId == 160);
+    ASSERT_TRUE(event.eventTime == 0);
+}
+
+// Test: replies, malformed messages and unknown events
+TEST(stream_errors) {
+    BinanceStreamDecoder decoder;
+    StreamEvent event;
+
+    ASSERT_TRUE(decoder.decode(std::string("{\"result\":null,\"id\":1}"), event));
+    ASSERT_TRUE(event.type == StreamEventType::UNKNOWN);
+
+    ASSERT_FALSE(decoder.decode(std::string("{\"stream\":\"x\",\"data\":{\"e\":\"trade\""), event));
+    ASSERT_FALSE(decoder.decode(std::string("{\"e\":\"outboundAccountPosition\"}"), event));
+    ASSERT_FALSE(decoder.decode(std::string("[1,2]"), event));
+    ASSERT_FALSE(decoder.decode(std::string(""), event));
+}
+
+int main() {
+    std::cout << "=== Binance Decoder Tests ===" << std::endl;
+
+    RUN_TEST(fast_double);
+    RUN_TEST(klines);
+    RUN_TEST(errors);
+    RUN_TEST(tickers);
+    RUN_TEST(depth);
+    RUN_TEST(symbol_table);
+    RUN_TEST(stream_trades);
+    RUN_TEST(stream_market_data);
+    RUN_TEST(stream_errors);
+
+    std::cout << "\nAll decoder tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include "../data/CandleCache.h"
+#include "../data/DataStorage.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+const char* kDbPath = "/tmp/test_candle_cache.db";
+const time_t kStart = 1704067200;  // 2024-01-01 00:00 UTC
+
+std::vector<Candle> makeCandles(const std::string& symbol, time_t start, int count, double price = 100.0) {
+    std::vector<Candle> candles;
+    for (int i = 0; i < count; i++) {
+        Candle candle;
+        candle.exchange = "binance";
+        candle.symbol = symbol;
+        candle.timeframe = "1h";
+        candle.timestamp = start + static_cast<time_t>(i) * 3600;
+        candle.open = candle.high = candle.low = candle.close = price + i;
+        candle.volume = 1.0;
+        candles.push_back(candle);
+    }
+    return candles;
+}
+
+// Fresh database with 1000 hourly BTCUSDT candles, and an empty cache
+void setUp(DataStorage& storage) {
+    CandleCache::getInstance().clear();
+    std::remove(kDbPath);
+    ASSERT_TRUE(storage.init(kDbPath));
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", kStart, 1000)));
+}
+
+time_t hour(int index) {
+    return kStart + static_cast<time_t>(index) * 3600;
+}
+
+// Test: a repeated or narrower request doesn't reach SQLite
+TEST(hits) {
+    DataStorage storage;
+    setUp(storage);
+    CandleCache& cache = CandleCache::getInstance();
+    CandleCache::Stats before = cache.getStats();
+
+    CandleSeries first = cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(100), hour(399));
+    ASSERT_TRUE(first.size() == 300);
+    ASSERT_TRUE(first.front().timestamp == hour(100) && first.back().timestamp == hour(399));
+
+    CandleSeries again = cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(100), hour(399));
+    CandleSeries inner = cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(150) + 1, hour(160));
+    ASSERT_TRUE(again.begin() == first.begin());  // Same candles, shared
+    ASSERT_TRUE(inner.size() == 10 && inner.front().timestamp == hour(151));
+
+    CandleCache::Stats after = cache.getStats();
+    ASSERT_TRUE(after.misses - before.misses == 1);
+    ASSERT_TRUE(after.hits - before.hits == 2);
+    ASSERT_TRUE(after.storageReads - before.storageReads == 1);
+    ASSERT_TRUE(after.segments == 1);
+
+    // Another database is another series
+    DataStorage other;
+    std::remove("/tmp/test_candle_cache_other.db");
+    ASSERT_TRUE(other.init("/tmp/test_candle_cache_other.db"));
+    ASSERT_TRUE(cache.getCandles(other, "binance", "BTCUSDT", "1h", hour(100), hour(399)).empty());
+    other.close();
+    std::remove("/tmp/test_candle_cache_other.db");
+
+    storage.close();
+}
+
+// Test: overlapping requests merge into one segment, reading only the gaps
+TEST(range_merge) {
+    DataStorage storage;
+    setUp(storage);
+    CandleCache& cache = CandleCache::getInstance();
+
+    cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(0), hour(99));
+    cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(200), hour(299));
+    ASSERT_TRUE(cache.getStats().segments == 2);
+
+    CandleCache::Stats before = cache.getStats();
+    CandleSeries merged = cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(50), hour(349));
+    ASSERT_TRUE(merged.size() == 300);
+    for (size_t i = 1; i < merged.size(); i++) {
+        ASSERT_TRUE(merged[i].timestamp == merged[i - 1].timestamp + 3600);
+    }
+    CandleCache::Stats after = cache.getStats();
+    ASSERT_TRUE(after.storageReads - before.storageReads == 2);  // 100..199 and 300..349
+    ASSERT_TRUE(after.segments == 1);
+
+    before = after;
+    ASSERT_TRUE(cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(0), hour(349)).size() == 350);
+    ASSERT_TRUE(cache.getStats().hits - before.hits == 1);
+
+    storage.close();
+}
+
+// Test: writes through any DataStorage drop what they touch; readers keep
+// the candles they were given
+TEST(invalidation) {
+    DataStorage storage;
+    setUp(storage);
+    CandleCache& cache = CandleCache::getInstance();
+
+    CandleSeries btc = cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(0), hour(99));
+    ASSERT_TRUE(storage.insertCandles(makeCandles("ETHUSDT", kStart, 100)));
+    CandleSeries eth = cache.getCandles(storage, "binance", "ETHUSDT", "1h", hour(0), hour(99));
+    ASSERT_TRUE(cache.getStats().segments == 2);
+
+    DataStorage writer;
+    ASSERT_TRUE(writer.init(kDbPath));
+    ASSERT_TRUE(writer.insertCandles(makeCandles("BTCUSDT", hour(50), 1, 5000.0)));
+    ASSERT_TRUE(cache.getStats().segments == 1);  // ETHUSDT is untouched
+    ASSERT_TRUE(btc[50].close == 150.0);          // Old view still valid
+
+    CandleCache::Stats before = cache.getStats();
+    CandleSeries updated = cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(0), hour(99));
+    ASSERT_TRUE(updated[50].close == 5000.0);
+    ASSERT_TRUE(cache.getStats().misses - before.misses == 1);
+
+    // Outside a segment's range: the segment stays
+    ASSERT_TRUE(writer.insertCandle(makeCandles("BTCUSDT", hour(500), 1, 1.0)[0]));
+    ASSERT_TRUE(cache.getStats().segments == 2);
+
+    ASSERT_TRUE(writer.clearCandles("binance", "ETHUSDT", "1h"));
+    ASSERT_TRUE(cache.getCandles(storage, "binance", "ETHUSDT", "1h", hour(0), hour(99)).empty());
+    ASSERT_TRUE(eth.size() == 100);
+
+    writer.close();
+    storage.close();
+}
+
+// Test: a range up to now covers later requests up to now, until new
+// candles are stored
+TEST(open_end) {
+    DataStorage storage;
+    setUp(storage);
+    CandleCache& cache = CandleCache::getInstance();
+
+    ASSERT_TRUE(cache.getCandles(storage, "binance", "BTCUSDT", "1h", 0, std::time(nullptr)).size() == 1000);
+    CandleCache::Stats before = cache.getStats();
+    ASSERT_TRUE(cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(900), std::time(nullptr) + 10).size() == 100);
+    ASSERT_TRUE(cache.getStats().hits - before.hits == 1);
+
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", hour(1000), 5)));
+    ASSERT_TRUE(cache.getCandles(storage, "binance", "BTCUSDT", "1h", 0, std::time(nullptr)).size() == 1005);
+
+    storage.close();
+}
+
+// Test: past the budget the least recently used segments go
+TEST(eviction) {
+    DataStorage storage;
+    setUp(storage);
+    CandleCache& cache = CandleCache::getInstance();
+    size_t defaultBudget = cache.getMaxBytes();
+
+    cache.setMaxBytes(250 * sizeof(Candle));
+    CandleCache::Stats before = cache.getStats();
+    CandleSeries a = cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(0), hour(99));
+    cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(200), hour(299));
+    cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(0), hour(99));     // Touch a
+    cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(400), hour(499));  // Evicts 200..299
+
+    CandleCache::Stats after = cache.getStats();
+    ASSERT_TRUE(after.evictions - before.evictions == 1);
+    ASSERT_TRUE(after.segments == 2 && after.bytes <= 250 * sizeof(Candle));
+    before = after;
+    cache.getCandles(storage, "binance", "BTCUSDT", "1h", hour(0), hour(99));
+    ASSERT_TRUE(cache.getStats().hits - before.hits == 1);
+    ASSERT_TRUE(a.size() == 100);
+
+    cache.setMaxBytes(defaultBudget);
+    storage.close();
+}
+
+// Test: readers on several threads while another thread writes
+TEST(concurrent_readers) {
+    DataStorage storage;
+    setUp(storage);
+    storage.close();
+    CandleCache& cache = CandleCache::getInstance();
+
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&cache, &failed, t]() {
+            DataStorage local;
+            if (!local.init(kDbPath)) {
+                failed = true;
+                return;
+            }
+            for (int i = 0; i < 200; i++) {
+                int from = (i * 37 + t * 101) % 900;
+                CandleSeries candles = cache.getCandles(local, "binance", "BTCUSDT", "1h", hour(from), hour(from + 99));
+                if (candles.size() != 100 || candles.front().timestamp != hour(from)) {
+                    failed = true;
+                }
+            }
+            local.close();
+        });
+    }
+    std::thread writer([]() {
+        DataStorage local;
+        local.init(kDbPath);
+        for (int i = 0; i < 20; i++) {
+            local.insertCandles(makeCandles("BTCUSDT", hour(i * 40), 10, 200.0));
+        }
+        local.close();
+    });
+    for (auto& thread : readers) {
+        thread.join();
+    }
+    writer.join();
+    ASSERT_FALSE(failed);
+
+    // After the writes settled, the cache agrees with the database
+    DataStorage check;
+    ASSERT_TRUE(check.init(kDbPath));
+    std::vector<Candle> stored = check.getCandles("binance", "BTCUSDT", "1h", hour(0), hour(999));
+    CandleSeries cached = cache.getCandles(check, "binance", "BTCUSDT", "1h", hour(0), hour(999));
+    ASSERT_TRUE(cached.size() == stored.size());
+    for (size_t i = 0; i < stored.size(); i++) {
+        ASSERT_TRUE(cached[i].timestamp == stored[i].timestamp && cached[i].close == stored[i].close);
+    }
+    check.close();
+    std::remove(kDbPath);
+}
+
+int main() {
+    std::cout << "=== Candle Cache Tests ===" << std::endl;
+
+    RUN_TEST(hits);
+    RUN_TEST(range_merge);
+    RUN_TEST(invalidation);
+    RUN_TEST(open_end);
+    RUN_TEST(eviction);
+    RUN_TEST(concurrent_readers);
+
+    std::cout << "\nAll candle cache tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,365 @@
+#include "../data/CandleImporter.h"
+#include "../data/CandleFile.h"
+#include "../data/DataStorage.h"
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+const char* kDbPath = "/tmp/test_candle_importer.db";
+const char* kDumpDir = "/tmp";
+const time_t kStart = 1704067200;  // 2024-01-01 00:00 UTC
+
+// Binance kline dump lines: open time in ms, 12 columns
+std::string klineLines(time_t start, int count, double price = 42000.0) {
+    std::string text;
+    char line[256];
+    for (int i = 0; i < count; i++) {
+        long long openTime = (static_cast<long long>(start) + i * 60) * 1000;
+        double open = price + i * 0.01;
+        snprintf(line, sizeof(line), "%lld,%.8f,%.8f,%.8f,%.8f,%.8f,%lld,%.8f,%d,%.8f,%.8f,0\n",
+                 openTime, open, open + 1.5, open - 1.5, open + 0.25, 10.0 + i,
+                 openTime + 59999, 420000.0 + i, 100 + i, 5.0, 210000.0);
+        text += line;
+    }
+    return text;
+}
+
+void writeFile(const std::string& path, const std::string& content) {
+    FILE* file = fopen(path.c_str(), "wb");
+    ASSERT_TRUE(file != nullptr);
+    ASSERT_TRUE(fwrite(content.data(), 1, content.size(), file) == content.size());
+    fclose(file);
+}
+
+void put16(std::string& out, uint16_t value) {
+    out += static_cast<char>(value & 0xFF);
+    out += static_cast<char>(value >> 8);
+}
+
+void put32(std::string& out, uint32_t value) {
+    put16(out, static_cast<uint16_t>(value & 0xFFFF));
+    put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+// Single-entry zip archive, deflated like the data.binance.vision dumps or stored
+void writeZip(const std::string& path, const std::string& name, const std::string& content, bool compress) {
+    std::string data = content;
+    if (compress) {
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        ASSERT_TRUE(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+        data.resize(deflateBound(&stream, content.size()));
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+        stream.avail_in = content.size();
+        stream.next_out = reinterpret_cast<Bytef*>(&data[0]);
+        stream.avail_out = data.size();
+        ASSERT_TRUE(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+        data.resize(stream.total_out);
+        deflateEnd(&stream);
+    }
+    uint32_t crc = crc32(0, reinterpret_cast<const Bytef*>(content.data()), content.size());
+    uint16_t method = compress ? 8 : 0;
+
+    std::string zip;
+    put32(zip, 0x04034b50);
+    put16(zip, 20); put16(zip, 0); put16(zip, method); put16(zip, 0); put16(zip, 0);
+    put32(zip, crc); put32(zip, data.size()); put32(zip, content.size());
+    put16(zip, name.size()); put16(zip, 0);
+    zip += name;
+    zip += data;
+
+    uint32_t directoryOffset = zip.size();
+    put32(zip, 0x02014b50);
+    put16(zip, 20); put16(zip, 20); put16(zip, 0); put16(zip, method); put16(zip, 0); put16(zip, 0);
+    put32(zip, crc); put32(zip, data.size()); put32(zip, content.size());
+    put16(zip, name.size()); put16(zip, 0); put16(zip, 0); put16(zip, 0); put16(zip, 0);
+    put32(zip, 0); put32(zip, 0);
+    zip += name;
+    uint32_t directorySize = zip.size() - directoryOffset;
+
+    put32(zip, 0x06054b50);
+    put16(zip, 0); put16(zip, 0); put16(zip, 1); put16(zip, 1);
+    put32(zip, directorySize); put32(zip, directoryOffset); put16(zip, 0);
+    writeFile(path, zip);
+}
+
+std::string dumpPath(const std::string& name) {
+    return std::string(kDumpDir) + "/" + name;
+}
+
+// Test: the fast number parser reads what strtod reads
+TEST(number_parsing) {
+    std::vector<std::string> numbers = {
+        "42283.58000000", "0.00000001", "1", "-3.5", "123456789.12345678",
+        "0.1", "1e-5", "2.5E3", "9007199254740993", "0.30000000000000004",
+        "12345678901234567890.5", ".5"
+    };
+    std::string text = "open_time,open,high,low,close,volume\r\n";
+    for (size_t i = 0; i < numbers.size(); i++) {
+        const std::string& n = numbers[i];
+        text += std::to_string(1700000000000LL + i * 60000) + "," + n + "," + n + "," + n + "," + n + "," + n + "\r\n";
+    }
+
+    CandleFile file;
+    std::vector<Candle> candles;
+    ASSERT_TRUE(file.parseCSV(text.data(), text.size(), candles, "binance", "BTCUSDT", "1m"));
+    ASSERT_TRUE(candles.size() == numbers.size());
+    ASSERT_TRUE(file.getSkippedLines() == 0);
+    for (size_t i = 0; i < numbers.size(); i++) {
+        double expected = std::strtod(numbers[i].c_str(), nullptr);
+        ASSERT_TRUE(candles[i].open == expected && candles[i].volume == expected);
+        ASSERT_TRUE(candles[i].timestamp == static_cast<time_t>(1700000000 + i * 60));
+        ASSERT_TRUE(candles[i].symbol == "BTCUSDT" && candles[i].timeframe == "1m");
+    }
+
+    // Seconds, milliseconds and microseconds; malformed lines are counted
+    text = "1704067200,1,2,0.5,1.5,10\n"
+           "1704067260000,1,2,0.5,1.5,10\n"
+           "1704067320000000,1,2,0.5,1.5,10\n"
+           "1704067380,1,2,x,1.5,10\n"
+           "1704067440,1,2,0.5,1.5\n"
+           "\n"
+           "# comment\n"
+           "1704067500,1,2,0.5,1.5,10";
+    ASSERT_TRUE(file.parseCSV(text.data(), text.size(), candles, "binance", "BTCUSDT", "1m"));
+    ASSERT_TRUE(candles.size() == 4);
+    ASSERT_TRUE(candles[1].timestamp == 1704067260 && candles[2].timestamp == 1704067320);
+    ASSERT_TRUE(candles[3].timestamp == 1704067500);
+    ASSERT_TRUE(file.getSkippedLines() == 2);
+}
+
+// Test: parallel chunks give the same series as one thread
+TEST(parallel_chunks) {
+    std::string text = "open_time,open,high,low,close,volume,close_time,quote_volume,count,taker_base,taker_quote,ignore\n" +
+                       klineLines(kStart, 60000);
+
+    CandleFile single;
+    single.setParseThreads(1);
+    std::vector<Candle> expected;
+    ASSERT_TRUE(single.parseCSV(text.data(), text.size(), expected, "binance", "BTCUSDT", "1m"));
+    ASSERT_TRUE(expected.size() == 60000);
+
+    for (unsigned int threads : {2u, 3u, 8u}) {
+        CandleFile parallel;
+        parallel.setParseThreads(threads);
+        std::vector<Candle> candles;
+        ASSERT_TRUE(parallel.parseCSV(text.data(), text.size(), candles, "binance", "BTCUSDT", "1m"));
+        ASSERT_TRUE(candles.size() == expected.size());
+        ASSERT_TRUE(parallel.getSkippedLines() == 0);
+        for (size_t i = 0; i < candles.size(); i++) {
+            ASSERT_TRUE(candles[i].timestamp == expected[i].timestamp);
+            ASSERT_TRUE(candles[i].close == expected[i].close && candles[i].volume == expected[i].volume);
+        }
+    }
+}
+
+// Test: CSV and zip dumps load the same, through memory mapping
+TEST(zip_dumps) {
+    std::string content = klineLines(kStart, 1440);
+    std::string csvPath = dumpPath("BTCUSDT-1m-2024-01-01.csv");
+    std::string deflatedPath = dumpPath("BTCUSDT-1m-2024-01-01.zip");
+    std::string storedPath = dumpPath("BTCUSDT-1m-2024-01-02.zip");
+    writeFile(csvPath, content);
+    writeZip(deflatedPath, "BTCUSDT-1m-2024-01-01.csv", content, true);
+    writeZip(storedPath, "BTCUSDT-1m-2024-01-01.csv", content, false);
+
+    CandleFile file;
+    std::vector<Candle> fromCsv, fromDeflated, fromStored;
+    ASSERT_TRUE(file.load(csvPath, fromCsv, "binance", "BTCUSDT", "1m"));
+    ASSERT_TRUE(file.load(deflatedPath, fromDeflated, "binance", "BTCUSDT", "1m"));
+    ASSERT_TRUE(file.load(storedPath, fromStored, "binance", "BTCUSDT", "1m"));
+    ASSERT_TRUE(fromCsv.size() == 1440);
+    ASSERT_TRUE(fromDeflated.size() == 1440 && fromStored.size() == 1440);
+    for (size_t i = 0; i < fromCsv.size(); i++) {
+        ASSERT_TRUE(fromDeflated[i].timestamp == fromCsv[i].timestamp && fromDeflated[i].close == fromCsv[i].close);
+        ASSERT_TRUE(fromStored[i].timestamp == fromCsv[i].timestamp && fromStored[i].high == fromCsv[i].high);
+    }
+
+    // Not a zip, and cut short
+    writeFile(storedPath, content);
+    ASSERT_FALSE(file.load(storedPath, fromStored, "binance", "BTCUSDT", "1m"));
+    std::string zip;
+    writeZip(deflatedPath, "BTCUSDT-1m-2024-01-01.csv", content, true);
+    FILE* in = fopen(deflatedPath.c_str(), "rb");
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        zip.append(buffer, read);
+    }
+    fclose(in);
+    writeFile(deflatedPath, zip.substr(0, 100) + zip.substr(zip.size() - 120));
+    ASSERT_FALSE(file.load(deflatedPath, fromDeflated, "binance", "BTCUSDT", "1m"));
+
+    std::remove(csvPath.c_str());
+    std::remove(deflatedPath.c_str());
+    std::remove(storedPath.c_str());
+}
+
+// Test: symbol and timeframe come from Binance dump names
+TEST(dump_names) {
+    std::string symbol, timeframe;
+    ASSERT_TRUE(CandleImporter::parseDumpName("/data/spot/monthly/BTCUSDT-1m-2024-01.zip", symbol, timeframe));
+    ASSERT_TRUE(symbol == "BTCUSDT" && timeframe == "1m");
+    ASSERT_TRUE(CandleImporter::parseDumpName("ETHBTC-4h-2023-12-31.csv", symbol, timeframe));
+    ASSERT_TRUE(symbol == "ETHBTC" && timeframe == "4h");
+    ASSERT_FALSE(CandleImporter::parseDumpName("candles.csv", symbol, timeframe));
+    ASSERT_FALSE(CandleImporter::parseDumpName("BTCUSDT-2024-01.zip", symbol, timeframe));
+}
+
+// Test: overlapping dumps and re-imports only add missing candles
+TEST(import_dedup) {
+    std::remove(kDbPath);
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+
+    // Day 1 with 10:00-10:59 missing, day 2, and day 1 again complete
+    std::string day1 = klineLines(kStart, 600) + klineLines(kStart + 660 * 60, 780);
+    std::string day2 = klineLines(kStart + 86400, 1440);
+    std::string day1Path = dumpPath("BTCUSDT-1m-2024-01-01.zip");
+    std::string day2Path = dumpPath("BTCUSDT-1m-2024-01-02.csv");
+    std::string fullPath = dumpPath("BTCUSDT-1m-2024-01-01-full.csv");
+    writeZip(day1Path, "BTCUSDT-1m-2024-01-01.csv", day1, true);
+    writeFile(day2Path, day2 + day2.substr(0, day2.find('\n') + 1));  // Repeated line
+    writeFile(fullPath, klineLines(kStart, 1440, 1.0));
+
+    CandleImporter importer(storage);
+    importer.setParseThreads(2);
+    std::vector<std::string> progress;
+    importer.setProgressCallback([&progress](const std::string& path, const CandleImporter::Stats&) {
+        progress.push_back(path);
+    });
+
+    ASSERT_TRUE(importer.importFiles({day1Path, day2Path}));
+    ASSERT_TRUE(progress.size() == 2 && progress[1] == day2Path);
+    CandleImporter::Stats stats = importer.getStats();
+    ASSERT_TRUE(stats.files == 2 && stats.failedFiles == 0);
+    ASSERT_TRUE(stats.parsed == 1380 + 1441);
+    ASSERT_TRUE(stats.inserted == 1380 + 1440 && stats.skipped == 1);
+    ASSERT_TRUE(storage.getCandleCount("binance", "BTCUSDT", "1m") == 2820);
+
+    // Both files are covered, including the hour day 1 doesn't have
+    std::vector<CandleRange> coverage = storage.getCoverage("binance", "BTCUSDT", "1m");
+    ASSERT_TRUE(coverage.size() == 1);
+    ASSERT_TRUE(coverage[0].start == kStart && coverage[0].end == kStart + 2 * 86400 - 60);
+
+    // Covered ranges are skipped: stored prices stay as they are
+    ASSERT_TRUE(importer.importFile(fullPath, "BTCUSDT", "1m"));
+    ASSERT_TRUE(importer.getStats().inserted == 0 && importer.getStats().skipped == 1440);
+    std::vector<Candle> stored = storage.getCandles("binance", "BTCUSDT", "1m", kStart, kStart + 59 * 60);
+    ASSERT_TRUE(stored.size() == 60 && std::fabs(stored[0].open - 42000.0) < 1e-9);
+
+    // A dropped range is filled again
+    storage.clearCandles("binance", "BTCUSDT", "1m");
+    ASSERT_TRUE(importer.importFile(fullPath, "BTCUSDT", "1m"));
+    ASSERT_TRUE(importer.getStats().inserted == 1440);
+    ASSERT_TRUE(storage.getCandleCount("binance", "BTCUSDT", "1m") == 1440);
+
+    // A bad file fails on its own
+    std::string badPath = dumpPath("ETHUSDT-1m-2024-01-01.zip");
+    writeFile(badPath, "not a zip");
+    ASSERT_FALSE(importer.importFiles({badPath, day2Path, dumpPath("candles.csv")}));
+    ASSERT_TRUE(importer.getStats().files == 1 && importer.getStats().failedFiles == 2);
+    ASSERT_FALSE(importer.getLastError().empty());
+    ASSERT_TRUE(storage.getCandleCount("binance", "BTCUSDT", "1m") == 2880);
+
+    storage.close();
+    std::remove(day1Path.c_str());
+    std::remove(day2Path.c_str());
+    std::remove(fullPath.c_str());
+    std::remove(badPath.c_str());
+    std::remove(kDbPath);
+}
+
+// Test: binary files round-trip, and a count that doesn't match the
+// records is rejected before anything is allocated
+TEST(binary_files) {
+    std::vector<Candle> candles;
+    for (int i = 0; i < 100; i++) {
+        Candle candle;
+        candle.exchange = "binance";
+        candle.symbol = "BTCUSDT";
+        candle.timeframe = "1m";
+        candle.timestamp = kStart + i * 60;
+        candle.open = candle.high = candle.low = candle.close = 42000.0 + i;
+        candle.volume = 1.0;
+        candles.push_back(candle);
+    }
+
+    std::string path = dumpPath("test_candle_importer.bin");
+    CandleFile file;
+    ASSERT_TRUE(file.saveBinary(path, candles));
+    std::vector<Candle> loaded;
+    ASSERT_TRUE(file.loadBinary(path, loaded));
+    ASSERT_TRUE(loaded.size() == 100 && loaded[99].timestamp == kStart + 99 * 60);
+    ASSERT_TRUE(loaded[99].close == 42099.0 && loaded[0].symbol == "BTCUSDT");
+
+    FILE* in = fopen(path.c_str(), "rb");
+    ASSERT_TRUE(in != nullptr);
+    std::string content;
+    char block[4096];
+    size_t read;
+    while ((read = fread(block, 1, sizeof(block), in)) > 0) {
+        content.append(block, read);
+    }
+    fclose(in);
+    size_t countOffset = content.size() - 100 * 48 - sizeof(uint64_t);
+
+    // Records missing from the end
+    writeFile(path, content.substr(0, content.size() - 48 * 10));
+    ASSERT_FALSE(file.loadBinary(path, loaded));
+    ASSERT_TRUE(loaded.empty());
+
+    // A huge count in an intact file
+    std::string corrupt = content;
+    uint64_t huge = 1ULL << 40;
+    std::memcpy(&corrupt[countOffset], &huge, sizeof(huge));
+    writeFile(path, corrupt);
+    ASSERT_FALSE(file.loadBinary(path, loaded));
+    ASSERT_FALSE(file.getLastError().empty());
+
+    // Trailing bytes
+    writeFile(path, content + "x");
+    ASSERT_FALSE(file.loadBinary(path, loaded));
+
+    std::remove(path.c_str());
+}
+
+int main() {
+    std::cout << "=== Candle Importer Tests ===" << std::endl;
+
+    RUN_TEST(number_parsing);
+    RUN_TEST(parallel_chunks);
+    RUN_TEST(zip_dumps);
+    RUN_TEST(dump_names);
+    RUN_TEST(import_dedup);
+    RUN_TEST(binary_files);
+
+    std::cout << "\nAll candle importer tests passed!" << std::endl;
+    return 0;
+}
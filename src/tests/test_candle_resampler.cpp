@@ -0,0 +1,162 @@
+#include "../data/CandleResampler.h"
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+#define ASSERT_NEAR(a, b, epsilon) ASSERT_TRUE(std::abs((a) - (b)) < (epsilon))
+
+// 2024-01-01 00:00:00 UTC (a Monday)
+const time_t kStart = 1704067200;
+
+// Helper to create 'count' consecutive 1m candles with rising closes
+std::vector<Candle> createMinuteCandles(time_t start, int count) {
+    std::vector<Candle> candles;
+    for (int i = 0; i < count; i++) {
+        Candle c;
+        c.exchange = "binance";
+        c.symbol = "BTCUSDT";
+        c.timeframe = "1m";
+        c.timestamp = start + i * 60;
+        c.open = 100.0 + i;
+        c.close = 100.5 + i;
+        c.high = 101.0 + i;
+        c.low = 99.0 + i;
+        c.volume = 1.0;
+        candles.push_back(c);
+    }
+    return candles;
+}
+
+// Test: bucket alignment
+TEST(alignment) {
+    ASSERT_TRUE(CandleResampler::alignTimestamp(kStart + 299, "5m") == kStart);
+    ASSERT_TRUE(CandleResampler::alignTimestamp(kStart + 300, "5m") == kStart + 300);
+    ASSERT_TRUE(CandleResampler::alignTimestamp(kStart + 5 * 3600 + 10, "4h") == kStart + 4 * 3600);
+
+    // Weekly buckets start on Monday, monthly on the 1st
+    ASSERT_TRUE(CandleResampler::alignTimestamp(kStart + 3 * 86400, "1w") == kStart);
+    ASSERT_TRUE(CandleResampler::alignTimestamp(kStart + 40 * 86400, "1M") == kStart + 31 * 86400);
+    ASSERT_TRUE(CandleResampler::nextBucketStart(kStart + 31 * 86400, "1M") == kStart + 60 * 86400);
+
+    ASSERT_TRUE(CandleResampler::canResample("1m", "15m"));
+    ASSERT_TRUE(CandleResampler::canResample("1h", "1M"));
+    ASSERT_FALSE(CandleResampler::canResample("4h", "1h"));
+    ASSERT_FALSE(CandleResampler::canResample("1m", "7m"));
+}
+
+// Test: batch resampling
+TEST(batch_resample) {
+    std::vector<Candle> minutes = createMinuteCandles(kStart, 60);
+    std::vector<Candle> fiveMin = CandleResampler::resample(minutes, "5m");
+
+    ASSERT_TRUE(fiveMin.size() == 12);
+    ASSERT_TRUE(fiveMin[0].timestamp == kStart);
+    ASSERT_TRUE(fiveMin[0].timeframe == "5m");
+    ASSERT_NEAR(fiveMin[0].open, 100.0, 0.0001);
+    ASSERT_NEAR(fiveMin[0].close, 104.5, 0.0001);
+    ASSERT_NEAR(fiveMin[0].high, 105.0, 0.0001);
+    ASSERT_NEAR(fiveMin[0].low, 99.0, 0.0001);
+    ASSERT_NEAR(fiveMin[0].volume, 5.0, 0.0001);
+
+    std::vector<Candle> hourly = CandleResampler::resample(minutes, "1h");
+    ASSERT_TRUE(hourly.size() == 1);
+    ASSERT_NEAR(hourly[0].volume, 60.0, 0.0001);
+
+    // Trailing partial bucket is dropped only when asked to
+    std::vector<Candle> partial = createMinuteCandles(kStart, 62);
+    ASSERT_TRUE(CandleResampler::resample(partial, "15m").size() == 5);
+    ASSERT_TRUE(CandleResampler::resample(partial, "15m", true).size() == 4);
+}
+
+// Test: incremental mode matches batch output
+TEST(incremental_update) {
+    std::vector<Candle> minutes = createMinuteCandles(kStart, 30);
+    std::vector<Candle> emitted;
+
+    CandleResampler resampler("1m", "15m");
+    resampler.setCallback([&emitted](const Candle& c) { emitted.push_back(c); });
+
+    for (size_t i = 0; i < minutes.size(); i++) {
+        // Open snapshot first, then the closed candle
+        Candle snapshot = minutes[i];
+        snapshot.close = snapshot.open;
+        resampler.update(snapshot, false);
+        resampler.update(minutes[i], true);
+
+        if (i == 14) {
+            ASSERT_TRUE(emitted.size() == 1);
+        }
+    }
+
+    std::vector<Candle> batch = CandleResampler::resample(minutes, "15m");
+    ASSERT_TRUE(emitted.size() == batch.size());
+    for (size_t i = 0; i < batch.size(); i++) {
+        ASSERT_TRUE(emitted[i].timestamp == batch[i].timestamp);
+        ASSERT_NEAR(emitted[i].open, batch[i].open, 0.0001);
+        ASSERT_NEAR(emitted[i].high, batch[i].high, 0.0001);
+        ASSERT_NEAR(emitted[i].low, batch[i].low, 0.0001);
+        ASSERT_NEAR(emitted[i].close, batch[i].close, 0.0001);
+        ASSERT_NEAR(emitted[i].volume, batch[i].volume, 0.0001);
+    }
+}
+
+// Test: in-progress bucket includes the open source candle
+TEST(current_bucket) {
+    std::vector<Candle> minutes = createMinuteCandles(kStart, 3);
+    CandleResampler resampler("1m", "5m");
+
+    Candle current;
+    ASSERT_FALSE(resampler.getCurrent(current));
+
+    resampler.update(minutes[0], true);
+    resampler.update(minutes[1], true);
+
+    Candle open = minutes[2];
+    open.high = 200.0;
+    resampler.update(open, false);
+
+    ASSERT_TRUE(resampler.getCurrent(current));
+    ASSERT_TRUE(current.timestamp == kStart);
+    ASSERT_NEAR(current.open, 100.0, 0.0001);
+    ASSERT_NEAR(current.high, 200.0, 0.0001);
+    ASSERT_NEAR(current.volume, 3.0, 0.0001);
+
+    // A gap skips straight to a new bucket and emits the old one
+    int emittedCount = 0;
+    resampler.setCallback([&emittedCount](const Candle&) { emittedCount++; });
+    resampler.update(createMinuteCandles(kStart + 600, 1)[0], true);
+    ASSERT_TRUE(emittedCount == 1);
+    ASSERT_TRUE(resampler.getCurrent(current));
+    ASSERT_TRUE(current.timestamp == kStart + 600);
+}
+
+int main() {
+    std::cout << "=== Candle Resampler Tests ===" << std::endl << std::endl;
+
+    RUN_TEST(alignment);
+    RUN_TEST(batch_resample);
+    RUN_TEST(incremental_update);
+    RUN_TEST(current_bucket);
+
+    std::cout << "\n=== All resampler tests passed! ===" << std::endl;
+    return 0;
+}
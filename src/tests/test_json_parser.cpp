@@ -0,0 +1,210 @@
+#include "../utils/JsonParser.h"
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+#define ASSERT_NEAR(a, b, epsilon) ASSERT_TRUE(std::abs((a) - (b)) < (epsilon))
+
+// Counts heap allocations to check the per-message path. The whole set is
+// replaced, so every new is paired with its own delete
+static size_t allocations = 0;
+static size_t allocatedBytes = 0;
+
+static void* countedAlloc(size_t size) {
+    allocations++;
+    allocatedBytes += size;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+const char* kKline =
+    "{\"stream\":\"btcusdt@kline_1m\",\"data\":{\"e\":\"kline\",\"E\":1704067260123,\"s\":\"BTCUSDT\","
+    "\"k\":{\"t\":1704067200000,\"T\":1704067259999,\"s\":\"BTCUSDT\",\"i\":\"1m\","
+    "\"o\":\"42000.50\",\"c\":\"42010.25\",\"h\":\"42020.00\",\"l\":\"41990.75\","
+    "\"v\":\"12.5\",\"n\":340,\"x\":true}}}";
+
+// Test: compiled paths find the same values as dotted strings
+TEST(json_path) {
+    JsonParser parser;
+    ASSERT_TRUE(parser.parse(kKline));
+
+    JsonPath stream("stream");
+    JsonPath openTime("data.k.t");
+    JsonPath close("data.k.c");
+    JsonPath closed("data.k.x");
+    ASSERT_TRUE(openTime.str() == "data.k.t");
+
+    ASSERT_TRUE(parser.getString(stream) == "btcusdt@kline_1m");
+    ASSERT_TRUE(parser.getInt64(openTime) == 1704067200000LL);
+    ASSERT_TRUE(parser.getInt64(openTime) == parser.getInt64("data.k.t"));
+    ASSERT_NEAR(parser.getDouble(close), 42010.25, 1e-9);  // Number sent as a string
+    ASSERT_TRUE(parser.getBool(closed));
+
+    std::string symbol;
+    ASSERT_TRUE(parser.getString(JsonPath("data.k.s"), symbol));
+    ASSERT_TRUE(symbol == "BTCUSDT");
+
+    // Keys match whole names only, at every level
+    ASSERT_FALSE(parser.has(JsonPath("data.k.tt")));
+    ASSERT_FALSE(parser.has(JsonPath("data.kk.t")));
+    ASSERT_FALSE(parser.has(JsonPath("dat.k.t")));
+    ASSERT_FALSE(parser.has(JsonPath("data.k.t.x")));
+    ASSERT_FALSE(parser.getString(JsonPath("data.missing"), symbol));
+    ASSERT_TRUE(symbol.empty());
+    ASSERT_TRUE(parser.getInt64(JsonPath("data.k.o"), -1) == -1);  // A string, not an integer
+    ASSERT_NEAR(parser.getDouble(JsonPath("data.k.i"), -1.0), -1.0, 1e-9);
+
+    // The empty path is the whole document
+    ASSERT_TRUE(parser.has(JsonPath("")));
+}
+
+// Test: in-situ parsing reads string values straight from the buffer
+TEST(parse_insitu) {
+    JsonParser parser;
+    std::vector<char> buffer(kKline, kKline + std::strlen(kKline) + 1);
+    ASSERT_TRUE(parser.parseInsitu(buffer.data()));
+
+    std::string stream = parser.getString(JsonPath("stream"));
+    ASSERT_TRUE(stream == "btcusdt@kline_1m");
+    ASSERT_TRUE(parser.getInt64(JsonPath("data.k.n")) == 340);
+    ASSERT_NEAR(parser.getDouble(JsonPath("data.k.o")), 42000.50, 1e-9);
+
+    // Strings are terminated in place, inside the caller's buffer
+    const char* value = "btcusdt@kline_1m";
+    auto inBuffer = std::search(buffer.begin(), buffer.end(), value, value + std::strlen(value));
+    ASSERT_TRUE(inBuffer != buffer.end());
+    ASSERT_TRUE(*(inBuffer + std::strlen(value)) == '\0');
+
+    // Malformed input fails like parse() does
+    char broken[] = "{\"stream\":";
+    ASSERT_FALSE(parser.parseInsitu(broken));
+    ASSERT_FALSE(parser.getError().empty());
+    ASSERT_FALSE(parser.has(JsonPath("stream")));
+}
+
+// Test: each parse starts from an empty pool, whatever came before
+TEST(pool_reuse) {
+    JsonParser parser;
+
+    // Bigger than the pools, so the parser spills into extra chunks
+    std::string big = "{\"values\":[";
+    for (int i = 0; i < 20000; i++) {
+        big += (i ? "," : "") + std::to_string(i);
+    }
+    big += "],\"name\":\"big\"}";
+    ASSERT_TRUE(parser.parse(big));
+    ASSERT_TRUE(parser.getArraySize("values") == 20000);
+    ASSERT_TRUE(parser.getArrayInt("values", 19999) == 19999);
+
+    ASSERT_TRUE(parser.parse(kKline));
+    ASSERT_FALSE(parser.has("values"));
+    ASSERT_FALSE(parser.has("name"));
+    ASSERT_TRUE(parser.getString("data.k.s") == "BTCUSDT");
+
+    ASSERT_FALSE(parser.parse("{\"broken\""));
+    ASSERT_FALSE(parser.has("data"));
+    ASSERT_TRUE(parser.toString() == "{}");
+
+    for (int i = 0; i < 100; i++) {
+        std::string message = "{\"id\":" + std::to_string(i) + ",\"text\":\"message number " +
+                              std::to_string(i) + " with a string longer than sixteen bytes\"}";
+        ASSERT_TRUE(parser.parse(message));
+        ASSERT_TRUE(parser.getInt("id") == i);
+        ASSERT_TRUE(parser.getString("text") == "message number " + std::to_string(i) +
+                                                " with a string longer than sixteen bytes");
+    }
+}
+
+// Test: the pools are made by the first parse, not the constructor
+TEST(lazy_pool) {
+    std::string message(kKline);
+    size_t before = allocatedBytes;
+    JsonParser parser;
+    ASSERT_TRUE(allocatedBytes - before < 1024);
+
+    before = allocatedBytes;
+    ASSERT_TRUE(parser.parse(message));
+    ASSERT_TRUE(allocatedBytes - before >= 80 * 1024);
+
+    // ...and only once
+    before = allocatedBytes;
+    ASSERT_TRUE(parser.parse(message));
+    ASSERT_TRUE(allocatedBytes == before);
+}
+
+// Test: a warm parser parses and looks up without allocating
+TEST(no_allocation) {
+    static const JsonPath kOpenTime("data.k.t");
+    static const JsonPath kClose("data.k.c");
+    static const JsonPath kSymbol("data.k.s");
+    static const JsonPath kClosed("data.k.x");
+
+    JsonParser parser;
+    std::string message(kKline);
+    std::vector<char> buffer;
+    buffer.reserve(message.size() + 1);
+    std::string symbol;
+    symbol.reserve(32);
+    ASSERT_TRUE(parser.parse(message));
+
+    size_t before = allocations;
+    int64_t sum = 0;
+    for (int i = 0; i < 10000; i++) {
+        buffer.assign(message.c_str(), message.c_str() + message.size() + 1);
+        ASSERT_TRUE(parser.parseInsitu(buffer.data()));
+        ASSERT_TRUE(parser.getString(kSymbol, symbol));
+        sum += parser.getInt64(kOpenTime) + static_cast<int64_t>(parser.getDouble(kClose));
+        ASSERT_TRUE(parser.getBool(kClosed));
+
+        ASSERT_TRUE(parser.parse(message));
+        ASSERT_TRUE(parser.has(kSymbol));
+    }
+    ASSERT_TRUE(allocations == before);
+    ASSERT_TRUE(symbol == "BTCUSDT");
+    ASSERT_TRUE(sum == 10000LL * (1704067200000LL + 42010));
+}
+
+int main() {
+    std::cout << "=== JSON Parser Tests ===" << std::endl;
+
+    RUN_TEST(json_path);
+    RUN_TEST(parse_insitu);
+    RUN_TEST(pool_reuse);
+    RUN_TEST(lazy_pool);
+    RUN_TEST(no_allocation);
+
+    std::cout << "\nAll JSON parser tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "../utils/LatencyTracker.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+// Test: every value falls in a bucket whose bound is within 1% above it
+TEST(bucket_bounds) {
+    std::mt19937_64 rng(42);
+    for (int i = 0; i < 100000; i++) {
+        uint64_t value = rng() % (1ULL << 39);
+        size_t index = LatencyHistogram::bucketIndex(value);
+        ASSERT_TRUE(index < LatencyHistogram::kBucketCount);
+
+        uint64_t bound = LatencyHistogram::bucketUpperBound(index);
+        ASSERT_TRUE(bound >= value);
+        ASSERT_TRUE(bound - value <= value / 128 + 1);
+    }
+
+    // Exact below 128ns, monotonic above
+    for (uint64_t value = 0; value < 128; value++) {
+        ASSERT_TRUE(LatencyHistogram::bucketUpperBound(LatencyHistogram::bucketIndex(value)) == value);
+    }
+    size_t previous = 0;
+    for (uint64_t value = 1; value < (1ULL << 30); value = value * 3 / 2 + 1) {
+        size_t index = LatencyHistogram::bucketIndex(value);
+        ASSERT_TRUE(index >= previous);
+        previous = index;
+    }
+}
+
+// Test: percentiles against the sorted samples
+TEST(percentiles) {
+    LatencyHistogram histogram;
+    ASSERT_TRUE(histogram.percentile(50.0) == 0);
+
+    std::mt19937_64 rng(7);
+    std::lognormal_distribution<double> latency(10.0, 1.0);  // ~22us median
+    std::vector<int64_t> samples;
+    for (int i = 0; i < 200000; i++) {
+        int64_t value = static_cast<int64_t>(latency(rng));
+        samples.push_back(value);
+        histogram.record(value);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    const double percents[] = { 50.0, 90.0, 99.0, 99.9 };
+    for (double percent : percents) {
+        int64_t exact = samples[static_cast<size_t>(percent / 100.0 * samples.size() + 0.5) - 1];
+        int64_t reported = histogram.percentile(percent);
+        ASSERT_TRUE(reported >= exact);
+        ASSERT_TRUE(reported - exact <= exact / 100 + 1);
+    }
+
+    LatencyStats stats = histogram.stats();
+    ASSERT_TRUE(stats.count == samples.size());
+    ASSERT_TRUE(stats.min == samples.front());
+    ASSERT_TRUE(stats.max == samples.back());
+    ASSERT_TRUE(histogram.percentile(100.0) == samples.back());
+
+    histogram.reset();
+    ASSERT_TRUE(histogram.count() == 0);
+    ASSERT_TRUE(histogram.stats().min == 0);
+}
+
+// Test: concurrent recording loses no samples
+TEST(concurrent_record) {
+    LatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&histogram, t]() {
+            for (int i = 0; i < 50000; i++) {
+                histogram.record(1000 + t);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_TRUE(histogram.count() == 200000);
+    ASSERT_TRUE(histogram.stats().min == 1000);
+    ASSERT_TRUE(histogram.stats().max == 1003);
+}
+
+// Test: tick origin, tick-to-signal and the report
+TEST(tracker) {
+    LatencyTracker& tracker = LatencyTracker::getInstance();
+    tracker.reset();
+
+    // No origin: nothing recorded
+    tracker.recordTickToSignal();
+    ASSERT_TRUE(tracker.getStats(LatencyStage::TICK_TO_SIGNAL).count == 0);
+
+    int64_t origin = LatencyTracker::now() - 5000;
+    LatencyTracker::setTickOrigin(origin);
+    tracker.recordTickToSignal();
+    LatencyTracker::setTickOrigin(0);
+    LatencyStats stats = tracker.getStats(LatencyStage::TICK_TO_SIGNAL);
+    ASSERT_TRUE(stats.count == 1);
+    ASSERT_TRUE(stats.min >= 5000);
+
+    // The origin is per thread
+    LatencyTracker::setTickOrigin(origin);
+    std::thread other([]() {
+        ASSERT_TRUE(LatencyTracker::getTickOrigin() == 0);
+    });
+    other.join();
+    LatencyTracker::setTickOrigin(0);
+
+    // Disabled tracker records nothing
+    tracker.setEnabled(false);
+    tracker.record(LatencyStage::QUEUE_WAIT, 100);
+    tracker.setEnabled(true);
+    ASSERT_TRUE(tracker.getStats(LatencyStage::QUEUE_WAIT).count == 0);
+
+    tracker.record(LatencyStage::JSON_DECODE, 1500);
+    std::string path = "/tmp/test_latency_report.txt";
+    ASSERT_TRUE(tracker.dumpToFile(path));
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    ASSERT_TRUE(contents.str() == tracker.report());
+    ASSERT_TRUE(contents.str().find("json_decode") != std::string::npos);
+    ASSERT_TRUE(contents.str().find("tick_to_signal") != std::string::npos);
+    std::remove(path.c_str());
+
+    ASSERT_FALSE(tracker.dumpToFile("/nonexistent/dir/report.txt"));
+    tracker.reset();
+}
+
+int main() {
+    std::cout << "=== Latency Tracker Tests ===" << std::endl;
+
+    RUN_TEST(bucket_bounds);
+    RUN_TEST(percentiles);
+    RUN_TEST(concurrent_record);
+    RUN_TEST(tracker);
+
+    std::cout << "\nAll latency tracker tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,228 @@
+#include "../exchange/LocalOrderBook.h"
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <map>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+#define ASSERT_NEAR(a, b, eps) ASSERT_TRUE(std::fabs((a) - (b)) < (eps))
+
+OrderBook makeSnapshot(int64_t lastUpdateId) {
+    OrderBook snapshot;
+    snapshot.symbol = "BTCUSDT";
+    snapshot.timestamp = 0;
+    snapshot.lastUpdateId = lastUpdateId;
+    snapshot.bids = {{100.0, 1.0}, {99.0, 2.0}, {98.0, 3.0}};
+    snapshot.asks = {{101.0, 1.5}, {102.0, 2.5}, {103.0, 3.5}};
+    return snapshot;
+}
+
+DepthUpdate makeDiff(int64_t first, int64_t last,
+                     std::vector<OrderBookLevel> bids, std::vector<OrderBookLevel> asks) {
+    DepthUpdate diff;
+    diff.symbol = "BTCUSDT";
+    diff.firstUpdateId = first;
+    diff.finalUpdateId = last;
+    diff.prevFinalUpdateId = -1;
+    diff.bids = bids;
+    diff.asks = asks;
+    diff.timestamp = 0;
+    return diff;
+}
+
+// Test: snapshot loading and top of book
+TEST(snapshot) {
+    LocalOrderBook book("BTCUSDT");
+    ASSERT_TRUE(book.needsSnapshot());
+
+    OrderBook snapshot = makeSnapshot(100);
+    // Unsorted input and empty levels are tolerated
+    snapshot.bids.push_back({99.5, 0.0});
+    std::swap(snapshot.asks[0], snapshot.asks[2]);
+    ASSERT_TRUE(book.applySnapshot(snapshot));
+    ASSERT_TRUE(book.isSynced());
+    ASSERT_TRUE(book.getLastUpdateId() == 100);
+
+    OrderBookLevel bid, ask;
+    ASSERT_TRUE(book.bestBid(bid) && bid.price == 100.0 && bid.quantity == 1.0);
+    ASSERT_TRUE(book.bestAsk(ask) && ask.price == 101.0 && ask.quantity == 1.5);
+    ASSERT_TRUE(book.spread() == 1.0);
+    ASSERT_TRUE(book.midPrice() == 100.5);
+    ASSERT_TRUE(book.bidLevels() == 3 && book.askLevels() == 3);
+
+    OrderBook top = book.toOrderBook(2);
+    ASSERT_TRUE(top.bids.size() == 2 && top.asks.size() == 2);
+    ASSERT_TRUE(top.bids[0].price == 100.0 && top.bids[1].price == 99.0);
+    ASSERT_TRUE(top.asks[0].price == 101.0 && top.asks[1].price == 102.0);
+    ASSERT_TRUE(top.lastUpdateId == 100);
+}
+
+// Test: diffs insert, update and remove levels
+TEST(diffs) {
+    LocalOrderBook book("BTCUSDT");
+    ASSERT_TRUE(book.applySnapshot(makeSnapshot(100)));
+
+    // Overlaps the snapshot: allowed for the first diff
+    auto result = book.applyDiff(makeDiff(95, 102, {{100.5, 4.0}, {99.0, 0.0}}, {{101.0, 0.0}}));
+    ASSERT_TRUE(result == LocalOrderBook::DiffResult::APPLIED);
+    ASSERT_TRUE(book.getLastUpdateId() == 102);
+
+    OrderBookLevel bid, ask;
+    ASSERT_TRUE(book.bestBid(bid) && bid.price == 100.5 && bid.quantity == 4.0);
+    ASSERT_TRUE(book.bestAsk(ask) && ask.price == 102.0);
+    ASSERT_TRUE(book.bidQuantity(99.0) == 0.0);
+    ASSERT_TRUE(book.bidLevels() == 3 && book.askLevels() == 2);
+
+    result = book.applyDiff(makeDiff(103, 103, {{98.0, 7.0}}, {{101.5, 1.0}}));
+    ASSERT_TRUE(result == LocalOrderBook::DiffResult::APPLIED);
+    ASSERT_TRUE(book.bidQuantity(98.0) == 7.0);
+    ASSERT_TRUE(book.bestAsk(ask) && ask.price == 101.5);
+
+    // Old diffs are ignored
+    result = book.applyDiff(makeDiff(101, 102, {{50.0, 1.0}}, {}));
+    ASSERT_TRUE(result == LocalOrderBook::DiffResult::STALE);
+    ASSERT_TRUE(book.bidQuantity(50.0) == 0.0);
+
+    // Removing a level that doesn't exist is harmless
+    result = book.applyDiff(makeDiff(104, 104, {{42.0, 0.0}}, {}));
+    ASSERT_TRUE(result == LocalOrderBook::DiffResult::APPLIED);
+}
+
+// Test: diffs buffered before the snapshot are replayed
+TEST(buffering) {
+    LocalOrderBook book("BTCUSDT");
+    ASSERT_TRUE(book.applyDiff(makeDiff(90, 99, {{1.0, 1.0}}, {})) == LocalOrderBook::DiffResult::BUFFERED);
+    ASSERT_TRUE(book.applyDiff(makeDiff(100, 105, {{100.0, 9.0}}, {})) == LocalOrderBook::DiffResult::BUFFERED);
+    ASSERT_TRUE(book.applyDiff(makeDiff(106, 107, {}, {{101.0, 0.5}})) == LocalOrderBook::DiffResult::BUFFERED);
+
+    // Snapshot newer than the first buffered diff, older than the others
+    ASSERT_TRUE(book.applySnapshot(makeSnapshot(102)));
+    ASSERT_TRUE(book.getLastUpdateId() == 107);
+    ASSERT_TRUE(book.bidQuantity(1.0) == 0.0);
+    ASSERT_TRUE(book.bidQuantity(100.0) == 9.0);
+    ASSERT_TRUE(book.askQuantity(101.0) == 0.5);
+
+    // A snapshot older than the buffered diffs is refused
+    LocalOrderBook late("BTCUSDT");
+    late.applyDiff(makeDiff(200, 201, {}, {}));
+    ASSERT_FALSE(late.applySnapshot(makeSnapshot(150)));
+    ASSERT_TRUE(late.needsSnapshot());
+    ASSERT_TRUE(late.applySnapshot(makeSnapshot(200)));
+    ASSERT_TRUE(late.getLastUpdateId() == 201);
+}
+
+// Test: sequence gaps force a resync
+TEST(gaps) {
+    LocalOrderBook book("BTCUSDT");
+    ASSERT_TRUE(book.applySnapshot(makeSnapshot(100)));
+    ASSERT_TRUE(book.applyDiff(makeDiff(101, 102, {}, {})) == LocalOrderBook::DiffResult::APPLIED);
+
+    auto result = book.applyDiff(makeDiff(110, 112, {{100.0, 5.0}}, {}));
+    ASSERT_TRUE(result == LocalOrderBook::DiffResult::GAP);
+    ASSERT_TRUE(book.needsSnapshot());
+    ASSERT_TRUE(book.bidLevels() == 0);
+    ASSERT_FALSE(book.getLastError().empty());
+
+    // The diff that revealed the gap is kept for the next snapshot
+    ASSERT_TRUE(book.applyDiff(makeDiff(113, 114, {}, {})) == LocalOrderBook::DiffResult::BUFFERED);
+    ASSERT_TRUE(book.applySnapshot(makeSnapshot(111)));
+    ASSERT_TRUE(book.getLastUpdateId() == 114);
+    ASSERT_TRUE(book.bidQuantity(100.0) == 5.0);
+
+    // Futures streams chain diffs with pu
+    DepthUpdate linked = makeDiff(120, 125, {}, {});
+    linked.prevFinalUpdateId = 114;
+    ASSERT_TRUE(book.applyDiff(linked) == LocalOrderBook::DiffResult::APPLIED);
+    DepthUpdate broken = makeDiff(126, 127, {}, {});
+    broken.prevFinalUpdateId = 124;
+    ASSERT_TRUE(book.applyDiff(broken) == LocalOrderBook::DiffResult::GAP);
+}
+
+// Test: market order fills walk the book
+TEST(market_order) {
+    LocalOrderBook book("BTCUSDT");
+    ASSERT_TRUE(book.applySnapshot(makeSnapshot(1)));
+
+    double average = 0.0;
+    ASSERT_TRUE(book.simulateMarketOrder(OrderSide::BUY, 1.0, average) == 1.0);
+    ASSERT_TRUE(average == 101.0);
+
+    // 1.5 @ 101 + 1.5 @ 102
+    ASSERT_TRUE(book.simulateMarketOrder(OrderSide::BUY, 3.0, average) == 3.0);
+    ASSERT_NEAR(average, 101.5, 1e-12);
+
+    // 1 @ 100 + 2 @ 99 + 3 @ 98, then the book runs out
+    double filled = book.simulateMarketOrder(OrderSide::SELL, 10.0, average);
+    ASSERT_TRUE(filled == 6.0);
+    ASSERT_NEAR(average, (100.0 + 198.0 + 294.0) / 6.0, 1e-12);
+}
+
+// Test: random diffs against a std::map reference
+TEST(random_against_map) {
+    LocalOrderBook book("BTCUSDT");
+    OrderBook empty;
+    empty.lastUpdateId = 0;
+    ASSERT_TRUE(book.applySnapshot(empty));
+
+    std::map<double, double> bids;
+    std::map<double, double> asks;
+    std::mt19937 rng(7);
+    int64_t id = 0;
+    for (int i = 0; i < 20000; i++) {
+        DepthUpdate diff = makeDiff(id + 1, id + 1, {}, {});
+        id++;
+        for (int j = 0; j < 3; j++) {
+            double price = 1000 + (rng() % 200) * 0.5;
+            double quantity = (rng() % 4 == 0) ? 0.0 : (rng() % 100) / 10.0;
+            bool bid = rng() % 2 == 0;
+            (bid ? diff.bids : diff.asks).push_back({price, quantity});
+            auto& side = bid ? bids : asks;
+            if (quantity == 0.0) side.erase(price);
+            else side[price] = quantity;
+        }
+        ASSERT_TRUE(book.applyDiff(diff) == LocalOrderBook::DiffResult::APPLIED);
+    }
+
+    OrderBook result = book.toOrderBook();
+    ASSERT_TRUE(result.bids.size() == bids.size() && result.asks.size() == asks.size());
+    size_t index = 0;
+    for (auto it = bids.rbegin(); it != bids.rend(); ++it, ++index) {
+        ASSERT_TRUE(result.bids[index].price == it->first && result.bids[index].quantity == it->second);
+    }
+    index = 0;
+    for (auto it = asks.begin(); it != asks.end(); ++it, ++index) {
+        ASSERT_TRUE(result.asks[index].price == it->first && result.asks[index].quantity == it->second);
+    }
+}
+
+int main() {
+    std::cout << "=== Local Order Book Tests ===" << std::endl;
+
+    RUN_TEST(snapshot);
+    RUN_TEST(diffs);
+    RUN_TEST(buffering);
+    RUN_TEST(gaps);
+    RUN_TEST(market_order);
+    RUN_TEST(random_against_map);
+
+    std::cout << "\nAll order book tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,402 @@
+#include "../cli/MockBinanceServer.h"
+#include "../exchange/BinanceAPI.h"
+#include "../exchange/BinanceWebSocket.h"
+#include "../data/CandleResampler.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+// Process stream messages until 'done' or 'timeoutMs' passes
+template <typename Predicate>
+bool pumpUntil(BinanceWebSocket& webSocket, Predicate done, int timeoutMs) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        webSocket.waitForMessages(50);
+        webSocket.processMessages();
+    }
+    return true;
+}
+
+// Test: BinanceAPI against the server's generated and loaded klines
+TEST(rest_klines) {
+    MockBinanceServer server;
+    ASSERT_TRUE(server.start());
+
+    BinanceAPI api;
+    api.setBaseUrl(server.getRestUrl() + "/");
+    ASSERT_TRUE(api.getBaseUrl() == server.getRestUrl());
+    ASSERT_TRUE(api.ping());
+
+    time_t now = std::time(nullptr);
+    std::vector<Candle> candles = api.getCandles("BTCUSDT", "1h", now - 10 * 3600, now, 500);
+    ASSERT_TRUE(candles.size() >= 9 && candles.size() <= 11);
+    for (size_t i = 0; i < candles.size(); i++) {
+        ASSERT_TRUE(candles[i].timestamp % 3600 == 0);
+        ASSERT_TRUE(candles[i].low <= candles[i].open && candles[i].open <= candles[i].high);
+        ASSERT_TRUE(candles[i].low <= candles[i].close && candles[i].close <= candles[i].high);
+        ASSERT_TRUE(candles[i].open > 40000 && candles[i].open < 60000);
+        if (i > 0) {
+            ASSERT_TRUE(candles[i].timestamp == candles[i - 1].timestamp + 3600);
+            ASSERT_TRUE(candles[i].open == candles[i - 1].close);
+        }
+    }
+
+    // Same series on every request
+    std::vector<Candle> again = api.getCandles("BTCUSDT", "1h", now - 10 * 3600, now, 500);
+    ASSERT_TRUE(again.size() == candles.size() && again[0].close == candles[0].close);
+
+    // Loaded candles win over generated ones
+    std::vector<Candle> loaded;
+    for (int i = 0; i < 2000; i++) {
+        Candle candle;
+        candle.symbol = "ETHUSDT";
+        candle.timeframe = "1m";
+        candle.timestamp = 1704067200 + i * 60;
+        candle.open = candle.high = candle.low = candle.close = 2000.0 + i;
+        candle.volume = 1.0;
+        loaded.push_back(candle);
+    }
+    server.addCandles(loaded);
+    candles = api.getCandles("ETHUSDT", "1m", 1704067200 + 100 * 60, 1704067200 + 3000 * 60, 1000);
+    ASSERT_TRUE(candles.size() == 1000);
+    ASSERT_TRUE(candles.front().timestamp == 1704067200 + 100 * 60);
+    ASSERT_TRUE(candles.front().close == 2100.0 && candles.back().close == 3099.0);
+
+    ASSERT_TRUE(api.getCandles("NOPEUSDT", "1h", now - 3600, now, 10).empty());
+    server.stop();
+}
+
+// Test: request weight is counted and answered with 429 past the limit,
+// after which the client holds requests back instead of sending them
+TEST(rate_limit) {
+    MockServerConfig config;
+    config.weightLimit = 20;
+    MockBinanceServer server(config);
+    ASSERT_TRUE(server.start());
+
+    BinanceAPI api;
+    api.setBaseUrl(server.getRestUrl());
+    api.setMaxRateLimitWait(std::chrono::milliseconds(100));
+
+    // Depth with limit 100 weighs 5
+    for (int i = 0; i < 4; i++) {
+        OrderBook book = api.getOrderBook("BTCUSDT", 100);
+        ASSERT_TRUE(book.bids.size() == 20 && book.asks.size() == 20);
+        ASSERT_TRUE(book.bids[0].price < book.asks[0].price);
+        ASSERT_TRUE(book.lastUpdateId > 0);
+    }
+    ASSERT_TRUE(server.getRateLimitedCount() == 0);
+    ASSERT_TRUE(api.getRateLimiter()->getAvailable(RateLimiter::REQUEST_WEIGHT) < 5990);
+
+    ASSERT_TRUE(api.getOrderBook("BTCUSDT", 100).bids.empty());
+    ASSERT_TRUE(server.getRateLimitedCount() == 1);
+    ASSERT_TRUE(api.getRateLimiter()->getRejectedCount() == 1);
+
+    // Retry-After holds the next request back; it never reaches the server
+    ASSERT_TRUE(api.getCandles("BTCUSDT", "1h", std::time(nullptr) - 3600, std::time(nullptr), 1).empty());
+    ASSERT_TRUE(server.getRequestCount() == 5);
+    server.stop();
+}
+
+// Test: BinanceWebSocket receives synthetic trades, klines and depth diffs
+// that continue the REST snapshot
+TEST(streams) {
+    MockServerConfig config;
+    config.symbols = { "BTCUSDT", "ETHUSDT" };
+    config.tradesPerSecond = 200;
+    config.depthIntervalMs = 20;
+    config.klineUpdateMs = 50;
+    MockBinanceServer server(config);
+    ASSERT_TRUE(server.start());
+
+    BinanceAPI api;
+    api.setBaseUrl(server.getRestUrl());
+    BinanceWebSocket webSocket;
+    webSocket.setStreamUrl(server.getStreamUrl() + "/");
+
+    std::vector<TradeUpdate> trades;
+    std::vector<KlineUpdate> klines;
+    std::vector<DepthUpdate> depth;
+    ASSERT_TRUE(webSocket.subscribeTrades("BTCUSDT", [&trades](const TradeUpdate& trade) {
+        trades.push_back(trade);
+    }));
+    ASSERT_TRUE(webSocket.subscribeKlines("BTCUSDT", "1m", [&klines](const KlineUpdate& kline) {
+        klines.push_back(kline);
+    }));
+    ASSERT_TRUE(webSocket.subscribeDepth("BTCUSDT", [&depth](const DepthUpdate& update) {
+        depth.push_back(update);
+    }));
+    ASSERT_TRUE(webSocket.connect());
+
+    ASSERT_TRUE(pumpUntil(webSocket, [&]() {
+        return trades.size() >= 50 && klines.size() >= 3 && depth.size() >= 10;
+    }, 5000));
+    OrderBook snapshot = api.getOrderBook("BTCUSDT", 1000);
+
+    for (size_t i = 1; i < trades.size(); i++) {
+        ASSERT_TRUE(trades[i].tradeId == trades[i - 1].tradeId + 1);
+        ASSERT_TRUE(trades[i].symbol == "BTCUSDT" && trades[i].price > 0);
+    }
+    ASSERT_TRUE(klines.back().interval == "1m" && klines.back().openTime % 60 == 0);
+    ASSERT_TRUE(klines.back().low <= klines.back().close && klines.back().close <= klines.back().high);
+    for (size_t i = 1; i < depth.size(); i++) {
+        ASSERT_TRUE(depth[i].firstUpdateId == depth[i - 1].finalUpdateId + 1);
+    }
+
+    // A later diff bridges the snapshot, as LocalOrderBook expects
+    size_t seen = depth.size();
+    ASSERT_TRUE(pumpUntil(webSocket, [&]() {
+        for (size_t i = seen; i < depth.size(); i++) {
+            if (depth[i].finalUpdateId > snapshot.lastUpdateId) {
+                return true;
+            }
+        }
+        return false;
+    }, 2000));
+    bool bridged = false;
+    for (size_t i = seen; i < depth.size(); i++) {
+        if (depth[i].firstUpdateId <= snapshot.lastUpdateId + 1 &&
+            depth[i].finalUpdateId >= snapshot.lastUpdateId + 1) {
+            bridged = true;
+        }
+    }
+    ASSERT_TRUE(bridged);
+
+    // Live SUBSCRIBE of a second symbol
+    std::vector<TradeUpdate> ethTrades;
+    ASSERT_TRUE(webSocket.subscribeTrades("ETHUSDT", [&ethTrades](const TradeUpdate& trade) {
+        ethTrades.push_back(trade);
+    }));
+    ASSERT_TRUE(pumpUntil(webSocket, [&]() { return ethTrades.size() >= 10; }, 5000));
+    ASSERT_TRUE(ethTrades[0].symbol == "ETHUSDT");
+    ASSERT_TRUE(server.getStreamConnectionCount() == 1);
+
+    webSocket.disconnect();
+    server.stop();
+    ASSERT_TRUE(server.getMessagesSent() > 0);
+    ASSERT_FALSE(server.isRunning());
+}
+
+// Test: when a later connection is refused, connect() closes the ones it
+// already opened, and a retry against a server that allows them all works
+TEST(partial_connect) {
+    MockServerConfig config;
+    config.symbols = { "BTCUSDT", "ETHUSDT", "BNBUSDT" };
+    config.tradesPerSecond = 100;
+    config.maxStreamConnections = 1;
+    MockBinanceServer limited(config);
+    ASSERT_TRUE(limited.start());
+
+    BinanceWebSocket webSocket;
+    webSocket.setMaxStreamsPerConnection(1);
+    webSocket.setStreamUrl(limited.getStreamUrl());
+
+    std::vector<std::string> symbols;
+    for (const auto& symbol : config.symbols) {
+        ASSERT_TRUE(webSocket.subscribeTrades(symbol, [&symbols](const TradeUpdate& trade) {
+            if (std::find(symbols.begin(), symbols.end(), trade.symbol) == symbols.end()) {
+                symbols.push_back(trade.symbol);
+            }
+        }));
+    }
+
+    ASSERT_FALSE(webSocket.connect());
+    ASSERT_TRUE(webSocket.getConnectionCount() == 0);
+    ASSERT_FALSE(webSocket.isConnected());
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (limited.getStreamConnectionCount() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(limited.getStreamConnectionCount() == 0);
+    limited.stop();
+
+    config.maxStreamConnections = 0;
+    MockBinanceServer server(config);
+    ASSERT_TRUE(server.start());
+    webSocket.setStreamUrl(server.getStreamUrl());
+    ASSERT_TRUE(webSocket.connect());
+    ASSERT_TRUE(webSocket.getConnectionCount() == 3);
+    ASSERT_TRUE(pumpUntil(webSocket, [&]() { return symbols.size() == 3; }, 5000));
+    ASSERT_TRUE(server.getStreamConnectionCount() == 3);
+
+    webSocket.disconnect();
+    server.stop();
+}
+
+// Closed kline message for the btcusdt@kline_<interval> stream
+std::string closedKline(int64_t openTime, const std::string& interval = "1m", int64_t lengthMs = 60000) {
+    return "{\"stream\":\"btcusdt@kline_" + interval + "\",\"data\":{\"e\":\"kline\",\"E\":" +
+           std::to_string(openTime + lengthMs) + ",\"s\":\"BTCUSDT\",\"k\":{\"t\":" + std::to_string(openTime) +
+           ",\"T\":" + std::to_string(openTime + lengthMs - 1) + ",\"s\":\"BTCUSDT\",\"i\":\"" + interval +
+           "\",\"f\":100,\"L\":200,"
+           "\"o\":\"50000\",\"c\":\"50001\",\"h\":\"50002\",\"l\":\"49999\",\"v\":\"1\",\"n\":100,"
+           "\"x\":true,\"q\":\"50000\",\"V\":\"1\",\"Q\":\"2\",\"B\":\"0\"}}}";
+}
+
+// Test: after a dropped connection the missed klines are backfilled from
+// REST, live klines are held until then, and none arrive twice
+TEST(kline_backfill) {
+    MockServerConfig config;
+    config.klineUpdateMs = 50;
+    MockBinanceServer server(config);
+    ASSERT_TRUE(server.start());
+
+    BinanceAPI api;
+    api.setBaseUrl(server.getRestUrl());
+    std::atomic<bool> fetching(false);
+    std::atomic<bool> release(false);
+    BinanceWebSocket webSocket;
+    webSocket.setStreamUrl(server.getStreamUrl());
+    webSocket.setKlineBackfill([&](const std::string& symbol, const std::string& interval,
+                                   time_t startTime, time_t endTime) {
+        fetching = true;
+        while (!release) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return api.getCandles(symbol, interval, startTime, endTime, 1000);
+    });
+
+    std::vector<KlineUpdate> klines;
+    ASSERT_TRUE(webSocket.subscribeKlines("BTCUSDT", "1m", [&klines](const KlineUpdate& kline) {
+        klines.push_back(kline);
+    }));
+    ASSERT_TRUE(webSocket.connect());
+    ASSERT_TRUE(pumpUntil(webSocket, [&]() { return !klines.empty(); }, 5000));
+
+    // The last closed kline seen before the drop is ten minutes old
+    int64_t first = (static_cast<int64_t>(std::time(nullptr)) / 60 - 10) * 60000;
+    webSocket.injectMessage(closedKline(first));
+    ASSERT_TRUE(pumpUntil(webSocket, [&]() { return klines.back().isClosed; }, 2000));
+    klines.clear();
+
+    server.dropStreamConnections();
+    ASSERT_TRUE(pumpUntil(webSocket, [&]() { return fetching.load(); }, 5000));
+
+    // Live klines and replays of delivered or soon backfilled ones wait
+    webSocket.injectMessage(closedKline(first));
+    webSocket.injectMessage(closedKline(first + 3 * 60000));
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    pumpUntil(webSocket, [&]() { return std::chrono::steady_clock::now() >= deadline; }, 1000);
+    ASSERT_TRUE(klines.empty());
+    ASSERT_TRUE(webSocket.isConnected());
+
+    release = true;
+    ASSERT_TRUE(pumpUntil(webSocket, [&]() { return !klines.empty() && !klines.back().isClosed; }, 5000));
+    webSocket.disconnect();
+    server.stop();
+
+    // Every minute since the last closed kline, once and in order, then
+    // the live open kline
+    int64_t expected = first + 60000;
+    for (const auto& kline : klines) {
+        if (kline.isClosed) {
+            ASSERT_TRUE(kline.openTime == expected);
+            expected += 60000;
+        } else {
+            ASSERT_TRUE(kline.openTime >= expected - 60000);
+        }
+    }
+    ASSERT_TRUE(expected - first >= 10 * 60000);
+    ASSERT_TRUE(klines.back().openTime == expected || klines.back().openTime == expected - 60000);
+}
+
+// Test: a monthly stream is backfilled from the 1st of the next month,
+// not 30 days after the last closed kline
+TEST(monthly_backfill) {
+    MockBinanceServer server;
+    ASSERT_TRUE(server.start());
+
+    const time_t january = 1704067200;  // 2024-01-01
+    const time_t february = january + 31 * 86400;
+    std::vector<time_t> requested;
+    BinanceWebSocket webSocket;
+    webSocket.setStreamUrl(server.getStreamUrl());
+    webSocket.setKlineBackfill([&requested](const std::string& symbol, const std::string& interval,
+                                            time_t startTime, time_t endTime) {
+        requested.push_back(startTime);
+        std::vector<Candle> candles;
+        for (time_t month = CandleResampler::alignTimestamp(startTime, interval); month <= endTime;
+             month = CandleResampler::nextBucketStart(month, interval)) {
+            Candle candle;
+            candle.symbol = symbol;
+            candle.timeframe = interval;
+            candle.timestamp = month;
+            candle.open = candle.high = candle.low = candle.close = 50000.0;
+            candle.volume = 1.0;
+            candles.push_back(candle);
+        }
+        return candles;
+    });
+
+    std::vector<KlineUpdate> klines;
+    ASSERT_TRUE(webSocket.subscribeKlines("BTCUSDT", "1M", [&klines](const KlineUpdate& kline) {
+        klines.push_back(kline);
+    }));
+    ASSERT_TRUE(webSocket.connect());
+    webSocket.injectMessage(closedKline(static_cast<int64_t>(january) * 1000, "1M", 31 * 86400000LL));
+    ASSERT_TRUE(pumpUntil(webSocket, [&]() { return !klines.empty(); }, 2000));
+    klines.clear();
+
+    server.dropStreamConnections();
+    time_t current = CandleResampler::alignTimestamp(std::time(nullptr), "1M");
+    ASSERT_TRUE(pumpUntil(webSocket, [&]() {
+        return !klines.empty() && klines.back().isClosed && klines.back().openTime / 1000 >= current - 31 * 86400;
+    }, 5000));
+    webSocket.disconnect();
+    server.stop();
+
+    ASSERT_TRUE(!requested.empty() && requested[0] == february);
+    time_t expected = february;
+    for (const auto& kline : klines) {
+        if (!kline.isClosed) {
+            continue;
+        }
+        time_t next = CandleResampler::nextBucketStart(expected, "1M");
+        ASSERT_TRUE(kline.openTime == static_cast<int64_t>(expected) * 1000);
+        ASSERT_TRUE(kline.closeTime == static_cast<int64_t>(next) * 1000 - 1);
+        expected = next;
+    }
+    ASSERT_TRUE(expected == current);
+}
+
+int main() {
+    std::cout << "=== Mock Binance Server Tests ===" << std::endl;
+
+    RUN_TEST(rest_klines);
+    RUN_TEST(rate_limit);
+    RUN_TEST(streams);
+    RUN_TEST(partial_connect);
+    RUN_TEST(kline_backfill);
+    RUN_TEST(monthly_backfill);
+
+    std::cout << "\nAll mock Binance server tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,181 @@
+#include "../exchange/RateLimiter.h"
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+#define ASSERT_NEAR(a, b, eps) ASSERT_TRUE(std::fabs((a) - (b)) < (eps))
+
+typedef RateLimiter::Clock Clock;
+
+double msFromNow(Clock::time_point when) {
+    return std::chrono::duration<double, std::milli>(when - Clock::now()).count();
+}
+
+// Test: reservations past the bucket are spaced by the refill rate, in order
+TEST(reservations_queue) {
+    RateLimiter limiter;
+    limiter.setLimit(RateLimiter::REQUEST_WEIGHT, 100, 1);  // 100 per second
+
+    Clock::time_point first = limiter.reserve(60);
+    Clock::time_point second = limiter.reserve(60);
+    Clock::time_point third = limiter.reserve(60);
+    ASSERT_TRUE(msFromNow(first) <= 0);
+    ASSERT_NEAR(msFromNow(second), 200, 20);
+    ASSERT_NEAR(msFromNow(third), 800, 20);
+    ASSERT_TRUE(limiter.getAvailable(RateLimiter::REQUEST_WEIGHT) < -70);
+
+    // Heavier than the bucket: waits for a full one, not forever
+    RateLimiter small;
+    small.setLimit(RateLimiter::REQUEST_WEIGHT, 10, 1);
+    ASSERT_TRUE(msFromNow(small.reserve(250)) <= 0);
+    ASSERT_NEAR(msFromNow(small.reserve(250)), 1000, 20);
+}
+
+// Test: acquire() takes nothing when the wait would be too long
+TEST(acquire_max_wait) {
+    RateLimiter limiter;
+    limiter.setLimit(RateLimiter::REQUEST_WEIGHT, 10, 10);  // 1 per second
+
+    ASSERT_TRUE(limiter.acquire(10, false, std::chrono::milliseconds(0)));
+    ASSERT_FALSE(limiter.acquire(5, false, std::chrono::milliseconds(100)));
+    ASSERT_NEAR(limiter.getAvailable(RateLimiter::REQUEST_WEIGHT), 0, 0.5);
+
+    auto start = Clock::now();
+    ASSERT_TRUE(limiter.acquire(1, false, std::chrono::milliseconds(2000)));
+    ASSERT_TRUE(Clock::now() - start >= std::chrono::milliseconds(900));
+}
+
+// Test: the server's used weight lowers the estimate, never raises it
+TEST(used_weight_feedback) {
+    RateLimiter limiter;
+    limiter.setLimit(RateLimiter::REQUEST_WEIGHT, 1000, 60);
+
+    limiter.reserve(50);   // Still in flight
+    limiter.reserve(10);
+    RateLimitFeedback feedback;
+    feedback.status = 200;
+    feedback.usedWeight = 900;  // Another client on the same IP used a lot
+    limiter.complete(10, feedback);
+    ASSERT_NEAR(limiter.getAvailable(RateLimiter::REQUEST_WEIGHT), 1000 - 900 - 50, 1);
+
+    feedback.usedWeight = 5;
+    limiter.complete(50, feedback);
+    ASSERT_NEAR(limiter.getAvailable(RateLimiter::REQUEST_WEIGHT), 50, 1);
+
+    // Missing headers change nothing
+    limiter.complete(0, RateLimitFeedback());
+    ASSERT_NEAR(limiter.getAvailable(RateLimiter::REQUEST_WEIGHT), 50, 1);
+}
+
+// Test: 429/418 hold every request back for Retry-After
+TEST(retry_after) {
+    RateLimiter limiter;
+    RateLimitFeedback feedback;
+    feedback.status = 429;
+    feedback.retryAfterSeconds = 2;
+    limiter.complete(1, feedback);
+    ASSERT_TRUE(limiter.getRejectedCount() == 1);
+    ASSERT_FALSE(limiter.acquire(1, false, std::chrono::milliseconds(500)));
+    ASSERT_NEAR(msFromNow(limiter.reserve(1)), 2000, 50);
+
+    feedback.status = 418;
+    feedback.retryAfterSeconds = 5;
+    limiter.complete(1, feedback);
+    ASSERT_TRUE(limiter.getRejectedCount() == 2);
+    ASSERT_NEAR(msFromNow(limiter.reserve(1)), 5000, 50);
+    ASSERT_TRUE(limiter.getTotalWaitMs() >= 6900);
+}
+
+// Test: orders draw from their own buckets as well as request weight
+TEST(order_buckets) {
+    RateLimiter limiter;
+    limiter.setLimit(RateLimiter::ORDERS_10S, 2, 10);
+
+    ASSERT_TRUE(msFromNow(limiter.reserve(1, true)) <= 0);
+    ASSERT_TRUE(msFromNow(limiter.reserve(1, true)) <= 0);
+    ASSERT_NEAR(msFromNow(limiter.reserve(1, true)), 5000, 50);
+    ASSERT_TRUE(msFromNow(limiter.reserve(1, false)) <= 0);  // Not an order
+
+    RateLimitFeedback feedback;
+    feedback.orderCount1d = 199999;
+    limiter.complete(0, feedback);
+    ASSERT_NEAR(limiter.getAvailable(RateLimiter::ORDERS_1D), 1, 0.1);
+}
+
+// Test: concurrent callers together stay within the rate
+TEST(concurrent_callers) {
+    RateLimiter limiter;
+    limiter.setLimit(RateLimiter::REQUEST_WEIGHT, 1000, 1);  // 1000 per second
+
+    const int kThreads = 8;
+    const int kRequests = 20;
+    std::atomic<int> sent(0);
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < kRequests; i++) {
+                if (limiter.acquire(10, false, std::chrono::milliseconds(5000))) {
+                    sent++;
+                    limiter.complete(10, RateLimitFeedback());
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed = Clock::now() - start;
+
+    // 1600 weight, 1000 up front then 1000 per second: at least 0.6s
+    ASSERT_TRUE(sent == kThreads * kRequests);
+    ASSERT_TRUE(elapsed >= std::chrono::milliseconds(580));
+    ASSERT_TRUE(elapsed < std::chrono::milliseconds(1500));
+}
+
+// Test: one limiter per host
+TEST(shared_per_host) {
+    std::shared_ptr<RateLimiter> a = RateLimiter::forHost("https://api.binance.com");
+    std::shared_ptr<RateLimiter> b = RateLimiter::forHost("https://api.binance.com");
+    std::shared_ptr<RateLimiter> c = RateLimiter::forHost("http://127.0.0.1:9700");
+    ASSERT_TRUE(a == b);
+    ASSERT_TRUE(a != c);
+    ASSERT_TRUE(a->getCapacity(RateLimiter::REQUEST_WEIGHT) == 6000);
+}
+
+int main() {
+    std::cout << "=== Rate Limiter Tests ===" << std::endl;
+
+    RUN_TEST(reservations_queue);
+    RUN_TEST(acquire_max_wait);
+    RUN_TEST(used_weight_feedback);
+    RUN_TEST(retry_after);
+    RUN_TEST(order_buckets);
+    RUN_TEST(concurrent_callers);
+    RUN_TEST(shared_per_host);
+
+    std::cout << "\nAll rate limiter tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "../strategy/RecipeLoader.h"
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+#define ASSERT_NEAR(a, b, epsilon) ASSERT_TRUE(std::abs((a) - (b)) < (epsilon))
+
+const char* kRecipesDir = "../../recipes";
+
+const char* kSnakeCase = R"({
+  "name": "Snake",
+  "market": {"exchange": "binance", "symbol": "BTCUSDT", "timeframe": "1h"},
+  "capital": {"initial": 5000, "position_size_percent": 20},
+  "risk_management": {
+    "stop_loss_percent": 2.5,
+    "take_profit_percent": 6.0,
+    "max_daily_loss_percent": 4.0,
+    "max_open_positions": 3
+  },
+  "indicators": [{"name": "ema", "period": 21}, {"name": "ema", "period": 50}],
+  "entry_conditions": {
+    "logic": "OR",
+    "rules": [{"indicator": "ema_21", "operator": ">", "value": 0, "compare_with": "ema_50"}]
+  },
+  "exit_conditions": {
+    "logic": "AND",
+    "rules": [{"indicator": "ema_21", "operator": "<", "value": 0, "compare_with": "ema_50"}]
+  }
+})";
+
+const char* kCamelCase = R"({
+  "name": "Camel",
+  "market": {"exchange": "binance", "symbol": "BTCUSDT", "timeframe": "1h"},
+  "capital": {"initial": 5000, "positionSizePercent": 20},
+  "risk": {
+    "stopLossPercent": 2.5,
+    "takeProfitPercent": 6.0,
+    "maxDailyLossPercent": 4.0,
+    "maxOpenPositions": 3
+  },
+  "indicators": [{"name": "ema", "period": 21}, {"name": "ema", "period": 50}],
+  "entryConditions": {
+    "logic": "OR",
+    "rules": [{"indicator": "ema_21", "operator": ">", "value": 0, "compareWith": "ema_50"}]
+  },
+  "exitConditions": {
+    "logic": "AND",
+    "rules": [{"indicator": "ema_21", "operator": "<", "value": 0, "compareWith": "ema_50"}]
+  }
+})";
+
+void checkRecipe(const Recipe& recipe) {
+    ASSERT_NEAR(recipe.capital.positionSizePercent, 20.0, 1e-9);
+    ASSERT_NEAR(recipe.risk.stopLossPercent, 2.5, 1e-9);
+    ASSERT_NEAR(recipe.risk.takeProfitPercent, 6.0, 1e-9);
+    ASSERT_NEAR(recipe.risk.maxDailyLossPercent, 4.0, 1e-9);
+    ASSERT_TRUE(recipe.risk.maxOpenPositions == 3);
+
+    ASSERT_TRUE(recipe.entryConditions.logic == "OR");
+    ASSERT_TRUE(recipe.entryConditions.rules.size() == 1);
+    ASSERT_TRUE(recipe.entryConditions.rules[0].operatorStr == ">");
+    ASSERT_TRUE(recipe.entryConditions.rules[0].compareWith == "ema_50");
+
+    ASSERT_TRUE(recipe.exitConditions.logic == "AND");
+    ASSERT_TRUE(recipe.exitConditions.rules.size() == 1);
+    ASSERT_TRUE(recipe.exitConditions.rules[0].operatorStr == "<");
+    ASSERT_TRUE(recipe.exitConditions.rules[0].compareWith == "ema_50");
+}
+
+// Test: snake_case and camelCase section names load the same recipe
+TEST(both_spellings) {
+    RecipeLoader loader;
+    Recipe snake;
+    ASSERT_TRUE(loader.loadFromString(kSnakeCase, snake));
+    checkRecipe(snake);
+
+    Recipe camel;
+    ASSERT_TRUE(loader.loadFromString(kCamelCase, camel));
+    checkRecipe(camel);
+}
+
+// Test: defaults still apply when neither spelling is present
+TEST(defaults) {
+    RecipeLoader loader;
+    Recipe recipe;
+    ASSERT_TRUE(loader.loadFromString(R"({
+      "name": "Bare",
+      "market": {"exchange": "binance", "symbol": "BTCUSDT", "timeframe": "1h"},
+      "capital": {"initial": 1000}
+    })", recipe));
+    ASSERT_NEAR(recipe.capital.positionSizePercent, 10.0, 1e-9);
+    ASSERT_NEAR(recipe.risk.maxDailyLossPercent, 5.0, 1e-9);
+    ASSERT_TRUE(recipe.risk.maxOpenPositions == 1);
+    ASSERT_TRUE(recipe.entryConditions.logic == "AND");
+    ASSERT_TRUE(recipe.entryConditions.rules.empty());
+    ASSERT_TRUE(recipe.exitConditions.logic == "OR");
+}
+
+// Test: every bundled recipe (all camelCase) loads with its rules
+TEST(bundled_recipes) {
+    namespace fs = std::filesystem;
+    ASSERT_TRUE(fs::is_directory(kRecipesDir));
+
+    size_t loaded = 0;
+    for (const auto& entry : fs::directory_iterator(kRecipesDir)) {
+        if (entry.path().extension() != ".json") {
+            continue;
+        }
+        RecipeLoader loader;
+        Recipe recipe;
+        if (!loader.loadFromFile(entry.path().string(), recipe)) {
+            std::cerr << "Failed to load " << entry.path() << ": " << loader.getLastError() << std::endl;
+            ASSERT_TRUE(false);
+        }
+        ASSERT_FALSE(recipe.entryConditions.rules.empty());
+        ASSERT_FALSE(recipe.exitConditions.rules.empty());
+        ASSERT_TRUE(recipe.risk.stopLossPercent > 0.0);
+        loaded++;
+    }
+    ASSERT_TRUE(loaded > 0);
+}
+
+int main() {
+    std::cout << "=== Recipe Format Tests ===" << std::endl;
+
+    RUN_TEST(both_spellings);
+    RUN_TEST(defaults);
+    RUN_TEST(bundled_recipes);
+
+    std::cout << "\nAll recipe format tests passed!" << std::endl;
+    return 0;
+}
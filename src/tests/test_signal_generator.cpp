@@ -0,0 +1,260 @@
+#include "../strategy/SignalGenerator.h"
+#include "../strategy/Indicators.h"
+#include "../data/CandleResampler.h"
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+const time_t kStart = 1704067200;  // 2024-01-01 00:00 UTC
+
+// 'count' candles of 'seconds' from 'start'; close = 100 + index
+std::vector<Candle> makeCandles(const std::string& timeframe, time_t start, int seconds, size_t count) {
+    std::vector<Candle> candles;
+    for (size_t i = 0; i < count; i++) {
+        Candle candle;
+        candle.exchange = "binance";
+        candle.symbol = "BTCUSDT";
+        candle.timeframe = timeframe;
+        candle.timestamp = start + static_cast<time_t>(i) * seconds;
+        candle.open = 100.0 + i;
+        candle.close = 100.0 + i + 0.5;
+        candle.high = candle.close + 1.0;
+        candle.low = candle.open - 1.0;
+        candle.volume = 1.0;
+        candles.push_back(candle);
+    }
+    return candles;
+}
+
+IndicatorConfig makeIndicator(const std::string& name, int period, const std::string& timeframe = "") {
+    IndicatorConfig indicator;
+    indicator.name = name;
+    indicator.period = period;
+    indicator.timeframe = timeframe;
+    return indicator;
+}
+
+TradingRule makeRule(const std::string& indicator, const std::string& op, double value,
+                     const std::string& compareWith = "") {
+    return { indicator, op, value, compareWith };
+}
+
+// Hourly recipe whose only entry rule is 'rule'
+Recipe makeRecipe(const std::vector<IndicatorConfig>& indicators, const TradingRule& rule) {
+    Recipe recipe;
+    recipe.name = "Signal test";
+    recipe.market = { "binance", "BTCUSDT", "1h" };
+    recipe.capital = { 1000.0, 50.0 };
+    recipe.risk = { 0.0, 0.0, 0.0, 1 };
+    recipe.indicators = indicators;
+    recipe.entryConditions.logic = "AND";
+    recipe.entryConditions.rules.push_back(rule);
+    recipe.exitConditions.logic = "OR";
+    return recipe;
+}
+
+// Test: each base candle maps to the last higher candle closed by its own close
+TEST(index_map) {
+    std::vector<Candle> hourly = makeCandles("1h", kStart, 3600, 72);
+    std::vector<Candle> daily = makeCandles("1d", kStart, 86400, 3);
+
+    std::vector<int> map = SignalGenerator::buildTimeframeIndexMap(hourly, "1h", daily, "1d");
+    ASSERT_TRUE(map.size() == hourly.size());
+    for (size_t i = 0; i < 23; i++) {
+        ASSERT_TRUE(map[i] == -1);
+    }
+    ASSERT_TRUE(map[23] == 0);   // Closes at 24:00 with the first day
+    ASSERT_TRUE(map[24] == 0);
+    ASSERT_TRUE(map[46] == 0);
+    ASSERT_TRUE(map[47] == 1);
+    ASSERT_TRUE(map[71] == 2);
+
+    // Higher candles that start before the base series
+    std::vector<Candle> earlier = makeCandles("1d", kStart - 2 * 86400, 86400, 5);
+    map = SignalGenerator::buildTimeframeIndexMap(hourly, "1h", earlier, "1d");
+    ASSERT_TRUE(map[0] == 1);
+    ASSERT_TRUE(map[22] == 1);
+    ASSERT_TRUE(map[23] == 2);
+
+    // Calendar buckets: a weekly candle opening on Monday 2024-01-01 closes
+    // seven days later, not on a multiple of 604800
+    std::vector<Candle> daily14 = makeCandles("1d", kStart, 86400, 14);
+    std::vector<Candle> weekly = makeCandles("1w", kStart, 7 * 86400, 2);
+    map = SignalGenerator::buildTimeframeIndexMap(daily14, "1d", weekly, "1w");
+    ASSERT_TRUE(map[5] == -1);
+    ASSERT_TRUE(map[6] == 0);
+    ASSERT_TRUE(map[13] == 1);
+
+    ASSERT_TRUE(SignalGenerator::buildTimeframeIndexMap(hourly, "1h", {}, "1d") ==
+                std::vector<int>(hourly.size(), -1));
+}
+
+// Test: a daily value becomes visible with the hourly candle that closes the day
+TEST(close_time_alignment) {
+    std::vector<Candle> hourly = makeCandles("1h", kStart, 3600, 72);
+
+    // close == close@1d only where the day's close is the hour's own close
+    SignalGenerator generator;
+    generator.loadRecipe(makeRecipe({ makeIndicator("sma", 2, "1d") },
+                                    makeRule("close", "==", 0.0, "close@1d")));
+    ASSERT_TRUE(generator.precalculateIndicators(hourly));
+    for (size_t i = 0; i < hourly.size(); i++) {
+        ASSERT_TRUE(generator.checkEntryConditionsAt(i) == (i % 24 == 23));
+    }
+
+    // sma_2@1d needs two closed days
+    generator.loadRecipe(makeRecipe({ makeIndicator("sma", 2, "1d") },
+                                    makeRule("sma_2@1d", ">", 0.0)));
+    ASSERT_TRUE(generator.precalculateIndicators(hourly));
+    ASSERT_FALSE(generator.checkEntryConditionsAt(46));
+    ASSERT_TRUE(generator.checkEntryConditionsAt(47));
+}
+
+// Test: changing later candles never changes earlier signals
+TEST(no_look_ahead) {
+    std::vector<Candle> calm = makeCandles("1h", kStart, 3600, 72);
+    std::vector<Candle> spiked = calm;
+    for (size_t i = 30; i < spiked.size(); i++) {
+        spiked[i].close = 5000.0;
+        spiked[i].high = 5001.0;
+    }
+
+    Recipe recipe = makeRecipe({ makeIndicator("ema", 2, "1d") },
+                               makeRule("close@1d", ">", 1000.0));
+    SignalGenerator a;
+    SignalGenerator b;
+    a.loadRecipe(recipe);
+    b.loadRecipe(recipe);
+    ASSERT_TRUE(a.precalculateIndicators(calm));
+    ASSERT_TRUE(b.precalculateIndicators(spiked));
+
+    // Day 1 (hours 24..47) contains the spike but closes at hour 47
+    for (size_t i = 0; i < 47; i++) {
+        ASSERT_FALSE(a.checkEntryConditionsAt(i));
+        ASSERT_FALSE(b.checkEntryConditionsAt(i));
+    }
+    ASSERT_FALSE(a.checkEntryConditionsAt(47));
+    ASSERT_TRUE(b.checkEntryConditionsAt(47));
+}
+
+// Test: "<name>_<period>" and "<name>_<period>@<timeframe>" keys
+TEST(indicator_keys) {
+    std::vector<Candle> hourly = makeCandles("1h", kStart, 3600, 96);
+    std::vector<double> closes = Indicators::getClosePrices(hourly);
+    std::vector<double> ema3 = Indicators::ema(closes, 3);
+    std::vector<double> ema5 = Indicators::ema(closes, 5);
+
+    std::vector<Candle> daily = CandleResampler::resample(hourly, "1d");
+    ASSERT_TRUE(daily.size() == 4);
+    std::vector<double> dailyEma2 = Indicators::ema(Indicators::getClosePrices(daily), 2);
+
+    std::vector<IndicatorConfig> indicators = {
+        makeIndicator("ema", 3), makeIndicator("ema", 5), makeIndicator("ema", 2, "1d")
+    };
+
+    size_t index = 60;
+    SignalGenerator generator;
+    generator.loadRecipe(makeRecipe(indicators, makeRule("ema_3", "==", ema3[index])));
+    ASSERT_TRUE(generator.precalculateIndicators(hourly));
+    ASSERT_TRUE(generator.checkEntryConditionsAt(index));
+    ASSERT_FALSE(generator.checkEntryConditionsAt(index + 1));
+
+    generator.loadRecipe(makeRecipe(indicators, makeRule("ema_5", "==", ema5[index])));
+    ASSERT_TRUE(generator.precalculateIndicators(hourly));
+    ASSERT_TRUE(generator.checkEntryConditionsAt(index));
+
+    // Two periods side by side: EMA 3 follows a rising series more closely
+    generator.loadRecipe(makeRecipe(indicators, makeRule("ema_3", ">", 0.0, "ema_5")));
+    ASSERT_TRUE(generator.precalculateIndicators(hourly));
+    ASSERT_TRUE(generator.checkEntryConditionsAt(index));
+
+    // Hour 60 falls on day 2; the last closed day is day 1
+    ASSERT_FALSE(std::isnan(dailyEma2[1]));
+    for (const std::string& key : { "ema@1d", "ema_2@1d" }) {
+        generator.loadRecipe(makeRecipe(indicators, makeRule(key, "==", dailyEma2[1])));
+        ASSERT_TRUE(generator.precalculateIndicators(hourly));
+        ASSERT_TRUE(generator.checkEntryConditionsAt(index));
+        ASSERT_TRUE(generator.checkEntryConditionsAt(47));
+        ASSERT_FALSE(generator.checkEntryConditionsAt(71));
+    }
+}
+
+// Test: a supplied series replaces resampling and brings its own history
+TEST(supplied_series) {
+    std::vector<Candle> hourly = makeCandles("1h", kStart, 3600, 48);
+    std::vector<Candle> daily = makeCandles("1d", kStart - 5 * 86400, 86400, 7);
+
+    SignalGenerator generator;
+    generator.setTimeframeCandles("1d", daily);
+    generator.loadRecipe(makeRecipe({ makeIndicator("sma", 3, "1d") },
+                                    makeRule("sma_3@1d", ">", 0.0)));
+    ASSERT_TRUE(generator.precalculateIndicators(hourly));
+
+    // Warmed up before the first hourly candle; resampling would leave
+    // it empty until three days had closed
+    for (size_t i = 0; i < hourly.size(); i++) {
+        ASSERT_TRUE(generator.checkEntryConditionsAt(i));
+    }
+
+    // The value at hour 0 is the mean of days -3..-1, not of later days
+    double expected = (daily[2].close + daily[3].close + daily[4].close) / 3.0;
+    generator.loadRecipe(makeRecipe({ makeIndicator("sma", 3, "1d") },
+                                    makeRule("sma_3@1d", "==", expected)));
+    ASSERT_TRUE(generator.precalculateIndicators(hourly));
+    ASSERT_TRUE(generator.checkEntryConditionsAt(0));
+    ASSERT_FALSE(generator.checkEntryConditionsAt(23));
+}
+
+// Test: history to load per higher timeframe
+TEST(timeframe_warmup) {
+    IndicatorConfig macd = makeIndicator("macd", 26, "4h");
+    macd.params["fast_period"] = 12;
+    macd.params["slow_period"] = 30;
+    macd.params["signal_period"] = 9;
+    Recipe recipe = makeRecipe({ makeIndicator("rsi", 14), makeIndicator("ema", 50, "1d"),
+                                 makeIndicator("rsi", 14, "1d"), macd },
+                               makeRule("rsi", ">", 0.0));
+
+    std::map<std::string, int> warmup = SignalGenerator::getTimeframeWarmup(recipe);
+    ASSERT_TRUE(warmup.size() == 2);
+    ASSERT_TRUE(warmup["1d"] == 100);
+    ASSERT_TRUE(warmup["4h"] == 60);
+
+    ASSERT_TRUE(SignalGenerator::getTimeframeWarmup(
+        makeRecipe({ makeIndicator("rsi", 14) }, makeRule("rsi", ">", 0.0))).empty());
+}
+
+int main() {
+    std::cout << "=== Signal Generator Tests ===" << std::endl;
+
+    RUN_TEST(index_map);
+    RUN_TEST(close_time_alignment);
+    RUN_TEST(no_look_ahead);
+    RUN_TEST(indicator_keys);
+    RUN_TEST(supplied_series);
+    RUN_TEST(timeframe_warmup);
+
+    std::cout << "\nAll signal generator tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include "../exchange/StreamCapture.h"
+#include "../exchange/StreamReplay.h"
+#include "../exchange/BinanceWebSocket.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+const char* kCapturePath = "/tmp/test_stream_capture.emgw";
+
+std::string tradeMessage(long id, double price) {
+    return "{\"stream\":\"btcusdt@trade\",\"data\":{\"e\":\"trade\",\"E\":1704067260123,\"s\":\"BTCUSDT\","
+           "\"t\":" + std::to_string(id) + ",\"p\":\"" + std::to_string(price) + "\",\"q\":\"0.01200000\","
+           "\"T\":1704067260120,\"m\":true,\"M\":true}}";
+}
+
+std::vector<CaptureRecord> readAll(StreamCaptureReader& reader) {
+    std::vector<CaptureRecord> records;
+    CaptureRecord record;
+    while (reader.next(record)) {
+        records.push_back(record);
+    }
+    return records;
+}
+
+// Test: records round-trip, and reopening appends
+TEST(round_trip) {
+    std::remove(kCapturePath);
+    std::string large(100000, 'x');
+
+    StreamCaptureWriter writer;
+    ASSERT_TRUE(writer.open(kCapturePath));
+    ASSERT_TRUE(writer.append(0, 1000, "first", 5));
+    ASSERT_TRUE(writer.append(2, 2000, "", 0));
+    ASSERT_TRUE(writer.append(1, 3000, large.data(), large.size()));
+    ASSERT_TRUE(writer.getRecordCount() == 3);
+    writer.close();
+    ASSERT_FALSE(writer.append(0, 4000, "closed", 6));
+
+    ASSERT_TRUE(writer.open(kCapturePath));
+    ASSERT_TRUE(writer.append(3, 4000, "appended", 8));
+    ASSERT_TRUE(writer.flush());
+
+    StreamCaptureReader reader;
+    ASSERT_TRUE(reader.open(kCapturePath));
+    std::vector<CaptureRecord> records = readAll(reader);
+    ASSERT_TRUE(records.size() == 4);
+    ASSERT_TRUE(records[0].timestamp == 1000 && records[0].connection == 0 && records[0].payload == "first");
+    ASSERT_TRUE(records[1].connection == 2 && records[1].payload.empty());
+    ASSERT_TRUE(records[2].payload == large);
+    ASSERT_TRUE(records[3].timestamp == 4000 && records[3].payload == "appended");
+    ASSERT_FALSE(reader.isTruncated());
+    writer.close();
+
+    // Not a capture
+    FILE* file = fopen(kCapturePath, "wb");
+    fputs("timestamp,open,high,low,close,volume\n", file);
+    fclose(file);
+    ASSERT_FALSE(reader.open(kCapturePath));
+    ASSERT_FALSE(writer.open(kCapturePath));
+    std::remove(kCapturePath);
+}
+
+// Test: a record cut short by a crash ends reading and is dropped on append
+TEST(truncated_record) {
+    std::remove(kCapturePath);
+    StreamCaptureWriter writer;
+    ASSERT_TRUE(writer.open(kCapturePath));
+    writer.append(0, 1, "complete", 8);
+    writer.append(0, 2, "cut short", 9);
+    writer.close();
+
+    FILE* file = fopen(kCapturePath, "rb");
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    ASSERT_TRUE(truncate(kCapturePath, size - 3) == 0);
+
+    StreamCaptureReader reader;
+    ASSERT_TRUE(reader.open(kCapturePath));
+    ASSERT_TRUE(readAll(reader).size() == 1);
+    ASSERT_TRUE(reader.isTruncated());
+
+    ASSERT_TRUE(writer.open(kCapturePath));
+    writer.append(0, 3, "after", 5);
+    writer.close();
+
+    ASSERT_TRUE(reader.open(kCapturePath));
+    std::vector<CaptureRecord> records = readAll(reader);
+    ASSERT_FALSE(reader.isTruncated());
+    ASSERT_TRUE(records.size() == 2);
+    ASSERT_TRUE(records[0].payload == "complete" && records[1].payload == "after");
+    std::remove(kCapturePath);
+}
+
+// Test: replay dispatches every message to the subscribed callbacks, in
+// order, flat out and at a recorded pace
+TEST(replay) {
+    std::remove(kCapturePath);
+    const int kMessages = 1000;
+    const int64_t kGapNs = 100000;  // 0.1ms between messages
+
+    StreamCaptureWriter writer;
+    ASSERT_TRUE(writer.open(kCapturePath));
+    for (int i = 0; i < kMessages; i++) {
+        std::string message = tradeMessage(i, 42000.0 + i);
+        writer.append(0, 1000000000LL + i * kGapNs, message.data(), message.size());
+        if (i == 500) {
+            // Replies to SUBSCRIBE requests are captured too
+            std::string reply = "{\"result\":null,\"id\":1}";
+            writer.append(0, 1000000000LL + i * kGapNs, reply.data(), reply.size());
+        }
+    }
+    writer.close();
+
+    BinanceWebSocket webSocket;
+    std::vector<long> tradeIds;
+    ASSERT_TRUE(webSocket.subscribeTrades("BTCUSDT", [&tradeIds](const TradeUpdate& trade) {
+        tradeIds.push_back(trade.tradeId);
+    }));
+
+    StreamReplay replay;
+    ASSERT_TRUE(replay.open(kCapturePath));
+    ASSERT_TRUE(replay.play(webSocket) == kMessages + 1);
+    ASSERT_TRUE(tradeIds.size() == static_cast<size_t>(kMessages));
+    for (int i = 0; i < kMessages; i++) {
+        ASSERT_TRUE(tradeIds[i] == i);
+    }
+
+    // 100ms recorded, played at 2x: ~50ms
+    tradeIds.clear();
+    StreamReplay paced;
+    ASSERT_TRUE(paced.open(kCapturePath));
+    paced.setSpeed(2.0);
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(paced.play(webSocket) == kMessages + 1);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_TRUE(elapsed >= std::chrono::milliseconds(45));
+    ASSERT_TRUE(tradeIds.size() == static_cast<size_t>(kMessages));
+
+    // stop() from another thread
+    tradeIds.clear();
+    StreamReplay slow;
+    ASSERT_TRUE(slow.open(kCapturePath));
+    slow.setSpeed(0.001);
+    std::thread stopper([&slow]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        slow.stop();
+    });
+    ASSERT_TRUE(slow.play(webSocket) < static_cast<size_t>(kMessages));
+    stopper.join();
+
+    StreamReplay missing;
+    ASSERT_FALSE(missing.open("/nonexistent/capture.emgw"));
+    std::remove(kCapturePath);
+}
+
+int main() {
+    std::cout << "=== Stream Capture Tests ===" << std::endl;
+
+    RUN_TEST(round_trip);
+    RUN_TEST(truncated_record);
+    RUN_TEST(replay);
+
+    std::cout << "\nAll stream capture tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,541 @@
+#include "../data/DataStorage.h"
+#include "../utils/DataSyncManager.h"
+#include "../cli/MockBinanceServer.h"
+#include <sqlite3.h>
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+const char* kDbPath = "/tmp/test_sync_planner.db";
+const time_t kStart = 1704067200;  // 2024-01-01 00:00 UTC
+
+std::vector<Candle> makeCandles(const std::string& symbol, const std::string& timeframe,
+                                time_t start, int interval, int count) {
+    std::vector<Candle> candles;
+    for (int i = 0; i < count; i++) {
+        Candle candle;
+        candle.exchange = "binance";
+        candle.symbol = symbol;
+        candle.timeframe = timeframe;
+        candle.timestamp = start + static_cast<time_t>(i) * interval;
+        candle.open = candle.high = candle.low = candle.close = 100.0 + i;
+        candle.volume = 1.0;
+        candles.push_back(candle);
+    }
+    return candles;
+}
+
+// Test: the summary follows inserts, upserts and deletes
+TEST(series_info) {
+    std::remove(kDbPath);
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+
+    SeriesInfo info;
+    ASSERT_FALSE(storage.getSeriesInfo("binance", "BTCUSDT", "1h", info));
+
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1h", kStart, 3600, 100)));
+    ASSERT_TRUE(storage.getSeriesInfo("binance", "BTCUSDT", "1h", info));
+    ASSERT_TRUE(info.firstTimestamp == kStart);
+    ASSERT_TRUE(info.lastTimestamp == kStart + 99 * 3600);
+    ASSERT_TRUE(info.candleCount == 100);
+    ASSERT_TRUE(info.missingCandles(3600) == 0);
+
+    // Overlapping batch: only the 20 new candles count, the rest are updated
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1h", kStart + 90 * 3600, 3600, 30)));
+    ASSERT_TRUE(storage.getCandleCount("binance", "BTCUSDT", "1h") == 120);
+    std::vector<Candle> updated = storage.getCandles("binance", "BTCUSDT", "1h",
+                                                     kStart + 90 * 3600, kStart + 90 * 3600);
+    ASSERT_TRUE(updated.size() == 1 && updated[0].close == 100.0);
+
+    // An older candle after a hole moves the first timestamp back
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1h", kStart - 10 * 3600, 3600, 1)));
+    ASSERT_TRUE(storage.getSeriesInfo("binance", "BTCUSDT", "1h", info));
+    ASSERT_TRUE(info.firstTimestamp == kStart - 10 * 3600);
+    ASSERT_TRUE(info.candleCount == 121);
+    ASSERT_TRUE(info.missingCandles(3600) == 9);
+
+    ASSERT_TRUE(storage.insertCandles(makeCandles("ETHUSDT", "4h", kStart, 14400, 10)));
+    std::vector<SeriesInfo> all = storage.getAllSeriesInfo();
+    ASSERT_TRUE(all.size() == 2);
+    ASSERT_TRUE(all[0].symbol == "BTCUSDT" && all[1].symbol == "ETHUSDT");
+    ASSERT_TRUE(all[1].timeframe == "4h" && all[1].candleCount == 10);
+
+    ASSERT_TRUE(storage.clearCandles("binance", "BTCUSDT", "1h"));
+    ASSERT_FALSE(storage.getSeriesInfo("binance", "BTCUSDT", "1h", info));
+    ASSERT_TRUE(storage.getCandleCount("binance", "BTCUSDT", "1h") == 0);
+    ASSERT_TRUE(storage.getAllSeriesInfo().size() == 1);
+
+    storage.close();
+    std::remove(kDbPath);
+}
+
+// Test: a database written before the summary table is filled on open
+TEST(migrates_existing_database) {
+    std::remove(kDbPath);
+    sqlite3* db = nullptr;
+    ASSERT_TRUE(sqlite3_open(kDbPath, &db) == SQLITE_OK);
+    const char* oldSchema =
+        "CREATE TABLE candles (id INTEGER PRIMARY KEY AUTOINCREMENT, exchange TEXT NOT NULL,"
+        " symbol TEXT NOT NULL, timeframe TEXT NOT NULL, timestamp INTEGER NOT NULL,"
+        " open REAL NOT NULL, high REAL NOT NULL, low REAL NOT NULL, close REAL NOT NULL,"
+        " volume REAL NOT NULL, UNIQUE(exchange, symbol, timeframe, timestamp));";
+    ASSERT_TRUE(sqlite3_exec(db, oldSchema, nullptr, nullptr, nullptr) == SQLITE_OK);
+    for (int i = 0; i < 50; i++) {
+        std::string sql = "INSERT INTO candles (exchange, symbol, timeframe, timestamp, open, high, low, close, volume)"
+                          " VALUES ('binance', 'BTCUSDT', '1d', " + std::to_string(kStart + i * 86400) +
+                          ", 1, 1, 1, 1, 1);";
+        ASSERT_TRUE(sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+    }
+    sqlite3_close(db);
+
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+    SeriesInfo info;
+    ASSERT_TRUE(storage.getSeriesInfo("binance", "BTCUSDT", "1d", info));
+    ASSERT_TRUE(info.firstTimestamp == kStart);
+    ASSERT_TRUE(info.lastTimestamp == kStart + 49 * 86400);
+    ASSERT_TRUE(info.candleCount == 50);
+
+    // Reopening doesn't count twice
+    storage.close();
+    DataStorage reopened;
+    ASSERT_TRUE(reopened.init(kDbPath));
+    ASSERT_TRUE(reopened.getCandleCount("binance", "BTCUSDT", "1d") == 50);
+    reopened.close();
+    std::remove(kDbPath);
+}
+
+// Test: the planner asks only for what each series is missing
+TEST(plan_sync) {
+    std::remove(kDbPath);
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+
+    time_t now = kStart + 100 * 3600 + 1800;  // Halfway into the 101st hour
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1h", kStart, 3600, 90)));
+    ASSERT_TRUE(storage.insertCandles(makeCandles("ETHUSDT", "1h", kStart, 3600, 100)));
+
+    std::vector<SyncTask> tasks = DataSyncManager::getInstance().planSync(
+        storage, "binance", { "BTCUSDT", "ETHUSDT", "SOLUSDT" }, { "1h", "1d", "7x" }, now);
+
+    // BTC 1h partial, ETH 1h up to date, SOL 1h new, all three 1d new
+    ASSERT_TRUE(tasks.size() == 5);
+    const SyncTask& btc = tasks[0];
+    ASSERT_TRUE(btc.symbol == "BTCUSDT" && btc.timeframe == "1h");
+    ASSERT_TRUE(btc.startTime == kStart + 90 * 3600);
+    ASSERT_TRUE(btc.endTime == kStart + 99 * 3600);  // Hour 100 is still open
+    ASSERT_TRUE(btc.expectedCandles == 10);
+
+    const SyncTask& sol = tasks[1];
+    ASSERT_TRUE(sol.symbol == "SOLUSDT" && sol.timeframe == "1h");
+    ASSERT_TRUE(sol.startTime % 3600 == 0);
+    ASSERT_TRUE(sol.startTime <= now - 30 * 86400 && sol.startTime > now - 30 * 86400 - 3600);
+    ASSERT_TRUE(sol.expectedCandles == 30 * 24);
+
+    for (size_t i = 2; i < tasks.size(); i++) {
+        ASSERT_TRUE(tasks[i].timeframe == "1d");
+        ASSERT_TRUE(tasks[i].startTime % 86400 == 0);
+        ASSERT_TRUE(tasks[i].endTime == kStart + 3 * 86400);
+    }
+
+    // Once downloaded, nothing is left to do
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1h", kStart + 90 * 3600, 3600, 10)));
+    tasks = DataSyncManager::getInstance().planSync(storage, "binance", { "BTCUSDT", "ETHUSDT" }, { "1h" }, now);
+    ASSERT_TRUE(tasks.empty());
+
+    storage.close();
+    std::remove(kDbPath);
+}
+
+// Test: coverage ranges merge on insert and answer what is missing
+TEST(coverage_index) {
+    std::remove(kDbPath);
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+
+    // Two fetches with a hole between them, the second one reaching
+    // past the candles it returned (the exchange had none there)
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1h", kStart, 3600, 10),
+                                      CandleRange(kStart, kStart + 9 * 3600), 3600));
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1h", kStart + 20 * 3600, 3600, 5),
+                                      CandleRange(kStart + 20 * 3600, kStart + 29 * 3600), 3600));
+    std::vector<CandleRange> coverage = storage.getCoverage("binance", "BTCUSDT", "1h");
+    ASSERT_TRUE(coverage.size() == 2);
+    ASSERT_TRUE(coverage[1].start == kStart + 20 * 3600 && coverage[1].end == kStart + 29 * 3600);
+
+    std::vector<CandleRange> missing = storage.getMissingRanges("binance", "BTCUSDT", "1h",
+        CandleRange(kStart - 5 * 3600, kStart + 35 * 3600 + 1), 3600);
+    ASSERT_TRUE(missing.size() == 3);
+    ASSERT_TRUE(missing[0].start == kStart - 5 * 3600 && missing[0].end == kStart - 3600);
+    ASSERT_TRUE(missing[1].start == kStart + 10 * 3600 && missing[1].end == kStart + 19 * 3600);
+    ASSERT_TRUE(missing[1].candles(3600) == 10);
+    ASSERT_TRUE(missing[2].start == kStart + 30 * 3600 && missing[2].end == kStart + 35 * 3600);
+    ASSERT_TRUE(storage.getMissingRanges("binance", "BTCUSDT", "1h",
+        CandleRange(kStart + 2 * 3600, kStart + 8 * 3600), 3600).empty());
+
+    // Filling the hole joins everything into one range
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1h", kStart + 10 * 3600, 3600, 10),
+                                      CandleRange(kStart + 10 * 3600, kStart + 19 * 3600), 3600));
+    coverage = storage.getCoverage("binance", "BTCUSDT", "1h");
+    ASSERT_TRUE(coverage.size() == 1);
+    ASSERT_TRUE(coverage[0].start == kStart && coverage[0].end == kStart + 29 * 3600);
+
+    ASSERT_TRUE(storage.clearCandles("binance", "BTCUSDT", "1h"));
+    ASSERT_TRUE(storage.getCoverage("binance", "BTCUSDT", "1h").empty());
+
+    storage.close();
+    std::remove(kDbPath);
+}
+
+// Test: candles stored without a fetched range still cover what they fill
+TEST(plain_insert_coverage) {
+    std::remove(kDbPath);
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+
+    // Out of order, with a repeat, a hole at 5 and an off-grid timestamp
+    std::vector<Candle> candles = makeCandles("BTCUSDT", "1h", kStart, 3600, 10);
+    candles.erase(candles.begin() + 5);
+    std::swap(candles[0], candles[3]);
+    candles.push_back(candles[1]);
+    candles.push_back(makeCandles("BTCUSDT", "1h", kStart + 20 * 3600 + 60, 3600, 1)[0]);
+    ASSERT_TRUE(storage.insertCandles(candles));
+    std::vector<CandleRange> coverage = storage.getCoverage("binance", "BTCUSDT", "1h");
+    ASSERT_TRUE(coverage.size() == 2);
+    ASSERT_TRUE(coverage[0].start == kStart && coverage[0].end == kStart + 4 * 3600);
+    ASSERT_TRUE(coverage[1].start == kStart + 6 * 3600 && coverage[1].end == kStart + 9 * 3600);
+
+    // Planning sees only the hole and what lies beyond
+    std::vector<CandleRange> missing = storage.getMissingRanges("binance", "BTCUSDT", "1h",
+        CandleRange(kStart, kStart + 11 * 3600), 3600);
+    ASSERT_TRUE(missing.size() == 2);
+    ASSERT_TRUE(missing[0].start == kStart + 5 * 3600 && missing[0].end == kStart + 5 * 3600);
+    ASSERT_TRUE(missing[1].start == kStart + 10 * 3600 && missing[1].end == kStart + 11 * 3600);
+
+    // A single candle fills the hole
+    ASSERT_TRUE(storage.insertCandle(makeCandles("BTCUSDT", "1h", kStart + 5 * 3600, 3600, 1)[0]));
+    coverage = storage.getCoverage("binance", "BTCUSDT", "1h");
+    ASSERT_TRUE(coverage.size() == 1);
+    ASSERT_TRUE(coverage[0].start == kStart && coverage[0].end == kStart + 9 * 3600);
+
+    // Several series in one batch each get their own coverage
+    std::vector<Candle> mixed = makeCandles("ETHUSDT", "1m", kStart, 60, 3);
+    std::vector<Candle> weekly = makeCandles("ETHUSDT", "1w", kStart, 7 * 86400, 2);
+    mixed.insert(mixed.end(), weekly.begin(), weekly.end());
+    ASSERT_TRUE(storage.insertCandles(mixed));
+    coverage = storage.getCoverage("binance", "ETHUSDT", "1m");
+    ASSERT_TRUE(coverage.size() == 1 && coverage[0].end == kStart + 120);
+    ASSERT_TRUE(storage.getCoverage("binance", "ETHUSDT", "1w").empty());
+
+    storage.close();
+    std::remove(kDbPath);
+}
+
+// Test: holes in stored candles, and coverage rebuilt from them
+TEST(find_gaps) {
+    std::remove(kDbPath);
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+
+    // 0..99 with 40..44 and 70 missing
+    std::vector<Candle> candles = makeCandles("ETHUSDT", "1m", kStart, 60, 100);
+    candles.erase(candles.begin() + 70);
+    candles.erase(candles.begin() + 40, candles.begin() + 45);
+    ASSERT_TRUE(storage.insertCandles(candles));
+
+    std::vector<CandleRange> gaps = storage.findGaps("binance", "ETHUSDT", "1m",
+        CandleRange(kStart - 120, kStart + 101 * 60), 60);
+    ASSERT_TRUE(gaps.size() == 4);
+    ASSERT_TRUE(gaps[0].start == kStart - 120 && gaps[0].end == kStart - 60);
+    ASSERT_TRUE(gaps[1].start == kStart + 40 * 60 && gaps[1].end == kStart + 44 * 60);
+    ASSERT_TRUE(gaps[2].start == kStart + 70 * 60 && gaps[2].end == kStart + 70 * 60);
+    ASSERT_TRUE(gaps[3].start == kStart + 100 * 60 && gaps[3].end == kStart + 101 * 60);
+    ASSERT_TRUE(storage.findGaps("binance", "ETHUSDT", "1m", CandleRange(kStart, kStart + 39 * 60), 60).empty());
+    ASSERT_TRUE(storage.findGaps("binance", "ETHUSDT", "1m", CandleRange(kStart + 41 * 60, kStart + 43 * 60), 60).size() == 1);
+
+    // The insert covered the runs of stored candles; a rebuild finds the same
+    std::vector<CandleRange> missing = storage.getMissingRanges("binance", "ETHUSDT", "1m",
+        CandleRange(kStart, kStart + 99 * 60), 60);
+    ASSERT_TRUE(missing.size() == 2);
+    ASSERT_TRUE(missing[0].start == kStart + 40 * 60 && missing[0].end == kStart + 44 * 60);
+    ASSERT_TRUE(missing[1].start == kStart + 70 * 60 && missing[1].end == kStart + 70 * 60);
+    ASSERT_TRUE(storage.getCoverage("binance", "ETHUSDT", "1m").size() == 3);
+    ASSERT_TRUE(storage.rebuildCoverage("binance", "ETHUSDT", "1m", 60));
+    ASSERT_TRUE(storage.getCoverage("binance", "ETHUSDT", "1m").size() == 3);
+
+    storage.close();
+    std::remove(kDbPath);
+}
+
+// Test: 1w and 1M candles don't open on multiples of the interval, so
+// their series are stored but never covered
+TEST(calendar_timeframes) {
+    std::remove(kDbPath);
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+
+    // Weekly candles open on Mondays (kStart is one), not on the
+    // multiples of 604800 counted from a Thursday epoch
+    const int week = 7 * 24 * 3600;
+    ASSERT_TRUE(kStart % week != 0);
+    CandleRange fetched(kStart, kStart + 9 * week);
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1w", kStart, week, 10), fetched, week));
+    ASSERT_TRUE(storage.getCandleCount("binance", "BTCUSDT", "1w") == 10);
+    ASSERT_TRUE(storage.getCoverage("binance", "BTCUSDT", "1w").empty());
+
+    ASSERT_TRUE(storage.addCoverage("binance", "BTCUSDT", "1w", fetched, week));
+    ASSERT_TRUE(storage.getCoverage("binance", "BTCUSDT", "1w").empty());
+
+    // Always missing as a whole, unaligned, and no coverage rebuilt
+    std::vector<CandleRange> missing = storage.getMissingRanges("binance", "BTCUSDT", "1w", fetched, week);
+    ASSERT_TRUE(missing.size() == 1);
+    ASSERT_TRUE(missing[0].start == fetched.start && missing[0].end == fetched.end);
+    ASSERT_TRUE(storage.findGaps("binance", "BTCUSDT", "1w", fetched, week).empty());
+    ASSERT_FALSE(storage.rebuildCoverage("binance", "BTCUSDT", "1w", week));
+    ASSERT_TRUE(storage.getCoverage("binance", "BTCUSDT", "1w").empty());
+
+    const int month = 30 * 24 * 3600;
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1M", kStart, month, 3),
+                                      CandleRange(kStart, kStart + 2 * month), month));
+    ASSERT_TRUE(storage.getCoverage("binance", "BTCUSDT", "1M").empty());
+
+    storage.close();
+    std::remove(kDbPath);
+}
+
+// Test: weekly and monthly series are planned on Binance's calendar
+// buckets, Mondays and the 1st of the month
+TEST(calendar_plan) {
+    std::remove(kDbPath);
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+    DataSyncManager& sync = DataSyncManager::getInstance();
+
+    // Wednesday 2024-01-24: the week of Monday the 15th has closed, though
+    // the epoch grid (Thursdays) would still count it as open
+    const int day = 24 * 3600;
+    const int week = 7 * day;
+    time_t now = kStart + 23 * day + 12 * 3600;
+    ASSERT_TRUE(storage.insertCandles(makeCandles("BTCUSDT", "1w", kStart, week, 2)));
+    std::vector<SyncTask> tasks = sync.planSync(storage, "binance", { "BTCUSDT" }, { "1w" }, now);
+    ASSERT_TRUE(tasks.size() == 1);
+    ASSERT_TRUE(tasks[0].startTime == kStart + 2 * week);
+    ASSERT_TRUE(tasks[0].endTime == kStart + 2 * week);
+    ASSERT_TRUE(tasks[0].expectedCandles == 1);
+
+    // A new weekly series starts on a Monday
+    tasks = sync.planSync(storage, "binance", { "ETHUSDT" }, { "1w" }, now);
+    ASSERT_TRUE(tasks.size() == 1);
+    ASSERT_TRUE(tasks[0].startTime == kStart - week);  // Monday 2023-12-25
+    ASSERT_TRUE(tasks[0].expectedCandles == 4);
+
+    // Months: January and February 2024 stored, now is 2024-05-10
+    const time_t february = kStart + 31 * day;
+    const time_t march = february + 29 * day;
+    const time_t april = march + 31 * day;
+    std::vector<Candle> months = makeCandles("BTCUSDT", "1M", kStart, 0, 2);
+    months[1].timestamp = february;
+    ASSERT_TRUE(storage.insertCandles(months));
+    now = april + 30 * day + 9 * day + 3600;
+    tasks = sync.planSync(storage, "binance", { "BTCUSDT", "ETHUSDT" }, { "1M" }, now);
+    ASSERT_TRUE(tasks.size() == 2);
+    ASSERT_TRUE(tasks[0].startTime == march);  // Not February + 30 days
+    ASSERT_TRUE(tasks[0].endTime == april);    // May is still open
+    ASSERT_TRUE(tasks[0].expectedCandles == 2);
+    ASSERT_TRUE(tasks[1].startTime == april && tasks[1].expectedCandles == 1);
+
+    // Nothing left once April is in
+    months = makeCandles("BTCUSDT", "1M", march, 0, 2);
+    months[1].timestamp = april;
+    ASSERT_TRUE(storage.insertCandles(months));
+    ASSERT_TRUE(sync.planSync(storage, "binance", { "BTCUSDT" }, { "1M" }, now).empty());
+
+    storage.close();
+    std::remove(kDbPath);
+}
+
+// Test: concurrent fetchers against the local stand-in, one writer
+TEST(parallel_sync) {
+    std::remove(kDbPath);
+    MockServerConfig config;
+    config.symbols = { "BTCUSDT", "ETHUSDT", "SOLUSDT" };
+    MockBinanceServer server(config);
+    ASSERT_TRUE(server.start());
+    setenv("EMIGLIO_BINANCE_API_URL", server.getRestUrl().c_str(), 1);
+
+    DataSyncManager& sync = DataSyncManager::getInstance();
+    sync.setDatabasePath(kDbPath);
+    sync.setFetcherCount(3);
+
+    std::vector<int> completed;
+    int planned = 0;
+    std::vector<std::string> statuses;
+    std::thread::id callbackThread;
+    sync.setProgressCallback([&](int done, int total, const std::string& status) {
+        planned = total;
+        completed.push_back(done);
+        statuses.push_back(status);
+        callbackThread = std::this_thread::get_id();
+    });
+
+    std::vector<std::string> symbols = { "BTCUSDT", "ETHUSDT", "SOLUSDT" };
+    std::vector<std::string> timeframes = { "1h", "4h" };
+    ASSERT_TRUE(sync.syncSeries("binance", symbols, timeframes));
+
+    SyncStats stats = sync.getLastSyncStats();
+    ASSERT_TRUE(stats.tasksTotal == 6 && stats.tasksCompleted == 6 && stats.tasksFailed == 0);
+    ASSERT_TRUE(stats.candlesStored >= 6 * 180);  // 30 days of 1h and 4h per symbol
+    ASSERT_TRUE(stats.candlesPerSecond > 0);
+    ASSERT_TRUE(planned == 6 && completed.back() == 6);
+    ASSERT_TRUE(callbackThread == std::this_thread::get_id());
+    ASSERT_TRUE(statuses.back().find("candles/s") != std::string::npos);
+    for (size_t i = 1; i < completed.size(); i++) {
+        ASSERT_TRUE(completed[i] >= completed[i - 1]);
+    }
+
+    // Everything planned arrived, so there is nothing left to plan
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+    int64_t stored = 0;
+    for (const SeriesInfo& info : storage.getAllSeriesInfo()) {
+        ASSERT_TRUE(info.missingCandles(info.timeframe == "1h" ? 3600 : 14400) == 0);
+        stored += info.candleCount;
+    }
+    ASSERT_TRUE(stored == stats.candlesStored);
+    ASSERT_TRUE(sync.planSync(storage, "binance", symbols, timeframes, std::time(nullptr)).empty() ||
+                std::time(nullptr) % 3600 < 5);  // Unless an hour just closed
+    storage.close();
+
+    completed.clear();
+    ASSERT_TRUE(sync.syncSeries("binance", { "BTCUSDT" }, { "1d" }));
+    ASSERT_TRUE(sync.getLastSyncStats().tasksTotal == 1);
+    ASSERT_TRUE(planned == 1 && completed.back() == 1);
+
+    // Punch a hole and let repair fetch just that
+    DataStorage editor;
+    ASSERT_TRUE(editor.init(kDbPath));
+    std::vector<CandleRange> coverage = editor.getCoverage("binance", "ETHUSDT", "1h");
+    ASSERT_TRUE(coverage.size() == 1);
+    time_t holeStart = coverage[0].start + 100 * 3600;
+    editor.close();
+    sqlite3* db = nullptr;
+    ASSERT_TRUE(sqlite3_open(kDbPath, &db) == SQLITE_OK);
+    std::string sql = "DELETE FROM candles WHERE symbol = 'ETHUSDT' AND timeframe = '1h' AND timestamp >= " +
+                      std::to_string(holeStart) + " AND timestamp < " + std::to_string(holeStart + 50 * 3600) + ";";
+    ASSERT_TRUE(sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+    std::string reset = "DELETE FROM candle_coverage WHERE symbol = 'ETHUSDT';";
+    ASSERT_TRUE(sqlite3_exec(db, reset.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(db);
+
+    uint64_t requestsBefore = server.getRequestCount();
+    ASSERT_TRUE(sync.repairSeries("binance", "ETHUSDT", "1h", coverage[0].start, coverage[0].end));
+    ASSERT_TRUE(sync.getLastSyncStats().tasksTotal == 1);
+    ASSERT_TRUE(sync.getLastSyncStats().candlesStored == 50);
+    ASSERT_TRUE(server.getRequestCount() == requestsBefore + 1);
+    ASSERT_TRUE(sync.repairSeries("binance", "ETHUSDT", "1h", coverage[0].start, coverage[0].end));
+    ASSERT_TRUE(sync.getLastSyncStats().tasksTotal == 0);
+
+    sync.setProgressCallback(nullptr);
+    sync.setDatabasePath("/boot/home/Emiglio/data/emilio.db");
+    unsetenv("EMIGLIO_BINANCE_API_URL");
+    server.stop();
+    std::remove(kDbPath);
+}
+
+// Test: chunks the exchange answers with nothing (before a listing, a
+// halt, after the last candle) are skipped and covered; a failed request
+// stops the task and covers nothing
+TEST(empty_chunks) {
+    std::remove(kDbPath);
+    MockServerConfig config;
+    MockBinanceServer server(config);
+    ASSERT_TRUE(server.start());
+    setenv("EMIGLIO_BINANCE_API_URL", server.getRestUrl().c_str(), 1);
+
+    // 1000 candles, a 2500 minute halt, 500 more
+    const time_t listed = kStart + 1500 * 60;
+    std::vector<Candle> dataset = makeCandles("XRPUSDT", "1m", listed, 60, 1000);
+    std::vector<Candle> resumed = makeCandles("XRPUSDT", "1m", listed + 3500 * 60, 60, 500);
+    dataset.insert(dataset.end(), resumed.begin(), resumed.end());
+    server.addCandles(dataset);
+
+    DataSyncManager& sync = DataSyncManager::getInstance();
+    sync.setDatabasePath(kDbPath);
+    sync.setFetcherCount(2);
+
+    // Chunks of 1000 from kStart: empty, 500, 500, empty, empty, 500, empty
+    const time_t end = kStart + 6999 * 60;
+    uint64_t requestsBefore = server.getRequestCount();
+    ASSERT_TRUE(sync.repairSeries("binance", "XRPUSDT", "1m", kStart, end));
+    SyncStats stats = sync.getLastSyncStats();
+    ASSERT_TRUE(stats.tasksTotal == 1 && stats.tasksFailed == 0);
+    ASSERT_TRUE(stats.candlesStored == 1500);
+    ASSERT_TRUE(server.getRequestCount() == requestsBefore + 7);
+
+    DataStorage storage;
+    ASSERT_TRUE(storage.init(kDbPath));
+    ASSERT_TRUE(storage.getCandleCount("binance", "XRPUSDT", "1m") == 1500);
+    std::vector<CandleRange> coverage = storage.getCoverage("binance", "XRPUSDT", "1m");
+    ASSERT_TRUE(coverage.size() == 1);
+    ASSERT_TRUE(coverage[0].start == kStart && coverage[0].end == end);
+    ASSERT_TRUE(storage.getMissingRanges("binance", "XRPUSDT", "1m", CandleRange(kStart, end), 60).empty());
+
+    // Nothing left to fetch
+    requestsBefore = server.getRequestCount();
+    ASSERT_TRUE(sync.repairSeries("binance", "XRPUSDT", "1m", kStart, end));
+    ASSERT_TRUE(sync.getLastSyncStats().tasksTotal == 0);
+    ASSERT_TRUE(server.getRequestCount() == requestsBefore);
+
+    // Rejected requests (unknown symbol) fail the task and cover nothing
+    ASSERT_FALSE(sync.repairSeries("binance", "NOPEUSDT", "1m", kStart, end));
+    ASSERT_TRUE(sync.getLastSyncStats().tasksFailed == 1);
+    ASSERT_TRUE(storage.getCoverage("binance", "NOPEUSDT", "1m").empty());
+    storage.close();
+
+    sync.setDatabasePath("/boot/home/Emiglio/data/emilio.db");
+    unsetenv("EMIGLIO_BINANCE_API_URL");
+    server.stop();
+    std::remove(kDbPath);
+}
+
+int main() {
+    std::cout << "=== Sync Planner Tests ===" << std::endl;
+
+    RUN_TEST(series_info);
+    RUN_TEST(migrates_existing_database);
+    RUN_TEST(plan_sync);
+    RUN_TEST(coverage_index);
+    RUN_TEST(plain_insert_coverage);
+    RUN_TEST(find_gaps);
+    RUN_TEST(calendar_timeframes);
+    RUN_TEST(calendar_plan);
+    RUN_TEST(parallel_sync);
+    RUN_TEST(empty_chunks);
+
+    std::cout << "\nAll sync planner tests passed!" << std::endl;
+    return 0;
+}
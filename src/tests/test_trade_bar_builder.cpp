@@ -0,0 +1,230 @@
+#include "../data/TradeBarBuilder.h"
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+#define ASSERT_NEAR(a, b, epsilon) ASSERT_TRUE(std::abs((a) - (b)) < (epsilon))
+
+// Counts heap allocations to check the per-trade path
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// 2024-01-01 00:00:00 UTC in ms
+const int64_t kStartMs = 1704067200000LL;
+
+// Test: spec parsing
+TEST(specs) {
+    TradeBarBuilder::BarType type;
+    double threshold = 0.0;
+
+    ASSERT_TRUE(TradeBarBuilder::parseSpec("5s", type, threshold));
+    ASSERT_TRUE(type == TradeBarBuilder::BarType::TIME && threshold == 5.0);
+    ASSERT_TRUE(TradeBarBuilder::parseSpec("1m", type, threshold) && threshold == 60.0);
+    ASSERT_TRUE(TradeBarBuilder::parseSpec("tick:100", type, threshold));
+    ASSERT_TRUE(type == TradeBarBuilder::BarType::TICK && threshold == 100.0);
+    ASSERT_TRUE(TradeBarBuilder::parseSpec("volume:2.5", type, threshold));
+    ASSERT_TRUE(type == TradeBarBuilder::BarType::VOLUME && threshold == 2.5);
+    ASSERT_TRUE(TradeBarBuilder::parseSpec("dollar:1000000", type, threshold));
+    ASSERT_TRUE(type == TradeBarBuilder::BarType::DOLLAR);
+
+    ASSERT_FALSE(TradeBarBuilder::parseSpec("7x", type, threshold));
+    ASSERT_FALSE(TradeBarBuilder::parseSpec("1.5s", type, threshold));
+    ASSERT_FALSE(TradeBarBuilder::parseSpec("tick:0", type, threshold));
+    ASSERT_FALSE(TradeBarBuilder::parseSpec("renko:5", type, threshold));
+    ASSERT_FALSE(TradeBarBuilder("BTCUSDT", "bogus").isValid());
+}
+
+// Test: time bars, including empty intervals
+TEST(time_bars) {
+    std::vector<Candle> bars;
+    TradeBarBuilder builder("BTCUSDT", "5s");
+    builder.setCallback([&bars](const Candle& bar) { bars.push_back(bar); });
+
+    builder.addTrade(100.0, 1.0, kStartMs + 100);
+    builder.addTrade(103.0, 0.5, kStartMs + 2000);
+    builder.addTrade(99.0, 2.0, kStartMs + 4999);
+    ASSERT_TRUE(bars.empty());
+
+    Candle current;
+    ASSERT_TRUE(builder.getCurrent(current));
+    ASSERT_TRUE(current.timestamp == kStartMs / 1000);
+    ASSERT_TRUE(current.high == 103.0 && current.low == 99.0 && current.close == 99.0);
+
+    // Next trade lands two buckets later: one complete bar, one flat bar
+    builder.addTrade(101.0, 1.0, kStartMs + 12000);
+    ASSERT_TRUE(bars.size() == 2);
+    ASSERT_TRUE(bars[0].timestamp == kStartMs / 1000);
+    ASSERT_TRUE(bars[0].open == 100.0 && bars[0].high == 103.0 && bars[0].low == 99.0);
+    ASSERT_TRUE(bars[0].close == 99.0 && bars[0].volume == 3.5);
+    ASSERT_TRUE(bars[0].timeframe == "5s" && bars[0].symbol == "BTCUSDT");
+    ASSERT_TRUE(bars[1].timestamp == kStartMs / 1000 + 5);
+    ASSERT_TRUE(bars[1].open == 99.0 && bars[1].close == 99.0 && bars[1].volume == 0.0);
+
+    // A quiet market still closes bars on the timer
+    builder.advanceTime(kStartMs + 14999);
+    ASSERT_TRUE(bars.size() == 2);
+    builder.advanceTime(kStartMs + 25000);
+    ASSERT_TRUE(bars.size() == 5);
+    ASSERT_TRUE(bars[2].timestamp == kStartMs / 1000 + 10 && bars[2].close == 101.0);
+    ASSERT_TRUE(bars[4].timestamp == kStartMs / 1000 + 20 && bars[4].volume == 0.0);
+    ASSERT_TRUE(builder.getBarCount() == 5);
+
+    // Without gap filling, empty intervals are skipped
+    bars.clear();
+    TradeBarBuilder sparse("BTCUSDT", "1s");
+    sparse.setFillGaps(false);
+    sparse.setCallback([&bars](const Candle& bar) { bars.push_back(bar); });
+    sparse.addTrade(1.0, 1.0, kStartMs);
+    sparse.addTrade(2.0, 1.0, kStartMs + 10500);
+    sparse.flush();
+    ASSERT_TRUE(bars.size() == 2);
+    ASSERT_TRUE(bars[1].timestamp == kStartMs / 1000 + 10);
+}
+
+// Test: weekly bars open on Mondays and monthly bars on the 1st
+TEST(calendar_bars) {
+    const int64_t dayMs = 86400000LL;
+    std::vector<Candle> bars;
+    TradeBarBuilder weekly("BTCUSDT", "1w");
+    weekly.setCallback([&bars](const Candle& bar) { bars.push_back(bar); });
+
+    // Thursday 2024-01-04 belongs to the week of Monday the 1st
+    weekly.addTrade(100.0, 1.0, kStartMs + 3 * dayMs);
+    Candle current;
+    ASSERT_TRUE(weekly.getCurrent(current));
+    ASSERT_TRUE(current.timestamp == kStartMs / 1000);
+    weekly.addTrade(101.0, 1.0, kStartMs + 6 * dayMs + 1);
+    ASSERT_TRUE(bars.empty());
+    weekly.addTrade(102.0, 1.0, kStartMs + 7 * dayMs);
+    ASSERT_TRUE(bars.size() == 1 && bars[0].timestamp == kStartMs / 1000);
+    ASSERT_TRUE(weekly.getCurrent(current) && current.timestamp == kStartMs / 1000 + 7 * 86400);
+
+    // January has 31 days, February 2024 has 29
+    bars.clear();
+    const int64_t february = kStartMs + 31 * dayMs;
+    const int64_t march = february + 29 * dayMs;
+    const int64_t april = march + 31 * dayMs;
+    TradeBarBuilder monthly("BTCUSDT", "1M");
+    monthly.setCallback([&bars](const Candle& bar) { bars.push_back(bar); });
+    monthly.addTrade(100.0, 1.0, kStartMs + 14 * dayMs);
+    monthly.addTrade(101.0, 1.0, february - 1);
+    ASSERT_TRUE(bars.empty());
+    monthly.addTrade(102.0, 1.0, february + 9 * dayMs);
+    ASSERT_TRUE(bars.size() == 1 && bars[0].timestamp == kStartMs / 1000 && bars[0].close == 101.0);
+
+    // Quiet March is filled when April's first trade arrives
+    monthly.addTrade(103.0, 1.0, april + dayMs);
+    ASSERT_TRUE(bars.size() == 3);
+    ASSERT_TRUE(bars[1].timestamp == february / 1000);
+    ASSERT_TRUE(bars[2].timestamp == march / 1000 && bars[2].volume == 0.0);
+    ASSERT_TRUE(monthly.getCurrent(current) && current.timestamp == april / 1000);
+
+    monthly.advanceTime(april + 30 * dayMs - 1);
+    ASSERT_TRUE(bars.size() == 3);
+    monthly.advanceTime(april + 30 * dayMs);
+    ASSERT_TRUE(bars.size() == 4 && bars[3].timestamp == april / 1000);
+}
+
+// Test: tick, volume and dollar bars
+TEST(activity_bars) {
+    std::vector<Candle> bars;
+    auto collect = [&bars](const Candle& bar) { bars.push_back(bar); };
+
+    TradeBarBuilder ticks("BTCUSDT", "tick:3");
+    ticks.setCallback(collect);
+    for (int i = 0; i < 7; i++) {
+        ticks.addTrade(100.0 + i, 1.0, kStartMs + i * 100);
+    }
+    ASSERT_TRUE(bars.size() == 2);
+    ASSERT_TRUE(bars[0].open == 100.0 && bars[0].close == 102.0 && bars[0].volume == 3.0);
+    ASSERT_TRUE(bars[1].open == 103.0 && bars[1].close == 105.0);
+    // Both opened in the same second: the second bar is moved one second on
+    ASSERT_TRUE(bars[0].timestamp == kStartMs / 1000);
+    ASSERT_TRUE(bars[1].timestamp == kStartMs / 1000 + 1);
+
+    bars.clear();
+    TradeBarBuilder volume("BTCUSDT", "volume:10");
+    volume.setCallback(collect);
+    volume.addTrade(50.0, 4.0, kStartMs);
+    volume.addTrade(51.0, 4.0, kStartMs + 5000);
+    ASSERT_TRUE(bars.empty());
+    // The trade crossing the threshold completes the bar
+    volume.addTrade(49.0, 5.0, kStartMs + 9000);
+    ASSERT_TRUE(bars.size() == 1);
+    ASSERT_TRUE(bars[0].volume == 13.0 && bars[0].low == 49.0 && bars[0].high == 51.0);
+
+    bars.clear();
+    TradeBarBuilder dollar("BTCUSDT", "dollar:1000");
+    dollar.setCallback(collect);
+    dollar.addTrade(100.0, 4.0, kStartMs);
+    dollar.addTrade(200.0, 2.0, kStartMs + 1000);
+    ASSERT_TRUE(bars.empty());
+    dollar.addTrade(250.0, 1.0, kStartMs + 2000);
+    ASSERT_TRUE(bars.size() == 1 && bars[0].close == 250.0);
+}
+
+// Test: feeding trades doesn't allocate
+TEST(no_allocation) {
+    size_t emitted = 0;
+    TradeBarBuilder time("BTCUSDT", "1s");
+    TradeBarBuilder ticks("BTCUSDT", "tick:50");
+    time.setCallback([&emitted](const Candle&) { emitted++; });
+    ticks.setCallback([&emitted](const Candle&) { emitted++; });
+
+    size_t before = allocations;
+    for (int i = 0; i < 100000; i++) {
+        double price = 42000.0 + (i % 37) * 0.01;
+        time.addTrade(price, 0.001, kStartMs + i * 3);
+        ticks.addTrade(price, 0.001, kStartMs + i * 3);
+    }
+    ASSERT_TRUE(allocations == before);
+    ASSERT_TRUE(emitted == 299 + 2000);
+}
+
+int main() {
+    std::cout << "=== Trade Bar Builder Tests ===" << std::endl;
+
+    RUN_TEST(specs);
+    RUN_TEST(time_bars);
+    RUN_TEST(calendar_bars);
+    RUN_TEST(activity_bars);
+    RUN_TEST(no_allocation);
+
+    std::cout << "\nAll trade bar builder tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,568 @@
+#include "../exchange/WebSocketClient.h"
+#include "../exchange/WebSocketReactor.h"
+#include "../exchange/StreamCapture.h"
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <zlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+using namespace Emiglio;
+
+// Test macros
+#define TEST(name) void test_##name()
+#define RUN_TEST(name) do { \
+    std::cout << "Running " #name "..." << std::endl; \
+    test_##name(); \
+    std::cout << "✓ " #name " passed" << std::endl; \
+} while(0)
+
+#define ASSERT_TRUE(expr) do { \
+    if (!(expr)) { \
+        std::cerr << "✗ Assertion failed: " #expr << " at line " << __LINE__ << std::endl; \
+        exit(1); \
+    } \
+} while(0)
+
+#define ASSERT_FALSE(expr) ASSERT_TRUE(!(expr))
+
+// Unmasked server frame; 'flags' holds FIN (0x80) and RSV1 (0x40)
+std::string serverFrame(uint8_t opcode, const std::string& payload, uint8_t flags = 0x80) {
+    std::string frame;
+    frame += static_cast<char>(flags | opcode);
+    if (payload.size() < 126) {
+        frame += static_cast<char>(payload.size());
+    } else if (payload.size() < 65536) {
+        frame += static_cast<char>(126);
+        frame += static_cast<char>((payload.size() >> 8) & 0xFF);
+        frame += static_cast<char>(payload.size() & 0xFF);
+    } else {
+        frame += static_cast<char>(127);
+        for (int i = 7; i >= 0; i--) {
+            frame += static_cast<char>((static_cast<uint64_t>(payload.size()) >> (i * 8)) & 0xFF);
+        }
+    }
+    return frame + payload;
+}
+
+bool sendAll(int fd, const std::string& data) {
+    return ::send(fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size());
+}
+
+// Read one (masked) client frame; false on EOF
+bool readClientFrame(int fd, uint8_t& opcode, std::string& payload, uint32_t* maskKey = nullptr) {
+    uint8_t header[2];
+    if (recv(fd, header, 2, MSG_WAITALL) != 2) return false;
+    opcode = header[0] & 0x0F;
+    if ((header[1] & 0x80) == 0) return false;  // Client frames must be masked
+    size_t length = header[1] & 0x7F;
+    if (length == 126) {
+        uint8_t extended[2];
+        if (recv(fd, extended, 2, MSG_WAITALL) != 2) return false;
+        length = (extended[0] << 8) | extended[1];
+    } else if (length == 127) {
+        uint8_t extended[8];
+        if (recv(fd, extended, 8, MSG_WAITALL) != 8) return false;
+        length = 0;
+        for (int i = 0; i < 8; i++) {
+            length = (length << 8) | extended[i];
+        }
+    }
+    uint8_t mask[4];
+    if (recv(fd, mask, 4, MSG_WAITALL) != 4) return false;
+    if (maskKey) memcpy(maskKey, mask, 4);
+    payload.resize(length);
+    if (length > 0 && recv(fd, &payload[0], length, MSG_WAITALL) != static_cast<ssize_t>(length)) return false;
+    for (size_t i = 0; i < length; i++) {
+        payload[i] ^= mask[i % 4];
+    }
+    return true;
+}
+
+// Local feeder: accepts connections and runs 'script' on each after the
+// handshake. 'first' is sent in the same write as the 101 response, which
+// carries 'headers' (CRLF-terminated lines) too.
+class Feeder {
+public:
+    using Script = std::function<void(int fd, int connection)>;
+
+    Feeder(const std::string& first, Script script, const std::string& headers = "")
+        : first(first), headers(headers), script(script), connections(0) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        int yes = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(listenFd, 64);
+        socklen_t length = sizeof(addr);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &length);
+        port = ntohs(addr.sin_port);
+        acceptThread = std::thread(&Feeder::acceptLoop, this);
+    }
+
+    ~Feeder() {
+        ::shutdown(listenFd, SHUT_RDWR);
+        close(listenFd);
+        acceptThread.join();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    std::string url() const {
+        return "ws://127.0.0.1:" + std::to_string(port) + "/stream";
+    }
+
+    int connectionCount() const { return connections; }
+
+    std::string lastRequest() {
+        std::lock_guard<std::mutex> lock(requestMutex);
+        return request;
+    }
+
+private:
+    int listenFd;
+    int port;
+    std::string first;
+    std::string headers;
+    Script script;
+    std::mutex requestMutex;
+    std::string request;
+    std::atomic<int> connections;
+    std::thread acceptThread;
+    std::vector<std::thread> threads;
+
+    void acceptLoop() {
+        for (;;) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                return;
+            }
+            int index = connections++;
+            threads.emplace_back([this, fd, index]() {
+                std::string request;
+                char byte;
+                while (request.find("\r\n\r\n") == std::string::npos && recv(fd, &byte, 1, 0) == 1) {
+                    request += byte;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(requestMutex);
+                    this->request = request;
+                }
+                sendAll(fd, "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                            "Connection: Upgrade\r\n" + headers + "\r\n" + first);
+                script(fd, index);
+                close(fd);
+            });
+        }
+    }
+};
+
+bool waitFor(std::function<bool()> condition, int timeoutMs = 5000) {
+    for (int waited = 0; waited < timeoutMs; waited += 5) {
+        if (condition()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return condition();
+}
+
+// Test: many connections share the reactor thread, frames arrive in order
+TEST(many_connections) {
+    const int kConnections = 8;
+    const int kMessages = 200;
+
+    Feeder feeder(serverFrame(0x1, "m0"), [](int fd, int) {
+        for (int i = 1; i < kMessages; i++) {
+            // Payloads above 125 bytes use the extended length
+            std::string payload = "m" + std::to_string(i) + std::string(i % 3 == 0 ? 200 : 0, 'x');
+            sendAll(fd, serverFrame(0x1, payload));
+        }
+        uint8_t opcode;
+        std::string payload;
+        readClientFrame(fd, opcode, payload);  // Until the client goes away
+    });
+
+    WebSocketReactor reactor;
+    std::vector<std::unique_ptr<WebSocketClient>> clients;
+    std::vector<std::thread::id> threads(kConnections);
+    std::unique_ptr<std::atomic<int>[]> received(new std::atomic<int>[kConnections]);
+    std::atomic<bool> ordered(true);
+
+    for (int c = 0; c < kConnections; c++) {
+        received[c] = 0;
+        clients.emplace_back(new WebSocketClient());
+        clients[c]->setReactor(&reactor);
+        clients[c]->onMessage([&, c](const std::string& message) {
+            threads[c] = std::this_thread::get_id();
+            int expected = received[c]++;
+            if (message.compare(0, message.find('x'), "m" + std::to_string(expected)) != 0) {
+                ordered = false;
+            }
+        });
+        ASSERT_TRUE(clients[c]->connect(feeder.url()));
+    }
+
+    ASSERT_TRUE(reactor.getConnectionCount() == static_cast<size_t>(kConnections));
+    ASSERT_TRUE(waitFor([&]() {
+        for (int c = 0; c < kConnections; c++) {
+            if (received[c] < kMessages) return false;
+        }
+        return true;
+    }));
+    ASSERT_TRUE(ordered);
+
+    // All delivered on the reactor thread, not the test thread
+    for (int c = 0; c < kConnections; c++) {
+        ASSERT_TRUE(threads[c] == threads[0]);
+    }
+    ASSERT_FALSE(threads[0] == std::this_thread::get_id());
+
+    for (auto& client : clients) {
+        client->disconnect();
+        ASSERT_FALSE(client->isConnected());
+    }
+    ASSERT_TRUE(reactor.getConnectionCount() == 0);
+}
+
+// Test: pings are answered from the reactor thread
+TEST(ping_pong) {
+    std::atomic<bool> pongOk(false);
+    Feeder feeder("", [&pongOk](int fd, int) {
+        sendAll(fd, serverFrame(0x9, "heartbeat"));
+        uint8_t opcode = 0;
+        std::string payload;
+        if (readClientFrame(fd, opcode, payload)) {
+            pongOk = opcode == 0xA && payload == "heartbeat";
+        }
+        readClientFrame(fd, opcode, payload);
+    });
+
+    WebSocketReactor reactor;
+    WebSocketClient client;
+    client.setReactor(&reactor);
+    ASSERT_TRUE(client.connect(feeder.url()));
+    ASSERT_TRUE(waitFor([&]() { return pongOk.load(); }));
+
+    // Sending from another thread works alongside the reactor
+    ASSERT_TRUE(client.send("{\"method\":\"LIST_SUBSCRIPTIONS\",\"id\":1}"));
+    client.disconnect();
+}
+
+// Test: masking of every length class, and batched frames
+TEST(masked_frames) {
+    const size_t lengths[] = { 0, 1, 7, 8, 9, 31, 32, 33, 125, 126, 127, 1000, 65535, 65536, 70001 };
+    const size_t kFrames = sizeof(lengths) / sizeof(lengths[0]);
+
+    auto payloadOf = [](size_t length) {
+        std::string payload(length, '\0');
+        for (size_t i = 0; i < length; i++) {
+            payload[i] = static_cast<char>((i * 131 + length) & 0xFF);
+        }
+        return payload;
+    };
+
+    std::atomic<int> matched(0);
+    std::atomic<int> distinctMasks(0);
+    Feeder feeder("", [&](int fd, int) {
+        std::vector<uint32_t> masks;
+        for (size_t f = 0; f < kFrames + 3; f++) {
+            uint8_t opcode;
+            std::string payload;
+            uint32_t mask;
+            if (!readClientFrame(fd, opcode, payload, &mask)) return;
+            std::string expected = f < kFrames ? payloadOf(lengths[f]) : "batch" + std::to_string(f - kFrames);
+            if (opcode == 0x1 && payload == expected) matched++;
+            if (std::find(masks.begin(), masks.end(), mask) == masks.end()) distinctMasks++;
+            masks.push_back(mask);
+        }
+    });
+
+    WebSocketReactor reactor;
+    WebSocketClient client;
+    client.setReactor(&reactor);
+    ASSERT_TRUE(client.connect(feeder.url()));
+    for (size_t f = 0; f < kFrames; f++) {
+        ASSERT_TRUE(client.send(payloadOf(lengths[f])));
+    }
+    ASSERT_TRUE(client.send(std::vector<std::string>{ "batch0", "batch1", "batch2" }));
+    ASSERT_TRUE(client.send(std::vector<std::string>()));
+
+    ASSERT_TRUE(waitFor([&]() { return matched == static_cast<int>(kFrames + 3); }));
+    ASSERT_TRUE(distinctMasks >= static_cast<int>(kFrames));  // A fresh key per frame
+    client.disconnect();
+}
+
+// Test: a CLOSE frame or dropped socket reconnects with the reactor
+TEST(close_and_reconnect) {
+    Feeder feeder("", [](int fd, int connection) {
+        sendAll(fd, serverFrame(0x1, "c" + std::to_string(connection)));
+        if (connection == 0) {
+            sendAll(fd, serverFrame(0x8, ""));
+        } else if (connection == 1) {
+            // Dropped without a close frame
+            return;
+        } else {
+            uint8_t opcode;
+            std::string payload;
+            readClientFrame(fd, opcode, payload);
+        }
+    });
+
+    WebSocketReactor reactor;
+    WebSocketClient client;
+    std::mutex mutex;
+    std::vector<std::string> messages;
+    std::atomic<int> reconnects(0);
+    std::atomic<int> errors(0);
+
+    client.setReactor(&reactor);
+    client.setAutoReconnect(true, 10, 20);
+    client.onMessage([&](const std::string& message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.push_back(message);
+    });
+    client.onReconnect([&reconnects]() { reconnects++; });
+    client.onError([&errors](const std::string&) { errors++; });
+
+    ASSERT_TRUE(client.connect(feeder.url()));
+    ASSERT_TRUE(waitFor([&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return messages.size() >= 3;
+    }));
+    ASSERT_TRUE(reconnects == 2);
+    ASSERT_TRUE(errors == 1);  // Only the drop is an error
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ASSERT_TRUE(messages[0] == "c0" && messages[1] == "c1" && messages[2] == "c2");
+    }
+    ASSERT_TRUE(client.isConnected());
+    ASSERT_TRUE(reactor.getConnectionCount() == 1);
+
+    client.disconnect();
+    ASSERT_TRUE(reactor.getConnectionCount() == 0);
+}
+
+// Test: disconnect while a reconnect is waiting out its backoff
+TEST(disconnect_during_backoff) {
+    Feeder feeder("", [](int fd, int) {
+        sendAll(fd, serverFrame(0x8, ""));
+    });
+
+    WebSocketReactor reactor;
+    WebSocketClient client;
+    client.setReactor(&reactor);
+    client.setAutoReconnect(true, 60000, 60000);
+    ASSERT_TRUE(client.connect(feeder.url()));
+    ASSERT_TRUE(waitFor([&]() { return !client.isConnected(); }));
+
+    auto start = std::chrono::steady_clock::now();
+    client.disconnect();
+    ASSERT_TRUE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+    ASSERT_TRUE(feeder.connectionCount() == 1);
+}
+
+// Server side of permessage-deflate: one raw deflate stream, each message
+// flushed and stripped of the 00 00 FF FF tail
+class Deflater {
+public:
+    explicit Deflater(bool contextTakeover) : contextTakeover(contextTakeover) {
+        memset(&stream, 0, sizeof(stream));
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    }
+
+    ~Deflater() {
+        deflateEnd(&stream);
+    }
+
+    std::string compress(const std::string& message) {
+        std::string output(deflateBound(&stream, message.size()) + 16, '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(message.data()));
+        stream.avail_in = message.size();
+        stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+        stream.avail_out = output.size();
+        deflate(&stream, Z_SYNC_FLUSH);
+        size_t produced = output.size() - stream.avail_out;
+        if (produced < 4) {
+            // zlib skips a repeated flush; RFC 7692 7.2.3.6 sends 0x00
+            output = std::string(1, '\0');
+        } else {
+            output.resize(produced - 4);
+        }
+        if (!contextTakeover) {
+            deflateReset(&stream);
+        }
+        return output;
+    }
+
+private:
+    z_stream stream;
+    bool contextTakeover;
+};
+
+// Test: compressed messages (with and without context takeover, fragmented,
+// larger than the initial inflate buffer) mixed with uncompressed ones
+TEST(permessage_deflate) {
+    std::vector<std::string> sent;
+    std::string ticker = "{\"e\":\"24hrTicker\",\"s\":\"BTCUSDT\",\"c\":\"67000.10\"}";
+    sent.push_back(ticker);
+    sent.push_back(ticker);  // Mostly back-references with context takeover
+    std::string array = "[";
+    for (int i = 0; i < 3000; i++) {
+        array += (i ? "," : "") + ticker;
+    }
+    sent.push_back(array + "]");
+    sent.push_back("plain");
+    sent.push_back("fragmented " + ticker);
+    sent.push_back("");
+
+    for (int takeover = 1; takeover >= 0; takeover--) {
+        Feeder feeder("", [&sent, takeover](int fd, int) {
+            Deflater deflater(takeover != 0);
+            for (size_t i = 0; i < sent.size(); i++) {
+                if (sent[i] == "plain") {
+                    sendAll(fd, serverFrame(0x1, sent[i]));
+                } else if (sent[i].compare(0, 10, "fragmented") == 0) {
+                    std::string compressed = deflater.compress(sent[i]);
+                    size_t half = compressed.size() / 2;
+                    sendAll(fd, serverFrame(0x1, compressed.substr(0, half), 0x40));
+                    sendAll(fd, serverFrame(0x9, "mid"));  // Control frames may interleave
+                    sendAll(fd, serverFrame(0x0, compressed.substr(half), 0x80));
+                } else {
+                    sendAll(fd, serverFrame(0x1, deflater.compress(sent[i]), 0xC0));
+                }
+            }
+            uint8_t opcode;
+            std::string payload;
+            while (readClientFrame(fd, opcode, payload)) {
+            }
+        }, takeover ? "Sec-WebSocket-Extensions: permessage-deflate\r\n"
+                    : "Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover\r\n");
+
+        WebSocketReactor reactor;
+        WebSocketClient client;
+        std::mutex mutex;
+        std::vector<std::string> received;
+        client.setReactor(&reactor);
+        client.onMessage([&](const std::string& message) {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.push_back(message);
+        });
+        ASSERT_TRUE(client.connect(feeder.url()));
+        ASSERT_TRUE(client.isCompressed());
+        ASSERT_TRUE(feeder.lastRequest().find("permessage-deflate") != std::string::npos);
+        ASSERT_TRUE(waitFor([&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return received.size() >= sent.size();
+        }));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ASSERT_TRUE(received == sent);
+        }
+        client.disconnect();
+    }
+}
+
+// Test: compression switched off, or declined by the server
+TEST(compression_off) {
+    Feeder feeder("", [](int fd, int) {
+        sendAll(fd, serverFrame(0x1, "raw"));
+        uint8_t opcode;
+        std::string payload;
+        readClientFrame(fd, opcode, payload);
+    });
+
+    WebSocketReactor reactor;
+    for (int enabled = 0; enabled <= 1; enabled++) {
+        WebSocketClient client;
+        std::atomic<bool> got(false);
+        client.setReactor(&reactor);
+        client.setCompression(enabled != 0);
+        client.onMessage([&got](const std::string& message) { got = message == "raw"; });
+        ASSERT_TRUE(client.connect(feeder.url()));
+        ASSERT_FALSE(client.isCompressed());
+        bool offered = feeder.lastRequest().find("permessage-deflate") != std::string::npos;
+        ASSERT_TRUE(offered == (enabled != 0));
+        ASSERT_TRUE(waitFor([&]() { return got.load(); }));
+        client.disconnect();
+    }
+
+    // An extension we never offered fails the handshake
+    Feeder rogue("", [](int, int) {}, "Sec-WebSocket-Extensions: x-unknown\r\n");
+    WebSocketClient client;
+    client.setReactor(&reactor);
+    ASSERT_FALSE(client.connect(rogue.url()));
+}
+
+// Test: received text messages are recorded as delivered (inflated), with
+// the connection index and wall-clock receive times
+TEST(capture) {
+    const char* path = "/tmp/test_websocket_capture.emgw";
+    std::remove(path);
+    Feeder feeder(serverFrame(0x1, "one"), [](int fd, int) {
+        Deflater deflater(true);
+        sendAll(fd, serverFrame(0x9, "ping"));  // Not recorded
+        sendAll(fd, serverFrame(0x1, deflater.compress("two"), 0xC0));
+        uint8_t opcode;
+        std::string payload;
+        while (readClientFrame(fd, opcode, payload)) {
+        }
+    }, "Sec-WebSocket-Extensions: permessage-deflate\r\n");
+
+    StreamCaptureWriter writer;
+    ASSERT_TRUE(writer.open(path));
+    int64_t before = StreamCaptureWriter::now();
+
+    WebSocketReactor reactor;
+    WebSocketClient client;
+    std::atomic<int> received(0);
+    client.setReactor(&reactor);
+    client.setCapture(&writer, 7);
+    client.onMessage([&received](const std::string&) { received++; });
+    ASSERT_TRUE(client.connect(feeder.url()));
+    ASSERT_TRUE(waitFor([&]() { return received == 2; }));
+    client.disconnect();
+    writer.close();
+
+    StreamCaptureReader reader;
+    ASSERT_TRUE(reader.open(path));
+    CaptureRecord first, second, extra;
+    ASSERT_TRUE(reader.next(first) && reader.next(second));
+    ASSERT_FALSE(reader.next(extra));
+    ASSERT_TRUE(first.payload == "one" && second.payload == "two");
+    ASSERT_TRUE(first.connection == 7 && second.connection == 7);
+    ASSERT_TRUE(first.timestamp >= before && second.timestamp >= first.timestamp);
+    std::remove(path);
+}
+
+int main() {
+    std::cout << "=== WebSocket Reactor Tests ===" << std::endl;
+
+    RUN_TEST(many_connections);
+    RUN_TEST(ping_pong);
+    RUN_TEST(masked_frames);
+    RUN_TEST(close_and_reconnect);
+    RUN_TEST(disconnect_during_backoff);
+    RUN_TEST(permessage_deflate);
+    RUN_TEST(compression_off);
+    RUN_TEST(capture);
+
+    std::cout << "\nAll WebSocket reactor tests passed!" << std::endl;
+    return 0;
+}
@@ -3,6 +3,10 @@
 #include "../utils/Logger.h"
 #include "../utils/Config.h"
 #include "../exchange/BinanceAPI.h"
+#include "../data/CandleResampler.h"
+#include "../data/CandleCache.h"
+#include "../backtest/BacktestCache.h"
+#include "../backtest/BacktestJob.h"
 
 #include <LayoutBuilder.h>
 #include <Box.h>
@@ -16,6 +20,7 @@
 #include <sstream>
 #include <iomanip>
 #include <ctime>
+#include <algorithm>
 
 namespace Emiglio {
 namespace UI {
@@ -76,6 +81,7 @@ BacktestView::BacktestView()
 	, commissionControl(nullptr)
 	, slippageControl(nullptr)
 	, runButton(nullptr)
+	, cancelButton(nullptr)
 	, exportButton(nullptr)
 	, resultsPanel(nullptr)
 	, statusLabel(nullptr)
@@ -96,6 +102,14 @@ BacktestView::BacktestView()
 }
 
 BacktestView::~BacktestView() {
+	// Stop a running job before the view goes away. The window is locked
+	// here, so its callbacks must stop posting first or the job could block
+	// on a full port and never finish.
+	if (backtestJob) {
+		*jobDetached = true;
+		backtestJob->cancel();
+		backtestJob->wait();
+	}
 }
 
 void BacktestView::AttachedToWindow() {
@@ -104,6 +118,7 @@ void BacktestView::AttachedToWindow() {
 
 	// Set message targets
 	runButton->SetTarget(this);
+	cancelButton->SetTarget(this);
 	exportButton->SetTarget(this);
 	startDateButton->SetTarget(this);
 	endDateButton->SetTarget(this);
@@ -161,7 +176,10 @@ void BacktestView::SetupUI() {
 					.Add(slippageControl)
 					.End()
 				.AddStrut(10)
-				.Add(runButton)
+				.AddGroup(B_HORIZONTAL, 5)
+					.Add(runButton)
+					.Add(cancelButton)
+					.End()
 				.Add(progressBar)
 				.AddStrut(15)
 				// Trades list section
@@ -288,6 +306,10 @@ void BacktestView::SetupConfigPanel() {
 	runButton = new BButton("run", "Run Backtest", new BMessage(MSG_BACKTEST_RUN));
 	runButton->MakeDefault(true);
 
+	// Cancel button (enabled while a backtest is running)
+	cancelButton = new BButton("cancel", "Cancel", new BMessage(MSG_BACKTEST_CANCEL));
+	cancelButton->SetEnabled(false);
+
 	// Export button
 	exportButton = new BButton("export", "Export Report", new BMessage(MSG_BACKTEST_EXPORT));
 	exportButton->SetEnabled(false);
@@ -357,6 +379,24 @@ void BacktestView::MessageReceived(BMessage* message) {
 			RunBacktest();
 			break;
 
+		case MSG_BACKTEST_CANCEL:
+			CancelBacktest();
+			break;
+
+		case MSG_BACKTEST_PROGRESS: {
+			double percent;
+			const char* status;
+			if (message->FindDouble("percent", &percent) == B_OK &&
+			    message->FindString("status", &status) == B_OK) {
+				progressBar->SetTo(percent, status);
+			}
+			break;
+		}
+
+		case MSG_BACKTEST_FINISHED:
+			BacktestFinished();
+			break;
+
 		case MSG_BACKTEST_EXPORT:
 			ExportResults();
 			break;
@@ -509,6 +549,146 @@ std::vector<std::string> BacktestView::FindRecipeFiles() {
 	return recipes;
 }
 
+// Runs on the backtest job thread: load candles from the database, derive
+// them from 1m data, or download them from Binance. Must not touch the UI.
+static bool LoadBacktestCandles(Backtest::BacktestJob& job, std::vector<Candle>& candles,
+                                const std::string& exchange, const std::string& symbol,
+                                const std::string& timeframe, time_t startTime, time_t endTime) {
+	DataStorage storage;
+	if (!storage.init("/boot/home/Emiglio/data/emilio.db")) {
+		throw std::runtime_error("Failed to initialize database");
+	}
+
+	int64_t timeframeSec = CandleResampler::timeframeToSeconds(timeframe);
+	if (timeframeSec <= 0) timeframeSec = 3600; // Default 1h
+
+	// Try to get candles from database first (through the shared cache, so
+	// a chart of the same series already loaded them)
+	CandleCache& cache = CandleCache::getInstance();
+	CandleSeries stored = cache.getCandles(storage, exchange, symbol, timeframe, startTime, endTime);
+
+	// What the database lacks for this range, from the coverage index
+	std::vector<CandleRange> missing = storage.getMissingRanges(exchange, symbol, timeframe,
+		CandleRange(startTime, std::min<time_t>(endTime, time(nullptr) - timeframeSec)), timeframeSec);
+
+	// Derive higher timeframes from stored 1m candles before going to the network
+	if (stored.empty() && timeframe != "1m" && CandleResampler::canResample("1m", timeframe)) {
+		candles = CandleResampler::loadResampled(storage, exchange, symbol, timeframe, startTime, endTime);
+		if (!candles.empty()) {
+			missing.clear();
+		}
+	}
+
+	// Download only the missing ranges from Binance
+	if (!missing.empty()) {
+		int64_t missingCandles = 0;
+		for (const auto& range : missing) {
+			missingCandles += range.candles(timeframeSec);
+		}
+		LOG_INFO("Missing " + std::to_string(missingCandles) + " candles in " +
+		         std::to_string(missing.size()) + " ranges, downloading from Binance...");
+		job.reportProgress(5.0, "Downloading historical data from Binance...");
+
+		// Download from Binance
+		BinanceAPI api;
+		if (!api.init("", "")) {  // Public API, no keys needed
+			throw std::runtime_error("Failed to initialize Binance API");
+		}
+
+		int64_t downloaded = 0;
+		bool failed = false;
+		for (const auto& range : missing) {
+			// Download in chunks (Binance limit is 1000 per request)
+			time_t currentStart = range.start;
+			while (currentStart <= range.end) {
+				if (job.isCancelled()) {
+					return false;
+				}
+
+				time_t currentEnd = std::min<time_t>(currentStart + 999 * timeframeSec, range.end);
+				std::vector<Candle> chunk = api.getCandles(symbol, timeframe, currentStart, currentEnd, 1000);
+
+				// A failed request leaves the rest uncovered, to try again
+				// next time; what is stored so far is still used
+				if (chunk.empty() && api.getLastStatus() != 200) {
+					LOG_WARNING("Failed to download " + symbol + " " + timeframe + " from " +
+					            std::to_string(currentStart) + " (HTTP " +
+					            std::to_string(api.getLastStatus()) + ")");
+					failed = true;
+					break;
+				}
+
+				// Save to database, marking the chunk as fetched. An empty
+				// answer (before the listing, a trading halt) is complete too.
+				time_t fetchedEnd = currentEnd;
+				if (chunk.empty()) {
+					storage.addCoverage(exchange, symbol, timeframe, CandleRange(currentStart, currentEnd), timeframeSec);
+				} else {
+					fetchedEnd = std::max(currentEnd, chunk.back().timestamp);
+					storage.insertCandles(chunk, CandleRange(currentStart, fetchedEnd), timeframeSec);
+				}
+				downloaded += chunk.size();
+
+				// Move to next chunk
+				currentStart = fetchedEnd + timeframeSec;
+
+				// Update progress
+				double progress = 5.0 + (25.0 * std::min(1.0, (double)downloaded / missingCandles));
+				job.reportProgress(progress, "Downloaded " + std::to_string(downloaded) + " candles...");
+			}
+			if (failed) {
+				break;
+			}
+		}
+
+		LOG_INFO("Downloaded and saved " + std::to_string(downloaded) + " candles");
+
+		if (downloaded > 0) {
+			stored = cache.getCandles(storage, exchange, symbol, timeframe, startTime, endTime);
+		}
+		if (stored.empty() && candles.empty() && failed) {
+			throw std::runtime_error("Failed to download candles for " + symbol + " from Binance");
+		}
+	}
+
+	// The simulator takes a vector, so the job gets its own copy of the
+	// cached series, made once after any download
+	if (!stored.empty()) {
+		candles = stored.toVector();
+	}
+
+	if (candles.empty()) {
+		throw std::runtime_error("No candles available for " + symbol +
+		                          " in the specified date range");
+	}
+
+	LOG_INFO("Loaded " + std::to_string(candles.size()) + " candles");
+
+	// CRITICAL: Validate that we have enough data
+	if (candles.size() < 50) {
+		throw std::runtime_error("Not enough data for backtest. Loaded only " +
+		                          std::to_string(candles.size()) +
+		                          " candles. Need at least 50 candles for reliable results.");
+	}
+
+	// Higher timeframe indicators get their own series, with warm-up history
+	// before startTime, when the database has one; otherwise the job
+	// resamples the candles loaded above
+	for (const auto& [higherTimeframe, warmup] : SignalGenerator::getTimeframeWarmup(job.getRecipe())) {
+		time_t from = startTime - static_cast<time_t>(warmup) * CandleResampler::timeframeToSeconds(higherTimeframe);
+		std::vector<Candle> higher = storage.getCandles(exchange, symbol, higherTimeframe, from, endTime);
+		if (higher.empty() && CandleResampler::canResample("1m", higherTimeframe)) {
+			higher = CandleResampler::loadResampled(storage, exchange, symbol, higherTimeframe, from, endTime);
+		}
+		if (!higher.empty()) {
+			LOG_INFO("Loaded " + std::to_string(higher.size()) + " " + higherTimeframe + " candles");
+			job.setTimeframeCandles(higherTimeframe, higher);
+		}
+	}
+
+	return true;
+}
+
 void BacktestView::RunBacktest() {
 	if (backtestRunning) {
 		BAlert* alert = new BAlert("Running", "Backtest is already running!",
@@ -526,29 +706,8 @@ void BacktestView::RunBacktest() {
 		return;
 	}
 
-	// IMPORTANT: Warn user about UI freeze
-	BAlert* warningAlert = new BAlert("Warning",
-		"IMPORTANT: The backtest will run in the main thread and may take several minutes.\n\n"
-		"The application will appear frozen during this time - this is normal.\n\n"
-		"Large date ranges or high-frequency data may take 5-10 minutes.\n\n"
-		"Do you want to continue?",
-		"Cancel", "Yes, Continue", nullptr,
-		B_WIDTH_AS_USUAL, B_WARNING_ALERT);
-
-	int32 result = warningAlert->Go();
-	if (result == 0) {  // User clicked "Cancel"
-		return;
-	}
-
 	LOG_INFO("Starting backtest with recipe: " + selectedRecipePath);
 
-	// Show progress
-	progressBar->Reset();
-	progressBar->Show();
-	runButton->SetEnabled(false);
-	backtestRunning = true;
-	statusLabel->SetText("Running backtest...");
-
 	try {
 		// Load recipe
 		Recipe recipe;
@@ -616,136 +775,106 @@ void BacktestView::RunBacktest() {
 			throw std::runtime_error("Start date must be before end date");
 		}
 
-		// Load or download historical data
-		DataStorage storage;
-		if (!storage.init("/boot/home/Emiglio/data/emilio.db")) {
-			throw std::runtime_error("Failed to initialize database");
-		}
-
 		LOG_INFO("Loading candles for " + symbol + " from " + startDateStr + " to " + endDateStr);
 
-		// Try to get candles from database first
-		std::vector<Candle> candles = storage.getCandles(
-			recipe.market.exchange,
-			symbol,
-			recipe.market.timeframe,
-			startTime,
-			endTime
-		);
-
-		// If not enough data in database, download from Binance
-		if (candles.empty()) {
-			LOG_INFO("No data in database, downloading from Binance...");
-			statusLabel->SetText("Downloading data from Binance (this may take several minutes)...");
-			progressBar->Update(15.0, "Downloading historical data from Binance...");
-
-			// Download from Binance
-			BinanceAPI api;
-			if (!api.init("", "")) {  // Public API, no keys needed
-				throw std::runtime_error("Failed to initialize Binance API");
+		Backtest::BacktestCache::getInstance().init("/boot/home/Emiglio/data/emilio.db");
+
+		// Loading, simulation and analysis run on the job thread; progress
+		// and completion come back as messages
+		backtestJob = std::make_unique<Backtest::BacktestJob>(recipe, config);
+
+		std::string exchange = recipe.market.exchange;
+		std::string timeframe = recipe.market.timeframe;
+		backtestJob->setCandleLoader([exchange, symbol, timeframe, startTime, endTime]
+			(Backtest::BacktestJob& job, std::vector<Candle>& candles) {
+				return LoadBacktestCandles(job, candles, exchange, symbol, timeframe, startTime, endTime);
+			});
+
+		// Never block the job on the window's port: progress that doesn't fit
+		// is dropped (the next update supersedes it), and the finish message
+		// is retried until it fits or the view is gone
+		BMessenger messenger(this);
+		jobDetached = std::make_shared<std::atomic<bool>>(false);
+		std::shared_ptr<std::atomic<bool>> detached = jobDetached;
+		backtestJob->setProgressCallback([messenger, detached](double percent, const std::string& status) {
+			if (*detached) {
+				return;
 			}
-
-			// Download in chunks (Binance limit is 1000 per request)
-			// Calculate timeframe duration in seconds
-			int timeframeSec = 3600; // Default 1h
-			if (recipe.market.timeframe == "1m") timeframeSec = 60;
-			else if (recipe.market.timeframe == "5m") timeframeSec = 300;
-			else if (recipe.market.timeframe == "15m") timeframeSec = 900;
-			else if (recipe.market.timeframe == "30m") timeframeSec = 1800;
-			else if (recipe.market.timeframe == "1h") timeframeSec = 3600;
-			else if (recipe.market.timeframe == "4h") timeframeSec = 14400;
-			else if (recipe.market.timeframe == "1d") timeframeSec = 86400;
-
-			time_t currentStart = startTime;
-			int totalChunks = 0;
-			int consecutiveEmptyChunks = 0;
-
-			// Download all data in the requested range, no limits on empty chunks
-			while (currentStart < endTime) {
-				std::vector<Candle> chunk = api.getCandles(
-					symbol,
-					recipe.market.timeframe,
-					currentStart,
-					endTime,
-					1000  // Max limit
-				);
-
-				totalChunks++;
-
-				if (chunk.empty()) {
-					consecutiveEmptyChunks++;
-					// Move forward by 1000 candles worth to skip gaps
-					currentStart += (1000 * timeframeSec);
-					LOG_INFO("Empty chunk #" + std::to_string(consecutiveEmptyChunks) +
-					         " received, continuing to search...");
-
-					// Update progress even for empty chunks
-					double progress = 15.0 + (30.0 * (double)(currentStart - startTime) / (endTime - startTime));
-					std::string statusMsg = "Searching... (" + std::to_string(candles.size()) + " candles found)";
-					progressBar->Update(progress, statusMsg.c_str());
-					continue;
+			BMessage progress(MSG_BACKTEST_PROGRESS);
+			progress.AddDouble("percent", percent);
+			progress.AddString("status", status.c_str());
+			messenger.SendMessage(&progress, (BHandler*)nullptr, 0);
+		});
+		backtestJob->setFinishedCallback([messenger, detached](Backtest::BacktestJob::State) {
+			BMessage finished(MSG_BACKTEST_FINISHED);
+			while (!*detached) {
+				status_t status = messenger.SendMessage(&finished, (BHandler*)nullptr, 100000);
+				if (status != B_TIMED_OUT && status != B_WOULD_BLOCK) {
+					break;
 				}
+			}
+		});
 
-				consecutiveEmptyChunks = 0; // Reset empty counter
-
-				// Save to database
-				storage.insertCandles(chunk);
-
-				// Merge with main candles vector
-				candles.insert(candles.end(), chunk.begin(), chunk.end());
-
-				// Move to next chunk: start from the last candle + 1 timeframe
-				currentStart = chunk.back().timestamp + timeframeSec;
-
-				// Update progress
-				double progress = 15.0 + (30.0 * (double)(currentStart - startTime) / (endTime - startTime));
-				std::string statusMsg = "Downloaded " + std::to_string(candles.size()) + " candles...";
-				progressBar->Update(progress, statusMsg.c_str());
+		// Show progress
+		progressBar->Reset();
+		progressBar->Show();
+		runButton->SetEnabled(false);
+		cancelButton->SetEnabled(true);
+		backtestRunning = true;
+		statusLabel->SetText("Running backtest...");
 
-				LOG_INFO("Downloaded chunk " + std::to_string(totalChunks) +
-				         ": " + std::to_string(chunk.size()) +
-				         " candles (total: " + std::to_string(candles.size()) + ")");
-			}
+		backtestJob->start();
 
-			LOG_INFO("Downloaded and saved " + std::to_string(candles.size()) + " candles");
-		}
+	} catch (const std::exception& e) {
+		LOG_ERROR("Backtest failed: " + std::string(e.what()));
 
-		if (candles.empty()) {
-			throw std::runtime_error("No candles available for " + symbol +
-			                          " in the specified date range");
-		}
+		BAlert* alert = new BAlert("Backtest Failed",
+		                            (std::string("Backtest failed:\n") + e.what()).c_str(),
+		                            "OK", nullptr, nullptr,
+		                            B_WIDTH_AS_USUAL, B_STOP_ALERT);
+		alert->Go();
 
-		LOG_INFO("Loaded " + std::to_string(candles.size()) + " candles");
+		statusLabel->SetText("Backtest failed");
+		backtestJob.reset();
+	}
+}
 
-		// CRITICAL: Validate that we have enough data
-		if (candles.size() < 50) {
-			throw std::runtime_error("Not enough data for backtest. Loaded only " +
-			                          std::to_string(candles.size()) +
-			                          " candles. Need at least 50 candles for reliable results.");
-		}
+void BacktestView::CancelBacktest() {
+	if (!backtestRunning || !backtestJob) {
+		return;
+	}
 
-		progressBar->Update(30.0, "Calculating indicators...");
-		statusLabel->SetText("Running backtest simulation...");
+	LOG_INFO("Cancelling backtest");
+	backtestJob->cancel();
+	cancelButton->SetEnabled(false);
+	statusLabel->SetText("Cancelling backtest...");
+}
 
-		// Run backtest
-		Backtest::BacktestSimulator simulator(recipe, config);
-		Backtest::BacktestResult result = simulator.run(candles);
+void BacktestView::BacktestFinished() {
+	if (!backtestJob) {
+		return;
+	}
 
-		progressBar->Update(70.0, "Analyzing performance...");
+	backtestJob->wait();
+	Backtest::BacktestJob::State state = backtestJob->getState();
 
-		// Analyze performance
-		Backtest::PerformanceAnalyzer analyzer;
-		analyzer.analyze(result);
+	if (state == Backtest::BacktestJob::State::COMPLETED) {
+		const Backtest::BacktestResult& result = backtestJob->getResult();
 
-		progressBar->Update(100.0, "Complete!");
+		if (backtestJob->isCached()) {
+			LOG_INFO("Using cached backtest result " + backtestJob->getCacheKey());
+		}
 
 		// Display results
 		lastResult = result;
-		lastCandles = candles;  // Save candles for chart
+		lastCandles = backtestJob->getCandles();  // Save candles for chart
 		DisplayResults(result);
 
-		// Save results to database
-		SaveResultsToDatabase(result, recipe, candles);
+		// Save results to database (cached results are already there)
+		if (!backtestJob->isCached()) {
+			SaveResultsToDatabase(result, backtestJob->getRecipe(), lastCandles,
+			                      backtestJob->getCacheKey());
+		}
 
 		exportButton->SetEnabled(true);
 
@@ -755,11 +884,14 @@ void BacktestView::RunBacktest() {
 
 		LOG_INFO("Backtest completed successfully");
 
-	} catch (const std::exception& e) {
-		LOG_ERROR("Backtest failed: " + std::string(e.what()));
+	} else if (state == Backtest::BacktestJob::State::CANCELLED) {
+		statusLabel->SetText("Backtest cancelled");
+
+	} else {
+		std::string error = backtestJob->getLastError();
 
 		BAlert* alert = new BAlert("Backtest Failed",
-		                            (std::string("Backtest failed:\n") + e.what()).c_str(),
+		                            (std::string("Backtest failed:\n") + error).c_str(),
 		                            "OK", nullptr, nullptr,
 		                            B_WIDTH_AS_USUAL, B_STOP_ALERT);
 		alert->Go();
@@ -767,9 +899,12 @@ void BacktestView::RunBacktest() {
 		statusLabel->SetText("Backtest failed");
 	}
 
+	backtestJob.reset();
+
 	// Reset UI
 	progressBar->Hide();
 	runButton->SetEnabled(true);
+	cancelButton->SetEnabled(false);
 	backtestRunning = false;
 }
 
@@ -938,7 +1073,8 @@ void BacktestView::ExportResults() {
 
 void BacktestView::SaveResultsToDatabase(const Backtest::BacktestResult& result,
                                           const Recipe& recipe,
-                                          const std::vector<Candle>& candles) {
+                                          const std::vector<Candle>& candles,
+                                          const std::string& cacheKey) {
 	try {
 		// Open database
 		DataStorage storage;
@@ -974,7 +1110,8 @@ void BacktestView::SaveResultsToDatabase(const Backtest::BacktestResult& result,
 		configStream << "\"timeframe\":\"" << recipe.market.timeframe << "\",";
 		configStream << "\"exchange\":\"" << recipe.market.exchange << "\",";
 		configStream << "\"commission\":" << result.totalCommission << ",";
-		configStream << "\"candles\":" << result.totalCandles;
+		configStream << "\"candles\":" << result.totalCandles << ",";
+		configStream << "\"cacheKey\":\"" << cacheKey << "\"";
 		configStream << "}";
 		dbResult.config = configStream.str();
 
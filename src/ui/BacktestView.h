@@ -17,11 +17,14 @@
 
 #include "../backtest/BacktestSimulator.h"
 #include "../backtest/PerformanceAnalyzer.h"
+#include "../backtest/BacktestJob.h"
 #include "../strategy/RecipeLoader.h"
 #include "../data/DataStorage.h"
 #include "EquityChartView.h"
 #include "DatePickerWindow.h"
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -39,7 +42,10 @@ enum {
 	MSG_QUOTE_SELECTED = 'qots',
 	MSG_START_DATE_CLICKED = 'stdc',
 	MSG_END_DATE_CLICKED = 'endc',
-	MSG_PERIOD_SELECTED = 'prds'
+	MSG_PERIOD_SELECTED = 'prds',
+	MSG_BACKTEST_CANCEL = 'btcn',
+	MSG_BACKTEST_PROGRESS = 'btpg',   // From the job thread: "percent", "status"
+	MSG_BACKTEST_FINISHED = 'btfn'    // From the job thread when it exits
 };
 
 // Custom string field with background color
@@ -116,6 +122,8 @@ private:
 
 	// Actions
 	void RunBacktest();
+	void CancelBacktest();
+	void BacktestFinished();
 	void ExportResults();
 	void UpdateRecipeList();
 	void DisplayResults(const Emiglio::Backtest::BacktestResult& result);
@@ -125,7 +133,8 @@ private:
 	std::vector<std::string> FindRecipeFiles();
 	void SaveResultsToDatabase(const Emiglio::Backtest::BacktestResult& result,
 	                            const Recipe& recipe,
-	                            const std::vector<Candle>& candles);
+	                            const std::vector<Candle>& candles,
+	                            const std::string& cacheKey);
 
 	// Config controls
 	BMenuField* recipeField;
@@ -142,6 +151,7 @@ private:
 	BTextControl* commissionControl;
 	BTextControl* slippageControl;
 	BButton* runButton;
+	BButton* cancelButton;
 	BButton* exportButton;
 
 	// Results controls
@@ -161,6 +171,8 @@ private:
 	Emiglio::Backtest::BacktestResult lastResult;
 	std::vector<Candle> lastCandles;
 	bool backtestRunning;
+	std::unique_ptr<Emiglio::Backtest::BacktestJob> backtestJob;
+	std::shared_ptr<std::atomic<bool>> jobDetached;  // Set when the view stops listening
 	int32 selectedTradeIndex;
 };
 
@@ -25,7 +25,7 @@ CandlestickChartView::CandlestickChartView()
 CandlestickChartView::~CandlestickChartView() {
 }
 
-void CandlestickChartView::SetCandles(const std::vector<Candle>& newCandles) {
+void CandlestickChartView::SetCandles(const CandleSeries& newCandles) {
 	candles = newCandles;
 
 	if (!candles.empty()) {
@@ -2,7 +2,7 @@
 #define EMIGLIO_CANDLESTICKCHARTVIEW_H
 
 #include <View.h>
-#include "../data/DataStorage.h"
+#include "../data/CandleCache.h"
 #include <vector>
 #include <map>
 #include <string>
@@ -22,8 +22,8 @@ public:
 	virtual void MouseUp(BPoint where) override;
 	virtual void FrameResized(float newWidth, float newHeight) override;
 
-	// Data management
-	void SetCandles(const std::vector<Candle>& candles);
+	// Data management (the view shares the cached series, no copy)
+	void SetCandles(const CandleSeries& candles);
 	void SetIndicatorData(const std::string& name, const std::vector<double>& data);
 	void ClearIndicators();
 
@@ -35,7 +35,7 @@ public:
 	void ResetView();
 
 	// Get candles for volume calculation
-	const std::vector<Candle>& GetCandles() const { return candles; }
+	const CandleSeries& GetCandles() const { return candles; }
 
 private:
 	void DrawGrid(BRect bounds);
@@ -49,7 +49,7 @@ private:
 	void CalculateScale();
 
 	// Data
-	std::vector<Candle> candles;
+	CandleSeries candles;
 	std::map<std::string, std::vector<double>> indicators;
 
 	// View state
@@ -3,6 +3,7 @@
 #include "../utils/Logger.h"
 #include "../utils/Config.h"
 #include "../exchange/BinanceAPI.h"
+#include "../data/CandleCache.h"
 
 #include <LayoutBuilder.h>
 #include <GroupView.h>
@@ -468,7 +469,8 @@ void ChartsView::LoadData() {
 		time_t startTime = 0;
 		time_t endTime = std::time(nullptr);
 
-		std::vector<Candle> candles = storage.getCandles(
+		CandleSeries candles = CandleCache::getInstance().getCandles(
+			storage,
 			currentExchange,
 			currentSymbol,
 			currentTimeframe,
@@ -558,7 +560,8 @@ void ChartsView::CalculateIndicators() {
 		time_t startTime = 0;
 		time_t endTime = std::time(nullptr);
 
-		std::vector<Candle> candles = storage.getCandles(
+		CandleSeries candles = CandleCache::getInstance().getCandles(
+			storage,
 			currentExchange,
 			currentSymbol,
 			currentTimeframe,
@@ -568,19 +571,24 @@ void ChartsView::CalculateIndicators() {
 
 		if (candles.empty()) return;
 
+		// Closes straight from the cached series
+		std::vector<double> closes;
+		closes.reserve(candles.size());
+		for (const Candle& candle : candles) {
+			closes.push_back(candle.close);
+		}
+
 		// Clear existing indicators
 		chartView->ClearIndicators();
 
 		// Calculate EMA if button says "Hide"
 		if (std::string(emaButton->Label()).find("Hide") != std::string::npos) {
-			std::vector<double> closes = Indicators::getClosePrices(candles);
 			std::vector<double> ema = Indicators::ema(closes, 20);
 			chartView->SetIndicatorData("EMA(20)", ema);
 		}
 
 		// Calculate Bollinger Bands if button says "Hide"
 		if (std::string(bollingerButton->Label()).find("Hide") != std::string::npos) {
-			std::vector<double> closes = Indicators::getClosePrices(candles);
 			auto bands = Indicators::bollingerBands(closes, 20, 2.0);
 			chartView->SetIndicatorData("Bollinger_Upper", bands.upper);
 			chartView->SetIndicatorData("Bollinger_Lower", bands.lower);
@@ -664,17 +672,10 @@ int32 ChartsView::DownloadThreadFunc(void* userData) {
 	time_t startTime;
 
 	// Check if we already have data - if so, download from last timestamp
-	std::vector<Candle> existingData = storage.getCandles(
-		data->exchange,
-		data->symbol,
-		data->timeframe,
-		0,
-		endTime
-	);
-
-	if (!existingData.empty()) {
+	SeriesInfo existing;
+	if (storage.getSeriesInfo(data->exchange, data->symbol, data->timeframe, existing)) {
 		// Calculate gap between last data and now
-		time_t lastTimestamp = existingData.back().timestamp;
+		time_t lastTimestamp = existing.lastTimestamp;
 		time_t gap = endTime - lastTimestamp;
 		time_t thirtyDays = 30 * 24 * 3600;
 
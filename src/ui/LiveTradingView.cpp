@@ -482,11 +482,18 @@ void LiveTradingView::ConnectWebSocket() {
 	connectionStatusLabel->SetText("Status: Connected");
 	connectButton->SetLabel("Disconnect");
 
-	// CRITICAL FIX: Start message processor timer
-	// This periodically calls webSocket->processMessages() from the main thread
-	// to safely process queued messages and fire UI callbacks
+	// CRITICAL FIX: Queued messages are processed in the main thread.
+	// The network thread posts MSG_PROCESS_WS_MESSAGES as soon as data
+	// arrives (at most one in flight, so bursts are batched); the timer only
+	// sends subscription changes held back by Binance's rate limit.
+	BMessenger messenger(this);
+	webSocket->setWakeupCallback([messenger]() {
+		BMessage processMsg(MSG_PROCESS_WS_MESSAGES);
+		messenger.SendMessage(&processMsg);
+	});
+
 	BMessage processMsg(MSG_PROCESS_WS_MESSAGES);
-	wsMessageProcessor = new BMessageRunner(this, &processMsg, 100000); // 100ms = 0.1 seconds
+	wsMessageProcessor = new BMessageRunner(this, &processMsg, 1000000); // 1 second
 
 	LOG_INFO("WebSocket connected successfully");
 }
@@ -2,16 +2,164 @@
 #include "Logger.h"
 #include "Config.h"
 #include "../data/DataStorage.h"
+#include "../data/CandleResampler.h"
 #include "../exchange/BinanceAPI.h"
 
 #include <ctime>
 #include <algorithm>
-#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <map>
+#include <thread>
 
 namespace Emiglio {
 
+namespace {
+
+const char* kDatabasePath = "/boot/home/Emiglio/data/emilio.db";
+
+// How far back a series without any data starts
+const int64_t kInitialHistorySeconds = 30 * 24 * 60 * 60;
+
+// Binance returns at most 1000 klines per request
+const int kCandlesPerRequest = 1000;
+
+const int kDefaultFetcherCount = 4;
+
+// Fetched requests waiting for the writer; fetchers block past this, so
+// a slow disk holds back downloads instead of buffering them all
+const size_t kMaxQueuedBatches = 32;
+
+// The candles of one request, or the end of a task
+struct FetchBatch {
+	size_t task;
+	std::vector<Candle> candles;
+	CandleRange fetched;      // What the request asked for and got
+	bool finished;
+	bool success;
+};
+
+// Fetchers push, the writer takes everything queued at once
+class BatchQueue {
+public:
+	explicit BatchQueue(int producers) : producers(producers) {}
+
+	void push(FetchBatch&& batch) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notFull.wait(lock, [this]() { return batches.size() < kMaxQueuedBatches; });
+		batches.push_back(std::move(batch));
+		notEmpty.notify_one();
+	}
+
+	void producerDone() {
+		std::lock_guard<std::mutex> lock(mutex);
+		producers--;
+		notEmpty.notify_one();
+	}
+
+	// Waits for batches; false once every producer is done and all was taken
+	bool takeAll(std::vector<FetchBatch>& out) {
+		std::unique_lock<std::mutex> lock(mutex);
+		notEmpty.wait(lock, [this]() { return !batches.empty() || producers == 0; });
+		if (batches.empty()) {
+			return false;
+		}
+		out.assign(std::make_move_iterator(batches.begin()), std::make_move_iterator(batches.end()));
+		batches.clear();
+		notFull.notify_all();
+		return true;
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable notEmpty;
+	std::condition_variable notFull;
+	std::deque<FetchBatch> batches;
+	int producers;
+};
+
+// Start of the last candle that has closed by 'now'. Weekly candles open
+// on Mondays and monthly ones on the 1st, not on multiples of their length.
+int64_t lastClosedBucket(time_t now, const std::string& timeframe) {
+	time_t open = CandleResampler::alignTimestamp(now, timeframe);
+	return CandleResampler::alignTimestamp(open - 1, timeframe);
+}
+
+// Number of candles opening from 'start' to 'end', inclusive
+int64_t countBuckets(int64_t start, int64_t end, const std::string& timeframe) {
+	time_t bucket = CandleResampler::alignTimestamp(start, timeframe);
+	if (bucket < start) {
+		bucket = CandleResampler::nextBucketStart(bucket, timeframe);
+	}
+	if (bucket > end) {
+		return 0;
+	}
+	if (timeframe != "1M") {
+		return (end - bucket) / CandleResampler::timeframeToSeconds(timeframe) + 1;
+	}
+
+	int64_t count = 0;
+	for (; bucket <= end; bucket = CandleResampler::nextBucketStart(bucket, timeframe)) {
+		count++;
+	}
+	return count;
+}
+
+// Download a task a page at a time into the queue
+bool fetchRange(BinanceAPI& api, const SyncTask& task, size_t index, BatchQueue& queue) {
+	int64_t interval = CandleResampler::timeframeToSeconds(task.timeframe);
+	int64_t currentStart = task.startTime;
+
+	while (currentStart <= task.endTime) {
+		int64_t currentEnd = std::min(currentStart + (kCandlesPerRequest - 1) * interval, task.endTime);
+
+		LOG_DEBUG("Downloading " + task.symbol + " " + task.timeframe + " from " +
+		          std::to_string(currentStart) + " to " + std::to_string(currentEnd));
+
+		std::vector<Candle> candles = api.getCandles(
+			task.symbol, task.timeframe, currentStart, currentEnd, kCandlesPerRequest);
+
+		if (candles.empty() && api.getLastStatus() != 200) {
+			LOG_WARNING("Failed to download " + task.symbol + " " + task.timeframe + " from " +
+			            std::to_string(currentStart) + " (HTTP " + std::to_string(api.getLastStatus()) + ")");
+			return false;
+		}
+
+		// An empty answer means the exchange has nothing there (before the
+		// listing, or a trading halt): that chunk is complete too
+		if (candles.empty()) {
+			LOG_DEBUG("No candles for " + task.symbol + " " + task.timeframe + " from " +
+			          std::to_string(currentStart) + " to " + std::to_string(currentEnd));
+		}
+
+		// Move to next chunk
+		int64_t fetchedEnd = candles.empty() ? currentEnd :
+		                     std::max(currentEnd, static_cast<int64_t>(candles.back().timestamp));
+
+		FetchBatch batch;
+		batch.task = index;
+		batch.candles = std::move(candles);
+		batch.fetched = CandleRange(currentStart, fetchedEnd);
+		batch.finished = false;
+		batch.success = true;
+		queue.push(std::move(batch));
+
+		currentStart = CandleResampler::nextBucketStart(
+			CandleResampler::alignTimestamp(fetchedEnd, task.timeframe), task.timeframe);
+	}
+
+	return true;
+}
+
+} // namespace
+
 DataSyncManager::DataSyncManager()
 	: progressCallback(nullptr)
+	, fetcherCount(kDefaultFetcherCount)
+	, databasePath(kDatabasePath)
 {
 }
 
@@ -28,6 +176,34 @@ void DataSyncManager::setProgressCallback(
 	progressCallback = callback;
 }
 
+void DataSyncManager::setFetcherCount(int count) {
+	fetcherCount = std::max(1, count);
+}
+
+void DataSyncManager::setDatabasePath(const std::string& path) {
+	std::lock_guard<std::mutex> lock(syncMutex);
+	databasePath = path;
+	storage.reset();
+}
+
+SyncStats DataSyncManager::getLastSyncStats() const {
+	std::lock_guard<std::mutex> lock(syncMutex);
+	return lastStats;
+}
+
+bool DataSyncManager::openStorage() {
+	if (storage) {
+		return true;
+	}
+	storage.reset(new DataStorage());
+	if (!storage->init(databasePath)) {
+		LOG_ERROR("Failed to initialize storage for sync");
+		storage.reset();
+		return false;
+	}
+	return true;
+}
+
 std::vector<std::string> DataSyncManager::getSymbolsNeedingSync() {
 	// Get list of popular trading pairs
 	std::vector<std::string> symbols = {
@@ -53,119 +229,222 @@ std::vector<std::string> DataSyncManager::getSymbolsNeedingSync() {
 	return symbols;
 }
 
-int64_t DataSyncManager::getLastTimestamp(const std::string& exchange,
-                                           const std::string& symbol,
-                                           const std::string& timeframe) {
-	DataStorage storage;
-	if (!storage.init("/boot/home/Emiglio/data/emilio.db")) {
-		LOG_ERROR("Failed to initialize storage for timestamp check");
-		return 0;
-	}
+std::vector<SyncTask> DataSyncManager::planSync(DataStorage& storage,
+                                                const std::string& exchange,
+                                                const std::vector<std::string>& symbols,
+                                                const std::vector<std::string>& timeframes,
+                                                time_t now) {
+	std::vector<SyncTask> tasks;
+
+	for (const auto& timeframe : timeframes) {
+		int64_t interval = CandleResampler::timeframeToSeconds(timeframe);
+		if (interval <= 0) {
+			LOG_WARNING("Skipping unknown timeframe for sync: " + timeframe);
+			continue;
+		}
 
-	// Get the most recent candle by requesting from 30 days ago to now
-	time_t now = time(nullptr);
-	time_t thirtyDaysAgo = now - (30 * 24 * 60 * 60);
+		// The candle still open at 'now' isn't final yet
+		int64_t lastClosed = lastClosedBucket(now, timeframe);
+
+		for (const auto& symbol : symbols) {
+			SyncTask task;
+			task.exchange = exchange;
+			task.symbol = symbol;
+			task.timeframe = timeframe;
+			task.endTime = lastClosed;
+
+			SeriesInfo info;
+			if (storage.getSeriesInfo(exchange, symbol, timeframe, info)) {
+				task.startTime = CandleResampler::nextBucketStart(
+					CandleResampler::alignTimestamp(info.lastTimestamp, timeframe), timeframe);
+			} else {
+				task.startTime = CandleResampler::alignTimestamp(now - kInitialHistorySeconds, timeframe);
+			}
 
-	std::vector<Candle> candles = storage.getCandles(exchange, symbol, timeframe,
-	                                                   thirtyDaysAgo, now);
-	if (candles.empty()) {
-		// No data exists, start from 30 days ago
-		return thirtyDaysAgo;
+			if (task.startTime > task.endTime) {
+				continue;  // Up to date
+			}
+			task.expectedCandles = countBuckets(task.startTime, task.endTime, timeframe);
+			tasks.push_back(task);
+		}
 	}
 
-	// Return the timestamp of the latest candle + 1 hour to continue from next candle
-	return candles.back().timestamp + 3600;  // timestamp is in seconds, add 1 hour
+	return tasks;
 }
 
-bool DataSyncManager::downloadRange(const std::string& exchange,
-                                     const std::string& symbol,
-                                     const std::string& timeframe,
-                                     int64_t startTime,
-                                     int64_t endTime) {
+bool DataSyncManager::syncSeries(const std::string& exchange,
+                                 const std::vector<std::string>& symbols,
+                                 const std::vector<std::string>& timeframes) {
 	if (exchange != "binance") {
 		LOG_WARNING("Only Binance exchange is currently supported for sync");
 		return false;
 	}
 
-	BinanceAPI api;
-	if (!api.init("", "")) {
-		LOG_ERROR("Failed to initialize Binance API for sync");
+	std::lock_guard<std::mutex> lock(syncMutex);
+	if (!openStorage()) {
 		return false;
 	}
 
-	DataStorage storage;
-	if (!storage.init("/boot/home/Emiglio/data/emilio.db")) {
-		LOG_ERROR("Failed to initialize storage for sync");
+	std::vector<SyncTask> tasks = planSync(*storage, exchange, symbols, timeframes, time(nullptr));
+	LOG_INFO(std::to_string(tasks.size()) + " of " +
+	         std::to_string(symbols.size() * timeframes.size()) + " series need syncing");
+
+	return runTasks(tasks);
+}
+
+bool DataSyncManager::repairSeries(const std::string& exchange,
+                                   const std::string& symbol,
+                                   const std::string& timeframe,
+                                   time_t startTime,
+                                   time_t endTime) {
+	if (exchange != "binance") {
+		LOG_WARNING("Only Binance exchange is currently supported for sync");
 		return false;
 	}
 
-	// Download in chunks (max 1000 candles per request)
-	int64_t chunkSize = 1000;
-	int64_t timeframeMs = 3600000;  // 1h default
+	int64_t interval = CandleResampler::timeframeToSeconds(timeframe);
+	if (interval <= 0) {
+		LOG_WARNING("Cannot repair unknown timeframe: " + timeframe);
+		return false;
+	}
 
-	// Convert timeframe to milliseconds
-	if (timeframe == "1m") timeframeMs = 60000;
-	else if (timeframe == "5m") timeframeMs = 300000;
-	else if (timeframe == "15m") timeframeMs = 900000;
-	else if (timeframe == "1h") timeframeMs = 3600000;
-	else if (timeframe == "4h") timeframeMs = 14400000;
-	else if (timeframe == "1d") timeframeMs = 86400000;
+	std::lock_guard<std::mutex> lock(syncMutex);
+	if (!openStorage()) {
+		return false;
+	}
 
-	int64_t currentStart = startTime;
-	int totalDownloaded = 0;
+	// Only closed candles can be complete
+	int64_t lastClosed = lastClosedBucket(time(nullptr), timeframe);
+	CandleRange range(startTime, std::min<int64_t>(endTime, lastClosed));
+
+	std::vector<SyncTask> tasks;
+	for (const auto& missing : storage->getMissingRanges(exchange, symbol, timeframe, range, interval)) {
+		SyncTask task;
+		task.exchange = exchange;
+		task.symbol = symbol;
+		task.timeframe = timeframe;
+		task.startTime = missing.start;
+		task.endTime = missing.end;
+		task.expectedCandles = countBuckets(missing.start, missing.end, timeframe);
+		tasks.push_back(task);
+	}
+	LOG_INFO("Repairing " + symbol + " " + timeframe + ": " + std::to_string(tasks.size()) +
+	         " missing ranges");
 
-	while (currentStart < endTime) {
-		int64_t currentEnd = std::min(currentStart + (chunkSize * timeframeMs), endTime);
+	return runTasks(tasks);
+}
 
-		LOG_INFO("Downloading " + symbol + " " + timeframe + " from " +
-		         std::to_string(currentStart) + " to " + std::to_string(currentEnd));
+bool DataSyncManager::runTasks(const std::vector<SyncTask>& tasks) {
+	lastStats = SyncStats();
+	lastStats.tasksTotal = static_cast<int>(tasks.size());
+	if (tasks.empty()) {
+		return true;
+	}
 
-		std::vector<Candle> candles = api.getCandles(
-			symbol, timeframe, currentStart, currentEnd, chunkSize);
+	// Fetchers take the next task until none are left
+	int fetchers = std::min(fetcherCount, static_cast<int>(tasks.size()));
+	BatchQueue queue(fetchers);
+	std::atomic<size_t> nextTask(0);
+	std::vector<std::thread> threads;
+	for (int i = 0; i < fetchers; i++) {
+		threads.emplace_back([&tasks, &nextTask, &queue]() {
+			BinanceAPI api;
+			bool ready = api.init("", "");
+			if (!ready) {
+				LOG_ERROR("Failed to initialize Binance API for sync");
+			}
+			for (size_t index = nextTask++; index < tasks.size(); index = nextTask++) {
+				FetchBatch done;
+				done.task = index;
+				done.finished = true;
+				done.success = ready && fetchRange(api, tasks[index], index, queue);
+				queue.push(std::move(done));
+			}
+			queue.producerDone();
+		});
+	}
 
-		if (candles.empty()) {
-			LOG_WARNING("No candles received for " + symbol + " " + timeframe);
-			break;
+	// This thread writes: whatever was fetched since the last write goes
+	// into one transaction per series
+	auto start = std::chrono::steady_clock::now();
+	std::vector<FetchBatch> batches;
+	std::map<size_t, FetchBatch> pending;
+	while (queue.takeAll(batches)) {
+		// A task's pages arrive in order and back to back: store them, and
+		// mark what they cover, together
+		pending.clear();
+		std::string status;
+		for (auto& batch : batches) {
+			if (!batch.finished) {
+				auto found = pending.find(batch.task);
+				if (found == pending.end()) {
+					pending.emplace(batch.task, std::move(batch));
+				} else {
+					FetchBatch& merged = found->second;
+					merged.candles.insert(merged.candles.end(), std::make_move_iterator(batch.candles.begin()),
+					                      std::make_move_iterator(batch.candles.end()));
+					merged.fetched.start = std::min(merged.fetched.start, batch.fetched.start);
+					merged.fetched.end = std::max(merged.fetched.end, batch.fetched.end);
+				}
+			}
+			if (batch.finished) {
+				const SyncTask& task = tasks[batch.task];
+				lastStats.tasksCompleted++;
+				if (!batch.success) {
+					lastStats.tasksFailed++;
+					LOG_WARNING("Failed to sync " + task.symbol + " " + task.timeframe);
+				}
+				status = task.symbol + " " + task.timeframe;
+			}
 		}
 
-		// Store candles using insertCandles
-		if (!storage.insertCandles(candles)) {
-			LOG_WARNING("Failed to store some candles for " + symbol + " " + timeframe);
+		for (const auto& entry : pending) {
+			const FetchBatch& batch = entry.second;
+			const SyncTask& task = tasks[batch.task];
+			int64_t interval = CandleResampler::timeframeToSeconds(task.timeframe);
+			if (batch.candles.empty()) {
+				// Only empty pages: nothing to store, but nothing missing either
+				if (!storage->addCoverage(task.exchange, task.symbol, task.timeframe, batch.fetched, interval)) {
+					LOG_WARNING("Failed to mark " + task.symbol + " " + task.timeframe + " covered");
+				}
+			} else if (storage->insertCandles(batch.candles, batch.fetched, interval)) {
+				lastStats.candlesStored += batch.candles.size();
+			} else {
+				LOG_WARNING("Failed to store " + std::to_string(batch.candles.size()) + " candles");
+			}
 		}
 
-		totalDownloaded += candles.size();
+		lastStats.elapsedSeconds = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - start).count();
+		if (lastStats.elapsedSeconds > 0) {
+			lastStats.candlesPerSecond = lastStats.candlesStored / lastStats.elapsedSeconds;
+		}
 
 		if (progressCallback) {
-			progressCallback(totalDownloaded, -1, symbol + " " + timeframe);
+			progressCallback(lastStats.tasksCompleted, lastStats.tasksTotal,
+			                 (status.empty() ? std::string("Syncing") : "Synced " + status) + ": " +
+			                 std::to_string(lastStats.candlesStored) + " candles, " +
+			                 std::to_string(static_cast<int64_t>(lastStats.candlesPerSecond)) + " candles/s");
 		}
+	}
 
-		// Move to next chunk
-		currentStart = candles.back().timestamp + 1;  // timestamp is in seconds
-
-		// Small delay to avoid rate limiting
-		usleep(100000);  // 100ms
+	for (auto& thread : threads) {
+		thread.join();
 	}
 
-	LOG_INFO("Downloaded " + std::to_string(totalDownloaded) + " candles for " +
-	         symbol + " " + timeframe);
+	LOG_INFO("Stored " + std::to_string(lastStats.candlesStored) + " candles for " +
+	         std::to_string(lastStats.tasksTotal) + " series in " +
+	         std::to_string(static_cast<int64_t>(lastStats.elapsedSeconds * 1000)) + " ms (" +
+	         std::to_string(static_cast<int64_t>(lastStats.candlesPerSecond)) + " candles/s)");
 
-	return totalDownloaded > 0;
+	return lastStats.tasksFailed == 0;
 }
 
 bool DataSyncManager::syncSymbol(const std::string& exchange,
                                   const std::string& symbol,
                                   const std::string& timeframe) {
 	LOG_INFO("Syncing " + symbol + " " + timeframe + " from " + exchange);
-
-	int64_t lastTimestamp = getLastTimestamp(exchange, symbol, timeframe);
-	int64_t currentTime = time(nullptr);  // Current time in seconds
-
-	if (lastTimestamp >= currentTime - 3600) {  // If less than 1 hour old
-		LOG_INFO(symbol + " " + timeframe + " is already up to date");
-		return true;
-	}
-
-	return downloadRange(exchange, symbol, timeframe, lastTimestamp, currentTime);
+	return syncSeries(exchange, { symbol }, { timeframe });
 }
 
 bool DataSyncManager::syncAllData() {
@@ -174,28 +453,10 @@ bool DataSyncManager::syncAllData() {
 	std::vector<std::string> symbols = getSymbolsNeedingSync();
 	std::vector<std::string> timeframes = {"1h", "4h", "1d"};
 
-	int totalSymbols = symbols.size() * timeframes.size();
-	int completed = 0;
-
-	for (const auto& symbol : symbols) {
-		for (const auto& timeframe : timeframes) {
-			completed++;
-
-			if (progressCallback) {
-				progressCallback(completed, totalSymbols,
-				                "Syncing " + symbol + " " + timeframe);
-			}
-
-			if (!syncSymbol("binance", symbol, timeframe)) {
-				LOG_WARNING("Failed to sync " + symbol + " " + timeframe);
-			}
-
-			// Small delay between symbols
-			usleep(200000);  // 200ms
-		}
-	}
+	syncSeries("binance", symbols, timeframes);
 
-	LOG_INFO("Data sync completed: " + std::to_string(completed) + " symbol/timeframe pairs processed");
+	LOG_INFO("Data sync completed: " + std::to_string(symbols.size() * timeframes.size()) +
+	         " symbol/timeframe pairs processed");
 	return true;
 }
 
@@ -4,9 +4,41 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
 
 namespace Emiglio {
 
+class DataStorage;
+
+// One range of candles to download for a series
+struct SyncTask {
+	std::string exchange;
+	std::string symbol;
+	std::string timeframe;
+	int64_t startTime;        // Open time of the first missing candle
+	int64_t endTime;          // Open time of the last closed candle
+	int64_t expectedCandles;
+
+	SyncTask() : startTime(0), endTime(0), expectedCandles(0) {}
+};
+
+// Aggregate progress of a sync, across all fetchers
+struct SyncStats {
+	int tasksTotal;
+	int tasksCompleted;
+	int tasksFailed;
+	int64_t candlesStored;
+	double elapsedSeconds;
+	double candlesPerSecond;
+
+	SyncStats()
+		: tasksTotal(0), tasksCompleted(0), tasksFailed(0), candlesStored(0),
+		  elapsedSeconds(0), candlesPerSecond(0) {}
+};
+
 class DataSyncManager {
 public:
 	static DataSyncManager& getInstance();
@@ -19,12 +51,48 @@ public:
 	bool syncSymbol(const std::string& exchange, const std::string& symbol,
 	                const std::string& timeframe);
 
+	// Sync every symbol/timeframe pair. A pool of fetchers downloads the
+	// planned ranges concurrently, paced by the exchange's shared rate
+	// limiter; the calling thread is the only writer and stores what they
+	// fetch in batched transactions on one connection.
+	bool syncSeries(const std::string& exchange,
+	                const std::vector<std::string>& symbols,
+	                const std::vector<std::string>& timeframes);
+
+	// Download only what 'startTime'..'endTime' is missing according to
+	// the coverage index: holes left by earlier downloads, not the ranges
+	// already stored
+	bool repairSeries(const std::string& exchange,
+	                  const std::string& symbol,
+	                  const std::string& timeframe,
+	                  time_t startTime,
+	                  time_t endTime);
+
 	// Get list of symbols that need syncing
 	std::vector<std::string> getSymbolsNeedingSync();
 
-	// Set callback for progress updates
+	// What each symbol/timeframe is missing up to 'now', from one summary
+	// lookup per series. Series that are up to date get no task; series
+	// without data start 30 days back.
+	std::vector<SyncTask> planSync(DataStorage& storage,
+	                               const std::string& exchange,
+	                               const std::vector<std::string>& symbols,
+	                               const std::vector<std::string>& timeframes,
+	                               time_t now);
+
+	// Set callback for progress updates: tasks completed, tasks planned and
+	// a status with the candles stored so far and the rate they arrive at.
+	// Always called on the thread running the sync.
 	void setProgressCallback(std::function<void(int, int, const std::string&)> callback);
 
+	// Number of concurrent fetchers (default 4)
+	void setFetcherCount(int count);
+
+	// Database synced into; the connection stays open between syncs
+	void setDatabasePath(const std::string& path);
+
+	SyncStats getLastSyncStats() const;
+
 	// Delete copy constructor and assignment operator
 	DataSyncManager(const DataSyncManager&) = delete;
 	DataSyncManager& operator=(const DataSyncManager&) = delete;
@@ -34,18 +102,18 @@ private:
 	~DataSyncManager();
 
 	std::function<void(int, int, const std::string&)> progressCallback;
+	int fetcherCount;
+	std::string databasePath;
+
+	// One sync at a time owns the connection
+	mutable std::mutex syncMutex;
+	std::unique_ptr<DataStorage> storage;
+	SyncStats lastStats;
+
+	bool openStorage();
 
-	// Helper to get last timestamp for a symbol
-	int64_t getLastTimestamp(const std::string& exchange,
-	                         const std::string& symbol,
-	                         const std::string& timeframe);
-
-	// Helper to download data for a date range
-	bool downloadRange(const std::string& exchange,
-	                   const std::string& symbol,
-	                   const std::string& timeframe,
-	                   int64_t startTime,
-	                   int64_t endTime);
+	// Fetch and store 'tasks' with the fetcher pool; syncMutex held
+	bool runTasks(const std::vector<SyncTask>& tasks);
 };
 
 } // namespace Emiglio
@@ -0,0 +1,165 @@
+#ifndef EMIGLIO_FASTNUMBER_H
+#define EMIGLIO_FASTNUMBER_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace Emiglio {
+
+// Number parsing for exchange payloads. Binance sends prices and quantities
+// as quoted decimals ("42123.45000000"), which don't go through the JSON
+// parser's number path and are too hot for std::stod (locale lookup,
+// exceptions, std::string argument).
+namespace FastNumber {
+
+// Parse a decimal in [begin, end). Handles sign, fraction and exponent;
+// values with at most 19 significant digits and a small decimal exponent
+// are converted exactly with one multiply or divide (Clinger's fast path),
+// anything else falls back to strtod. Returns false if the whole range
+// isn't a number.
+inline bool parseDouble(const char* begin, const char* end, double& out) {
+	static const double kPow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	const char* p = begin;
+	if (p == end) {
+		return false;
+	}
+
+	bool negative = false;
+	if (*p == '-' || *p == '+') {
+		negative = (*p == '-');
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int digits = 0;        // Significant digits accumulated in mantissa
+	int exponent = 0;      // Decimal exponent applied to mantissa
+	bool overflow = false; // More than 19 significant digits
+	bool any = false;
+
+	for (; p != end && static_cast<unsigned>(*p - '0') < 10; p++) {
+		any = true;
+		if (digits < 19) {
+			mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+			if (mantissa != 0) {
+				digits++;
+			}
+		} else {
+			overflow = true;
+			exponent++;
+		}
+	}
+
+	if (p != end && *p == '.') {
+		p++;
+
+		// Fixed-decimal strings carry trailing zeros ("0.10000000"); leaving
+		// them out keeps the mantissa small and more values on the fast path
+		const char* fractionEnd = p;
+		while (fractionEnd != end && static_cast<unsigned>(*fractionEnd - '0') < 10) {
+			fractionEnd++;
+		}
+		const char* significantEnd = fractionEnd;
+		while (significantEnd != p && *(significantEnd - 1) == '0') {
+			significantEnd--;
+		}
+		any = any || fractionEnd != p;
+
+		for (; p != significantEnd; p++) {
+			if (digits < 19) {
+				mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+				if (mantissa != 0) {
+					digits++;
+				}
+				exponent--;
+			} else if (*p != '0') {
+				overflow = true;
+			}
+		}
+		p = fractionEnd;
+	}
+
+	if (!any) {
+		return false;
+	}
+
+	if (p != end && (*p == 'e' || *p == 'E')) {
+		p++;
+		bool negativeExp = false;
+		if (p != end && (*p == '-' || *p == '+')) {
+			negativeExp = (*p == '-');
+			p++;
+		}
+		if (p == end || static_cast<unsigned>(*p - '0') >= 10) {
+			return false;
+		}
+		int e = 0;
+		for (; p != end && static_cast<unsigned>(*p - '0') < 10; p++) {
+			if (e < 100000) {
+				e = e * 10 + (*p - '0');
+			}
+		}
+		exponent += negativeExp ? -e : e;
+	}
+
+	if (p != end) {
+		return false;
+	}
+
+	if (!overflow && mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+		double value = static_cast<double>(mantissa);
+		value = exponent < 0 ? value / kPow10[-exponent] : value * kPow10[exponent];
+		out = negative ? -value : value;
+		return true;
+	}
+
+	// Slow path: strtod needs a terminated copy
+	char buffer[128];
+	size_t length = static_cast<size_t>(end - begin);
+	if (length >= sizeof(buffer)) {
+		return false;
+	}
+	std::memcpy(buffer, begin, length);
+	buffer[length] = '\0';
+	char* parsedEnd = nullptr;
+	out = std::strtod(buffer, &parsedEnd);
+	return parsedEnd == buffer + length;
+}
+
+inline bool parseDouble(const char* str, size_t length, double& out) {
+	return parseDouble(str, str + length, out);
+}
+
+// Parse a signed integer in [begin, end) (no overflow check beyond 19 digits)
+inline bool parseInt64(const char* begin, const char* end, int64_t& out) {
+	const char* p = begin;
+	bool negative = false;
+	if (p != end && (*p == '-' || *p == '+')) {
+		negative = (*p == '-');
+		p++;
+	}
+	if (p == end || end - p > 19) {
+		return false;
+	}
+
+	uint64_t value = 0;
+	for (; p != end; p++) {
+		unsigned digit = static_cast<unsigned>(*p - '0');
+		if (digit >= 10) {
+			return false;
+		}
+		value = value * 10 + digit;
+	}
+
+	out = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+	return true;
+}
+
+} // namespace FastNumber
+} // namespace Emiglio
+
+#endif // EMIGLIO_FASTNUMBER_H
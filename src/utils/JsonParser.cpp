@@ -1,7 +1,10 @@
 #include "JsonParser.h"
 #include "Logger.h"
+#include "FastNumber.h"
 #include <fstream>
 #include <sstream>
+#include <cstddef>
+#include <cstring>
 
 // RapidJSON includes
 #include "rapidjson/document.h"
@@ -14,14 +17,118 @@ using namespace rapidjson;
 
 namespace Emiglio {
 
+// Document whose values and parse stack both live in memory pools, so
+// Clear()ing the pools recycles everything between parses
+typedef GenericDocument<UTF8<>, MemoryPoolAllocator<>, MemoryPoolAllocator<>> PooledDocument;
+
+namespace {
+
+// Initial pool sizes; messages that need more fall back to heap chunks,
+// which are released on the next parse
+const size_t kValuePoolSize = 64 * 1024;
+const size_t kStackPoolSize = 16 * 1024;
+
+const Value* findMember(const Value& object, const char* name, size_t length) {
+	if (!object.IsObject()) {
+		return nullptr;
+	}
+	for (auto it = object.MemberBegin(); it != object.MemberEnd(); ++it) {
+		if (it->name.GetStringLength() == length &&
+		    std::memcmp(it->name.GetString(), name, length) == 0) {
+			return &it->value;
+		}
+	}
+	return nullptr;
+}
+
+// Binance often returns numbers as strings
+double toDouble(const Value& val, double defaultValue) {
+	if (val.IsNumber()) {
+		return val.GetDouble();
+	}
+	if (val.IsString()) {
+		double result;
+		if (FastNumber::parseDouble(val.GetString(), val.GetStringLength(), result)) {
+			return result;
+		}
+	}
+	return defaultValue;
+}
+
+int64_t toInt64(const Value& val, int64_t defaultValue) {
+	if (val.IsInt64()) {
+		return val.GetInt64();
+	} else if (val.IsUint64()) {
+		return static_cast<int64_t>(val.GetUint64());
+	}
+	return defaultValue;
+}
+
+} // namespace
+
+JsonPath::JsonPath(const std::string& keyPath)
+	: path(keyPath) {
+	size_t start = 0;
+	while (!keyPath.empty()) {
+		size_t pos = keyPath.find('.', start);
+		keys.push_back(keyPath.substr(start, pos == std::string::npos ? std::string::npos : pos - start));
+		if (pos == std::string::npos) {
+			break;
+		}
+		start = pos + 1;
+	}
+}
+
 // Real RapidJSON implementation
 class JsonParser::Impl {
 public:
-	Document doc;
+	// Pools and the document living in them, in one block
+	struct Pool {
+		alignas(std::max_align_t) char buffer[kValuePoolSize + kStackPoolSize];
+		MemoryPoolAllocator<> valueAllocator;
+		MemoryPoolAllocator<> stackAllocator;
+		PooledDocument doc;
+
+		Pool()
+			: valueAllocator(buffer, kValuePoolSize)
+			, stackAllocator(buffer + kValuePoolSize, kStackPoolSize)
+			, doc(&valueAllocator, 1024, &stackAllocator) {}
+	};
+
+	// Made by the first parse, so parsers that are never used (or only
+	// hold a config file briefly) don't reserve the pools up front
+	std::unique_ptr<Pool> pool;
 	std::string errorMsg;
 	bool valid;
 
-	Impl() : valid(false) {}
+	Impl()
+		: valid(false) {}
+
+	// Drop the previous document and recycle its memory
+	void reset() {
+		valid = false;
+		if (!pool) {
+			pool = std::make_unique<Pool>();
+			return;
+		}
+		pool->doc.SetNull();
+		pool->valueAllocator.Clear();
+		pool->stackAllocator.Clear();
+	}
+
+	bool checkResult() {
+		const PooledDocument& doc = pool->doc;
+		if (doc.HasParseError()) {
+			errorMsg = GetParseError_En(doc.GetParseError());
+			errorMsg += " (offset: " + std::to_string(doc.GetErrorOffset()) + ")";
+			valid = false;
+			LOG_ERROR("Failed to parse JSON: " + errorMsg);
+			return false;
+		}
+
+		valid = true;
+		return true;
+	}
 
 	// Navigate to a value using key path (supports nested keys like "exchange.apiKey")
 	const Value* navigate(const std::string& keyPath) const {
@@ -31,34 +138,37 @@ public:
 
 		// Empty path means root document
 		if (keyPath.empty()) {
-			return &doc;
+			return &pool->doc;
 		}
 
-		// Root must be object for path navigation
-		if (!doc.IsObject()) {
-			return nullptr;
-		}
-
-		const Value* current = &doc;
-
-		// Split keyPath by '.'
-		std::string path = keyPath;
-		size_t pos = 0;
-		while ((pos = path.find('.')) != std::string::npos) {
-			std::string key = path.substr(0, pos);
-			if (!current->IsObject() || !current->HasMember(key.c_str())) {
-				return nullptr;
+		const Value* current = &pool->doc;
+		const char* key = keyPath.c_str();
+		const char* end = key + keyPath.size();
+		while (current) {
+			const char* dot = static_cast<const char*>(std::memchr(key, '.', end - key));
+			const char* keyEnd = dot ? dot : end;
+			current = findMember(*current, key, keyEnd - key);
+			if (!dot) {
+				break;
 			}
-			current = &(*current)[key.c_str()];
-			path = path.substr(pos + 1);
+			key = dot + 1;
 		}
+		return current;
+	}
 
-		// Final key
-		if (!current->IsObject() || !current->HasMember(path.c_str())) {
+	const Value* navigate(const JsonPath& path) const {
+		if (!valid) {
 			return nullptr;
 		}
 
-		return &(*current)[path.c_str()];
+		const Value* current = &pool->doc;
+		for (const auto& key : path.keys) {
+			current = findMember(*current, key.data(), key.size());
+			if (!current) {
+				return nullptr;
+			}
+		}
+		return current;
 	}
 };
 
@@ -70,19 +180,15 @@ JsonParser::~JsonParser() {
 }
 
 bool JsonParser::parse(const std::string& jsonString) {
-	pImpl->doc.Parse(jsonString.c_str());
-
-	if (pImpl->doc.HasParseError()) {
-		pImpl->errorMsg = GetParseError_En(pImpl->doc.GetParseError());
-		pImpl->errorMsg += " (offset: " + std::to_string(pImpl->doc.GetErrorOffset()) + ")";
-		pImpl->valid = false;
-		LOG_ERROR("Failed to parse JSON: " + pImpl->errorMsg);
-		return false;
-	}
+	pImpl->reset();
+	pImpl->pool->doc.Parse(jsonString.c_str());
+	return pImpl->checkResult();
+}
 
-	pImpl->valid = true;
-	LOG_DEBUG("JSON parsed successfully");
-	return true;
+bool JsonParser::parseInsitu(char* buffer) {
+	pImpl->reset();
+	pImpl->pool->doc.ParseInsitu(buffer);
+	return pImpl->checkResult();
 }
 
 bool JsonParser::parseFile(const std::string& filePath) {
@@ -141,12 +247,8 @@ double JsonParser::getDouble(const std::string& keyPath, double defaultValue) co
 		} else if (val->IsInt64()) {
 			return static_cast<double>(val->GetInt64());
 		} else if (val->IsString()) {
-			// Try to parse string as double (Binance sometimes returns numbers as strings)
-			try {
-				return std::stod(val->GetString());
-			} catch (...) {
-				return defaultValue;
-			}
+			// Binance sometimes returns numbers as strings
+			return toDouble(*val, defaultValue);
 		}
 	}
 	return defaultValue;
@@ -225,12 +327,7 @@ double JsonParser::getArrayDouble(const std::string& keyPath, size_t index, doub
 		} else if (element.IsInt64()) {
 			return static_cast<double>(element.GetInt64());
 		} else if (element.IsString()) {
-			// Binance often returns numbers as strings
-			try {
-				return std::stod(element.GetString());
-			} catch (...) {
-				return defaultValue;
-			}
+			return toDouble(element, defaultValue);
 		}
 	}
 	return defaultValue;
@@ -260,11 +357,7 @@ double JsonParser::getNestedArrayDouble(const std::string& keyPath, size_t outer
 			} else if (innerElement.IsInt64()) {
 				return static_cast<double>(innerElement.GetInt64());
 			} else if (innerElement.IsString()) {
-				try {
-					return std::stod(innerElement.GetString());
-				} catch (...) {
-					return defaultValue;
-				}
+				return toDouble(innerElement, defaultValue);
 			}
 		}
 	}
@@ -330,11 +423,7 @@ double JsonParser::getArrayObjectDouble(const std::string& keyPath, size_t index
 			} else if (fieldVal.IsInt64()) {
 				return static_cast<double>(fieldVal.GetInt64());
 			} else if (fieldVal.IsString()) {
-				try {
-					return std::stod(fieldVal.GetString());
-				} catch (...) {
-					return defaultValue;
-				}
+				return toDouble(fieldVal, defaultValue);
 			}
 		}
 	}
@@ -359,6 +448,46 @@ int64_t JsonParser::getArrayObjectInt64(const std::string& keyPath, size_t index
 	return defaultValue;
 }
 
+bool JsonParser::has(const JsonPath& path) const {
+	return pImpl->navigate(path) != nullptr;
+}
+
+std::string JsonParser::getString(const JsonPath& path, const std::string& defaultValue) const {
+	const Value* val = pImpl->navigate(path);
+	if (val && val->IsString()) {
+		return std::string(val->GetString(), val->GetStringLength());
+	}
+	return defaultValue;
+}
+
+bool JsonParser::getString(const JsonPath& path, std::string& out) const {
+	const Value* val = pImpl->navigate(path);
+	if (val && val->IsString()) {
+		out.assign(val->GetString(), val->GetStringLength());
+		return true;
+	}
+	out.clear();
+	return false;
+}
+
+int64_t JsonParser::getInt64(const JsonPath& path, int64_t defaultValue) const {
+	const Value* val = pImpl->navigate(path);
+	return val ? toInt64(*val, defaultValue) : defaultValue;
+}
+
+double JsonParser::getDouble(const JsonPath& path, double defaultValue) const {
+	const Value* val = pImpl->navigate(path);
+	return val ? toDouble(*val, defaultValue) : defaultValue;
+}
+
+bool JsonParser::getBool(const JsonPath& path, bool defaultValue) const {
+	const Value* val = pImpl->navigate(path);
+	if (val && val->IsBool()) {
+		return val->GetBool();
+	}
+	return defaultValue;
+}
+
 std::string JsonParser::getError() const {
 	return pImpl->errorMsg;
 }
@@ -371,10 +500,10 @@ std::string JsonParser::toString(bool pretty) const {
 	StringBuffer buffer;
 	if (pretty) {
 		PrettyWriter<StringBuffer> writer(buffer);
-		pImpl->doc.Accept(writer);
+		pImpl->pool->doc.Accept(writer);
 	} else {
 		Writer<StringBuffer> writer(buffer);
-		pImpl->doc.Accept(writer);
+		pImpl->pool->doc.Accept(writer);
 	}
 
 	return buffer.GetString();
@@ -3,11 +3,31 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <cstdint>
 
 namespace Emiglio {
 
-// Wrapper around RapidJSON for easier usage
+// A key path ("data.s") split once, for lookups repeated on every message.
+// Build these once (e.g. as static or member constants) and pass them to
+// the JsonPath overloads of JsonParser.
+class JsonPath {
+public:
+	explicit JsonPath(const std::string& keyPath);
+
+	const std::string& str() const { return path; }
+
+private:
+	friend class JsonParser;
+
+	std::string path;
+	std::vector<std::string> keys;
+};
+
+// Wrapper around RapidJSON for easier usage.
+// The document's memory pool (about 80 KB) is made by the first parse and
+// kept between parse calls, so reusing one parser for a stream of messages
+// doesn't allocate once it has warmed up.
 class JsonParser {
 public:
 	JsonParser();
@@ -16,9 +36,21 @@ public:
 	// Parse JSON from string
 	bool parse(const std::string& jsonString);
 
+	// Parse a mutable, NUL-terminated buffer in place. String values point
+	// into 'buffer', which must outlive any lookups.
+	bool parseInsitu(char* buffer);
+
 	// Parse JSON from file
 	bool parseFile(const std::string& filePath);
 
+	// Lookups by precompiled path (no splitting or allocation per call)
+	bool has(const JsonPath& path) const;
+	std::string getString(const JsonPath& path, const std::string& defaultValue = "") const;
+	bool getString(const JsonPath& path, std::string& out) const;  // Reuses out's capacity
+	int64_t getInt64(const JsonPath& path, int64_t defaultValue = 0) const;
+	double getDouble(const JsonPath& path, double defaultValue = 0.0) const;
+	bool getBool(const JsonPath& path, bool defaultValue = false) const;
+
 	// Get string value by key path (e.g., "exchange.apiKey")
 	std::string getString(const std::string& keyPath, const std::string& defaultValue = "") const;
 
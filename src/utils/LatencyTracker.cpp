@@ -0,0 +1,226 @@
+#include "LatencyTracker.h"
+#include "Logger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+
+namespace Emiglio {
+
+namespace {
+
+thread_local int64_t tickOrigin = 0;
+
+int highestBit(uint64_t value) {
+	int bit = 0;
+	while (value >>= 1) {
+		bit++;
+	}
+	return bit;
+}
+
+} // namespace
+
+const size_t LatencyHistogram::kBucketCount;
+
+// ============================================================================
+// LatencyHistogram
+// ============================================================================
+
+LatencyHistogram::LatencyHistogram() {
+	reset();
+}
+
+// Values below 2^kSubBucketBits map to themselves. Above that, each power
+// of two [2^e, 2^(e+1)) is split into 2^kSubBucketBits equal buckets.
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+	const uint64_t subBuckets = 1ULL << kSubBucketBits;
+	if (value < subBuckets) {
+		return static_cast<size_t>(value);
+	}
+
+	int exponent = highestBit(value);
+	if (exponent >= kMaxValueBits) {
+		return kBucketCount - 1;
+	}
+	int shift = exponent - kSubBucketBits;
+	size_t group = static_cast<size_t>(shift + 1);
+	return (group << kSubBucketBits) | static_cast<size_t>((value >> shift) & (subBuckets - 1));
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+	const size_t subBuckets = static_cast<size_t>(1) << kSubBucketBits;
+	if (index < subBuckets) {
+		return index;
+	}
+
+	size_t group = index >> kSubBucketBits;
+	uint64_t sub = index & (subBuckets - 1);
+	int shift = static_cast<int>(group) - 1;
+	// Bucket covers [(2^7 + sub) << shift, (2^7 + sub + 1) << shift)
+	return (((static_cast<uint64_t>(subBuckets) + sub + 1) << shift) - 1);
+}
+
+void LatencyHistogram::record(int64_t nanoseconds) {
+	if (nanoseconds < 0) {
+		nanoseconds = 0;
+	}
+
+	buckets[bucketIndex(static_cast<uint64_t>(nanoseconds))].fetch_add(1, std::memory_order_relaxed);
+	total.fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+	int64_t current = minimum.load(std::memory_order_relaxed);
+	while (nanoseconds < current &&
+	       !minimum.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+	}
+	current = maximum.load(std::memory_order_relaxed);
+	while (nanoseconds > current &&
+	       !maximum.compare_exchange_weak(current, nanoseconds, std::memory_order_relaxed)) {
+	}
+}
+
+void LatencyHistogram::reset() {
+	for (auto& bucket : buckets) {
+		bucket.store(0, std::memory_order_relaxed);
+	}
+	total.store(0, std::memory_order_relaxed);
+	sum.store(0, std::memory_order_relaxed);
+	minimum.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+	maximum.store(0, std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::percentile(double percent) const {
+	uint64_t count = this->count();
+	if (count == 0) {
+		return 0;
+	}
+
+	// Rank of the requested sample, 1-based
+	uint64_t rank = static_cast<uint64_t>(percent / 100.0 * count + 0.5);
+	if (rank < 1) rank = 1;
+	if (rank > count) rank = count;
+
+	uint64_t seen = 0;
+	for (size_t i = 0; i < kBucketCount; i++) {
+		seen += buckets[i].load(std::memory_order_relaxed);
+		if (seen >= rank) {
+			// Never report more than the largest value recorded
+			int64_t bound = static_cast<int64_t>(bucketUpperBound(i));
+			int64_t max = maximum.load(std::memory_order_relaxed);
+			return bound < max ? bound : max;
+		}
+	}
+	return maximum.load(std::memory_order_relaxed);
+}
+
+LatencyStats LatencyHistogram::stats() const {
+	LatencyStats result;
+	result.count = count();
+	result.min = result.count > 0 ? minimum.load(std::memory_order_relaxed) : 0;
+	result.max = maximum.load(std::memory_order_relaxed);
+	result.mean = result.count > 0 ? static_cast<double>(sum.load(std::memory_order_relaxed)) / result.count : 0.0;
+	result.p50 = percentile(50.0);
+	result.p90 = percentile(90.0);
+	result.p99 = percentile(99.0);
+	result.p999 = percentile(99.9);
+	return result;
+}
+
+// ============================================================================
+// LatencyTracker
+// ============================================================================
+
+LatencyTracker& LatencyTracker::getInstance() {
+	static LatencyTracker instance;
+	return instance;
+}
+
+LatencyTracker::LatencyTracker()
+	: enabled(true) {
+}
+
+int64_t LatencyTracker::now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LatencyTracker::record(LatencyStage stage, int64_t nanoseconds) {
+	if (!isEnabled() || stage >= LatencyStage::COUNT) {
+		return;
+	}
+	histograms[static_cast<size_t>(stage)].record(nanoseconds);
+}
+
+void LatencyTracker::setTickOrigin(int64_t ns) {
+	tickOrigin = ns;
+}
+
+int64_t LatencyTracker::getTickOrigin() {
+	return tickOrigin;
+}
+
+void LatencyTracker::recordTickToSignal() {
+	if (tickOrigin != 0) {
+		recordSince(LatencyStage::TICK_TO_SIGNAL, tickOrigin);
+	}
+}
+
+LatencyStats LatencyTracker::getStats(LatencyStage stage) const {
+	return histograms[static_cast<size_t>(stage)].stats();
+}
+
+const LatencyHistogram& LatencyTracker::getHistogram(LatencyStage stage) const {
+	return histograms[static_cast<size_t>(stage)];
+}
+
+const char* LatencyTracker::stageName(LatencyStage stage) {
+	switch (stage) {
+		case LatencyStage::FRAME_DECODE: return "frame_decode";
+		case LatencyStage::QUEUE_WAIT: return "queue_wait";
+		case LatencyStage::JSON_DECODE: return "json_decode";
+		case LatencyStage::DISPATCH: return "dispatch";
+		case LatencyStage::INDICATOR_UPDATE: return "indicator_update";
+		case LatencyStage::SIGNAL_EVAL: return "signal_eval";
+		case LatencyStage::TICK_TO_SIGNAL: return "tick_to_signal";
+		default: return "unknown";
+	}
+}
+
+std::string LatencyTracker::report() const {
+	std::string text;
+	char line[256];
+	snprintf(line, sizeof(line), "%-18s %10s %10s %10s %10s %10s %10s %10s\n",
+	         "stage (us)", "count", "min", "p50", "p90", "p99", "p99.9", "max");
+	text += line;
+
+	for (size_t i = 0; i < static_cast<size_t>(LatencyStage::COUNT); i++) {
+		LatencyStats s = histograms[i].stats();
+		snprintf(line, sizeof(line), "%-18s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+		         stageName(static_cast<LatencyStage>(i)),
+		         static_cast<unsigned long long>(s.count),
+		         s.min / 1000.0, s.p50 / 1000.0, s.p90 / 1000.0,
+		         s.p99 / 1000.0, s.p999 / 1000.0, s.max / 1000.0);
+		text += line;
+	}
+	return text;
+}
+
+bool LatencyTracker::dumpToFile(const std::string& path) const {
+	std::ofstream file(path);
+	if (!file.is_open()) {
+		LOG_ERROR("Failed to open latency report file: " + path);
+		return false;
+	}
+	file << report();
+	return file.good();
+}
+
+void LatencyTracker::reset() {
+	for (auto& histogram : histograms) {
+		histogram.reset();
+	}
+}
+
+} // namespace Emiglio
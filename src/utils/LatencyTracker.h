@@ -0,0 +1,114 @@
+#ifndef EMIGLIO_LATENCYTRACKER_H
+#define EMIGLIO_LATENCYTRACKER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Emiglio {
+
+// Stages of the live pipeline, from a socket read to a trading signal
+enum class LatencyStage {
+	FRAME_DECODE,      // Socket read -> WebSocket frame extracted
+	QUEUE_WAIT,        // Queued by the network thread -> taken by processMessages()
+	JSON_DECODE,       // Stream message decode
+	DISPATCH,          // Stream callbacks
+	INDICATOR_UPDATE,  // Indicator calculation in SignalGenerator
+	SIGNAL_EVAL,       // Entry/exit rule evaluation
+	TICK_TO_SIGNAL,    // Socket read -> signal generated
+	COUNT
+};
+
+// Summary of one histogram, all values in nanoseconds
+struct LatencyStats {
+	uint64_t count;
+	int64_t min;
+	int64_t max;
+	double mean;
+	int64_t p50;
+	int64_t p90;
+	int64_t p99;
+	int64_t p999;
+};
+
+// HDR-style histogram: buckets are exact below 128ns, then 128 linear
+// sub-buckets per power of two (under 1% relative error) up to ~18
+// minutes. Recording is a few relaxed atomic increments, so the network
+// and main threads can share one histogram without locking.
+class LatencyHistogram {
+public:
+	static const int kSubBucketBits = 7;
+	static const int kMaxValueBits = 40;
+	static const size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 1) << kSubBucketBits;
+
+	LatencyHistogram();
+
+	void record(int64_t nanoseconds);
+	void reset();
+
+	uint64_t count() const { return total.load(std::memory_order_relaxed); }
+
+	// Upper bound of the bucket holding the given percentile (0-100)
+	int64_t percentile(double percent) const;
+	LatencyStats stats() const;
+
+	static size_t bucketIndex(uint64_t value);
+	static uint64_t bucketUpperBound(size_t index);
+
+private:
+	std::atomic<uint64_t> buckets[kBucketCount];
+	std::atomic<uint64_t> total;
+	std::atomic<int64_t> sum;
+	std::atomic<int64_t> minimum;
+	std::atomic<int64_t> maximum;
+};
+
+// Process-wide latency histograms per pipeline stage.
+//
+// Each stage records its own duration. End-to-end latency is measured from
+// the socket read time of the message being processed, which the WebSocket
+// layer publishes per thread with setTickOrigin() while it runs callbacks.
+class LatencyTracker {
+public:
+	static LatencyTracker& getInstance();
+
+	// Monotonic clock in nanoseconds
+	static int64_t now();
+
+	void setEnabled(bool enabled) { this->enabled.store(enabled, std::memory_order_relaxed); }
+	bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+	void record(LatencyStage stage, int64_t nanoseconds);
+	void recordSince(LatencyStage stage, int64_t startNs) { record(stage, now() - startNs); }
+
+	// Socket read time of the message the current thread is handling (0 = none)
+	static void setTickOrigin(int64_t ns);
+	static int64_t getTickOrigin();
+
+	// Record TICK_TO_SIGNAL if the current thread is handling a live message
+	void recordTickToSignal();
+
+	LatencyStats getStats(LatencyStage stage) const;
+	const LatencyHistogram& getHistogram(LatencyStage stage) const;
+	static const char* stageName(LatencyStage stage);
+
+	// Table of count/min/p50/p90/p99/p99.9/max per stage, in microseconds
+	std::string report() const;
+	bool dumpToFile(const std::string& path) const;
+
+	void reset();
+
+	LatencyTracker(const LatencyTracker&) = delete;
+	LatencyTracker& operator=(const LatencyTracker&) = delete;
+
+private:
+	LatencyTracker();
+
+	std::atomic<bool> enabled;
+	LatencyHistogram histograms[static_cast<size_t>(LatencyStage::COUNT)];
+};
+
+} // namespace Emiglio
+
+#endif // EMIGLIO_LATENCYTRACKER_H